@@ -0,0 +1,222 @@
+/* Batch simulator
+
+   Plays a range of seeds on every core and optionally appends one row
+   per game to a columnar result store (see results.h, query it with
+   resq).  With -P the seeds are sharded over worker processes instead
+   of threads so that a game which crashes the engine only costs its
+   shard (see shard.h).  With -t the engine's events are traced (see
+   trace.h) and written to a trace file at the end; each thread keeps
+   only its most recent TRACE_RING_EVENTS events.  With -H the per-card
+   cycle counters (see perfstats.h) are printed at the end; the engine
+   only keeps them when built with make PERF=-DPERF_STATS.
+
+   Usage: batchsim [-j threads | -P processes [-S shard] [-T timeout]]
+                   [-n games] [-s first seed] [-p players]
+                   [-a strategy] [-b strategy] [-k random] [-o store]
+                   [-t trace] [-H]
+*/
+
+#include "dominion.h"
+#include "simulate.h"
+#include "results.h"
+#include "workq.h"
+#include "shard.h"
+#include "trace.h"
+#include "perfstats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#define BATCH_GRAIN 256
+#define SHARD_GAMES 1000
+
+struct batch {
+  struct simJob job;
+  long firstSeed;
+  struct resultWriter *writer;
+  pthread_mutex_t lock;
+  struct simAggregate total;
+  int failed;
+};
+
+static void batchRange(void *arg, int worker, long begin, long end) {
+  struct batch *b = arg;
+  struct simResult *results = malloc((end - begin) * sizeof(struct simResult));
+  struct simAggregate agg;
+  long n = 0;
+  long seed;
+  long i;
+
+  if (results == NULL) {
+    b->failed = 1;
+    return;
+  }
+  memset(&agg, 0, sizeof(agg));
+  for (seed = begin; seed < end; seed++) {
+    if (simulateSeed(&b->job, seed, &results[n]) < 0)
+      continue;
+    addSimResult(&agg, &results[n]);
+    n++;
+  }
+
+  pthread_mutex_lock(&b->lock);
+  for (i = 0; i < n && b->writer != NULL; i++) {
+    if (appendResult(b->writer, &results[i]) < 0)
+      b->failed = 1;
+  }
+  mergeSimAggregate(&b->total, &agg);
+  pthread_mutex_unlock(&b->lock);
+  free(results);
+}
+
+static int playShard(void *arg, long firstSeed, long games, void *result) {
+  struct batch *b = arg;
+
+  return simulateSeeds(&b->job, firstSeed, games, result);
+}
+
+static void mergeShard(void *arg, void *total, void *result) {
+  mergeSimAggregate(total, result);
+}
+
+static void usage(void) {
+  printf("Usage: batchsim [-j threads | -P processes [-S shard] [-T timeout]]\n"
+	 "                [-n games] [-s first seed] [-p players]\n"
+	 "                [-a strategy] [-b strategy] [-k random] [-o store]\n"
+	 "                [-t trace] [-H]\n");
+}
+
+int main(int argc, char **argv) {
+  struct batch b;
+  struct strategy a;
+  struct strategy other;
+  struct shardJob shards;
+  struct shardStats stats;
+  const char *storePath = NULL;
+  const char *tracePath = NULL;
+  struct perfStats *perf;
+  int perfDump = 0;
+  long numGames = 1000;
+  int threads = 0;
+  int opt;
+  int i;
+  int k[10] = {adventurer, gardens, embargo, village, minion, mine, cutpurse,
+	       sea_hag, tribute, smithy};
+
+  memset(&b, 0, sizeof(b));
+  b.job.numPlayers = 2;
+  b.firstSeed = 1;
+  memcpy(b.job.kingdom, k, sizeof(k));
+  parseStrategy("smithy", &a);
+  parseStrategy("adventurer", &other);
+  memset(&shards, 0, sizeof(shards));
+  shards.shardGames = SHARD_GAMES;
+
+  while ((opt = getopt(argc, argv, "j:P:S:T:n:s:p:a:b:k:o:t:H")) != -1) {
+    switch (opt) {
+    case 'j': threads = atoi(optarg); break;
+    case 'P': shards.numWorkers = atoi(optarg); break;
+    case 'S': shards.shardGames = atol(optarg); break;
+    case 'T': shards.timeout = atoi(optarg); break;
+    case 'n': numGames = atol(optarg); break;
+    case 's': b.firstSeed = atol(optarg); break;
+    case 'p': b.job.numPlayers = atoi(optarg); break;
+    case 'a':
+    case 'b':
+      if (parseStrategy(optarg, opt == 'a' ? &a : &other) < 0) {
+	printf("Unknown strategy %s\n", optarg);
+	return 1;
+      }
+      break;
+    case 'k': b.job.randomKingdom = strcmp(optarg, "random") == 0; break;
+    case 'o': storePath = optarg; break;
+    case 't': tracePath = optarg; break;
+    case 'H': perfDump = 1; break;
+    default: usage(); return 1;
+    }
+  }
+  if (numGames < 1 || b.firstSeed < 1 || b.job.numPlayers < 2
+      || b.job.numPlayers > MAX_PLAYERS || shards.numWorkers < 0
+      || shards.shardGames < 1) {
+    usage();
+    return 1;
+  }
+  if (shards.numWorkers > 0 && (storePath != NULL || tracePath != NULL
+				 || perfDump)) {
+    printf("Result stores, traces and counters are only kept in thread mode"
+	   " (-j)\n");
+    return 1;
+  }
+  b.job.strategies[0] = a;
+  for (i = 1; i < b.job.numPlayers; i++)
+    b.job.strategies[i] = other;
+
+  if (storePath != NULL) {
+    b.writer = openResultWriter(storePath);
+    if (b.writer == NULL) {
+      printf("Could not open result store %s\n", storePath);
+      return 1;
+    }
+  }
+  pthread_mutex_init(&b.lock, NULL);
+  if (tracePath != NULL)
+    traceStart();
+  if (perfDump)
+    perfReset();
+
+  if (shards.numWorkers > 0) {
+    shards.firstSeed = b.firstSeed;
+    shards.games = numGames;
+    shards.resultSize = sizeof(struct simAggregate);
+    shards.play = playShard;
+    shards.merge = mergeShard;
+    shards.arg = &b;
+    if (runShardedBatch(&shards, &b.total, &stats) < 0) {
+      printf("Could not start worker processes\n");
+      return 1;
+    }
+    printf("Shards: %ld (%ld retried)\n", stats.shards, stats.retries);
+    if (stats.crashedSeeds > 0)
+      printf("Crashed seeds: %ld (first %ld)\n", stats.crashedSeeds,
+	     stats.firstCrashedSeed);
+  } else if (workqRun(b.firstSeed, b.firstSeed + numGames, BATCH_GRAIN,
+		      threads, batchRange, &b) < 0) {
+    printf("Could not start worker threads\n");
+    return 1;
+  }
+  if (b.writer != NULL && closeResultWriter(b.writer) < 0)
+    b.failed = 1;
+  if (tracePath != NULL) {
+    traceStop();
+    if (traceWrite(tracePath) < 0) {
+      printf("Could not write trace %s\n", tracePath);
+      b.failed = 1;
+    }
+  }
+
+  printf("Games: %ld\n", b.total.games);
+  for (i = 0; i < b.job.numPlayers; i++)
+    printf("Player %d wins: %ld (%.1f%%)\n", i, b.total.wins[i],
+	   b.total.games ? 100.0 * b.total.wins[i] / b.total.games : 0.0);
+  printf("Ties: %ld\nAverage turns: %.2f\n", b.total.ties,
+	 b.total.games ? (double)b.total.turns / b.total.games : 0.0);
+  if (perfDump) {
+    perf = malloc(sizeof(struct perfStats));
+    if (perf == NULL)
+      b.failed = 1;
+    else {
+      perfSnapshot(perf);
+      printf("\nCycles per call:\n");
+      if (perfPrint(stdout, perf) == 0)
+	printf("(none counted, build with make PERF=-DPERF_STATS)\n");
+      free(perf);
+    }
+  }
+  if (b.failed) {
+    printf("Writing results failed\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,164 @@
+#include "binproto.h"
+#include <string.h>
+
+static void putBig(unsigned char *p, unsigned long v, int bytes) {
+  int i;
+
+  for (i = bytes - 1; i >= 0; i--) {
+    p[i] = (unsigned char)(v & 0xff);
+    v >>= 8;
+  }
+}
+
+static unsigned long getBig(const unsigned char *p, int bytes) {
+  unsigned long v = 0;
+  int i;
+
+  for (i = 0; i < bytes; i++)
+    v = (v << 8) | p[i];
+  return v;
+}
+
+//as getBig, for fields that hold signed 4 byte values
+static int getInt(const unsigned char *p) {
+  return (int)(unsigned int)getBig(p, 4);
+}
+
+int encodeBinMove(struct sessionMove *m, unsigned char *buf) {
+  int i;
+
+  putBig(buf, BIN_MOVE_SIZE - 2, 2);
+  buf[2] = BIN_MOVE;
+  buf[3] = (unsigned char)m->op;
+  for (i = 0; i < 4; i++)
+    putBig(buf + 4 + 4 * i, (unsigned int)m->args[i], 4);
+  return BIN_MOVE_SIZE;
+}
+
+int decodeBinMove(const unsigned char *buf, int size, struct sessionMove *m) {
+  int i;
+
+  if (size < BIN_HEADER_SIZE)
+    return 0;
+  if (getBig(buf, 2) != BIN_MOVE_SIZE - 2 || buf[2] != BIN_MOVE)
+    return -1;
+  if (size < BIN_MOVE_SIZE)
+    return 0;
+  m->op = buf[3];
+  for (i = 0; i < 4; i++)
+    m->args[i] = getInt(buf + 4 + 4 * i);
+  m->outcome = 0;
+  return BIN_MOVE_SIZE;
+}
+
+int binMoveAllowed(struct session *s, struct sessionMove *m) {
+  if (m->op == SESSION_ADD || (m->op == SESSION_INIT && s->started))
+    return -1;
+  return 0;
+}
+
+int encodeBinResult(struct sessionMove *m, int over, const int *view,
+		    int *last, unsigned char *buf) {
+  unsigned char *p = buf + BIN_RESULT_HEADER;
+  int count = 0;
+  int i;
+
+  for (i = 0; i < VIEW_SLOTS; i++) {
+    if (view[i] != last[i]) {
+      putBig(p, i, 2);
+      putBig(p + 2, (unsigned int)view[i], 4);
+      p += BIN_PAIR_SIZE;
+      last[i] = view[i];
+      count++;
+    }
+  }
+  putBig(buf, p - buf - 2, 2);
+  buf[2] = BIN_RESULT;
+  buf[3] = (unsigned char)m->op;
+  putBig(buf + 4, (unsigned int)m->outcome, 4);
+  buf[8] = over ? 1 : 0;
+  putBig(buf + 9, count, 2);
+  return p - buf;
+}
+
+int decodeBinResult(const unsigned char *buf, int size, struct binResult *r,
+		    int *view) {
+  const unsigned char *p;
+  int length;
+  int slot;
+  int i;
+
+  if (size < BIN_HEADER_SIZE)
+    return 0;
+  length = (int)getBig(buf, 2) + 2;
+  if (buf[2] != BIN_RESULT || length < BIN_RESULT_HEADER
+      || length > BIN_MAX_RESULT)
+    return -1;
+  if (size < length)
+    return 0;
+  r->op = buf[3];
+  r->outcome = getInt(buf + 4);
+  r->over = buf[8];
+  r->count = (int)getBig(buf + 9, 2);
+  if (length != BIN_RESULT_HEADER + BIN_PAIR_SIZE * r->count)
+    return -1;
+  r->changed = 0;
+  for (i = 0, p = buf + BIN_RESULT_HEADER; i < r->count;
+       i++, p += BIN_PAIR_SIZE) {
+    slot = (int)getBig(p, 2);
+    if (slot >= VIEW_SLOTS)
+      return -1;
+    view[slot] = getInt(p + 2);
+    r->changed++;
+  }
+  return length;
+}
+
+int encodeBinFeed(int type, struct gameState *g, struct gameState *shadow,
+		  unsigned char *buf) {
+  int size;
+
+  if (type == BIN_KEYFRAME)
+    size = encodeKeyframe(g, shadow, buf + BIN_HEADER_SIZE);
+  else
+    size = encodeDelta(g, shadow, buf + BIN_HEADER_SIZE);
+  if (type == BIN_DELTA && size == 2)
+    return 0;
+  putBig(buf, size + 1, 2);
+  buf[2] = (unsigned char)type;
+  return BIN_HEADER_SIZE + size;
+}
+
+void feedView(struct gameState *g, int player, struct gameState *seen) {
+  int i;
+
+  memcpy(seen, g, sizeof(struct gameState));
+  for (i = 0; i < MAX_PLAYERS; i++) {
+    //no one knows the order of a deck, their own included
+    memset(seen->deck[i], 0xff, sizeof(seen->deck[i]));
+    if (i == player)
+      continue;
+    memset(seen->hand[i], 0xff, sizeof(seen->hand[i]));
+    memset(seen->discard[i], 0xff, sizeof(seen->discard[i]));
+  }
+}
+
+int decodeBinFeed(const unsigned char *buf, int size, struct gameState *g) {
+  int length;
+
+  if (size < BIN_HEADER_SIZE)
+    return 0;
+  length = (int)getBig(buf, 2) + 2;
+  if ((buf[2] != BIN_KEYFRAME && buf[2] != BIN_DELTA)
+      || length < BIN_HEADER_SIZE + 2 || length > BIN_MAX_FRAME)
+    return -1;
+  if (size < length)
+    return 0;
+  if (applyDelta(buf + BIN_HEADER_SIZE, length - BIN_HEADER_SIZE, g) < 0)
+    return -1;
+  return length;
+}
+
+int binFrameType(const unsigned char *buf, int size) {
+  return size < BIN_HEADER_SIZE ? 0 : buf[2];
+}
@@ -0,0 +1,123 @@
+/* Binary session protocol
+
+   A compact alternative to the text commands of domserver for bots.
+   Every frame is a 2 byte length (of what follows it), a 1 byte type
+   and the payload, all big-endian.  The client sends MOVE frames, each
+   a session op (see session.h) and four 4 byte arguments, 20 bytes on
+   the wire.  The server answers each with a RESULT: the op, its outcome
+   (4 bytes), whether the session is over (1 byte), a count (2 bytes)
+   and that many (slot, value) pairs of 2 and 4 bytes.  The pairs are
+   the slots of the client's view that changed since the last RESULT.
+   Right after connecting the server sends a RESULT with op SESSION_NONE
+   that carries every slot (as if the client's view were all
+   VIEW_UNKNOWN), so applying each RESULT in turn keeps a copy of the
+   view up to date.
+
+   The view is what the player to move can see: the turn, phase and
+   resources, every player's score and pile sizes, the supply, and the
+   current player's hand.  The seed is left out, since the shuffles
+   follow from it.
+
+   A client that sends SESSION_FEED gets the gameState as well, as the
+   player to move may see it (see feedView): a KEYFRAME frame ahead of
+   that move's RESULT, and from then on a DELTA frame ahead of every
+   RESULT whose move changed anything.  Both carry a body as described
+   in delta.h.
+*/
+
+#ifndef _BINPROTO_H
+#define _BINPROTO_H
+
+#include "dominion.h"
+#include "session.h"
+#include "delta.h"
+#include <limits.h>
+
+#define BIN_DEFAULT_PORT 7364
+#define BIN_HEADER_SIZE 3
+#define BIN_MOVE_SIZE (BIN_HEADER_SIZE + 1 + 4 * 4)
+#define BIN_RESULT_HEADER (BIN_HEADER_SIZE + 1 + 4 + 1 + 2)
+#define BIN_PAIR_SIZE 6
+#define VIEW_UNKNOWN INT_MIN   /* no slot holds it, so it always differs */
+
+enum BIN_FRAME {
+  BIN_MOVE = 1,
+  BIN_RESULT,
+  BIN_KEYFRAME,
+  BIN_DELTA
+};
+
+enum VIEW_SLOT {
+  VIEW_STARTED = 0,
+  VIEW_NUM_PLAYERS,
+  VIEW_WHOSE_TURN,
+  VIEW_TURN,
+  VIEW_PHASE,
+  VIEW_ACTIONS,
+  VIEW_COINS,
+  VIEW_BUYS,
+  VIEW_PLAYED_COUNT,
+  VIEW_SCORE,                                   /* one per player */
+  VIEW_DECK_COUNT = VIEW_SCORE + MAX_PLAYERS,
+  VIEW_DISCARD_COUNT = VIEW_DECK_COUNT + MAX_PLAYERS,
+  VIEW_HAND_COUNT = VIEW_DISCARD_COUNT + MAX_PLAYERS,
+  VIEW_SUPPLY = VIEW_HAND_COUNT + MAX_PLAYERS,  /* one per card */
+  VIEW_HAND = VIEW_SUPPLY + treasure_map + 1,   /* -1 past the hand */
+  VIEW_SLOTS = VIEW_HAND + MAX_HAND
+};
+
+#define BIN_MAX_RESULT (BIN_RESULT_HEADER + BIN_PAIR_SIZE * VIEW_SLOTS)
+#define BIN_MAX_FRAME (BIN_HEADER_SIZE + DELTA_MAX_SIZE)
+
+struct binResult {
+  int op;
+  int outcome;
+  int over;
+  int count;
+  int changed;       /* slots that changed */
+};
+
+int encodeBinMove(struct sessionMove *m, unsigned char *buf);
+/* Returns BIN_MOVE_SIZE */
+
+int decodeBinMove(const unsigned char *buf, int size, struct sessionMove *m);
+/* Returns the bytes used, 0 if buf holds only part of a frame, -1 if it
+   is not a move */
+
+int binMoveAllowed(struct session *s, struct sessionMove *m);
+/* -1 for the debug commands a bot may not use: add, and init once the
+   game has started; the server treats them as protocol errors */
+
+int encodeBinResult(struct sessionMove *m, int over, const int *view,
+		    int *last, unsigned char *buf);
+/* Encodes the slots of view that differ from last, copying them into
+   last; returns the frame size */
+
+int decodeBinResult(const unsigned char *buf, int size, struct binResult *r,
+		    int *view);
+/* Applies the frame to view; returns the bytes used, 0 if buf holds
+   only part of a frame, -1 if it is malformed */
+
+int encodeBinFeed(int type, struct gameState *g, struct gameState *shadow,
+		  unsigned char *buf);
+/* Encodes a KEYFRAME or DELTA frame (see delta.h for the shadow) into
+   BIN_MAX_FRAME bytes; returns the frame size, 0 for a delta with
+   nothing in it */
+
+void feedView(struct gameState *g, int player, struct gameState *seen);
+/* Copies into seen what player may know of g: every count, the supply
+   and the played cards, their own hand and discard.  Every deck, and
+   the other players' hands and discards, read -1 throughout */
+
+int decodeBinFeed(const unsigned char *buf, int size, struct gameState *g);
+/* Applies a KEYFRAME or DELTA frame to g; returns the bytes used, 0 if
+   buf holds only part of a frame, -1 if it is malformed */
+
+int binFrameType(const unsigned char *buf, int size);
+/* The type of the frame at buf, 0 if not known yet */
+
+void sessionView(struct session *s, int *view);
+/* Fills VIEW_SLOTS ints with what the player to move can see; it lives
+   in session.c */
+
+#endif
@@ -0,0 +1,369 @@
+#include "book.h"
+#include "dominion_helpers.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void putWord(unsigned char *p, unsigned int v) {
+  p[0] = v & 0xFF;
+  p[1] = (v >> 8) & 0xFF;
+  p[2] = (v >> 16) & 0xFF;
+  p[3] = (v >> 24) & 0xFF;
+}
+
+static unsigned int getWord(const unsigned char *p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+struct book *createBook(struct strategy *s) {
+  struct book *b = calloc(1, sizeof(struct book));
+
+  if (b == NULL)
+    return NULL;
+  b->table = calloc(BOOK_MIN_SLOTS, BOOK_SLOT_SIZE);
+  if (b->table == NULL) {
+    free(b);
+    return NULL;
+  }
+  b->strategy = *s;
+  b->slots = BOOK_MIN_SLOTS;
+  return b;
+}
+
+void freeBook(struct book *b) {
+  if (b == NULL)
+    return;
+  free(b->table);
+  free(b);
+}
+
+//the slot holding kingdom, or the empty one where it would go
+static unsigned char *findSlot(struct book *b, unsigned int kingdom) {
+  long i = ((kingdom * 2654435761u) & 0xFFFFFFFFu) & (b->slots - 1);
+  unsigned int held;
+
+  for (;;) {
+    held = getWord(&b->table[i * BOOK_SLOT_SIZE]);
+    if (held == kingdom || held == 0)
+      return &b->table[i * BOOK_SLOT_SIZE];
+    i = (i + 1) & (b->slots - 1);
+  }
+}
+
+static void packEntry(struct bookEntry *e, unsigned char *slot) {
+  int s;
+
+  putWord(slot, e->kingdom);
+  for (s = 0; s < BOOK_SPLITS; s++) {
+    slot[4 + 2 * s] = e->buys[s][0] < 0 ? BOOK_NOTHING : e->buys[s][0];
+    slot[5 + 2 * s] = e->buys[s][1] < 0 ? BOOK_NOTHING : e->buys[s][1];
+  }
+}
+
+static void unpackEntry(const unsigned char *slot, struct bookEntry *e) {
+  int s;
+
+  e->kingdom = getWord(slot);
+  for (s = 0; s < BOOK_SPLITS; s++) {
+    e->buys[s][0] = slot[4 + 2 * s] == BOOK_NOTHING ? -1 : slot[4 + 2 * s];
+    e->buys[s][1] = slot[5 + 2 * s] == BOOK_NOTHING ? -1 : slot[5 + 2 * s];
+  }
+}
+
+static int grow(struct book *b) {
+  unsigned char *old = b->table;
+  long oldSlots = b->slots;
+  long i;
+
+  b->table = calloc(oldSlots * 2, BOOK_SLOT_SIZE);
+  if (b->table == NULL) {
+    b->table = old;
+    return -1;
+  }
+  b->slots = oldSlots * 2;
+  for (i = 0; i < oldSlots; i++) {
+    if (getWord(&old[i * BOOK_SLOT_SIZE]) != 0)
+      memcpy(findSlot(b, getWord(&old[i * BOOK_SLOT_SIZE])),
+	     &old[i * BOOK_SLOT_SIZE], BOOK_SLOT_SIZE);
+  }
+  free(old);
+  return 0;
+}
+
+int bookAdd(struct book *b, struct bookEntry *e) {
+  unsigned char *slot;
+
+  if (e->kingdom == 0)
+    return -1;
+  slot = findSlot(b, e->kingdom);
+  if (getWord(slot) == 0) {
+    //keep the table at most half full
+    if (2 * (b->entries + 1) > b->slots) {
+      if (grow(b) < 0)
+	return -1;
+      slot = findSlot(b, e->kingdom);
+    }
+    b->entries++;
+  }
+  packEntry(e, slot);
+  return 0;
+}
+
+int bookFind(struct book *b, unsigned int kingdom, struct bookEntry *e) {
+  unsigned char *slot;
+
+  if (kingdom == 0)
+    return -1;
+  slot = findSlot(b, kingdom);
+  if (getWord(slot) != kingdom)
+    return -1;
+  unpackEntry(slot, e);
+  return 0;
+}
+
+int writeBook(const char *path, struct book *b) {
+  unsigned char header[BOOK_HEADER_SIZE];
+  FILE *f = fopen(path, "wb");
+  int ok;
+
+  if (f == NULL)
+    return -1;
+  memset(header, 0, sizeof(header));
+  memcpy(header, BOOK_MAGIC, 4);
+  putWord(&header[4], (unsigned int)b->slots);
+  putWord(&header[8], (unsigned int)b->entries);
+  header[12] = b->strategy.action < 0 ? BOOK_NOTHING : b->strategy.action;
+  header[13] = b->strategy.copies;
+  ok = fwrite(header, sizeof(header), 1, f) == 1
+    && fwrite(b->table, BOOK_SLOT_SIZE, b->slots, f) == (size_t)b->slots;
+  return fclose(f) == 0 && ok ? 0 : -1;
+}
+
+struct book *readBook(const char *path) {
+  unsigned char header[BOOK_HEADER_SIZE];
+  FILE *f = fopen(path, "rb");
+  struct book *b;
+  long slots;
+
+  if (f == NULL)
+    return NULL;
+  if (fread(header, sizeof(header), 1, f) != 1
+      || memcmp(header, BOOK_MAGIC, 4) != 0) {
+    fclose(f);
+    return NULL;
+  }
+  slots = getWord(&header[4]);
+  b = calloc(1, sizeof(struct book));
+  //a slot count that is not a power of two would break the probing
+  if (b == NULL || slots < BOOK_MIN_SLOTS || (slots & (slots - 1)) != 0
+      || 2 * (long)getWord(&header[8]) > slots
+      || (b->table = malloc(slots * BOOK_SLOT_SIZE)) == NULL
+      || fread(b->table, BOOK_SLOT_SIZE, slots, f) != (size_t)slots) {
+    freeBook(b);
+    fclose(f);
+    return NULL;
+  }
+  fclose(f);
+  b->slots = slots;
+  b->entries = getWord(&header[8]);
+  b->strategy.action = header[12] == BOOK_NOTHING ? -1 : header[12];
+  b->strategy.copies = header[13];
+  return b;
+}
+
+int splitOf(int coins, int *bigger) {
+  int big = coins > 7 - coins ? coins : 7 - coins;
+
+  if (coins < 2 || coins > 5)
+    return -1;
+  *bigger = coins == big;
+  return big == 5 ? SPLIT_5_2 : SPLIT_4_3;
+}
+
+//whether player holds a starting deck plus at most one opening buy, in
+//the buy of the first turn (5 left to draw) or the second (none left)
+static int openingTurn(int player, struct gameState *g) {
+  int *piles[3] = {g->deck[player], g->hand[player], g->discard[player]};
+  int counts[3] = {g->deckCount[player], g->handCount[player],
+		   g->discardCount[player]};
+  int bought = 0;
+  int p, i;
+
+  if (g->numBuys != 1 || g->handCount[player] != 5
+      || !((g->deckCount[player] == 5 && g->discardCount[player] == 0)
+	   || (g->deckCount[player] == 0 && g->discardCount[player] >= 5
+	       && g->discardCount[player] <= 6)))
+    return 0;
+  for (p = 0; p < 3; p++) {
+    for (i = 0; i < counts[p]; i++)
+      bought += piles[p][i] != copper && piles[p][i] != estate;
+  }
+  return bought <= 1;
+}
+
+int bookMove(struct book *b, struct gameState *g, struct mctsMove *m) {
+  struct bookEntry e;
+  unsigned int kingdom = 0;
+  int bigger;
+  int split;
+  int card;
+
+  split = splitOf(g->coins, &bigger);
+  if (split < 0 || !openingTurn(whoseTurn(g), g))
+    return -1;
+  //the kingdom is the kingdom cards the game has piles for
+  for (card = adventurer; card <= treasure_map; card++) {
+    if (g->supplyCount[card] >= 0)
+      kingdom |= 1u << (card - adventurer);
+  }
+  if (bookFind(b, kingdom, &e) < 0)
+    return -1;
+  card = e.buys[split][bigger ? 0 : 1];
+  m->type = card < 0 ? MCTS_END_TURN : MCTS_BUY;
+  m->card = card;
+  return 0;
+}
+
+//deals the opening hands of split to seat, the bigger one first; seat 0
+//already holds its first hand, seat 1 draws it off the top of its deck
+static void forceSplit(int seat, int split, struct gameState *g) {
+  int big = split == SPLIT_5_2 ? 5 : 4;
+  int i;
+
+  if (seat == 0) {
+    for (i = 0; i < 5; i++) {
+      g->hand[0][i] = i < big ? copper : estate;
+      g->deck[0][i] = i < 7 - big ? copper : estate;
+    }
+    updateCoins(0, g, 0);
+  } else {
+    for (i = 0; i < 5; i++) {
+      g->deck[seat][i] = i < 7 - big ? copper : estate;
+      g->deck[seat][5 + i] = i < big ? copper : estate;
+    }
+  }
+}
+
+//an opening card to play when the strategy has nothing of its own
+static int openingPlay(int buys[2], struct gameState *g, struct simMove *m) {
+  int player = whoseTurn(g);
+  int i, pos;
+
+  if (g->numActions < 1)
+    return -1;
+  for (i = 0; i < 2; i++) {
+    if (buys[i] < adventurer)
+      continue;
+    for (pos = 0; pos < g->handCount[player]; pos++) {
+      if (g->hand[player][pos] == buys[i]
+	  && simChoices(buys[i], pos, g, &m->choice1, &m->choice2,
+			&m->choice3) == 0) {
+	m->type = MOVE_PLAY;
+	m->card = buys[i];
+	m->handPos = pos;
+	return 0;
+      }
+    }
+  }
+  return -1;
+}
+
+int playOpening(int kingdom[10], int seed, struct strategy *s, int seat,
+		int split, int buys[2], double *score) {
+  struct gameState *g = malloc(sizeof(struct gameState));
+  int owned[2] = {0, 0};
+  int opened = 0;
+  int turns = 0;
+  struct simMove m;
+  int player;
+  int plays;
+  int us, them;
+
+  if (g == NULL)
+    return -1;
+  memset(g, 0, sizeof(struct gameState));
+  if (seed <= 0 || initializeGame(2, kingdom, seed, g) < 0) {
+    free(g);
+    return -1;
+  }
+  forceSplit(seat, split, g);
+
+  while (!isGameOver(g) && turns < MAX_SIM_TURNS) {
+    player = whoseTurn(g);
+    if (player == seat && opened < 2) {
+      if (buys[opened] >= 0 && buyCard(buys[opened], g) == 0
+	  && buys[opened] == s->action)
+	owned[player]++;
+      opened++;
+    } else {
+      for (plays = 0; plays < MAX_SIM_PLAYS; plays++) {
+	if (simPlayMove(s, g, &m) < 0
+	    && (player != seat || openingPlay(buys, g, &m) < 0))
+	  break;
+	if (applySimMove(&m, g) < 0)
+	  break;
+      }
+      while (simBuyMove(s, owned[player], g, &m) == 0
+	     && applySimMove(&m, g) == 0) {
+	if (m.card == s->action)
+	  owned[player]++;
+      }
+    }
+    endTurn(g);
+    turns++;
+  }
+
+  us = scoreFor(seat, g);
+  them = scoreFor(1 - seat, g);
+  *score = us > them ? 1 : us == them ? 0.5 : 0;
+  free(g);
+  return 0;
+}
+
+struct bookBot {
+  struct bot bot;
+  struct bot *inner;
+  struct book *book;
+  long moves;
+};
+
+static int bookDecide(struct bot *b, struct gameState *g, double deadline,
+		      struct mctsMove *m) {
+  struct bookBot *bb = (struct bookBot *)b;
+  int result = 0;
+
+  if (isGameOver(g))
+    return -1;
+  if (bookMove(bb->book, g, m) == 0)
+    bb->moves++;
+  else
+    result = botDecide(bb->inner, g, deadline, m);
+  b->stats = bb->inner->stats;
+  b->stats.decisions += bb->moves;
+  b->stats.book = bb->moves;
+  return result;
+}
+
+static void bookMoved(struct bot *b, struct mctsMove *m,
+		      struct gameState *after) {
+  botMoved(((struct bookBot *)b)->inner, m, after);
+}
+
+static void bookDestroy(struct bot *b) {
+  botFree(((struct bookBot *)b)->inner);
+  free(b);
+}
+
+struct bot *bookBot(struct bot *inner, struct book *book) {
+  struct bookBot *bb = calloc(1, sizeof(struct bookBot));
+
+  if (bb == NULL)
+    return NULL;
+  bb->bot.decide = bookDecide;
+  bb->bot.moved = bookMoved;
+  bb->bot.destroy = bookDestroy;
+  bb->bot.seat = inner->seat;
+  bb->inner = inner;
+  bb->book = book;
+  return &bb->bot;
+}
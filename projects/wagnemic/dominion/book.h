@@ -0,0 +1,88 @@
+/* Opening books
+
+   Every player starts with 7 coppers and 3 estates and draws them as
+   two hands of 5, so the first two turns have either 5 and 2 coins or
+   4 and 3 (in some order), and nothing else to do but buy.  A book
+   holds, per kingdom, the best pair of opening buys for each split, as
+   found by mkbook: it plays every pair that split allows (silver, any
+   kingdom card that costs no more, or nothing) against the strategy
+   the book is for, with that strategy as the continuation, and keeps
+   the pair that scored best.  The continuation also plays the opening
+   cards when it has no action of its own to play.
+
+   A book file is a 16 byte header ("DOB1", the slot count and entry
+   count as little-endian 32 bit values, the strategy's action card and
+   copies, 2 bytes unused) and a power-of-two number of 8 byte slots:
+   the kingdomMask() (0 for an empty slot, little-endian) and one byte
+   per buy (BOOK_NOTHING for none).  A kingdom's slot is found by
+   hashing its mask and probing linearly from there; the table is never
+   more than half full, so a lookup reads a slot or two.
+*/
+
+#ifndef _BOOK_H
+#define _BOOK_H
+
+#include "dominion.h"
+#include "simulate.h"
+#include "ismcts.h"
+#include "bot.h"
+
+#define BOOK_MAGIC "DOB1"
+#define BOOK_HEADER_SIZE 16
+#define BOOK_SLOT_SIZE 8
+#define BOOK_NOTHING 0xFF
+#define BOOK_MIN_SLOTS 16
+
+enum BOOK_SPLIT {
+  SPLIT_5_2 = 0,
+  SPLIT_4_3,
+  BOOK_SPLITS
+};
+
+struct bookEntry {
+  unsigned int kingdom;          /* kingdomMask() */
+  int buys[BOOK_SPLITS][2];      /* on the bigger hand, then the smaller;
+				    -1 for nothing */
+};
+
+struct book {
+  struct strategy strategy;
+  long slots;
+  long entries;
+  unsigned char *table;
+};
+
+struct book *createBook(struct strategy *s);
+void freeBook(struct book *b);
+
+int bookAdd(struct book *b, struct bookEntry *e);
+/* Adds e, or replaces the kingdom's entry; -1 if memory runs out */
+
+int bookFind(struct book *b, unsigned int kingdom, struct bookEntry *e);
+/* -1 if the kingdom is not in the book */
+
+int writeBook(const char *path, struct book *b);
+struct book *readBook(const char *path);
+/* NULL if the file cannot be read or is not a book */
+
+int bookMove(struct book *b, struct gameState *g, struct mctsMove *m);
+/* The book's buy (MCTS_END_TURN for none) when the player to move is
+   in one of their two opening turns and the kingdom is in the book;
+   -1 otherwise */
+
+int splitOf(int coins, int *bigger);
+/* The split a first or second turn with coins belongs to, and whether
+   this is its bigger hand; -1 if no opening hand has coins */
+
+int playOpening(int kingdom[10], int seed, struct strategy *s, int seat,
+		int split, int buys[2], double *score);
+/* A two player game of s against s, except that the player in seat
+   gets split with the bigger hand first and opens with buys (-1 for
+   nothing); score is 1 if that player won, 0.5 for a tie.  -1 if the
+   game could not be set up */
+
+struct bot *bookBot(struct bot *inner, struct book *b);
+/* A bot that plays the book's openings and otherwise as inner; the
+   book is not its to free, inner is */
+
+#endif
@@ -0,0 +1,290 @@
+#include "bot.h"
+#include "workq.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+
+struct strategyBot {
+  struct bot bot;
+  struct strategy strategy;
+  int bought;               /* copies of the action card */
+};
+
+struct searchBot {
+  struct bot bot;
+  struct mctsTree *tree;
+  struct gameState root;    /* the state the tree searches */
+  int rooted;
+  int ponder;
+  long iterations;          /* the budget with no deadline */
+  int threads;              /* workers started */
+  pthread_t *workers;
+  pthread_mutex_t lock;     /* guards what follows */
+  pthread_cond_t wake;      /* running or quit set */
+  pthread_cond_t idle;      /* busy back to 0 */
+  pthread_cond_t reached;   /* done got to target */
+  int running;
+  int quit;
+  int busy;                 /* workers in an iteration */
+  long done;                /* iterations finished */
+  long target;
+};
+
+double botClock(void) {
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static int legal(struct mctsMove *m, struct gameState *g) {
+  struct mctsMove moves[MCTS_MAX_MOVES];
+  int n = mctsLegalMoves(g, moves);
+  int i;
+
+  for (i = 0; i < n; i++) {
+    if (moves[i].type == m->type && moves[i].card == m->card)
+      return 1;
+  }
+  return 0;
+}
+
+static int strategyDecide(struct bot *b, struct gameState *g, double deadline,
+			  struct mctsMove *m) {
+  struct strategyBot *sb = (struct strategyBot *)b;
+  struct simMove sm;
+
+  if (isGameOver(g))
+    return -1;
+  b->stats.decisions++;
+  if (g->phase == 0) {
+    m->type = MCTS_PLAY;
+    if (simPlayMove(&sb->strategy, g, &sm) == 0) {
+      m->card = sm.card;
+      //ISMCTS will not play the cards the engine mishandles, nor will we
+      if (legal(m, g))
+	return 0;
+    }
+    m->type = MCTS_END_ACTIONS;
+    m->card = -1;
+  } else if (simBuyMove(&sb->strategy, sb->bought, g, &sm) == 0) {
+    m->type = MCTS_BUY;
+    m->card = sm.card;
+  } else {
+    m->type = MCTS_END_TURN;
+    m->card = -1;
+  }
+  return 0;
+}
+
+static void strategyMoved(struct bot *b, struct mctsMove *m,
+			  struct gameState *after) {
+  struct strategyBot *sb = (struct strategyBot *)b;
+
+  //a buy leaves its buyer to move
+  if (m->type == MCTS_BUY && m->card == sb->strategy.action
+      && whoseTurn(after) == b->seat)
+    sb->bought++;
+}
+
+static void strategyFree(struct bot *b) {
+  free(b);
+}
+
+struct bot *strategyBot(struct strategy *s, int seat) {
+  struct strategyBot *sb = calloc(1, sizeof(struct strategyBot));
+
+  if (sb == NULL)
+    return NULL;
+  sb->bot.decide = strategyDecide;
+  sb->bot.moved = strategyMoved;
+  sb->bot.destroy = strategyFree;
+  sb->bot.seat = seat;
+  sb->strategy = *s;
+  return &sb->bot;
+}
+
+static void *work(void *arg) {
+  struct searchBot *sb = arg;
+  struct gameState *scratch = malloc(sizeof(struct gameState));
+
+  pthread_mutex_lock(&sb->lock);
+  while (!sb->quit && scratch != NULL) {
+    if (!sb->running) {
+      pthread_cond_wait(&sb->wake, &sb->lock);
+      continue;
+    }
+    sb->busy++;
+    pthread_mutex_unlock(&sb->lock);
+    mctsTreeIterate(sb->tree, scratch);
+    pthread_mutex_lock(&sb->lock);
+    if (++sb->done == sb->target)
+      pthread_cond_broadcast(&sb->reached);
+    if (--sb->busy == 0)
+      pthread_cond_broadcast(&sb->idle);
+  }
+  pthread_mutex_unlock(&sb->lock);
+  free(scratch);
+  return NULL;
+}
+
+static void resumeWorkers(struct searchBot *sb) {
+  pthread_mutex_lock(&sb->lock);
+  sb->running = 1;
+  pthread_cond_broadcast(&sb->wake);
+  pthread_mutex_unlock(&sb->lock);
+}
+
+//stops the workers and waits out the iterations they are in
+static void pauseWorkers(struct searchBot *sb) {
+  pthread_mutex_lock(&sb->lock);
+  sb->running = 0;
+  while (sb->busy > 0)
+    pthread_cond_wait(&sb->idle, &sb->lock);
+  pthread_mutex_unlock(&sb->lock);
+}
+
+static void waitFor(struct searchBot *sb, double deadline, long need) {
+  struct timespec until;
+
+  pthread_mutex_lock(&sb->lock);
+  if (deadline != BOT_NO_DEADLINE) {
+    until.tv_sec = (time_t)deadline;
+    until.tv_nsec = (long)((deadline - until.tv_sec) * 1e9);
+    sb->target = -1;
+    sb->running = 1;
+    pthread_cond_broadcast(&sb->wake);
+    while (pthread_cond_timedwait(&sb->reached, &sb->lock, &until)
+	   != ETIMEDOUT)
+      ;
+  } else if (need > 0) {
+    sb->target = sb->done + need;
+    sb->running = 1;
+    pthread_cond_broadcast(&sb->wake);
+    while (sb->done < sb->target)
+      pthread_cond_wait(&sb->reached, &sb->lock);
+  }
+  //the iterations under way finish on their own; moved() waits for them
+  if (!sb->ponder)
+    sb->running = 0;
+  pthread_mutex_unlock(&sb->lock);
+}
+
+static int searchDecide(struct bot *b, struct gameState *g, double deadline,
+			struct mctsMove *m) {
+  struct searchBot *sb = (struct searchBot *)b;
+  struct mctsMove moves[MCTS_MAX_MOVES];
+  struct mctsStats stats;
+  int n;
+
+  if (isGameOver(g))
+    return -1;
+  //a state the tree did not follow the game to
+  if (!sb->rooted || memcmp(g, &sb->root, sizeof(struct gameState)) != 0) {
+    pauseWorkers(sb);
+    mctsTreeReset(sb->tree, g, b->seat);
+    memcpy(&sb->root, g, sizeof(struct gameState));
+    sb->rooted = 1;
+  }
+  if (mctsTreeBest(sb->tree, m, &stats) == 0)
+    b->stats.reused += stats.iterations;
+  waitFor(sb, deadline, sb->iterations);
+
+  b->stats.decisions++;
+  if (mctsTreeBest(sb->tree, m, &stats) == 0) {
+    b->stats.iterations += stats.iterations;
+    return 0;
+  }
+  //out of time before any iteration finished: stop playing or end the turn
+  n = mctsLegalMoves(g, moves);
+  *m = moves[n - 1];
+  return 0;
+}
+
+static void searchMoved(struct bot *b, struct mctsMove *m,
+			struct gameState *after) {
+  struct searchBot *sb = (struct searchBot *)b;
+
+  pauseWorkers(sb);
+  if (sb->rooted)
+    mctsTreeAdvance(sb->tree, m, after);
+  else
+    mctsTreeReset(sb->tree, after, b->seat);
+  memcpy(&sb->root, after, sizeof(struct gameState));
+  sb->rooted = 1;
+  if (sb->ponder && !isGameOver(after))
+    resumeWorkers(sb);
+}
+
+static void searchFree(struct bot *b) {
+  struct searchBot *sb = (struct searchBot *)b;
+  int i;
+
+  pthread_mutex_lock(&sb->lock);
+  sb->quit = 1;
+  pthread_cond_broadcast(&sb->wake);
+  pthread_mutex_unlock(&sb->lock);
+  for (i = 0; i < sb->threads; i++)
+    pthread_join(sb->workers[i], NULL);
+  pthread_cond_destroy(&sb->wake);
+  pthread_cond_destroy(&sb->idle);
+  pthread_cond_destroy(&sb->reached);
+  pthread_mutex_destroy(&sb->lock);
+  mctsTreeFree(sb->tree);
+  free(sb->workers);
+  free(sb);
+}
+
+struct bot *searchBot(struct mctsConfig *c, long nodes, int seat, int ponder) {
+  struct searchBot *sb = calloc(1, sizeof(struct searchBot));
+  pthread_condattr_t monotonic;
+  int threads = c->threads > 0 ? c->threads : workqDefaultThreads();
+
+  if (sb == NULL)
+    return NULL;
+  sb->tree = mctsTreeCreate(c, nodes);
+  sb->workers = malloc(threads * sizeof(pthread_t));
+  if (sb->tree == NULL || sb->workers == NULL) {
+    mctsTreeFree(sb->tree);
+    free(sb->workers);
+    free(sb);
+    return NULL;
+  }
+  sb->bot.decide = searchDecide;
+  sb->bot.moved = searchMoved;
+  sb->bot.destroy = searchFree;
+  sb->bot.seat = seat;
+  sb->ponder = ponder;
+  sb->iterations = c->iterations;
+  pthread_mutex_init(&sb->lock, NULL);
+  pthread_condattr_init(&monotonic);
+  pthread_condattr_setclock(&monotonic, CLOCK_MONOTONIC);
+  pthread_cond_init(&sb->wake, NULL);
+  pthread_cond_init(&sb->idle, NULL);
+  pthread_cond_init(&sb->reached, &monotonic);
+  pthread_condattr_destroy(&monotonic);
+
+  for (sb->threads = 0; sb->threads < threads; sb->threads++) {
+    if (pthread_create(&sb->workers[sb->threads], NULL, work, sb) != 0) {
+      searchFree(&sb->bot);
+      return NULL;
+    }
+  }
+  return &sb->bot;
+}
+
+int botDecide(struct bot *b, struct gameState *g, double deadline,
+	      struct mctsMove *m) {
+  return b->decide(b, g, deadline, m);
+}
+
+void botMoved(struct bot *b, struct mctsMove *m, struct gameState *after) {
+  b->moved(b, m, after);
+}
+
+void botFree(struct bot *b) {
+  if (b != NULL)
+    b->destroy(b);
+}
@@ -0,0 +1,66 @@
+/* Anytime players
+
+   A bot is asked for one move at a time (a step of a turn, as in
+   ismcts.h) with decide(state, deadline), where the deadline is a time
+   on botClock(), and must answer by then; a search bot answers with the
+   best move it has found so far.  After every move in the game, whoever
+   made it, the driver calls moved() with the state it led to, so a bot
+   can follow the game without being asked.
+
+   A strategy bot plays one of simulate.c's strategies and answers at
+   once.  A search bot keeps an ISMCTS tree and a pool of threads that
+   run iterations on it whenever it is searching: from the state it is
+   asked about until the deadline, or, with ponder set, all the time,
+   including the opponents' turns, until it is destroyed.  When a move
+   is made it keeps the subtree below that move, so what it worked out
+   while waiting is there when its turn comes.  It searches as its own
+   seat, which need not be the player to move.
+
+   With no deadline (BOT_NO_DEADLINE) a search bot runs the config's
+   iterations, on top of any it kept, before it answers.
+*/
+
+#ifndef _BOT_H
+#define _BOT_H
+
+#include "dominion.h"
+#include "simulate.h"
+#include "ismcts.h"
+
+#define BOT_NO_DEADLINE 0.0
+
+struct botStats {
+  long decisions;
+  long iterations;     /* root visits when deciding, kept ones included */
+  long reused;         /* root visits already there when asked */
+  long endgame;        /* decisions an endgame override made */
+  long book;           /* decisions taken from an opening book */
+};
+
+struct bot {
+  int (*decide)(struct bot *b, struct gameState *g, double deadline,
+		struct mctsMove *m);
+  void (*moved)(struct bot *b, struct mctsMove *m, struct gameState *after);
+  void (*destroy)(struct bot *b);
+  int seat;
+  struct botStats stats;
+};
+
+double botClock(void);
+/* Seconds on a monotonic clock */
+
+struct bot *strategyBot(struct strategy *s, int seat);
+
+struct bot *searchBot(struct mctsConfig *c, long nodes, int seat, int ponder);
+/* Searches a tree of at most nodes nodes on c's threads (0 = one per
+   core); NULL if memory or threads run out */
+
+int botDecide(struct bot *b, struct gameState *g, double deadline,
+	      struct mctsMove *m);
+/* Returns -1 if the game is over */
+
+void botMoved(struct bot *b, struct mctsMove *m, struct gameState *after);
+
+void botFree(struct bot *b);
+
+#endif
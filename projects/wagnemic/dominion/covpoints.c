@@ -0,0 +1,155 @@
+#include "covpoints.h"
+#include "dominion.h"
+#include <string.h>
+#include <pthread.h>
+
+struct coverInfo {
+  const char *name;
+  int card;
+};
+
+//in enum COVER_POINT order
+static const struct coverInfo points[NUM_COVER_POINTS] = {
+  {"drawCard/from deck", -1},
+  {"drawCard/shuffle discard", -1},
+  {"drawCard/nothing to draw", -1},
+  {"buyCard/no buys", -1},
+  {"buyCard/empty pile", -1},
+  {"buyCard/too expensive", -1},
+  {"buyCard/bought", -1},
+  {"gainCard/empty pile", -1},
+  {"gainCard/to deck", -1},
+  {"gainCard/to hand", -1},
+  {"gainCard/to discard", -1},
+  {"adventurer/shuffle", adventurer},
+  {"adventurer/treasure", adventurer},
+  {"adventurer/set aside", adventurer},
+  {"council_room", council_room},
+  {"feast/empty pile", feast},
+  {"feast/too expensive", feast},
+  {"feast/gain", feast},
+  {"gardens", gardens},
+  {"mine/not a treasure", mine},
+  {"mine/bad card", mine},
+  {"mine/too expensive", mine},
+  {"mine/gain", mine},
+  {"remodel/too expensive", remodel},
+  {"remodel/gain", remodel},
+  {"smithy", smithy},
+  {"village", village},
+  {"baron/discard estate", baron},
+  {"baron/no estate", baron},
+  {"baron/gain estate", baron},
+  {"baron/estates gone", baron},
+  {"great_hall", great_hall},
+  {"minion/coins", minion},
+  {"minion/redraw", minion},
+  {"minion/other redraws", minion},
+  {"minion/neither", minion},
+  {"steward/draw", steward},
+  {"steward/coins", steward},
+  {"steward/trash", steward},
+  {"tribute/one from deck", tribute},
+  {"tribute/one from discard", tribute},
+  {"tribute/nothing", tribute},
+  {"tribute/shuffle", tribute},
+  {"tribute/two", tribute},
+  {"tribute/duplicate", tribute},
+  {"tribute/treasure", tribute},
+  {"tribute/victory", tribute},
+  {"tribute/action", tribute},
+  {"ambassador/bad choice", ambassador},
+  {"ambassador/too few copies", ambassador},
+  {"ambassador/return", ambassador},
+  {"cutpurse", cutpurse},
+  {"cutpurse/copper", cutpurse},
+  {"cutpurse/reveal", cutpurse},
+  {"embargo/not in game", embargo},
+  {"embargo/token", embargo},
+  {"outpost", outpost},
+  {"salvager/trash", salvager},
+  {"salvager/no trash", salvager},
+  {"sea_hag", sea_hag},
+  {"treasure_map/pair", treasure_map},
+  {"treasure_map/single", treasure_map},
+  {"cardEffect/not an action", -1}
+};
+
+//one per thread that has passed a point
+struct coverThread {
+  unsigned long *counts;
+  struct coverThread *next;
+};
+
+__thread unsigned long coverCounts[NUM_COVER_POINTS];
+__thread int coverThreadRegistered = 0;
+
+static __thread struct coverThread self;
+static struct coverThread *threads = NULL;
+static unsigned long finished[NUM_COVER_POINTS];
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t once = PTHREAD_ONCE_INIT;
+static pthread_key_t exitKey;
+
+//runs as a thread exits, while its thread-locals are still there
+static void retireThread(void *arg) {
+  struct coverThread *t = arg;
+  struct coverThread **p;
+  int i;
+
+  pthread_mutex_lock(&lock);
+  for (p = &threads; *p != NULL && *p != t; p = &(*p)->next)
+    ;
+  if (*p != NULL)
+    *p = t->next;
+  for (i = 0; i < NUM_COVER_POINTS; i++)
+    finished[i] += t->counts[i];
+  pthread_mutex_unlock(&lock);
+}
+
+static void createKey(void) {
+  pthread_key_create(&exitKey, retireThread);
+}
+
+void coverRegisterThread(void) {
+  pthread_once(&once, createKey);
+  self.counts = coverCounts;
+  pthread_mutex_lock(&lock);
+  self.next = threads;
+  threads = &self;
+  pthread_mutex_unlock(&lock);
+  pthread_setspecific(exitKey, &self);
+  coverThreadRegistered = 1;
+}
+
+void coverSnapshot(unsigned long counts[NUM_COVER_POINTS]) {
+  struct coverThread *t;
+  int i;
+
+  pthread_mutex_lock(&lock);
+  memcpy(counts, finished, sizeof(finished));
+  for (t = threads; t != NULL; t = t->next) {
+    for (i = 0; i < NUM_COVER_POINTS; i++)
+      counts[i] += t->counts[i];
+  }
+  pthread_mutex_unlock(&lock);
+}
+
+void coverReset(void) {
+  pthread_mutex_lock(&lock);
+  memset(finished, 0, sizeof(finished));
+  memset(coverCounts, 0, sizeof(coverCounts));
+  pthread_mutex_unlock(&lock);
+}
+
+const char *coverPointName(int point) {
+  if (point < 0 || point >= NUM_COVER_POINTS)
+    return NULL;
+  return points[point].name;
+}
+
+int coverPointCard(int point) {
+  if (point < 0 || point >= NUM_COVER_POINTS)
+    return -1;
+  return points[point].card;
+}
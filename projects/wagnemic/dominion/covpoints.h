@@ -0,0 +1,109 @@
+/* Named coverage points
+
+   COVER(point) marks a branch of drawCard, buyCard, gainCard or
+   cardEffect.  It costs one increment of a thread-local counter (plus a
+   test of a thread-local flag), so it stays in every build and needs
+   no gcov.  Each thread's counters are registered the first time the
+   thread passes a point and folded into a process total when the
+   thread exits; coverSnapshot adds up the total and every live thread.
+   Counters of other threads are read without locking them, so a
+   snapshot taken while they run may lag by a few hits.  Random testers
+   use the snapshot to see which branches they have not reached yet.
+*/
+
+#ifndef _COVPOINTS_H
+#define _COVPOINTS_H
+
+enum COVER_POINT {
+  COVER_DRAW_DECK = 0,
+  COVER_DRAW_SHUFFLE,
+  COVER_DRAW_EMPTY,
+  COVER_BUY_NO_BUYS,
+  COVER_BUY_EMPTY_PILE,
+  COVER_BUY_TOO_EXPENSIVE,
+  COVER_BUY,
+  COVER_GAIN_EMPTY_PILE,
+  COVER_GAIN_TO_DECK,
+  COVER_GAIN_TO_HAND,
+  COVER_GAIN_TO_DISCARD,
+  COVER_ADVENTURER_SHUFFLE,
+  COVER_ADVENTURER_TREASURE,
+  COVER_ADVENTURER_OTHER,
+  COVER_COUNCIL_ROOM,
+  COVER_FEAST_EMPTY_PILE,
+  COVER_FEAST_TOO_EXPENSIVE,
+  COVER_FEAST_GAIN,
+  COVER_GARDENS,
+  COVER_MINE_NOT_TREASURE,
+  COVER_MINE_BAD_CARD,
+  COVER_MINE_TOO_EXPENSIVE,
+  COVER_MINE_GAIN,
+  COVER_REMODEL_TOO_EXPENSIVE,
+  COVER_REMODEL_GAIN,
+  COVER_SMITHY,
+  COVER_VILLAGE,
+  COVER_BARON_DISCARD_ESTATE,
+  COVER_BARON_NO_ESTATE,
+  COVER_BARON_GAIN_ESTATE,
+  COVER_BARON_ESTATES_GONE,
+  COVER_GREAT_HALL,
+  COVER_MINION_COINS,
+  COVER_MINION_REDRAW,
+  COVER_MINION_OTHER_REDRAWS,
+  COVER_MINION_NEITHER,
+  COVER_STEWARD_DRAW,
+  COVER_STEWARD_COINS,
+  COVER_STEWARD_TRASH,
+  COVER_TRIBUTE_ONE_FROM_DECK,
+  COVER_TRIBUTE_ONE_FROM_DISCARD,
+  COVER_TRIBUTE_NOTHING,
+  COVER_TRIBUTE_SHUFFLE,
+  COVER_TRIBUTE_TWO,
+  COVER_TRIBUTE_DUPLICATE,
+  COVER_TRIBUTE_TREASURE,
+  COVER_TRIBUTE_VICTORY,
+  COVER_TRIBUTE_ACTION,
+  COVER_AMBASSADOR_BAD_CHOICE,
+  COVER_AMBASSADOR_TOO_FEW,
+  COVER_AMBASSADOR_RETURN,
+  COVER_CUTPURSE,
+  COVER_CUTPURSE_COPPER,
+  COVER_CUTPURSE_REVEAL,
+  COVER_EMBARGO_NOT_IN_GAME,
+  COVER_EMBARGO_TOKEN,
+  COVER_OUTPOST,
+  COVER_SALVAGER_TRASH,
+  COVER_SALVAGER_NO_TRASH,
+  COVER_SEA_HAG,
+  COVER_TREASURE_MAP_PAIR,
+  COVER_TREASURE_MAP_SINGLE,
+  COVER_NOT_AN_ACTION,
+  NUM_COVER_POINTS
+};
+
+extern __thread unsigned long coverCounts[NUM_COVER_POINTS];
+extern __thread int coverThreadRegistered;
+
+void coverRegisterThread(void);
+
+#define COVER(point) \
+  do { \
+    if (!coverThreadRegistered) \
+      coverRegisterThread(); \
+    coverCounts[point]++; \
+  } while (0)
+
+void coverSnapshot(unsigned long counts[NUM_COVER_POINTS]);
+/* Hits of every point over all threads so far */
+
+void coverReset(void);
+/* Zeroes the total and the calling thread's counters */
+
+const char *coverPointName(int point);
+/* e.g. "baron/no estate", NULL past the last point */
+
+int coverPointCard(int point);
+/* The card whose branch the point is, -1 for drawCard, buyCard and
+   gainCard */
+
+#endif
@@ -0,0 +1,800 @@
+/* Failure minimizer for state files and simulated games
+
+   Shrinks a failing input while it keeps failing the same way, then
+   writes the result as a stand-alone C test that compiles against
+   dominion.h (a state file's test also links playcheck.o and
+   statefile.o).  A run fails if it crashes, hangs (runs past -t
+   seconds) or leaves a state that breaks checkInvariants (see
+   invariants.h); a state file's call is first checked the way fuzz
+   checks it (see playcheck.h), so every kind of fuzz finding
+   reproduces.  Two failures are the same if they are the same signal,
+   the same finding, or the same first invariant with the numbers taken
+   out.
+
+   A state file (see statefile.h) is reduced by delta debugging each
+   pile, then by simpler card codes, smaller supply and resource counts,
+   zeroed choices and fewer players, until nothing more goes.  With -g
+   the simulator plays that seed until it fails, and the recorded moves
+   are delta debugged, then each move's hand position and choices are
+   simplified.  Every round of candidates runs in forked children, -j at
+   a time, and the first one (in a fixed order) that still fails is
+   kept, so the result does not depend on -j.
+
+   Usage: ddmin [-j jobs] [-t seconds] [-o test.c] reproducer.dst
+          ddmin [-j jobs] [-t seconds] [-o test.c] -g seed [-p players]
+                [-a strategy] [-b strategy] [-k random]
+*/
+
+#include "dominion.h"
+#include "dominion_helpers.h"
+#include "interface.h"
+#include "simulate.h"
+#include "statefile.h"
+#include "playcheck.h"
+#include "invariants.h"
+#include "rngs.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#define MAX_MOVES 16384
+#define MAX_SIGNATURE 128
+#define MAX_JOBS 64
+
+enum MODE {
+  MODE_CASE = 0,
+  MODE_GAME
+};
+
+//the reducible lists of a case: three piles per player, then playedCards
+#define CASE_LISTS (3 * MAX_PLAYERS + 1)
+
+struct input {
+  int mode;
+  struct playCase c;                 /* MODE_CASE */
+  int numPlayers;                    /* MODE_GAME */
+  int kingdom[10];
+  int seed;
+  struct strategy strategies[MAX_PLAYERS];
+  int numMoves;
+  struct simMove moves[MAX_MOVES];
+};
+
+//written by the children, read by the parent
+struct slot {
+  char signature[MAX_SIGNATURE];
+  int numMoves;                      /* recorded moves, recording runs */
+  struct simMove moves[MAX_MOVES];
+};
+
+static const char *cardIdents[] = {
+  "curse", "estate", "duchy", "province", "copper", "silver", "gold",
+  "adventurer", "council_room", "feast", "gardens", "mine", "remodel",
+  "smithy", "village", "baron", "great_hall", "minion", "steward", "tribute",
+  "ambassador", "cutpurse", "embargo", "outpost", "salvager", "sea_hag",
+  "treasure_map"
+};
+
+static struct slot *slots;
+static int jobs = 1;
+static int timeout = 2;
+static long runs = 0;
+
+static int *listOf(struct playCase *c, int list, int **count) {
+  struct gameState *s = &c->state;
+  int p = list / 3;
+
+  if (list == 3 * MAX_PLAYERS) {
+    *count = &s->playedCardCount;
+    return s->playedCards;
+  }
+  switch (list % 3) {
+  case 0:
+    *count = &s->handCount[p];
+    return s->hand[p];
+  case 1:
+    *count = &s->deckCount[p];
+    return s->deck[p];
+  default:
+    *count = &s->discardCount[p];
+    return s->discard[p];
+  }
+}
+
+//the card being played must stay where handPos points
+static int isPlayedCard(struct playCase *c, int list, int i) {
+  return list == 3 * c->state.whoseTurn && i == c->handPos;
+}
+
+static int listLength(struct input *in, int list) {
+  int *count;
+
+  if (in->mode == MODE_GAME)
+    return in->numMoves;
+  listOf(&in->c, list, &count);
+  return *count;
+}
+
+static int removeRange(struct input *in, int list, int from, int to) {
+  int *count;
+  int *cards;
+
+  if (in->mode == MODE_GAME) {
+    memmove(&in->moves[from], &in->moves[to],
+	    (in->numMoves - to) * sizeof(struct simMove));
+    in->numMoves -= to - from;
+    return 0;
+  }
+  cards = listOf(&in->c, list, &count);
+  if (list == 3 * in->c.state.whoseTurn && in->c.handPos >= from) {
+    if (in->c.handPos < to)
+      return -1;
+    in->c.handPos -= to - from;
+  }
+  memmove(&cards[from], &cards[to], (*count - to) * sizeof(int));
+  *count -= to - from;
+  //the slots left behind read as 0, as they would from a state file
+  //and in the written test, or cards that read past a count differ
+  memset(&cards[*count], 0, (to - from) * sizeof(int));
+  return 0;
+}
+
+//a state that ends just before a PROT_NONE page, so overruns fault
+static struct gameState *fencedState(void) {
+  long page = sysconf(_SC_PAGESIZE);
+  long pages = (sizeof(struct gameState) + page - 1) / page;
+  char *p = mmap(NULL, (pages + 2) * page, PROT_READ | PROT_WRITE,
+		 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+  if (p == MAP_FAILED)
+    return NULL;
+  mprotect(p, page, PROT_NONE);
+  mprotect(p + (pages + 1) * page, page, PROT_NONE);
+  return (struct gameState *)(p + (pages + 1) * page
+			      - sizeof(struct gameState));
+}
+
+//the invariant that failed without its numbers
+static void signatureOf(const char *why, char *signature) {
+  int n = 0;
+
+  for (; *why && *why != ';' && n < MAX_SIGNATURE - 1; why++) {
+    if ((*why < '0' || *why > '9') && *why != '-')
+      signature[n++] = *why;
+  }
+  signature[n] = '\0';
+}
+
+static int checkAfter(struct gameState *g, long *total, char *signature) {
+  char why[INVARIANT_TEXT];
+
+  if (checkInvariants(g, *total, why, sizeof(why)) > 0) {
+    signatureOf(why, signature);
+    return -1;
+  }
+  *total = cardTotal(g);
+  return 0;
+}
+
+//fuzz's checks first, so that its findings keep their names
+static void runCase(struct playCase *c, struct gameState *g, char *signature) {
+  static struct playCase post;
+  struct snapshot pre;
+  long total;
+  int bonus = 0;
+  int finding;
+  int r;
+
+  *g = c->state;
+  total = cardTotal(g);
+  finding = takeSnapshot(g, &pre);
+  SelectStream(1);
+  PutSeed(c->seed);
+  if (c->entry == ENTRY_CARD_EFFECT)
+    r = cardEffect(c->card, c->choice1, c->choice2, c->choice3, g,
+		   c->handPos, &bonus);
+  else
+    r = playCard(c->handPos, c->choice1, c->choice2, c->choice3, g);
+  if (finding == FIND_NONE) {
+    finding = checkCall(&pre, g);
+    if (finding == FIND_NONE && r < 0) {
+      post = *c;
+      post.state = *g;
+      finding = checkFailure(c, &post);
+    }
+    if (finding != FIND_NONE) {
+      snprintf(signature, MAX_SIGNATURE, "%s", findingNames[finding]);
+      return;
+    }
+  }
+  checkAfter(g, &total, signature);
+}
+
+static void runMoves(struct input *in, struct gameState *g, char *signature) {
+  long total = -1;
+  int i;
+
+  memset(g, 0, sizeof(struct gameState));
+  if (initializeGame(in->numPlayers, in->kingdom, in->seed, g) < 0
+      || checkAfter(g, &total, signature) < 0)
+    return;
+  total = cardTotal(g);
+  for (i = 0; i < in->numMoves; i++) {
+    applySimMove(&in->moves[i], g);
+    if (checkAfter(g, &total, signature) < 0)
+      return;
+  }
+}
+
+//plays the seed as simulateGame would, recording moves until it fails
+static void recordGame(struct input *in, struct gameState *g,
+		       struct slot *out) {
+  struct strategy *s;
+  struct simMove m;
+  int owned[MAX_PLAYERS];
+  long total = -1;
+  int plays;
+  int turns;
+  int player;
+
+  memset(g, 0, sizeof(struct gameState));
+  memset(owned, 0, sizeof(owned));
+  out->numMoves = 0;
+  if (initializeGame(in->numPlayers, in->kingdom, in->seed, g) < 0
+      || checkAfter(g, &total, out->signature) < 0)
+    return;
+  total = cardTotal(g);
+  for (turns = 0; !isGameOver(g) && turns < MAX_SIM_TURNS; turns++) {
+    player = whoseTurn(g);
+    s = &in->strategies[player];
+    for (plays = 0; plays < MAX_SIM_PLAYS; plays++) {
+      if (simPlayMove(s, g, &m) < 0 || out->numMoves >= MAX_MOVES - 1)
+	break;
+      out->moves[out->numMoves++] = m;
+      if (applySimMove(&m, g) < 0 || checkAfter(g, &total, out->signature) < 0)
+	break;
+    }
+    if (out->signature[0])
+      return;
+    while (out->numMoves < MAX_MOVES - 1) {
+      if (simBuyMove(s, s->action >= 0 ? owned[player] : 0, g, &m) < 0)
+	break;
+      out->moves[out->numMoves++] = m;
+      if (applySimMove(&m, g) < 0)
+	break;
+      if (checkAfter(g, &total, out->signature) < 0)
+	return;
+      if (m.card == s->action)
+	owned[player]++;
+    }
+    memset(&m, 0, sizeof(m));
+    m.type = MOVE_END;
+    out->moves[out->numMoves++] = m;
+    endTurn(g);
+    if (checkAfter(g, &total, out->signature) < 0 || out->numMoves >= MAX_MOVES)
+      return;
+  }
+}
+
+static pid_t spawn(struct input *in, int slot, int record) {
+  struct gameState *g;
+  pid_t pid;
+
+  fflush(stdout);
+  pid = fork();
+
+  if (pid != 0)
+    return pid;
+  //some card effects print; keep it out of the report
+  freopen("/dev/null", "w", stdout);
+  alarm(timeout);
+  g = fencedState();
+  if (g == NULL)
+    _exit(2);
+  if (record)
+    recordGame(in, g, &slots[slot]);
+  else if (in->mode == MODE_CASE)
+    runCase(&in->c, g, slots[slot].signature);
+  else
+    runMoves(in, g, slots[slot].signature);
+  _exit(0);
+}
+
+static void outcome(int status, int slot, char *signature) {
+  if (WIFSIGNALED(status) && WTERMSIG(status) == SIGALRM)
+    snprintf(signature, MAX_SIGNATURE, "hang");
+  else if (WIFSIGNALED(status))
+    snprintf(signature, MAX_SIGNATURE, "signal %d", WTERMSIG(status));
+  else
+    snprintf(signature, MAX_SIGNATURE, "%s", slots[slot].signature);
+}
+
+//runs the candidates, jobs at a time; the lowest one failing like target
+static int firstFailing(struct input **cands, int n, const char *target) {
+  char signature[MAX_SIGNATURE];
+  pid_t pids[MAX_JOBS];
+  int status;
+  int next;
+  int found = -1;
+  int base;
+  int i;
+
+  for (base = 0; base < n && found < 0; base += jobs) {
+    for (i = 0; i < jobs && base + i < n; i++) {
+      slots[i].signature[0] = '\0';
+      pids[i] = spawn(cands[base + i], i, 0);
+      runs++;
+    }
+    next = i;
+    for (i = 0; i < next; i++) {
+      if (pids[i] < 0 || waitpid(pids[i], &status, 0) < 0)
+	continue;
+      outcome(status, i, signature);
+      if (found < 0 && strcmp(signature, target) == 0)
+	found = base + i;
+    }
+  }
+  return found;
+}
+
+static struct input **allocCandidates(int n) {
+  struct input **cands = malloc(n * sizeof(struct input *));
+  int i;
+
+  for (i = 0; cands != NULL && i < n; i++) {
+    cands[i] = malloc(sizeof(struct input));
+    if (cands[i] == NULL)
+      return NULL;
+  }
+  return cands;
+}
+
+static struct input **cands;
+static int numCands;
+
+//copies the input into candidate i, growing the pool if needed
+static struct input *candidate(struct input *best, int i) {
+  struct input **more;
+
+  if (i >= numCands) {
+    more = allocCandidates(numCands + jobs);
+    if (more == NULL) {
+      perror("malloc");
+      exit(2);
+    }
+    memcpy(more, cands, numCands * sizeof(struct input *));
+    free(cands);
+    cands = more;
+    numCands += jobs;
+  }
+  memcpy(cands[i], best, sizeof(struct input));
+  return cands[i];
+}
+
+//ddmin on one list: drop chunks while the failure holds
+static int reduceList(struct input *best, int list, const char *target) {
+  int chunks = 2;
+  int reduced = 0;
+  int length;
+  int size;
+  int n;
+  int i;
+  int found;
+
+  while ((length = listLength(best, list)) >= 1) {
+    if (chunks > length)
+      chunks = length;
+    size = (length + chunks - 1) / chunks;
+    n = 0;
+    for (i = 0; i < length; i += size) {
+      if (removeRange(candidate(best, n), list, i,
+		      i + size < length ? i + size : length) == 0)
+	n++;
+    }
+    found = firstFailing(cands, n, target);
+    if (found >= 0) {
+      memcpy(best, cands[found], sizeof(struct input));
+      chunks = chunks > 2 ? chunks - 1 : 2;
+      reduced = 1;
+    } else if (chunks < length) {
+      chunks = chunks * 2 < length ? chunks * 2 : length;
+    } else {
+      break;
+    }
+  }
+  return reduced;
+}
+
+static int simplerValue(int v, int step) {
+  switch (step) {
+  case 0: return 0;
+  case 1: return v / 2;
+  default: return v > 0 ? v - 1 : v + 1;
+  }
+}
+
+/* The single-field edits, numbered so they can be tried in order.
+   Returns -1 if edit e does not change the input. */
+static int applyEdit(struct input *in, int e) {
+  static const int simple[] = {curse, estate, copper};
+  struct gameState *s = &in->c.state;
+  int *count;
+  int *cards;
+  int *field;
+  int list;
+  int v;
+
+  if (in->mode == MODE_GAME) {
+    struct simMove *m = &in->moves[e / 4 % MAX_MOVES];
+    int *args[] = {&m->handPos, &m->choice1, &m->choice2, &m->choice3};
+
+    if (e / 4 >= in->numMoves || m->type != MOVE_PLAY || *args[e % 4] == 0)
+      return -1;
+    *args[e % 4] = 0;
+    return 0;
+  }
+
+  //one card to curse, estate or copper
+  if (e < CASE_LISTS * MAX_DECK * 3) {
+    list = e / (MAX_DECK * 3);
+    cards = listOf(&in->c, list, &count);
+    v = e / 3 % MAX_DECK;
+    if (v >= *count || isPlayedCard(&in->c, list, v)
+	|| cards[v] <= simple[e % 3])
+      return -1;
+    cards[v] = simple[e % 3];
+    return 0;
+  }
+  e -= CASE_LISTS * MAX_DECK * 3;
+
+  //supply and embargo counts, resources and choices toward zero
+  if (e < (treasure_map + 1) * 2 * 3) {
+    field = e / 3 % 2 ? &s->embargoTokens[e / 6] : &s->supplyCount[e / 6];
+  } else {
+    e -= (treasure_map + 1) * 2 * 3;
+    switch (e / 3) {
+    case 0: field = &s->coins; break;
+    case 1: field = &s->numActions; break;
+    case 2: field = &s->numBuys; break;
+    case 3: field = &s->outpostPlayed; break;
+    case 4: field = &s->outpostTurn; break;
+    case 5: field = &in->c.choice1; break;
+    case 6: field = &in->c.choice2; break;
+    case 7: field = &in->c.choice3; break;
+    case 8:
+      //drop the last player if it is not the one playing
+      if (e % 3 != 0 || s->numPlayers <= 2
+	  || s->whoseTurn >= s->numPlayers - 1)
+	return -1;
+      s->numPlayers--;
+      s->handCount[s->numPlayers] = 0;
+      s->deckCount[s->numPlayers] = 0;
+      s->discardCount[s->numPlayers] = 0;
+      memset(s->hand[s->numPlayers], 0, sizeof(s->hand[0]));
+      memset(s->deck[s->numPlayers], 0, sizeof(s->deck[0]));
+      memset(s->discard[s->numPlayers], 0, sizeof(s->discard[0]));
+      return 0;
+    default:
+      return -1;
+    }
+  }
+  //cards not in the game stay at -1
+  if (*field <= 0 || (v = simplerValue(*field, e % 3)) == *field)
+    return -1;
+  *field = v;
+  return 0;
+}
+
+static int numEdits(struct input *in) {
+  if (in->mode == MODE_GAME)
+    return in->numMoves * 4;
+  return CASE_LISTS * MAX_DECK * 3 + (treasure_map + 1) * 2 * 3 + 9 * 3;
+}
+
+//tries the edits in order, keeping each one that still fails
+static int reduceFields(struct input *best, const char *target) {
+  int reduced = 0;
+  int e = 0;
+  int n;
+  int found;
+  int edit[MAX_JOBS];
+
+  while (e < numEdits(best)) {
+    n = 0;
+    for (; e < numEdits(best) && n < jobs; e++) {
+      if (applyEdit(candidate(best, n), e) == 0)
+	edit[n++] = e;
+    }
+    if (n == 0)
+      continue;
+    found = firstFailing(cands, n, target);
+    if (found >= 0) {
+      memcpy(best, cands[found], sizeof(struct input));
+      e = edit[found];   //the same edit may go further, e.g. halving
+      reduced = 1;
+    }
+  }
+  return reduced;
+}
+
+static void minimize(struct input *best, const char *target) {
+  int reduced = 1;
+  int list;
+
+  while (reduced) {
+    reduced = 0;
+    if (best->mode == MODE_GAME) {
+      reduced |= reduceList(best, 0, target);
+    } else {
+      for (list = 0; list < CASE_LISTS; list++)
+	reduced |= reduceList(best, list, target);
+    }
+    reduced |= reduceFields(best, target);
+  }
+}
+
+static void writePile(FILE *f, const char *name, int p, int *cards,
+		      int count) {
+  int i;
+
+  if (count == 0)
+    return;
+  if (p >= 0)
+    fprintf(f, "  G.%sCount[%d] = %d;\n", name, p, count);
+  else
+    fprintf(f, "  G.playedCardCount = %d;\n", count);
+  for (i = 0; i < count; i++) {
+    if (p >= 0)
+      fprintf(f, "  G.%s[%d][%d] = %s;\n", name, p, i, cardIdents[cards[i]]);
+    else
+      fprintf(f, "  G.%s[%d] = %s;\n", name, i, cardIdents[cards[i]]);
+  }
+}
+
+static void writeScalar(FILE *f, const char *name, int v) {
+  if (v != 0)
+    fprintf(f, "  G.%s = %d;\n", name, v);
+}
+
+static void writeMove(FILE *f, struct simMove *m) {
+  switch (m->type) {
+  case MOVE_PLAY:
+    fprintf(f, "  playCard(%d, %d, %d, %d, &G);\n", m->handPos, m->choice1,
+	    m->choice2, m->choice3);
+    break;
+  case MOVE_BUY:
+    fprintf(f, "  buyCard(%s, &G);\n", cardIdents[m->card]);
+    break;
+  default:
+    fprintf(f, "  endTurn(&G);\n");
+    break;
+  }
+  fprintf(f, "  checkState(&G, &total);\n");
+}
+
+static int writeTest(const char *path, const char *from, struct input *in,
+		     const char *signature) {
+  FILE *f = fopen(path, "w");
+  struct gameState *s = &in->c.state;
+  char name[64];
+  int p;
+  int i;
+
+  if (f == NULL)
+    return -1;
+  fprintf(f,
+	  "/* Minimized by ddmin from %s\n"
+	  "   Fails with: %s */\n\n"
+	  "#include \"dominion.h\"\n"
+	  "#include \"dominion_helpers.h\"\n"
+	  "#include \"rngs.h\"\n"
+	  "%s"
+	  "#include <stdio.h>\n"
+	  "#include <string.h>\n"
+	  "#include <assert.h>\n\n"
+	  "static int validCard(int card) {\n"
+	  "  return card >= curse && card <= treasure_map;\n"
+	  "}\n\n"
+	  "static int checkPile(int *cards, int count, int max) {\n"
+	  "  int i;\n\n"
+	  "  assert(count >= 0 && count <= max);\n"
+	  "  for (i = 0; i < count; i++)\n"
+	  "    assert(validCard(cards[i]));\n"
+	  "  return count;\n"
+	  "}\n\n"
+	  "//pile counts, card codes and no cards out of nowhere\n"
+	  "static void checkState(struct gameState *s, int *total) {\n"
+	  "  int n = 0;\n"
+	  "  int p;\n"
+	  "  int i;\n\n"
+	  "  assert(s->numPlayers >= 2 && s->numPlayers <= MAX_PLAYERS);\n"
+	  "  assert(s->whoseTurn >= 0 && s->whoseTurn < s->numPlayers);\n"
+	  "  for (i = curse; i <= treasure_map; i++) {\n"
+	  "    assert(s->supplyCount[i] >= -1);\n"
+	  "    if (s->supplyCount[i] > 0)\n"
+	  "      n += s->supplyCount[i];\n"
+	  "  }\n"
+	  "  for (p = 0; p < s->numPlayers; p++) {\n"
+	  "    n += checkPile(s->hand[p], s->handCount[p], MAX_HAND);\n"
+	  "    n += checkPile(s->deck[p], s->deckCount[p], MAX_DECK);\n"
+	  "    n += checkPile(s->discard[p], s->discardCount[p], MAX_DECK);\n"
+	  "  }\n"
+	  "  n += checkPile(s->playedCards, s->playedCardCount, MAX_DECK);\n"
+	  "  assert(*total < 0 || n <= *total);\n"
+	  "  *total = n;\n"
+	  "}\n\n"
+	  "int main () {\n"
+	  "  static struct gameState G;\n"
+	  "  int total = -1;\n",
+	  from, signature,
+	  in->mode == MODE_CASE ? "#include \"playcheck.h\"\n" : "");
+
+  if (in->mode == MODE_GAME) {
+    fprintf(f, "  int k[10] = {");
+    for (i = 0; i < 10; i++)
+      fprintf(f, "%s%s", i ? ", " : "", cardIdents[in->kingdom[i]]);
+    fprintf(f, "};\n\n  memset(&G, 0, sizeof(G));\n"
+	    "  assert(initializeGame(%d, k, %d, &G) == 0);\n"
+	    "  checkState(&G, &total);\n", in->numPlayers, in->seed);
+    for (i = 0; i < in->numMoves; i++)
+      writeMove(f, &in->moves[i]);
+  } else {
+    fprintf(f, "  static struct playCase pre;\n"
+	    "  static struct playCase post;\n"
+	    "  struct snapshot snap;\n"
+	    "  int bonus = 0;\n"
+	    "  int r;\n\n  memset(&G, 0, sizeof(G));\n");
+    writeScalar(f, "numPlayers", s->numPlayers);
+    for (i = curse; i <= treasure_map; i++) {
+      snprintf(name, sizeof(name), "supplyCount[%s]", cardIdents[i]);
+      writeScalar(f, name, s->supplyCount[i]);
+      snprintf(name, sizeof(name), "embargoTokens[%s]", cardIdents[i]);
+      writeScalar(f, name, s->embargoTokens[i]);
+    }
+    writeScalar(f, "outpostPlayed", s->outpostPlayed);
+    writeScalar(f, "outpostTurn", s->outpostTurn);
+    writeScalar(f, "whoseTurn", s->whoseTurn);
+    writeScalar(f, "phase", s->phase);
+    writeScalar(f, "numActions", s->numActions);
+    writeScalar(f, "coins", s->coins);
+    writeScalar(f, "numBuys", s->numBuys);
+    for (p = 0; p < s->numPlayers && p < MAX_PLAYERS; p++) {
+      writePile(f, "hand", p, s->hand[p], s->handCount[p]);
+      writePile(f, "deck", p, s->deck[p], s->deckCount[p]);
+      writePile(f, "discard", p, s->discard[p], s->discardCount[p]);
+    }
+    writePile(f, "playedCards", -1, s->playedCards, s->playedCardCount);
+    fprintf(f, "  checkState(&G, &total);\n"
+	    "  pre.state = G;\n"
+	    "  assert(takeSnapshot(&G, &snap) == FIND_NONE);\n\n"
+	    "  SelectStream(1);\n  PutSeed(%d);\n", in->c.seed);
+    if (in->c.entry == ENTRY_CARD_EFFECT)
+      fprintf(f, "  r = cardEffect(%s, %d, %d, %d, &G, %d, &bonus);\n",
+	      cardIdents[in->c.card], in->c.choice1, in->c.choice2,
+	      in->c.choice3, in->c.handPos);
+    else
+      fprintf(f, "  r = playCard(%d, %d, %d, %d, &G);\n", in->c.handPos,
+	      in->c.choice1, in->c.choice2, in->c.choice3);
+    fprintf(f, "  post.state = G;\n"
+	    "  assert(checkCall(&snap, &G) == FIND_NONE);\n"
+	    "  assert(r >= 0 || checkFailure(&pre, &post) == FIND_NONE);\n"
+	    "  checkState(&G, &total);\n");
+  }
+  fprintf(f, "\n  printf (\"ALL TESTS OK\\n\");\n  return 0;\n}\n");
+  return fclose(f);
+}
+
+static int size(struct input *in) {
+  int n = 0;
+  int list;
+
+  if (in->mode == MODE_GAME)
+    return in->numMoves;
+  for (list = 0; list < CASE_LISTS; list++)
+    n += listLength(in, list);
+  return n;
+}
+
+static void usage(void) {
+  printf("Usage: ddmin [-j jobs] [-t seconds] [-o test.c] reproducer.dst\n"
+	 "       ddmin [-j jobs] [-t seconds] [-o test.c] -g seed [-p players]\n"
+	 "             [-a strategy] [-b strategy] [-k random]\n");
+}
+
+int main(int argc, char **argv) {
+  static struct input best;
+  struct strategy a;
+  struct strategy other;
+  char target[MAX_SIGNATURE];
+  char from[64];
+  const char *outPath = "minimized.c";
+  int randomKingdom = 0;
+  int status;
+  int opt;
+  int before;
+  int i;
+  int k[10] = {adventurer, gardens, embargo, village, minion, mine, cutpurse,
+	       sea_hag, tribute, smithy};
+
+  best.mode = MODE_CASE;
+  best.numPlayers = 2;
+  parseStrategy("smithy", &a);
+  parseStrategy("adventurer", &other);
+  jobs = sysconf(_SC_NPROCESSORS_ONLN);
+  while ((opt = getopt(argc, argv, "j:t:o:g:p:a:b:k:")) != -1) {
+    switch (opt) {
+    case 'j': jobs = atoi(optarg); break;
+    case 't': timeout = atoi(optarg); break;
+    case 'o': outPath = optarg; break;
+    case 'g': best.mode = MODE_GAME; best.seed = atoi(optarg); break;
+    case 'p': best.numPlayers = atoi(optarg); break;
+    case 'a':
+    case 'b':
+      if (parseStrategy(optarg, opt == 'a' ? &a : &other) < 0) {
+	printf("Unknown strategy %s\n", optarg);
+	return 2;
+      }
+      break;
+    case 'k': randomKingdom = strcmp(optarg, "random") == 0; break;
+    default: usage(); return 2;
+    }
+  }
+  if (jobs > MAX_JOBS)
+    jobs = MAX_JOBS;
+  if (jobs < 1 || timeout < 1
+      || (best.mode == MODE_CASE && optind != argc - 1)
+      || (best.mode == MODE_GAME && (best.seed < 1 || best.numPlayers < 2
+				     || best.numPlayers > MAX_PLAYERS))) {
+    usage();
+    return 2;
+  }
+  slots = mmap(NULL, MAX_JOBS * sizeof(struct slot), PROT_READ | PROT_WRITE,
+	       MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (slots == MAP_FAILED)
+    return 2;
+
+  if (best.mode == MODE_CASE) {
+    if (readStateFile(argv[optind], &best.c) < 0) {
+      printf("Could not read %s\n", argv[optind]);
+      return 2;
+    }
+    snprintf(from, sizeof(from), "%s", argv[optind]);
+  } else {
+    memcpy(best.kingdom, k, sizeof(k));
+    if (randomKingdom)
+      selectKingdomCards(best.seed, best.kingdom);
+    best.strategies[0] = a;
+    for (i = 1; i < MAX_PLAYERS; i++)
+      best.strategies[i] = other;
+    snprintf(from, sizeof(from), "seed %d", best.seed);
+    //record the moves up to the failure
+    slots[0].signature[0] = '\0';
+    waitpid(spawn(&best, 0, 1), &status, 0);
+    best.numMoves = slots[0].numMoves;
+    memcpy(best.moves, slots[0].moves, best.numMoves * sizeof(struct simMove));
+  }
+
+  slots[0].signature[0] = '\0';
+  waitpid(spawn(&best, 0, 0), &status, 0);
+  outcome(status, 0, target);
+  if (target[0] == '\0') {
+    printf("%s does not fail\n", from);
+    return 1;
+  }
+  printf("Fails with: %s\n", target);
+
+  before = size(&best);
+  minimize(&best, target);
+  printf("Reduced %d %s to %d in %ld runs\n", before,
+	 best.mode == MODE_GAME ? "moves" : "cards", size(&best), runs);
+  if (writeTest(outPath, from, &best, target) < 0) {
+    printf("Could not write %s\n", outPath);
+    return 2;
+  }
+  printf("Wrote %s\n", outPath);
+  return 0;
+}
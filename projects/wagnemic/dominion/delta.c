@@ -0,0 +1,222 @@
+#include "delta.h"
+#include "statediff.h"
+#include <string.h>
+
+#define NUM_SCALARS 8
+
+//scalar fields in record order, with where they live
+static int *scalarOf(struct gameState *g, int field) {
+  switch (field) {
+  case FIELD_NUM_PLAYERS: return &g->numPlayers;
+  case FIELD_OUTPOST_PLAYED: return &g->outpostPlayed;
+  case FIELD_OUTPOST_TURN: return &g->outpostTurn;
+  case FIELD_WHOSE_TURN: return &g->whoseTurn;
+  case FIELD_PHASE: return &g->phase;
+  case FIELD_NUM_ACTIONS: return &g->numActions;
+  case FIELD_COINS: return &g->coins;
+  case FIELD_NUM_BUYS: return &g->numBuys;
+  default: return NULL;
+  }
+}
+
+static const int scalars[NUM_SCALARS] = {
+  FIELD_NUM_PLAYERS, FIELD_OUTPOST_PLAYED, FIELD_OUTPOST_TURN,
+  FIELD_WHOSE_TURN, FIELD_PHASE, FIELD_NUM_ACTIONS, FIELD_COINS,
+  FIELD_NUM_BUYS
+};
+
+static int *pileOf(struct gameState *g, int field, int p, int **count) {
+  switch (field) {
+  case FIELD_HAND:
+    *count = &g->handCount[p];
+    return g->hand[p];
+  case FIELD_DECK:
+    *count = &g->deckCount[p];
+    return g->deck[p];
+  case FIELD_DISCARD:
+    *count = &g->discardCount[p];
+    return g->discard[p];
+  default:
+    *count = &g->playedCardCount;
+    return g->playedCards;
+  }
+}
+
+static int boundOf(int field, int count) {
+  int bound = field == FIELD_HAND ? MAX_HAND : MAX_DECK;
+
+  return count < 0 ? 0 : count > bound ? bound : count;
+}
+
+static void putBig(unsigned char *p, unsigned long v, int bytes) {
+  int i;
+
+  for (i = bytes - 1; i >= 0; i--) {
+    p[i] = (unsigned char)(v & 0xff);
+    v >>= 8;
+  }
+}
+
+static unsigned long getBig(const unsigned char *p, int bytes) {
+  unsigned long v = 0;
+  int i;
+
+  for (i = 0; i < bytes; i++)
+    v = (v << 8) | p[i];
+  return v;
+}
+
+static unsigned char *putValue(unsigned char *p, int field, int index,
+			       int value) {
+  p[0] = DELTA_VALUE;
+  p[1] = field;
+  p[2] = index;
+  putBig(p + 3, (unsigned int)value, 4);
+  return p + DELTA_RECORD_HEADER + 4;
+}
+
+//splices the pile into the shadow if it differs; all sends it whole
+static unsigned char *putPile(unsigned char *p, struct gameState *g,
+			      struct gameState *shadow, int field, int player,
+			      int all, int *records) {
+  int *count;
+  int *oldCount;
+  int *cards = pileOf(g, field, player, &count);
+  int *old = pileOf(shadow, field, player, &oldCount);
+  int n = boundOf(field, *count);
+  int keep = 0;
+  int wide = 0;
+  int i;
+
+  if (!all) {
+    i = boundOf(field, *oldCount);
+    while (keep < n && keep < i && cards[keep] == old[keep])
+      keep++;
+    if (keep == n && *count == *oldCount)
+      return p;
+  }
+  for (i = keep; i < n; i++) {
+    if (cards[i] < 0 || cards[i] > 254)
+      wide = 1;
+  }
+  p[0] = wide ? DELTA_PILE_WIDE : DELTA_PILE;
+  p[1] = field;
+  p[2] = player;
+  putBig(p + 3, keep, 2);
+  putBig(p + 5, (unsigned int)*count, 2);
+  p += DELTA_PILE_HEADER;
+  for (i = keep; i < n; i++) {
+    if (wide) {
+      putBig(p, (unsigned int)cards[i], 4);
+      p += 4;
+    } else
+      *p++ = (unsigned char)cards[i];
+  }
+  memcpy(old + keep, cards + keep, (n - keep) * sizeof(int));
+  *oldCount = *count;
+  (*records)++;
+  return p;
+}
+
+static int encode(struct gameState *g, struct gameState *shadow,
+		  unsigned char *buf, int all) {
+  static const int piles[3] = {FIELD_HAND, FIELD_DECK, FIELD_DISCARD};
+  unsigned char *p = buf + 2;
+  int records = 0;
+  int *value;
+  int i;
+  int k;
+
+  for (i = 0; i < NUM_SCALARS; i++) {
+    value = scalarOf(g, scalars[i]);
+    if (all || *value != *scalarOf(shadow, scalars[i])) {
+      p = putValue(p, scalars[i], 0, *value);
+      *scalarOf(shadow, scalars[i]) = *value;
+      records++;
+    }
+  }
+  for (i = 0; i <= treasure_map; i++) {
+    if (all || g->supplyCount[i] != shadow->supplyCount[i]) {
+      p = putValue(p, FIELD_SUPPLY_COUNT, i, g->supplyCount[i]);
+      shadow->supplyCount[i] = g->supplyCount[i];
+      records++;
+    }
+    if (all || g->embargoTokens[i] != shadow->embargoTokens[i]) {
+      p = putValue(p, FIELD_EMBARGO_TOKENS, i, g->embargoTokens[i]);
+      shadow->embargoTokens[i] = g->embargoTokens[i];
+      records++;
+    }
+  }
+  for (i = 0; i < MAX_PLAYERS; i++) {
+    for (k = 0; k < 3; k++)
+      p = putPile(p, g, shadow, piles[k], i, all, &records);
+  }
+  p = putPile(p, g, shadow, FIELD_PLAYED_CARDS, 0, all, &records);
+  putBig(buf, records, 2);
+  return p - buf;
+}
+
+int encodeKeyframe(struct gameState *g, struct gameState *shadow,
+		   unsigned char *buf) {
+  return encode(g, shadow, buf, 1);
+}
+
+int encodeDelta(struct gameState *g, struct gameState *shadow,
+		unsigned char *buf) {
+  return encode(g, shadow, buf, 0);
+}
+
+int applyDelta(const unsigned char *buf, int size, struct gameState *g) {
+  const unsigned char *p = buf + 2;
+  const unsigned char *end = buf + size;
+  int records;
+  int field;
+  int keep;
+  int count;
+  int width;
+  int *cards;
+  int *pileCount;
+  int *value;
+  int r;
+  int i;
+
+  if (size < 2)
+    return -1;
+  records = (int)getBig(buf, 2);
+  for (r = 0; r < records; r++) {
+    if (end - p < DELTA_RECORD_HEADER)
+      return -1;
+    if (p[0] == DELTA_VALUE) {
+      if (end - p < DELTA_RECORD_HEADER + 4 || p[2] > treasure_map)
+	return -1;
+      if (p[1] == FIELD_SUPPLY_COUNT)
+	value = &g->supplyCount[p[2]];
+      else if (p[1] == FIELD_EMBARGO_TOKENS)
+	value = &g->embargoTokens[p[2]];
+      else if ((value = scalarOf(g, p[1])) == NULL)
+	return -1;
+      *value = (int)(unsigned int)getBig(p + 3, 4);
+      p += DELTA_RECORD_HEADER + 4;
+      continue;
+    }
+    if ((p[0] != DELTA_PILE && p[0] != DELTA_PILE_WIDE)
+	|| end - p < DELTA_PILE_HEADER || p[2] >= MAX_PLAYERS
+	|| p[1] < FIELD_HAND || p[1] > FIELD_PLAYED_CARDS)
+      return -1;
+    width = p[0] == DELTA_PILE ? 1 : 4;
+    field = p[1];
+    cards = pileOf(g, field, p[2], &pileCount);
+    keep = (int)getBig(p + 3, 2);
+    count = (short)getBig(p + 5, 2);
+    if (keep > boundOf(field, count)
+	|| end - p < DELTA_PILE_HEADER + width * (boundOf(field, count) - keep))
+      return -1;
+    p += DELTA_PILE_HEADER;
+    for (i = keep; i < boundOf(field, count); i++) {
+      cards[i] = width == 1 ? *p : (int)(unsigned int)getBig(p, 4);
+      p += width;
+    }
+    *pileCount = count;
+  }
+  return p == end ? records : -1;
+}
@@ -0,0 +1,59 @@
+/* State deltas
+
+   Streams a gameState to a receiver that rebuilds it from a keyframe
+   followed by deltas.  The sender keeps a shadow: the state as the
+   receiver has it.  A delta is the list of what differs from the
+   shadow, after which the shadow is brought up to date, so a delta can
+   be taken after every API call or after several.
+
+   Scalars, supply and embargo counts go out as DELTA_VALUE records.  A
+   pile goes out as a splice: how many cards from its bottom are
+   unchanged, its new count and the cards above that, so a draw sends
+   one card into the hand and a shortened deck, and only a shuffle
+   sends a whole deck.  Cards fit a byte (DELTA_PILE) unless a pile
+   holds something else (DELTA_PILE_WIDE, 4 bytes each).  Finding the
+   changes costs a look at each pile up to its count, never at the
+   unused rest of the arrays, so it follows the number of cards in play
+   and not the size of gameState.  Field and index numbers are those of
+   statediff.h; multi-byte numbers are big-endian.
+
+   Body: 2 byte record count, then each record as a 1 byte kind, 1 byte
+   field, 1 byte index (card or player) and
+     DELTA_VALUE      4 byte value
+     DELTA_PILE       2 byte kept, 2 byte count, 1 byte per new card
+     DELTA_PILE_WIDE  2 byte kept, 2 byte count, 4 bytes per new card
+*/
+
+#ifndef _DELTA_H
+#define _DELTA_H
+
+#include "dominion.h"
+
+enum DELTA_KIND {
+  DELTA_VALUE = 1,
+  DELTA_PILE,
+  DELTA_PILE_WIDE
+};
+
+#define DELTA_RECORD_HEADER 3
+#define DELTA_PILE_HEADER (DELTA_RECORD_HEADER + 4)
+/* every scalar, supply and embargo count and every pile in full */
+#define DELTA_MAX_SIZE (2 + (DELTA_RECORD_HEADER + 4) \
+			* (8 + 2 * (treasure_map + 1)) \
+			+ DELTA_PILE_HEADER * (3 * MAX_PLAYERS + 1) \
+			+ 4 * (MAX_PLAYERS * (MAX_HAND + 2 * MAX_DECK) + MAX_DECK))
+
+int encodeKeyframe(struct gameState *g, struct gameState *shadow,
+		   unsigned char *buf);
+/* Encodes all of g and makes shadow a copy of it; returns the size */
+
+int encodeDelta(struct gameState *g, struct gameState *shadow,
+		unsigned char *buf);
+/* Encodes what differs between g and shadow and updates shadow; returns
+   the size, which is 2 when nothing changed */
+
+int applyDelta(const unsigned char *buf, int size, struct gameState *g);
+/* Applies a keyframe or delta body to g; returns the number of records,
+   -1 if the body is malformed (g may then be partly updated) */
+
+#endif
@@ -0,0 +1,164 @@
+#include "domclient.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+static int greet(struct domClient *c) {
+  c->over = 0;
+  c->lastOp = SESSION_NONE;
+  c->lastOutcome = 0;
+  c->results = 0;
+  c->mirror = NULL;
+  c->feedBytes = 0;
+  c->inLen = 0;
+  memset(c->view, 0, sizeof(c->view));
+  if (c->fd >= 0 && domPoll(c, 1) > 0)
+    return 0;
+  domClose(c);
+  return -1;
+}
+
+int domConnect(struct domClient *c, const char *host, int port) {
+  struct addrinfo hints;
+  struct addrinfo *found;
+  struct addrinfo *a;
+  char service[16];
+  int one = 1;
+
+  c->fd = -1;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  snprintf(service, sizeof(service), "%d", port);
+  if (getaddrinfo(host, service, &hints, &found) != 0)
+    return -1;
+  for (a = found; a != NULL && c->fd < 0; a = a->ai_next) {
+    c->fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+    if (c->fd >= 0 && connect(c->fd, a->ai_addr, a->ai_addrlen) < 0) {
+      close(c->fd);
+      c->fd = -1;
+    }
+  }
+  freeaddrinfo(found);
+  if (c->fd >= 0)
+    setsockopt(c->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  return greet(c);
+}
+
+int domConnectUnix(struct domClient *c, const char *path) {
+  struct sockaddr_un addr;
+
+  c->fd = -1;
+  if (strlen(path) >= sizeof(addr.sun_path))
+    return -1;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, path);
+  c->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (c->fd >= 0 && connect(c->fd, (struct sockaddr *)&addr,
+			    sizeof(addr)) < 0) {
+    close(c->fd);
+    c->fd = -1;
+  }
+  return greet(c);
+}
+
+int domSend(struct domClient *c, int op, int arg0, int arg1, int arg2,
+	    int arg3) {
+  unsigned char frame[BIN_MOVE_SIZE];
+  struct sessionMove m;
+  int size;
+  int sent = 0;
+  ssize_t n;
+
+  m.op = op;
+  m.args[0] = arg0;
+  m.args[1] = arg1;
+  m.args[2] = arg2;
+  m.args[3] = arg3;
+  size = encodeBinMove(&m, frame);
+  while (sent < size) {
+    n = send(c->fd, frame + sent, size - sent, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return -1;
+    sent += n;
+  }
+  return 0;
+}
+
+int domPoll(struct domClient *c, int wait) {
+  struct binResult r;
+  int applied = 0;
+  int used;
+  int off;
+  int type;
+  ssize_t n;
+
+  for (;;) {
+    off = 0;
+    for (;;) {
+      type = binFrameType(c->in + off, c->inLen - off);
+      if (type == BIN_KEYFRAME || type == BIN_DELTA) {
+	used = c->mirror == NULL ? -1
+	  : decodeBinFeed(c->in + off, c->inLen - off, c->mirror);
+	if (used <= 0)
+	  break;
+	c->feedBytes += used;
+	off += used;
+	continue;
+      }
+      used = decodeBinResult(c->in + off, c->inLen - off, &r, c->view);
+      if (used <= 0)
+	break;
+      c->lastOp = r.op;
+      c->lastOutcome = r.outcome;
+      c->over = r.over;
+      c->results++;
+      applied++;
+      off += used;
+    }
+    memmove(c->in, c->in + off, c->inLen - off);
+    c->inLen -= off;
+    if (used < 0)
+      return -1;
+    if (applied > 0 && !wait)
+      return applied;
+    if (applied > 0)
+      wait = 0;
+    n = recv(c->fd, c->in + c->inLen, sizeof(c->in) - c->inLen,
+	     wait ? 0 : MSG_DONTWAIT);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      return applied;
+    if (n <= 0)
+      return applied > 0 ? applied : -1;
+    c->inLen += n;
+  }
+}
+
+int domMove(struct domClient *c, int op, int arg0, int arg1, int arg2,
+	    int arg3) {
+  if (domSend(c, op, arg0, arg1, arg2, arg3) < 0 || domPoll(c, 1) <= 0)
+    return -2;
+  return c->lastOutcome;
+}
+
+int domFeed(struct domClient *c, struct gameState *mirror) {
+  c->mirror = mirror;
+  return domMove(c, SESSION_FEED, 0, 0, 0, 0) == 0 ? 0 : -1;
+}
+
+void domClose(struct domClient *c) {
+  if (c->fd >= 0)
+    close(c->fd);
+  c->fd = -1;
+}
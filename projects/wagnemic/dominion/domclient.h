@@ -0,0 +1,65 @@
+/* Client library for the binary session protocol
+
+   Connects to domserver's binary listener and keeps the bot's view of
+   its game (see binproto.h) up to date.  domMove is the simple blocking
+   call: send one move, wait for its result.  Clients that drive many
+   games from one thread use domSend and domPoll instead: domSend writes
+   a move (at most one should be outstanding per connection, so the
+   socket never fills), and domPoll applies whatever results have
+   arrived without blocking.  domFeed subscribes to the state feed and
+   keeps a gameState mirror of what the player to move may know of the
+   game as well (see feedView in binproto.h).
+
+   Typical use:
+
+     struct domClient c;
+     domConnect(&c, "localhost", BIN_DEFAULT_PORT);
+     domMove(&c, SESSION_INIT, 2, 1, 0, 0);
+     while (!c.over)
+       domMove(&c, SESSION_END, 0, 0, 0, 0);
+     domClose(&c);
+*/
+
+#ifndef _DOMCLIENT_H
+#define _DOMCLIENT_H
+
+#include "binproto.h"
+
+struct domClient {
+  int fd;
+  int view[VIEW_SLOTS];
+  int over;            /* the session has ended */
+  int lastOp;
+  int lastOutcome;
+  long results;        /* results applied, the greeting included */
+  struct gameState *mirror;   /* kept up to date once feeding */
+  long feedBytes;      /* keyframe and delta bytes received */
+  int inLen;
+  unsigned char in[BIN_MAX_FRAME];
+};
+
+int domConnect(struct domClient *c, const char *host, int port);
+int domConnectUnix(struct domClient *c, const char *path);
+/* Both wait for the greeting, so the view is complete on return; -1 on
+   failure */
+
+int domMove(struct domClient *c, int op, int arg0, int arg1, int arg2,
+	    int arg3);
+/* Returns the move's outcome (0 or -1), or -2 if the connection failed */
+
+int domSend(struct domClient *c, int op, int arg0, int arg1, int arg2,
+	    int arg3);
+/* Returns -1 if the connection failed */
+
+int domPoll(struct domClient *c, int wait);
+/* Reads and applies results, blocking for the first one if wait is set;
+   returns how many were applied, -1 if the connection failed or closed
+   with no result pending */
+
+int domFeed(struct domClient *c, struct gameState *mirror);
+/* Subscribes to the state feed; mirror holds the game on return,
+   and after every later result.  Returns -1 if the connection failed */
+
+void domClose(struct domClient *c);
+
+#endif
@@ -1,10 +1,23 @@
 #include "dominion.h"
 #include "dominion_helpers.h"
 #include "rngs.h"
+#include "covpoints.h"
+#include "trace.h"
+#include "perfstats.h"
 #include <stdio.h>
 #include <math.h>
 #include <stdlib.h>
 
+#ifdef CHECK_INVARIANTS
+//the public entry points get wrapped by the checker in invariants.c
+#include "invariants.h"
+#define initializeGame uncheckedInitializeGame
+#define shuffle uncheckedShuffle
+#define playCard uncheckedPlayCard
+#define buyCard uncheckedBuyCard
+#define endTurn uncheckedEndTurn
+#endif
+
 int compare(const void* a, const void* b) {
   if (*(int*)a > *(int*)b)
     return 1;
@@ -40,6 +53,8 @@ int initializeGame(int numPlayers, int kingdomCards[10], int randomSeed,
   int i;
   int j;
   int it;			
+  PERF_SCOPE(PERF_INITIALIZE_GAME);
+  TRACE(TRACE_INIT, numPlayers, -1, randomSeed);
   //set up random number generator
   SelectStream(1);
   PutSeed((long)randomSeed);
@@ -205,9 +220,12 @@ int shuffle(int player, struct gameState *state) {
   int newDeckPos = 0;
   int card;
   int i;
+  PERF_SCOPE(PERF_SHUFFLE);
 
   if (state->deckCount[player] < 1)
     return -1;
+  TRACE(TRACE_SHUFFLE, player, -1, state->deckCount[player]);
+  PERF_SHUFFLED();
   qsort ((void*)(state->deck[player]), state->deckCount[player], sizeof(int), compare); 
   /* SORT CARDS IN DECK TO ENSURE DETERMINISM! */
 
@@ -232,6 +250,7 @@ int playCard(int handPos, int choice1, int choice2, int choice3, struct gameStat
 {	
   int card;
   int coin_bonus = 0; 		//tracks coins gain from actions
+  PERF_SCOPE(PERF_PLAY_CARD);
 
   //check if it is the right phase
   if (state->phase != 0)
@@ -257,8 +276,10 @@ int playCard(int handPos, int choice1, int choice2, int choice3, struct gameStat
   //play card
   if ( cardEffect(card, choice1, choice2, choice3, state, handPos, &coin_bonus) < 0 )
     {
+      TRACE(TRACE_PLAY, state->whoseTurn, card, -1);
       return -1;
     }
+  TRACE(TRACE_PLAY, state->whoseTurn, card, 0);
 	
   //reduce number of actions
   state->numActions--;
@@ -271,35 +292,33 @@ int playCard(int handPos, int choice1, int choice2, int choice3, struct gameStat
 
 int buyCard(int supplyPos, struct gameState *state) {
   int who;
-  if (DEBUG){
-    printf("Entering buyCard...\n");
-  }
+  PERF_SCOPE(PERF_BUY_CARD);
 
   // I don't know what to do about the phase thing.
 
   who = state->whoseTurn;
 
   if (state->numBuys < 1){
-    if (DEBUG)
-      printf("You do not have any buys left\n");
+    COVER(COVER_BUY_NO_BUYS);
+    TRACE(TRACE_BUY, who, supplyPos, -1);
     return -1;
   } else if (supplyCount(supplyPos, state) <1){
-    if (DEBUG)
-      printf("There are not any of that type of card left\n");
+    COVER(COVER_BUY_EMPTY_PILE);
+    TRACE(TRACE_BUY, who, supplyPos, -1);
     return -1;
   } else if (state->coins < getCost(supplyPos)){
-    if (DEBUG) 
-      printf("You do not have enough money to buy that. You have %d coins.\n", state->coins);
+    COVER(COVER_BUY_TOO_EXPENSIVE);
+    TRACE(TRACE_BUY, who, supplyPos, -1);
     return -1;
   } else {
+    COVER(COVER_BUY);
+    TRACE(TRACE_BUY, who, supplyPos, 0);
     state->phase=1;
     //state->supplyCount[supplyPos]--;
     gainCard(supplyPos, state, 0, who); //card goes in discard, this might be wrong.. (2 means goes into hand, 0 goes into discard)
   
     state->coins = (state->coins) - (getCost(supplyPos));
     state->numBuys--;
-    if (DEBUG)
-      printf("You bought card number %d for %d coins. You now have %d buys and %d coins.\n", supplyPos, getCost(supplyPos), state->numBuys, state->coins);
   }
 
   //state->discard[who][state->discardCount[who]] = supplyPos;
@@ -351,7 +370,10 @@ int endTurn(struct gameState *state) {
   int k;
   int i;
   int currentPlayer = whoseTurn(state);
+  PERF_SCOPE(PERF_END_TURN);
   
+  TRACE(TRACE_END_TURN, currentPlayer, -1,
+	currentPlayer < state->numPlayers - 1 ? currentPlayer + 1 : 0);
   //Discard hand
   for (i = 0; i < state->handCount[currentPlayer]; i++){
     state->discard[currentPlayer][state->discardCount[currentPlayer]++] = state->hand[currentPlayer][i];//Discard
@@ -390,6 +412,7 @@ int endTurn(struct gameState *state) {
 int isGameOver(struct gameState *state) {
   int i;
   int j;
+  PERF_SCOPE(PERF_IS_GAME_OVER);
 	
   //if stack of Province cards is empty, the game ends
   if (state->supplyCount[province] == 0)
@@ -418,6 +441,7 @@ int scoreFor (int player, struct gameState *state) {
 
   int i;
   int score = 0;
+  PERF_SCOPE(PERF_SCORE_FOR);
   //score from hand
   for (i = 0; i < state->handCount[player]; i++)
     {
@@ -525,10 +549,12 @@ int getWinners(int players[MAX_PLAYERS], struct gameState *state) {
 int drawCard(int player, struct gameState *state)
 {	int count;
   int deckCounter;
+  PERF_SCOPE(PERF_DRAW_CARD);
   if (state->deckCount[player] <= 0){//Deck is empty
     
     //Step 1 Shuffle the discard pile back into a deck
     int i;
+    COVER(COVER_DRAW_SHUFFLE);
     //Move discard to deck
     for (i = 0; i < state->discardCount[player];i++){
       state->deck[player][i] = state->discard[player][i];
@@ -540,41 +566,37 @@ int drawCard(int player, struct gameState *state)
 
     //Shufffle the deck
     shuffle(player, state);//Shuffle the deck up and make it so that we can draw
-   
-    if (DEBUG){//Debug statements
-      printf("Deck count now: %d\n", state->deckCount[player]);
-    }
     
     state->discardCount[player] = 0;
 
     //Step 2 Draw Card
     count = state->handCount[player];//Get current player's hand count
     
-    if (DEBUG){//Debug statements
-      printf("Current hand count: %d\n", count);
-    }
-    
     deckCounter = state->deckCount[player];//Create a holder for the deck count
 
-    if (deckCounter == 0)
+    if (deckCounter == 0){
+      COVER(COVER_DRAW_EMPTY);
       return -1;
+    }
 
     state->hand[player][count] = state->deck[player][deckCounter - 1];//Add card to hand
     state->deckCount[player]--;
     state->handCount[player]++;//Increment hand count
+    TRACE(TRACE_DRAW, player, state->hand[player][count], state->deckCount[player]);
+    PERF_DRAWN();
   }
 
   else{
     int count = state->handCount[player];//Get current hand count for player
     int deckCounter;
-    if (DEBUG){//Debug statements
-      printf("Current hand count: %d\n", count);
-    }
+    COVER(COVER_DRAW_DECK);
 
     deckCounter = state->deckCount[player];//Create holder for the deck count
     state->hand[player][count] = state->deck[player][deckCounter - 1];//Add card to the hand
     state->deckCount[player]--;
     state->handCount[player]++;//Increment hand count
+    TRACE(TRACE_DRAW, player, state->hand[player][count], state->deckCount[player]);
+    PERF_DRAWN();
   }
 
   return 0;
@@ -658,6 +680,7 @@ int cardEffect(int card, int choice1, int choice2, int choice3, struct gameState
   int drawntreasure=0;
   int cardDrawn;
   int z = 0;// this is the counter for the temp hand
+  PERF_SCOPE(card);
   if (nextPlayer > (state->numPlayers - 1)){
     nextPlayer = 0;
   }
@@ -669,13 +692,17 @@ int cardEffect(int card, int choice1, int choice2, int choice3, struct gameState
     case adventurer:
       while(drawntreasure<2){
 	if (state->deckCount[currentPlayer] <1){//if the deck is empty we need to shuffle discard and add to deck
+	  COVER(COVER_ADVENTURER_SHUFFLE);
 	  shuffle(currentPlayer, state);
 	}
 	drawCard(currentPlayer, state);
 	cardDrawn = state->hand[currentPlayer][state->handCount[currentPlayer]-1];//top card of hand is most recently drawn card.
-	if (cardDrawn == copper || cardDrawn == silver || cardDrawn == gold)
+	if (cardDrawn == copper || cardDrawn == silver || cardDrawn == gold){
+	  COVER(COVER_ADVENTURER_TREASURE);
 	  drawntreasure++;
+	}
 	else{
+	  COVER(COVER_ADVENTURER_OTHER);
 	  temphand[z]=cardDrawn;
 	  state->handCount[currentPlayer]--; //this should just remove the top card (the most recently drawn one).
 	  z++;
@@ -688,6 +715,7 @@ int cardEffect(int card, int choice1, int choice2, int choice3, struct gameState
       return 0;
 			
     case council_room:
+      COVER(COVER_COUNCIL_ROOM);
       //+4 Cards
       for (i = 0; i < 4; i++)
 	{
@@ -725,33 +753,15 @@ int cardEffect(int card, int choice1, int choice2, int choice3, struct gameState
       x = 1;//Condition to loop on
       while( x == 1) {//Buy one card
 	if (supplyCount(choice1, state) <= 0){
-	  if (DEBUG)
-	    printf("None of that card left, sorry!\n");
-
-	  if (DEBUG){
-	    printf("Cards Left: %d\n", supplyCount(choice1, state));
-	  }
+	  COVER(COVER_FEAST_EMPTY_PILE);
 	}
 	else if (state->coins < getCost(choice1)){
-	  printf("That card is too expensive!\n");
-
-	  if (DEBUG){
-	    printf("Coins: %d < %d\n", state->coins, getCost(choice1));
-	  }
+	  COVER(COVER_FEAST_TOO_EXPENSIVE);
 	}
 	else{
-
-	  if (DEBUG){
-	    printf("Deck Count: %d\n", state->handCount[currentPlayer] + state->deckCount[currentPlayer] + state->discardCount[currentPlayer]);
-	  }
-
+	  COVER(COVER_FEAST_GAIN);
 	  gainCard(choice1, state, 0, currentPlayer);//Gain the card
 	  x = 0;//No more buying cards
-
-	  if (DEBUG){
-	    printf("Deck Count: %d\n", state->handCount[currentPlayer] + state->deckCount[currentPlayer] + state->discardCount[currentPlayer]);
-	  }
-
 	}
       }     
 
@@ -765,6 +775,7 @@ int cardEffect(int card, int choice1, int choice2, int choice3, struct gameState
       return 0;
 			
     case gardens:
+      COVER(COVER_GARDENS);
       return -1;
 			
     case mine:
@@ -772,19 +783,23 @@ int cardEffect(int card, int choice1, int choice2, int choice3, struct gameState
 
       if (state->hand[currentPlayer][choice1] < copper || state->hand[currentPlayer][choice1] > gold)
 	{
+	  COVER(COVER_MINE_NOT_TREASURE);
 	  return -1;
 	}
 		
       if (choice2 > treasure_map || choice2 < curse)
 	{
+	  COVER(COVER_MINE_BAD_CARD);
 	  return -1;
 	}
 
       if ( (getCost(state->hand[currentPlayer][choice1]) + 3) > getCost(choice2) )
 	{
+	  COVER(COVER_MINE_TOO_EXPENSIVE);
 	  return -1;
 	}
 
+      COVER(COVER_MINE_GAIN);
       gainCard(choice2, state, 2, currentPlayer);
 
       //discard card from hand
@@ -807,9 +822,11 @@ int cardEffect(int card, int choice1, int choice2, int choice3, struct gameState
 
       if ( (getCost(state->hand[currentPlayer][choice1]) + 2) > getCost(choice2) )
 	{
+	  COVER(COVER_REMODEL_TOO_EXPENSIVE);
 	  return -1;
 	}
 
+      COVER(COVER_REMODEL_GAIN);
       gainCard(choice2, state, 0, currentPlayer);
 
       //discard card from hand
@@ -829,6 +846,7 @@ int cardEffect(int card, int choice1, int choice2, int choice3, struct gameState
       return 0;
 		
     case smithy:
+      COVER(COVER_SMITHY);
       //+3 Cards
       for (i = 0; i < 3; i++)
 	{
@@ -840,6 +858,7 @@ int cardEffect(int card, int choice1, int choice2, int choice3, struct gameState
       return 0;
 		
     case village:
+      COVER(COVER_VILLAGE);
       //+1 Card
       drawCard(currentPlayer, state);
 			
@@ -857,6 +876,7 @@ int cardEffect(int card, int choice1, int choice2, int choice3, struct gameState
 	int card_not_discarded = 1;//Flag for discard set!
 	while(card_not_discarded){
 	  if (state->hand[currentPlayer][p] == estate){//Found an estate card!
+	    COVER(COVER_BARON_DISCARD_ESTATE);
 	    state->coins += 4;//Add 4 coins to the amount of coins
 	    state->discard[currentPlayer][state->discardCount[currentPlayer]] = state->hand[currentPlayer][p];
 	    state->discardCount[currentPlayer]++;
@@ -868,6 +888,7 @@ int cardEffect(int card, int choice1, int choice2, int choice3, struct gameState
 	    card_not_discarded = 0;//Exit the loop
 	  }
 	  else if (p > state->handCount[currentPlayer]){
+	    COVER(COVER_BARON_NO_ESTATE);
 	    if(DEBUG) {
 	      printf("No estate cards in your hand, invalid choice\n");
 	      printf("Must gain an estate if there are any\n");
@@ -876,6 +897,7 @@ int cardEffect(int card, int choice1, int choice2, int choice3, struct gameState
 	      gainCard(estate, state, 0, currentPlayer);
 	      state->supplyCount[estate]--;//Decrement estates
 	      if (supplyCount(estate, state) == 0){
+		COVER(COVER_BARON_ESTATES_GONE);
 		isGameOver(state);
 	      }
 	    }
@@ -890,9 +912,11 @@ int cardEffect(int card, int choice1, int choice2, int choice3, struct gameState
 			    
       else{
 	if (supplyCount(estate, state) > 0){
+	  COVER(COVER_BARON_GAIN_ESTATE);
 	  gainCard(estate, state, 0, currentPlayer);//Gain an estate
 	  state->supplyCount[estate]--;//Decrement Estates
 	  if (supplyCount(estate, state) == 0){
+	    COVER(COVER_BARON_ESTATES_GONE);
 	    isGameOver(state);
 	  }
 	}
@@ -902,6 +926,7 @@ int cardEffect(int card, int choice1, int choice2, int choice3, struct gameState
       return 0;
 		
     case great_hall:
+      COVER(COVER_GREAT_HALL);
       //+1 Card
       drawCard(currentPlayer, state);
 			
@@ -921,11 +946,13 @@ int cardEffect(int card, int choice1, int choice2, int choice3, struct gameState
 			
       if (choice1)		//+2 coins
 	{
+	  COVER(COVER_MINION_COINS);
 	  state->coins = state->coins + 2;
 	}
 			
       else if (choice2)		//discard hand, redraw 4, other players with 5+ cards discard hand and draw 4
 	{
+	  COVER(COVER_MINION_REDRAW);
 	  //discard hand
 	  while(numHandCards(state) > 0)
 	    {
@@ -945,6 +972,7 @@ int cardEffect(int card, int choice1, int choice2, int choice3, struct gameState
 		{
 		  if ( state->handCount[i] > 4 )
 		    {
+		      COVER(COVER_MINION_OTHER_REDRAWS);
 		      //discard hand
 		      while( state->handCount[i] > 0 )
 			{
@@ -961,22 +989,29 @@ int cardEffect(int card, int choice1, int choice2, int choice3, struct gameState
 	    }
 				
 	}
+      else
+	{
+	  COVER(COVER_MINION_NEITHER);
+	}
       return 0;
 		
     case steward:
       if (choice1 == 1)
 	{
+	  COVER(COVER_STEWARD_DRAW);
 	  //+2 cards
 	  drawCard(currentPlayer, state);
 	  drawCard(currentPlayer, state);
 	}
       else if (choice1 == 2)
 	{
+	  COVER(COVER_STEWARD_COINS);
 	  //+2 coins
 	  state->coins = state->coins + 2;
 	}
       else
 	{
+	  COVER(COVER_STEWARD_TRASH);
 	  //trash 2 cards in hand
 	  discardCard(choice2, currentPlayer, state, 1);
 	  discardCard(choice3, currentPlayer, state, 1);
@@ -989,14 +1024,17 @@ int cardEffect(int card, int choice1, int choice2, int choice3, struct gameState
     case tribute:
       if ((state->discardCount[nextPlayer] + state->deckCount[nextPlayer]) <= 1){
 	if (state->deckCount[nextPlayer] > 0){
+	  COVER(COVER_TRIBUTE_ONE_FROM_DECK);
 	  tributeRevealedCards[0] = state->deck[nextPlayer][state->deckCount[nextPlayer]-1];
 	  state->deckCount[nextPlayer]--;
 	}
 	else if (state->discardCount[nextPlayer] > 0){
+	  COVER(COVER_TRIBUTE_ONE_FROM_DISCARD);
 	  tributeRevealedCards[0] = state->discard[nextPlayer][state->discardCount[nextPlayer]-1];
 	  state->discardCount[nextPlayer]--;
 	}
 	else{
+	  COVER(COVER_TRIBUTE_NOTHING);
 	  //No Card to Reveal
 	  if (DEBUG){
 	    printf("No cards to reveal\n");
@@ -1005,7 +1043,9 @@ int cardEffect(int card, int choice1, int choice2, int choice3, struct gameState
       }
 	    
       else{
+	COVER(COVER_TRIBUTE_TWO);
 	if (state->deckCount[nextPlayer] == 0){
+	  COVER(COVER_TRIBUTE_SHUFFLE);
 	  for (i = 0; i < state->discardCount[nextPlayer]; i++){
 	    state->deck[nextPlayer][i] = state->discard[nextPlayer][i];//Move to deck
 	    state->deckCount[nextPlayer]++;
@@ -1024,6 +1064,7 @@ int cardEffect(int card, int choice1, int choice2, int choice3, struct gameState
       }    
 		       
       if (tributeRevealedCards[0] == tributeRevealedCards[1]){//If we have a duplicate card, just drop one 
+	COVER(COVER_TRIBUTE_DUPLICATE);
 	state->playedCards[state->playedCardCount] = tributeRevealedCards[1];
 	state->playedCardCount++;
 	tributeRevealedCards[1] = -1;
@@ -1031,14 +1072,17 @@ int cardEffect(int card, int choice1, int choice2, int choice3, struct gameState
 
       for (i = 0; i <= 2; i ++){
 	if (tributeRevealedCards[i] == copper || tributeRevealedCards[i] == silver || tributeRevealedCards[i] == gold){//Treasure cards
+	  COVER(COVER_TRIBUTE_TREASURE);
 	  state->coins += 2;
 	}
 		    
 	else if (tributeRevealedCards[i] == estate || tributeRevealedCards[i] == duchy || tributeRevealedCards[i] == province || tributeRevealedCards[i] == gardens || tributeRevealedCards[i] == great_hall){//Victory Card Found
+	  COVER(COVER_TRIBUTE_VICTORY);
 	  drawCard(currentPlayer, state);
 	  drawCard(currentPlayer, state);
 	}
 	else{//Action Card
+	  COVER(COVER_TRIBUTE_ACTION);
 	  state->numActions = state->numActions + 2;
 	}
       }
@@ -1050,11 +1094,13 @@ int cardEffect(int card, int choice1, int choice2, int choice3, struct gameState
 
       if (choice2 > 2 || choice2 < 0)
 	{
+	  COVER(COVER_AMBASSADOR_BAD_CHOICE);
 	  return -1;				
 	}
 
       if (choice1 == handPos)
 	{
+	  COVER(COVER_AMBASSADOR_BAD_CHOICE);
 	  return -1;
 	}
 
@@ -1067,9 +1113,12 @@ int cardEffect(int card, int choice1, int choice2, int choice3, struct gameState
 	}
       if (j < choice2)
 	{
+	  COVER(COVER_AMBASSADOR_TOO_FEW);
 	  return -1;				
 	}
 
+      COVER(COVER_AMBASSADOR_RETURN);
+
       if (DEBUG) 
 	printf("Player %d reveals card number: %d\n", currentPlayer, state->hand[currentPlayer][choice1]);
 
@@ -1104,6 +1153,7 @@ int cardEffect(int card, int choice1, int choice2, int choice3, struct gameState
       return 0;
 		
     case cutpurse:
+      COVER(COVER_CUTPURSE);
 
       updateCoins(currentPlayer, state, 2);
       for (i = 0; i < state->numPlayers; i++)
@@ -1114,11 +1164,13 @@ int cardEffect(int card, int choice1, int choice2, int choice3, struct gameState
 		{
 		  if (state->hand[i][j] == copper)
 		    {
+		      COVER(COVER_CUTPURSE_COPPER);
 		      discardCard(j, i, state, 0);
 		      break;
 		    }
 		  if (j == state->handCount[i])
 		    {
+		      COVER(COVER_CUTPURSE_REVEAL);
 		      for (k = 0; k < state->handCount[i]; k++)
 			{
 			  if (DEBUG)
@@ -1145,10 +1197,12 @@ int cardEffect(int card, int choice1, int choice2, int choice3, struct gameState
       //see if selected pile is in play
       if ( state->supplyCount[choice1] == -1 )
 	{
+	  COVER(COVER_EMBARGO_NOT_IN_GAME);
 	  return -1;
 	}
 			
       //add embargo token to selected supply pile
+      COVER(COVER_EMBARGO_TOKEN);
       state->embargoTokens[choice1]++;
 			
       //trash card
@@ -1156,6 +1210,7 @@ int cardEffect(int card, int choice1, int choice2, int choice3, struct gameState
       return 0;
 		
     case outpost:
+      COVER(COVER_OUTPOST);
       //set outpost flag
       state->outpostPlayed++;
 			
@@ -1169,17 +1224,23 @@ int cardEffect(int card, int choice1, int choice2, int choice3, struct gameState
 			
       if (choice1)
 	{
+	  COVER(COVER_SALVAGER_TRASH);
 	  //gain coins equal to trashed card
 	  state->coins = state->coins + getCost( handCard(choice1, state) );
 	  //trash card
 	  discardCard(choice1, currentPlayer, state, 1);	
 	}
+      else
+	{
+	  COVER(COVER_SALVAGER_NO_TRASH);
+	}
 			
       //discard card
       discardCard(handPos, currentPlayer, state, 0);
       return 0;
 		
     case sea_hag:
+      COVER(COVER_SEA_HAG);
       for (i = 0; i < state->numPlayers; i++){
 	if (i != currentPlayer){
 	  state->discard[i][state->discardCount[i]] = state->deck[i][state->deckCount[i]--];			    state->deckCount[i]--;
@@ -1202,6 +1263,7 @@ int cardEffect(int card, int choice1, int choice2, int choice3, struct gameState
 	}
       if (index > -1)
 	{
+	  COVER(COVER_TREASURE_MAP_PAIR);
 	  //trash both treasure cards
 	  discardCard(handPos, currentPlayer, state, 1);
 	  discardCard(index, currentPlayer, state, 1);
@@ -1217,14 +1279,17 @@ int cardEffect(int card, int choice1, int choice2, int choice3, struct gameState
 	}
 			
       //no second treasure_map found in hand
+      COVER(COVER_TREASURE_MAP_SINGLE);
       return -1;
     }
 	
+  COVER(COVER_NOT_AN_ACTION);
   return -1;
 }
 
 int discardCard(int handPos, int currentPlayer, struct gameState *state, int trashFlag)
 {
+  PERF_SCOPE(PERF_DISCARD_CARD);
 	
   //if card is not trashed, added to Played pile 
   if (trashFlag < 1)
@@ -1233,6 +1298,10 @@ int discardCard(int handPos, int currentPlayer, struct gameState *state, int tra
       state->playedCards[state->playedCardCount] = state->hand[currentPlayer][handPos]; 
       state->playedCardCount++;
     }
+  else
+    {
+      TRACE(TRACE_TRASH, currentPlayer, state->hand[currentPlayer][handPos], 0);
+    }
 	
   //set played card to -1
   state->hand[currentPlayer][handPos] = -1;
@@ -1264,10 +1333,13 @@ int discardCard(int handPos, int currentPlayer, struct gameState *state, int tra
 int gainCard(int supplyPos, struct gameState *state, int toFlag, int player)
 {
   //Note: supplyPos is enum of choosen card
+  PERF_SCOPE(PERF_GAIN_CARD);
 	
   //check if supply pile is empty (0) or card is not used in game (-1)
   if ( supplyCount(supplyPos, state) < 1 )
     {
+      COVER(COVER_GAIN_EMPTY_PILE);
+      TRACE(TRACE_GAIN, player, supplyPos, -1);
       return -1;
     }
 	
@@ -1278,22 +1350,26 @@ int gainCard(int supplyPos, struct gameState *state, int toFlag, int player)
 
   if (toFlag == 1)
     {
+      COVER(COVER_GAIN_TO_DECK);
       state->deck[ player ][ state->deckCount[player] ] = supplyPos;
       state->deckCount[player]++;
     }
   else if (toFlag == 2)
     {
+      COVER(COVER_GAIN_TO_HAND);
       state->hand[ player ][ state->handCount[player] ] = supplyPos;
       state->handCount[player]++;
     }
   else
     {
+      COVER(COVER_GAIN_TO_DISCARD);
       state->discard[player][ state->discardCount[player] ] = supplyPos;
       state->discardCount[player]++;
     }
 	
   //decrease number in supply pile
   state->supplyCount[supplyPos]--;
+  TRACE(TRACE_GAIN, player, supplyPos, toFlag == 1 || toFlag == 2 ? toFlag : 0);
 	 
   return 0;
 }
@@ -1301,6 +1377,7 @@ int gainCard(int supplyPos, struct gameState *state, int toFlag, int player)
 int updateCoins(int player, struct gameState *state, int bonus)
 {
   int i;
+  PERF_SCOPE(PERF_UPDATE_COINS);
 	
   //reset coin count
   state->coins = 0;
@@ -0,0 +1,324 @@
+/* Load generator for the binary session protocol
+
+   Plays games against domserver's binary listener from many simulated
+   bot clients at once, the clients spread over -j threads that each
+   wait on their clients with epoll.  Every client plays all seats of a
+   two player game with a smithy big money strategy, keeps one move in
+   flight, and starts a new game on a new connection when one ends until
+   it has played its share.  Reports the moves per second and the
+   distribution of move round trip times.  With -f every client also
+   subscribes to the state feed, checks its mirror against the view
+   after each result and reports the feed bytes per move.
+
+   Usage: domload [-l port | -u socket path] [-c clients] [-g games]
+                  [-j threads] [-f]
+*/
+
+#include "dominion.h"
+#include "domclient.h"
+#include "perfstats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+
+#define MAX_THREADS 64
+#define MAX_EVENTS 256
+
+enum STAGE {
+  STAGE_ACTION = 0,
+  STAGE_BUY,
+  STAGE_END
+};
+
+struct bot {
+  struct domClient c;
+  int stage;
+  int gamesLeft;
+  unsigned long long sentAt;
+  struct gameState *mirror;   /* with -f */
+};
+
+struct loadThread {
+  pthread_t thread;
+  struct bot *bots;
+  int numBots;
+  long games;
+  long moves;
+  long failed;
+  long feedBytes;
+  long mismatches;           /* mirrors that disagreed with the view */
+  struct perfHist latency;   /* nanoseconds */
+};
+
+static const char *sockPath = NULL;
+static int port = BIN_DEFAULT_PORT;
+static int feed = 0;
+
+static unsigned long long now(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int connectBot(struct bot *b) {
+  int result;
+
+  b->stage = STAGE_ACTION;
+  if (sockPath != NULL)
+    result = domConnectUnix(&b->c, sockPath);
+  else
+    result = domConnect(&b->c, "localhost", port);
+  if (result < 0 || !feed)
+    return result;
+  if (b->mirror == NULL)
+    b->mirror = malloc(sizeof(struct gameState));
+  if (b->mirror == NULL)
+    return -1;
+  return domFeed(&b->c, b->mirror);
+}
+
+//whether the feed's copy of the game agrees with what the view shows
+static int mirrorAgrees(struct bot *b) {
+  struct gameState *g = b->mirror;
+  int *v = b->c.view;
+  int current = v[VIEW_WHOSE_TURN];
+  int i;
+
+  if (!v[VIEW_STARTED])
+    return 1;
+  if (g->whoseTurn != current || g->coins != v[VIEW_COINS]
+      || g->numActions != v[VIEW_ACTIONS] || g->numBuys != v[VIEW_BUYS]
+      || g->handCount[current] != v[VIEW_HAND_COUNT + current])
+    return 0;
+  for (i = 0; i < g->handCount[current]; i++) {
+    if (g->hand[current][i] != v[VIEW_HAND + i])
+      return 0;
+  }
+  return 1;
+}
+
+static void closeBot(struct loadThread *t, int epfd, struct bot *b) {
+  epoll_ctl(epfd, EPOLL_CTL_DEL, b->c.fd, NULL);
+  t->feedBytes += b->c.feedBytes;
+  domClose(&b->c);
+}
+
+//the next move for the player to act, from the bot's view alone
+static void nextMove(struct bot *b, int *op, int *arg) {
+  int *v = b->c.view;
+  int i;
+
+  *op = SESSION_END;
+  *arg = 0;
+  if (!v[VIEW_STARTED]) {
+    *op = SESSION_INIT;
+    *arg = 2;
+    return;
+  }
+  if (b->stage == STAGE_ACTION) {
+    b->stage = STAGE_BUY;
+    for (i = 0; v[VIEW_ACTIONS] > 0 && i < v[VIEW_HAND_COUNT
+					      + v[VIEW_WHOSE_TURN]]; i++) {
+      if (v[VIEW_HAND + i] == smithy) {
+	*op = SESSION_PLAY;
+	*arg = i;
+	return;
+      }
+    }
+  }
+  if (b->stage == STAGE_BUY) {
+    b->stage = STAGE_END;
+    *op = SESSION_BUY;
+    if (v[VIEW_COINS] >= 8 && v[VIEW_SUPPLY + province] > 0)
+      *arg = province;
+    else if (v[VIEW_COINS] >= 6)
+      *arg = gold;
+    else if (v[VIEW_COINS] >= 4 && v[VIEW_TURN] < 3)
+      *arg = smithy;
+    else if (v[VIEW_COINS] >= 3)
+      *arg = silver;
+    else
+      *op = SESSION_END;
+    if (*op == SESSION_BUY)
+      return;
+  }
+  b->stage = STAGE_ACTION;
+}
+
+static int sendNext(struct loadThread *t, struct bot *b) {
+  int op;
+  int arg;
+
+  nextMove(b, &op, &arg);
+  b->sentAt = now();
+  t->moves++;
+  return domSend(&b->c, op, arg, op == SESSION_INIT ? 0 : -1, -1, -1);
+}
+
+static int watchBot(int epfd, struct bot *b, int op) {
+  struct epoll_event ev;
+
+  ev.events = EPOLLIN;
+  ev.data.ptr = b;
+  return epoll_ctl(epfd, op, b->c.fd, &ev);
+}
+
+static void *runClients(void *arg) {
+  struct loadThread *t = arg;
+  struct epoll_event events[MAX_EVENTS];
+  struct bot *b;
+  int epfd = epoll_create1(0);
+  int active = 0;
+  int n;
+  int i;
+
+  for (i = 0; i < t->numBots; i++) {
+    b = &t->bots[i];
+    if (b->gamesLeft == 0)
+      continue;
+    if (connectBot(b) < 0 || watchBot(epfd, b, EPOLL_CTL_ADD) < 0
+	|| sendNext(t, b) < 0) {
+      t->failed++;
+      continue;
+    }
+    active++;
+  }
+  while (active > 0) {
+    n = epoll_wait(epfd, events, MAX_EVENTS, -1);
+    for (i = 0; i < n; i++) {
+      b = events[i].data.ptr;
+      if (domPoll(&b->c, 0) <= 0) {
+	//a closed connection with no result to show for it
+	closeBot(t, epfd, b);
+	t->failed++;
+	active--;
+	continue;
+      }
+      perfHistRecord(&t->latency, now() - b->sentAt);
+      if (feed && !mirrorAgrees(b))
+	t->mismatches++;
+      if (b->c.over) {
+	t->games++;
+	closeBot(t, epfd, b);
+	if (--b->gamesLeft == 0) {
+	  active--;
+	  continue;
+	}
+	if (connectBot(b) < 0 || watchBot(epfd, b, EPOLL_CTL_ADD) < 0) {
+	  t->failed++;
+	  active--;
+	  continue;
+	}
+      }
+      if (sendNext(t, b) < 0) {
+	closeBot(t, epfd, b);
+	t->failed++;
+	active--;
+      }
+    }
+  }
+  close(epfd);
+  return NULL;
+}
+
+static void usage(void) {
+  printf("Usage: domload [-l port | -u socket path] [-c clients] [-g games]\n"
+	 "               [-j threads] [-f]\n");
+}
+
+int main(int argc, char **argv) {
+  struct loadThread threads[MAX_THREADS];
+  struct perfHist latency;
+  struct bot *bots;
+  unsigned long long start;
+  double seconds;
+  long games = 1000;
+  long moves = 0;
+  long played = 0;
+  long failed = 0;
+  long feedBytes = 0;
+  long mismatches = 0;
+  int numClients = 100;
+  int numThreads = 1;
+  int first = 0;
+  int opt;
+  int i;
+
+  while ((opt = getopt(argc, argv, "l:u:c:g:j:f")) != -1) {
+    switch (opt) {
+    case 'l': port = atoi(optarg); break;
+    case 'u': sockPath = optarg; break;
+    case 'c': numClients = atoi(optarg); break;
+    case 'g': games = atol(optarg); break;
+    case 'j': numThreads = atoi(optarg); break;
+    case 'f': feed = 1; break;
+    default: usage(); return 1;
+    }
+  }
+  if (numClients < 1 || games < 1 || numThreads < 1
+      || numThreads > MAX_THREADS) {
+    usage();
+    return 1;
+  }
+  if (numThreads > numClients)
+    numThreads = numClients;
+  bots = calloc(numClients, sizeof(struct bot));
+  if (bots == NULL) {
+    printf("Out of memory\n");
+    return 1;
+  }
+  //the games are dealt out as evenly as they go
+  for (i = 0; i < numClients; i++)
+    bots[i].gamesLeft = games / numClients + (i < games % numClients);
+
+  start = now();
+  for (i = 0; i < numThreads; i++) {
+    memset(&threads[i], 0, sizeof(struct loadThread));
+    threads[i].bots = bots + first;
+    threads[i].numBots = numClients / numThreads
+      + (i < numClients % numThreads);
+    first += threads[i].numBots;
+    if (pthread_create(&threads[i].thread, NULL, runClients,
+		       &threads[i]) != 0) {
+      printf("Could not start thread %d\n", i);
+      return 1;
+    }
+  }
+  memset(&latency, 0, sizeof(latency));
+  for (i = 0; i < numThreads; i++) {
+    pthread_join(threads[i].thread, NULL);
+    played += threads[i].games;
+    moves += threads[i].moves;
+    failed += threads[i].failed;
+    feedBytes += threads[i].feedBytes;
+    mismatches += threads[i].mismatches;
+    perfHistMerge(&latency, &threads[i].latency);
+  }
+  seconds = (now() - start) / 1e9;
+
+  printf("Games: %ld\nMoves: %ld in %.2fs (%.0f/s)\n", played, moves, seconds,
+	 moves / seconds);
+  printf("Round trip (us): p50 %.1f, p99 %.1f, max %.1f\n",
+	 perfHistPercentile(&latency, 50) / 1000.0,
+	 perfHistPercentile(&latency, 99) / 1000.0, latency.max / 1000.0);
+  if (feed)
+    printf("Feed: %ld bytes, %.1f per move\n", feedBytes,
+	   (double)feedBytes / moves);
+  if (mismatches > 0) {
+    printf("Mirrors out of step: %ld\n", mismatches);
+    return 1;
+  }
+  if (failed > 0) {
+    printf("Failed connections: %ld\n", failed);
+    return 1;
+  }
+  for (i = 0; i < numClients; i++)
+    free(bots[i].mirror);
+  free(bots);
+  return 0;
+}
@@ -0,0 +1,498 @@
+/* Multi-game server
+
+   Hosts one game per connection with the command set of player (see
+   session.h), over TCP or a Unix socket.  Each of the -j event loops
+   is a thread with its own epoll set; they share the listening socket
+   (EPOLLEXCLUSIVE wakes only one of them per connection) and a
+   connection stays on the loop that accepted it.  A connection keeps a
+   fixed input buffer and an output buffer that grows to fit the largest
+   response and is then reused, so commands allocate nothing.  Complete
+   lines are run as commands; each response ends with the "$ " prompt.
+   While a response has not been sent in full the connection is not
+   read, so a client that does not read its output only stalls itself.
+   The connection is closed once the session ends.
+
+   With -b (TCP) or -B (Unix socket) the server also listens for bots
+   that speak the binary protocol (see binproto.h).  Their moves run
+   through the same sessions without any text being rendered, and each
+   is answered with the slots of the bot's view that changed.  A bot
+   that sends a debug command (add, or init once its game has started)
+   is disconnected.
+
+   The engine is deterministic from the seed, so each game's seed is
+   drawn at random and never sent; a bot that knew it could replay every
+   shuffle.  With -s, game n (counting connections from 0) is played
+   with seed first seed + n instead, for repeatable runs.  With -n the
+   server exits after that many sessions have ended and prints its
+   totals.  Hosting thousands of games needs a matching open file limit
+   (ulimit -n).
+
+   Usage: domserver [-l port | -u socket path] [-b port | -B socket path]
+                    [-j loops] [-s first seed] [-n sessions]
+*/
+
+#define _GNU_SOURCE
+#include "dominion.h"
+#include "session.h"
+#include "outbuf.h"
+#include "binproto.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/random.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#define DOM_DEFAULT_PORT 7363
+#define IN_BUFFER 1024
+#define OUT_INITIAL 4096
+#define OUT_LIMIT (16 << 20)
+#define MAX_EVENTS 256
+#define MAX_LOOPS 64
+
+struct conn {
+  int fd;
+  int binary;        /* speaks binproto instead of text */
+  int closing;       /* session over, close once the output is sent */
+  int sent;          /* bytes of out already written */
+  int inLen;
+  char in[IN_BUFFER];
+  struct outBuf out;
+  struct session game;
+  struct conn *nextFree;
+  int last[VIEW_SLOTS];   /* the view as the binary client has it */
+  int feeding;            /* asked for the state feed */
+  struct gameState *shadow;   /* the game as the feed has sent it */
+  struct gameState *seen;     /* the game as the player to move sees it */
+};
+
+//the text and binary listening sockets; -1 when not in use
+struct listener {
+  int fd;
+  int binary;
+};
+
+struct loop {
+  int epfd;
+  pthread_t thread;
+  struct conn *free;   /* closed connections, kept for reuse */
+  long sessions;
+  long commands;
+};
+
+static struct listener listeners[2] = {{-1, 0}, {-1, 1}};
+static long firstSeed = 0;   /* 0 for random seeds */
+static long nextGame = 0;
+static long maxSessions = 0;
+static long sessionsEnded = 0;
+static volatile sig_atomic_t stopping = 0;
+
+static void onSignal(int sig) {
+  stopping = 1;
+}
+
+static struct conn *newConn(struct loop *l, int fd, int binary) {
+  struct conn *c = l->free;
+
+  if (c != NULL)
+    l->free = c->nextFree;
+  else {
+    c = malloc(sizeof(struct conn));
+    if (c == NULL || outInit(&c->out, OUT_INITIAL, OUT_LIMIT) < 0) {
+      free(c);
+      return NULL;
+    }
+    c->shadow = NULL;
+    c->seen = NULL;
+  }
+  c->fd = fd;
+  c->binary = binary;
+  c->closing = 0;
+  c->sent = 0;
+  c->inLen = 0;
+  c->feeding = 0;
+  outClear(&c->out);
+  return c;
+}
+
+static void closeConn(struct loop *l, struct conn *c) {
+  epoll_ctl(l->epfd, EPOLL_CTL_DEL, c->fd, NULL);
+  close(c->fd);
+  l->sessions++;
+  l->commands += c->game.commands;
+  c->nextFree = l->free;
+  l->free = c;
+  if (__atomic_add_fetch(&sessionsEnded, 1, __ATOMIC_RELAXED) == maxSessions)
+    stopping = 1;
+}
+
+static int watch(struct loop *l, struct conn *c, int op, unsigned int events) {
+  struct epoll_event ev;
+
+  ev.events = events;
+  ev.data.ptr = c;
+  return epoll_ctl(l->epfd, op, c->fd, &ev);
+}
+
+//writes what it can; returns 1 when everything is out, 0 if the socket
+//is full, -1 if the connection is gone
+static int flush(struct conn *c) {
+  ssize_t n;
+
+  while (c->sent < c->out.len) {
+    n = send(c->fd, c->out.data + c->sent, c->out.len - c->sent,
+	     MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EINTR)
+	continue;
+      return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+    }
+    c->sent += n;
+  }
+  outClear(&c->out);
+  c->sent = 0;
+  return 1;
+}
+
+//answers a move, or greets when m is NULL, with the view's changes
+static void sendView(struct conn *c, struct sessionMove *m, int over) {
+  unsigned char frame[BIN_MAX_RESULT];
+  struct sessionMove hello;
+  int view[VIEW_SLOTS];
+  int i;
+
+  if (m == NULL) {
+    //nothing is known yet, so every slot goes out
+    for (i = 0; i < VIEW_SLOTS; i++)
+      c->last[i] = VIEW_UNKNOWN;
+    memset(&hello, 0, sizeof(hello));
+    m = &hello;
+  }
+  sessionView(&c->game, view);
+  outAppend(&c->out, (char *)frame,
+	    encodeBinResult(m, over, view, c->last, frame));
+}
+
+//sends a keyframe or, once feeding, whatever changed since the last
+//frame; the client is playing, so it only gets what it may know
+static int sendFeed(struct conn *c, int type) {
+  unsigned char frame[BIN_MAX_FRAME];
+
+  if (c->shadow == NULL) {
+    c->shadow = malloc(sizeof(struct gameState));
+    c->seen = malloc(sizeof(struct gameState));
+    if (c->shadow == NULL || c->seen == NULL) {
+      free(c->shadow);
+      free(c->seen);
+      c->shadow = c->seen = NULL;
+      return -1;
+    }
+  }
+  feedView(&c->game.game, whoseTurn(&c->game.game), c->seen);
+  return outAppend(&c->out, (char *)frame,
+		   encodeBinFeed(type, c->seen, c->shadow, frame));
+}
+
+//runs every complete move in the input buffer
+static int runMoves(struct conn *c) {
+  struct sessionMove m;
+  int off = 0;
+  int used;
+
+  while (!c->closing
+	 && (used = decodeBinMove((unsigned char *)c->in + off,
+				  c->inLen - off, &m)) > 0) {
+    if (binMoveAllowed(&c->game, &m) < 0)
+      return -1;
+    c->closing = sessionRun(&c->game, &m, NULL);
+    //the feed goes first, so the client's copy is current with the result
+    if (m.op == SESSION_FEED && !c->feeding) {
+      c->feeding = 1;
+      if (sendFeed(c, BIN_KEYFRAME) < 0)
+	return -1;
+    }
+    else if (c->feeding && sendFeed(c, BIN_DELTA) < 0)
+      return -1;
+    sendView(c, &m, c->closing);
+    off += used;
+  }
+  if (!c->closing && used < 0)
+    return -1;
+  memmove(c->in, c->in + off, c->inLen - off);
+  c->inLen -= off;
+  return 0;
+}
+
+//runs every complete line in the input buffer
+static void runLines(struct conn *c) {
+  char *line = c->in;
+  char *end;
+  int left = c->inLen;
+
+  while (!c->closing && left > 0) {
+    end = memchr(line, '\n', left);
+    if (end == NULL) {
+      //a line too long for the buffer is cut, as fgets would
+      if (left < IN_BUFFER)
+	break;
+      end = line + left - 1;
+    }
+    *end = '\0';
+    c->closing = sessionCommand(&c->game, line, &c->out);
+    if (!c->closing)
+      outAppend(&c->out, "$ ", 2);
+    left -= end + 1 - line;
+    line = end + 1;
+  }
+  memmove(c->in, line, left);
+  c->inLen = left;
+}
+
+//sends the pending output and decides what to wait for next
+static void afterOutput(struct loop *l, struct conn *c) {
+  int done = flush(c);
+
+  if (done < 0 || (done == 1 && c->closing))
+    closeConn(l, c);
+  else if (done == 0)
+    watch(l, c, EPOLL_CTL_MOD, EPOLLOUT);
+  else
+    watch(l, c, EPOLL_CTL_MOD, EPOLLIN | EPOLLRDHUP);
+}
+
+static void readConn(struct loop *l, struct conn *c) {
+  ssize_t n = read(c->fd, c->in + c->inLen, IN_BUFFER - c->inLen);
+
+  if (n < 0 && (errno == EINTR || errno == EAGAIN))
+    return;
+  if (n <= 0) {
+    closeConn(l, c);
+    return;
+  }
+  c->inLen += n;
+  if (!c->binary)
+    runLines(c);
+  else if (runMoves(c) < 0) {
+    closeConn(l, c);
+    return;
+  }
+  afterOutput(l, c);
+}
+
+//a seed in 1..2^31-1, or -1 if none could be had
+static int gameSeed(long game) {
+  unsigned int r;
+
+  if (firstSeed > 0)
+    return (int)(firstSeed + game);
+  if (getrandom(&r, sizeof(r), 0) != sizeof(r))
+    return -1;
+  return (int)(r % 2147483647U) + 1;
+}
+
+static void acceptConns(struct loop *l, struct listener *from) {
+  struct conn *c;
+  long game;
+  int one = 1;
+  int fd;
+
+  while ((fd = accept4(from->fd, NULL, NULL, SOCK_NONBLOCK)) >= 0) {
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    c = newConn(l, fd, from->binary);
+    game = __atomic_fetch_add(&nextGame, 1, __ATOMIC_RELAXED);
+    if (c == NULL
+	|| sessionStart(&c->game, gameSeed(game),
+			from->binary ? NULL : &c->out) < 0) {
+      if (c != NULL) {
+	c->nextFree = l->free;
+	l->free = c;
+      }
+      close(fd);
+      continue;
+    }
+    if (from->binary)
+      sendView(c, NULL, 0);
+    else
+      outAppend(&c->out, "$ ", 2);
+    if (watch(l, c, EPOLL_CTL_ADD, EPOLLIN | EPOLLRDHUP) < 0) {
+      closeConn(l, c);
+      continue;
+    }
+    afterOutput(l, c);
+  }
+}
+
+static void *runLoop(void *arg) {
+  struct loop *l = arg;
+  struct epoll_event events[MAX_EVENTS];
+  struct conn *c;
+  int n;
+  int i;
+
+  while (!stopping) {
+    //wake up now and then to notice a stop
+    n = epoll_wait(l->epfd, events, MAX_EVENTS, 200);
+    for (i = 0; i < n; i++) {
+      c = events[i].data.ptr;
+      if (c == (void *)&listeners[0] || c == (void *)&listeners[1])
+	acceptConns(l, events[i].data.ptr);
+      else if (events[i].events & EPOLLOUT)
+	afterOutput(l, c);
+      else if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+	readConn(l, c);
+    }
+  }
+  return NULL;
+}
+
+static int listenTcp(int port) {
+  struct sockaddr_in addr;
+  int one = 1;
+  int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+
+  if (fd < 0)
+    return -1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+  if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0
+      || listen(fd, SOMAXCONN) < 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static int listenUnix(const char *path) {
+  struct sockaddr_un addr;
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+
+  if (fd < 0 || strlen(path) >= sizeof(addr.sun_path)) {
+    if (fd >= 0)
+      close(fd);
+    return -1;
+  }
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, path);
+  unlink(path);
+  if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0
+      || listen(fd, SOMAXCONN) < 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static void usage(void) {
+  printf("Usage: domserver [-l port | -u socket path] [-b port | -B socket path]\n"
+	 "                 [-j loops] [-s first seed] [-n sessions]\n");
+}
+
+int main(int argc, char **argv) {
+  struct loop loops[MAX_LOOPS];
+  struct epoll_event ev;
+  const char *path = NULL;
+  const char *binPath = NULL;
+  long sessions = 0;
+  long commands = 0;
+  int port = DOM_DEFAULT_PORT;
+  int binPort = 0;
+  int numLoops = 1;
+  int opt;
+  int i;
+  int k;
+
+  while ((opt = getopt(argc, argv, "l:u:b:B:j:s:n:")) != -1) {
+    switch (opt) {
+    case 'l': port = atoi(optarg); break;
+    case 'u': path = optarg; break;
+    case 'b': binPort = atoi(optarg); break;
+    case 'B': binPath = optarg; break;
+    case 'j': numLoops = atoi(optarg); break;
+    case 's': firstSeed = atol(optarg); break;
+    case 'n': maxSessions = atol(optarg); break;
+    default: usage(); return 1;
+    }
+  }
+  if (numLoops < 1 || numLoops > MAX_LOOPS || firstSeed < 0
+      || maxSessions < 0 || binPort < 0) {
+    usage();
+    return 1;
+  }
+  listeners[0].fd = path != NULL ? listenUnix(path) : listenTcp(port);
+  if (listeners[0].fd < 0) {
+    printf("Could not listen on %s\n", path != NULL ? path : "the port");
+    return 1;
+  }
+  if (binPath != NULL || binPort > 0) {
+    listeners[1].fd = binPath != NULL ? listenUnix(binPath)
+      : listenTcp(binPort);
+    if (listeners[1].fd < 0) {
+      printf("Could not listen on %s\n",
+	     binPath != NULL ? binPath : "the binary port");
+      return 1;
+    }
+  }
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+  signal(SIGPIPE, SIG_IGN);
+
+  for (i = 0; i < numLoops; i++) {
+    memset(&loops[i], 0, sizeof(struct loop));
+    loops[i].epfd = epoll_create1(0);
+    if (loops[i].epfd < 0) {
+      printf("Could not start event loop %d\n", i);
+      return 1;
+    }
+    for (k = 0; k < 2; k++) {
+      ev.events = EPOLLIN | EPOLLEXCLUSIVE;
+      ev.data.ptr = &listeners[k];
+      if (listeners[k].fd >= 0
+	  && epoll_ctl(loops[i].epfd, EPOLL_CTL_ADD, listeners[k].fd, &ev) < 0) {
+	printf("Could not start event loop %d\n", i);
+	return 1;
+      }
+    }
+    if (pthread_create(&loops[i].thread, NULL, runLoop, &loops[i]) != 0) {
+      printf("Could not start event loop %d\n", i);
+      return 1;
+    }
+  }
+  if (path != NULL)
+    printf("Serving on %s", path);
+  else
+    printf("Serving on port %d", port);
+  if (binPath != NULL)
+    printf(", binary on %s", binPath);
+  else if (binPort > 0)
+    printf(", binary on port %d", binPort);
+  printf(" with %d loops\n", numLoops);
+  fflush(stdout);
+
+  for (i = 0; i < numLoops; i++) {
+    pthread_join(loops[i].thread, NULL);
+    sessions += loops[i].sessions;
+    commands += loops[i].commands;
+  }
+  for (k = 0; k < 2; k++) {
+    if (listeners[k].fd >= 0)
+      close(listeners[k].fd);
+  }
+  if (path != NULL)
+    unlink(path);
+  if (binPath != NULL)
+    unlink(binPath);
+  printf("Sessions: %ld\nCommands: %ld\n", sessions, commands);
+  return 0;
+}
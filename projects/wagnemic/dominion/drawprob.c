@@ -0,0 +1,234 @@
+#include "drawprob.h"
+#include <string.h>
+
+enum DRAW_QUERY {
+  QUERY_COINS = 1,
+  QUERY_CARD
+};
+
+#define KEY_INTS (2 + 2 * DRAW_KINDS)
+
+struct drawEntry {
+  int key[KEY_INTS];   /* query, n, then the pile counts; 0s when unused */
+  int top;
+  double dist[DRAW_MAX_COINS + 1];
+};
+
+static __thread struct drawEntry table[DRAW_CACHE_SIZE];
+static __thread struct drawStats counts;
+
+static unsigned int hashKey(int *key) {
+  unsigned int h = 2166136261u;
+  int i;
+
+  for (i = 0; i < KEY_INTS; i++) {
+    h ^= (unsigned int)key[i];
+    h *= 16777619u;
+  }
+  return h;
+}
+
+//the entry for key; *hit says whether it holds the answer already,
+//otherwise it is claimed for key and the caller fills it in
+static struct drawEntry *lookup(int *key, int *hit) {
+  struct drawEntry *e = &table[hashKey(key) % DRAW_CACHE_SIZE];
+
+  counts.queries++;
+  *hit = memcmp(e->key, key, sizeof(e->key)) == 0;
+  if (*hit)
+    counts.hits++;
+  else
+    memcpy(e->key, key, sizeof(e->key));
+  return e;
+}
+
+static double choose(int n, int k) {
+  double c = 1;
+  int i;
+
+  if (k < 0 || k > n)
+    return 0;
+  if (k > n - k)
+    k = n - k;
+  for (i = 1; i <= k; i++)
+    c = c * (n - k + i) / i;
+  return c;
+}
+
+static int pileSize(int *pile) {
+  int size = 0;
+  int i;
+
+  for (i = 0; i < DRAW_KINDS; i++)
+    size += pile[i];
+  return size;
+}
+
+//adds the coins of n cards drawn from pile, on top of base, to dist
+static int coinsFrom(int *pile, int n, int base, double *dist) {
+  int size = pileSize(pile);
+  int top = base;
+  double all;
+  int c, s, g, o;
+
+  if (n > size)
+    n = size;
+  all = choose(size, n);
+  for (c = 0; c <= n && c <= pile[DRAW_COPPER]; c++) {
+    for (s = 0; c + s <= n && s <= pile[DRAW_SILVER]; s++) {
+      for (g = 0; c + s + g <= n && g <= pile[DRAW_GOLD]; g++) {
+	o = n - c - s - g;
+	if (o > pile[DRAW_OTHER])
+	  continue;
+	dist[base + c + 2 * s + 3 * g] += choose(pile[DRAW_COPPER], c)
+	  * choose(pile[DRAW_SILVER], s) * choose(pile[DRAW_GOLD], g)
+	  * choose(pile[DRAW_OTHER], o) / all;
+	if (base + c + 2 * s + 3 * g > top)
+	  top = base + c + 2 * s + 3 * g;
+      }
+    }
+  }
+  return top;
+}
+
+int drawCoins(struct drawPiles *p, int n, double *dist) {
+  int key[KEY_INTS];
+  struct drawEntry *e;
+  int deckSize = pileSize(p->deck);
+  int hit;
+  int i;
+
+  if (n < 0 || n > DRAW_MAX_CARDS)
+    return -1;
+  for (i = 0; i < DRAW_KINDS; i++) {
+    if (p->deck[i] < 0 || p->discard[i] < 0)
+      return -1;
+  }
+  key[0] = QUERY_COINS;
+  key[1] = n;
+  memcpy(&key[2], p->deck, sizeof(p->deck));
+  memcpy(&key[2 + DRAW_KINDS], p->discard, sizeof(p->discard));
+  e = lookup(key, &hit);
+  if (!hit) {
+    memset(e->dist, 0, sizeof(e->dist));
+    if (n <= deckSize)
+      e->top = coinsFrom(p->deck, n, 0, e->dist);
+    else
+      //the whole deck is drawn before the reshuffle
+      e->top = coinsFrom(p->discard, n - deckSize, p->deck[DRAW_COPPER]
+			 + 2 * p->deck[DRAW_SILVER] + 3 * p->deck[DRAW_GOLD],
+			 e->dist);
+  }
+  memcpy(dist, e->dist, (e->top + 1) * sizeof(double));
+  return e->top;
+}
+
+double drawAtLeastCoins(struct drawPiles *p, int n, int coins) {
+  double dist[DRAW_MAX_COINS + 1];
+  double chance = 0;
+  int top = drawCoins(p, n, dist);
+  int c;
+
+  for (c = coins > 0 ? coins : 0; c <= top; c++)
+    chance += dist[c];
+  return chance;
+}
+
+int drawCardCount(int deckSize, int deckHas, int discardSize, int discardHas,
+		  int n, double *dist) {
+  int key[KEY_INTS];
+  struct drawEntry *e;
+  int size, has, base;
+  int hit;
+  int k;
+
+  if (n < 0 || n > DRAW_MAX_CARDS || deckHas < 0 || deckHas > deckSize
+      || discardHas < 0 || discardHas > discardSize)
+    return -1;
+  memset(key, 0, sizeof(key));
+  key[0] = QUERY_CARD;
+  key[1] = n;
+  key[2] = deckSize;
+  key[3] = deckHas;
+  key[4] = discardSize;
+  key[5] = discardHas;
+  e = lookup(key, &hit);
+  if (!hit) {
+    memset(e->dist, 0, sizeof(e->dist));
+    size = deckSize;
+    has = deckHas;
+    base = 0;
+    if (n > deckSize) {
+      size = discardSize;
+      has = discardHas;
+      base = deckHas;
+      n -= deckSize;
+      if (n > size)
+	n = size;
+    }
+    e->top = base;
+    for (k = 0; k <= n && k <= has; k++) {
+      e->dist[base + k] = choose(has, k) * choose(size - has, n - k)
+	/ choose(size, n);
+      if (e->dist[base + k] > 0)
+	e->top = base + k;
+    }
+  }
+  memcpy(dist, e->dist, (e->top + 1) * sizeof(double));
+  return e->top;
+}
+
+static int kindOf(int card) {
+  switch (card) {
+  case copper: return DRAW_COPPER;
+  case silver: return DRAW_SILVER;
+  case gold: return DRAW_GOLD;
+  default: return DRAW_OTHER;
+  }
+}
+
+void drawPilesFor(int player, int nextTurn, struct gameState *g,
+		  struct drawPiles *p) {
+  int i;
+
+  memset(p, 0, sizeof(struct drawPiles));
+  for (i = 0; i < g->deckCount[player]; i++)
+    p->deck[kindOf(g->deck[player][i])]++;
+  for (i = 0; i < g->discardCount[player]; i++)
+    p->discard[kindOf(g->discard[player][i])]++;
+  //endTurn discards the hand; played cards do not come back
+  if (nextTurn && player == whoseTurn(g)) {
+    for (i = 0; i < g->handCount[player]; i++)
+      p->discard[kindOf(g->hand[player][i])]++;
+  }
+}
+
+double drawAtLeast(int player, int card, int nextTurn, struct gameState *g,
+		   int n, int k) {
+  double dist[DRAW_MAX_COINS + 1];
+  int deckHas = 0;
+  int discardHas = 0;
+  int discardSize = g->discardCount[player];
+  double chance = 0;
+  int top;
+  int i;
+
+  for (i = 0; i < g->deckCount[player]; i++)
+    deckHas += g->deck[player][i] == card;
+  for (i = 0; i < g->discardCount[player]; i++)
+    discardHas += g->discard[player][i] == card;
+  if (nextTurn && player == whoseTurn(g)) {
+    discardSize += g->handCount[player];
+    for (i = 0; i < g->handCount[player]; i++)
+      discardHas += g->hand[player][i] == card;
+  }
+  top = drawCardCount(g->deckCount[player], deckHas, discardSize, discardHas,
+		      n, dist);
+  for (i = k > 0 ? k : 0; i <= top; i++)
+    chance += dist[i];
+  return chance;
+}
+
+void drawCacheStats(struct drawStats *s) {
+  *s = counts;
+}
@@ -0,0 +1,72 @@
+/* Exact draw probabilities
+
+   Distributions of what the next n cards a player draws will hold,
+   worked out from how many of each card are in the deck and the
+   discard pile rather than by playing it out.  The deck's order is
+   taken as unknown: the cards come from the deck, and when it runs out
+   the discard pile is shuffled into a new one, as drawCard does, and
+   the rest come from that; if both run out fewer cards are drawn.
+   Coins are what updateCoins counts in a hand: 1 for a copper, 2 for a
+   silver and 3 for a gold.
+
+   A bot asks the same few questions many times in a turn, so every
+   answer is memoized, per thread, in a direct-mapped table keyed by
+   the query and the pile compositions it depends on; asking again
+   costs a hash and a copy.
+*/
+
+#ifndef _DRAWPROB_H
+#define _DRAWPROB_H
+
+#include "dominion.h"
+
+#define DRAW_MAX_CARDS 10                 /* most cards one query draws */
+#define DRAW_MAX_COINS (3 * DRAW_MAX_CARDS)
+#define DRAW_CACHE_SIZE 256
+
+enum DRAW_KIND {
+  DRAW_OTHER = 0,
+  DRAW_COPPER,
+  DRAW_SILVER,
+  DRAW_GOLD,
+  DRAW_KINDS
+};
+
+struct drawPiles {
+  int deck[DRAW_KINDS];
+  int discard[DRAW_KINDS];
+};
+
+struct drawStats {
+  long queries;
+  long hits;
+};
+
+void drawPilesFor(int player, int nextTurn, struct gameState *g,
+		  struct drawPiles *p);
+/* The piles player draws from: now, or with nextTurn set, at the start
+   of their next turn, when the hand they hold now (if it is their turn)
+   has been discarded */
+
+int drawCoins(struct drawPiles *p, int n, double *dist);
+/* dist[c] is the chance the next n cards are worth c coins, for c up to
+   the value returned (at most 3n); -1 if n is over DRAW_MAX_CARDS */
+
+double drawAtLeastCoins(struct drawPiles *p, int n, int coins);
+
+int drawCardCount(int deckSize, int deckHas, int discardSize, int discardHas,
+		  int n, double *dist);
+/* dist[k] is the chance that k of the next n cards are a card the deck
+   has deckHas of and the discard pile discardHas of, for k up to the
+   value returned (at most n); -1 if n is over DRAW_MAX_CARDS or a count
+   does not fit its pile */
+
+double drawAtLeast(int player, int card, int nextTurn, struct gameState *g,
+		   int n, int k);
+/* The chance of k or more of card in player's next n cards (see
+   drawPilesFor for nextTurn) */
+
+void drawCacheStats(struct drawStats *s);
+/* This thread's queries, and how many the table answered */
+
+#endif
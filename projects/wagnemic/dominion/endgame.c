@@ -0,0 +1,435 @@
+#include "endgame.h"
+#include "drawprob.h"
+#include "dominion_helpers.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define TIME_CHECK 255      /* nodes between looks at the clock, less 1 */
+#define MAX_COUNT 255       /* what a packed count holds */
+#define NO_DRAIN MAX_COUNT  /* the drain card when every other pile is out */
+
+enum END_PILE {
+  PILE_PROVINCE = 0,
+  PILE_DUCHY,
+  PILE_ESTATE,
+  PILE_GOLD,
+  PILE_SILVER,
+  PILE_COPPER,
+  PILE_DRAIN,               /* the smallest other pile */
+  END_PILES
+};
+
+static const int pileCard[PILE_DRAIN] = {province, duchy, estate, gold,
+					 silver, copper};
+
+//everything the race turns on, packed so it hashes as it stands
+struct endPosition {
+  unsigned char deck[2][DRAW_KINDS];
+  unsigned char discard[2][DRAW_KINDS];
+  unsigned char fresh[2];   /* next hand still dealt from the real piles */
+  unsigned char supply[END_PILES];
+  unsigned char drain;      /* the card of PILE_DRAIN */
+  unsigned char otherEmpty; /* empty piles not counted in supply */
+  unsigned char toMove;
+  unsigned char coins;
+  unsigned char buys;
+  short score[2];
+};
+
+struct endEntry {
+  unsigned long long key;
+  float value;              /* for player 0 */
+  unsigned char depth;
+  unsigned char exact;      /* no guess below it */
+};
+
+struct endgame {
+  struct endEntry *table;
+  unsigned long mask;
+  double deadline;
+  long nodes;
+  int aborted;
+  int guessed;              /* a guess went into the node being searched */
+};
+
+struct endgame *endgameCreate(int tableBits) {
+  struct endgame *e = calloc(1, sizeof(struct endgame));
+
+  if (e == NULL)
+    return NULL;
+  e->table = calloc(1UL << tableBits, sizeof(struct endEntry));
+  if (e->table == NULL) {
+    free(e);
+    return NULL;
+  }
+  e->mask = (1UL << tableBits) - 1;
+  return e;
+}
+
+void endgameFree(struct endgame *e) {
+  if (e == NULL)
+    return;
+  free(e->table);
+  free(e);
+}
+
+static int tracked(int card) {
+  int i;
+
+  for (i = 0; i < PILE_DRAIN; i++) {
+    if (pileCard[i] == card)
+      return 1;
+  }
+  return 0;
+}
+
+int endgameActive(struct gameState *g) {
+  int low = 0;
+  int i;
+
+  if (g->supplyCount[province] <= ENDGAME_PROVINCES)
+    return 1;
+  //isGameOver only counts the first 25 piles
+  for (i = 0; i < 25; i++) {
+    if (g->supplyCount[i] >= 0 && g->supplyCount[i] <= ENDGAME_LOW_PILE)
+      low++;
+  }
+  return low >= 3;
+}
+
+static int kindOf(int card) {
+  switch (card) {
+  case copper: return DRAW_COPPER;
+  case silver: return DRAW_SILVER;
+  case gold: return DRAW_GOLD;
+  default: return DRAW_OTHER;
+  }
+}
+
+static int cardOf(struct endPosition *s, int pile) {
+  return pile == PILE_DRAIN ? s->drain : pileCard[pile];
+}
+
+static int victoryPoints(int card) {
+  switch (card) {
+  case curse: return -1;
+  case estate: case great_hall: return 1;
+  case duchy: return 3;
+  case province: return 6;
+  default: return 0;   //gardens are worth too little to race for
+  }
+}
+
+static int pack(struct gameState *g, struct endPosition *s) {
+  int counts[2][2][DRAW_KINDS];
+  int fewest = -1;
+  int p, i, k;
+
+  if (g->numPlayers != 2)
+    return -1;
+  memset(s, 0, sizeof(struct endPosition));
+  memset(counts, 0, sizeof(counts));
+  for (p = 0; p < 2; p++) {
+    for (i = 0; i < g->deckCount[p]; i++)
+      counts[p][0][kindOf(g->deck[p][i])]++;
+    for (i = 0; i < g->discardCount[p]; i++)
+      counts[p][1][kindOf(g->discard[p][i])]++;
+    //endTurn discards the hand before its owner draws again
+    if (p == whoseTurn(g)) {
+      for (i = 0; i < g->handCount[p]; i++)
+	counts[p][1][kindOf(g->hand[p][i])]++;
+    }
+    for (k = 0; k < DRAW_KINDS; k++) {
+      if (counts[p][0][k] + counts[p][1][k] > MAX_COUNT / 2)
+	return -1;
+      s->deck[p][k] = counts[p][0][k];
+      s->discard[p][k] = counts[p][1][k];
+    }
+    s->fresh[p] = 1;
+    s->score[p] = scoreFor(p, g);
+  }
+  for (i = 0; i < PILE_DRAIN; i++)
+    s->supply[i] = g->supplyCount[pileCard[i]] > 0
+      ? g->supplyCount[pileCard[i]] : 0;
+  s->drain = NO_DRAIN;
+  for (i = 0; i < 25; i++) {
+    if (tracked(i) || g->supplyCount[i] < 0)
+      continue;
+    if (g->supplyCount[i] == 0)
+      s->otherEmpty++;
+    else if (fewest < 0 || g->supplyCount[i] < g->supplyCount[fewest]
+	     || (g->supplyCount[i] == g->supplyCount[fewest]
+		 && getCost(i) < getCost(fewest)))
+      fewest = i;
+  }
+  if (fewest >= 0) {
+    s->drain = fewest;
+    s->supply[PILE_DRAIN] = g->supplyCount[fewest];
+  }
+  s->toMove = whoseTurn(g);
+  s->coins = g->coins > MAX_COUNT ? MAX_COUNT : g->coins;
+  s->buys = g->numBuys > MAX_COUNT ? MAX_COUNT : g->numBuys;
+  return 0;
+}
+
+static int over(struct endPosition *s) {
+  int empty = s->otherEmpty;
+  int i;
+
+  if (s->supply[PILE_PROVINCE] == 0)
+    return 1;
+  for (i = 0; i < END_PILES; i++)
+    empty += s->supply[i] == 0;
+  //with no other pile left, PILE_DRAIN is no pile at all
+  if (s->drain == NO_DRAIN)
+    empty--;
+  return empty >= 3;
+}
+
+static double final(struct endPosition *s) {
+  if (s->score[0] == s->score[1])
+    return 0.5;
+  return s->score[0] > s->score[1] ? 1 : 0;
+}
+
+//past the depth limit: a lead is safer the fewer provinces are left
+static double guess(struct endgame *e, struct endPosition *s) {
+  double scale = 3 + 3 * s->supply[PILE_PROVINCE];
+
+  e->guessed = 1;
+  return 1 / (1 + exp(-(s->score[0] - s->score[1]) / scale));
+}
+
+static unsigned long long hashPosition(struct endPosition *s) {
+  const unsigned char *bytes = (const unsigned char *)s;
+  unsigned long long h = 14695981039346656037ULL;
+  size_t i;
+
+  for (i = 0; i < sizeof(struct endPosition); i++) {
+    h ^= bytes[i];
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+static int timeUp(struct endgame *e) {
+  if ((++e->nodes & TIME_CHECK) == 0 && botClock() > e->deadline)
+    e->aborted = 1;
+  return e->aborted;
+}
+
+static double buy(struct endgame *e, struct endPosition *s, int depth,
+		  int *best);
+
+//the turn of s->toMove starts: every hand it could draw, weighted
+static double draw(struct endgame *e, struct endPosition *s, int depth) {
+  struct endPosition next = *s;
+  struct drawPiles piles;
+  double dist[DRAW_MAX_COINS + 1];
+  double value = 0;
+  int p = s->toMove;
+  int top;
+  int c, k;
+
+  if (depth == 0)
+    return guess(e, s);
+  if (timeUp(e))
+    return 0;
+  memcpy(piles.deck, s->deck[p], sizeof(piles.deck));
+  memcpy(piles.discard, s->discard[p], sizeof(piles.discard));
+  //after the first hand, hands come from everything the player owns
+  for (k = 0; k < DRAW_KINDS; k++) {
+    next.deck[p][k] += next.discard[p][k];
+    next.discard[p][k] = 0;
+    if (!s->fresh[p]) {
+      piles.deck[k] = next.deck[p][k];
+      piles.discard[k] = 0;
+    }
+  }
+  next.fresh[p] = 0;
+  next.buys = 1;
+  top = drawCoins(&piles, 5, dist);
+  for (c = 0; c <= top; c++) {
+    if (dist[c] > 0) {
+      next.coins = c;
+      value += dist[c] * buy(e, &next, depth, NULL);
+    }
+  }
+  return value;
+}
+
+static double buy(struct endgame *e, struct endPosition *s, int depth,
+		  int *best) {
+  unsigned long long key = hashPosition(s);
+  struct endEntry *entry = &e->table[key & e->mask];
+  struct endPosition next;
+  int p = s->toMove;
+  int guessed = e->guessed;
+  double bestValue, value;
+  int pick = -1;
+  int card;
+  int i;
+
+  if (best == NULL && entry->key == key
+      && (entry->exact || entry->depth >= depth)) {
+    e->guessed |= !entry->exact;
+    return entry->value;
+  }
+  if (timeUp(e))
+    return 0;
+  e->guessed = 0;
+
+  //buying nothing more
+  next = *s;
+  next.toMove = 1 - p;
+  next.coins = 0;
+  next.buys = 0;
+  bestValue = draw(e, &next, depth - 1);
+  for (i = 0; i < END_PILES && !e->aborted; i++) {
+    card = cardOf(s, i);
+    if (s->supply[i] == 0 || getCost(card) > s->coins || s->buys == 0)
+      continue;
+    next = *s;
+    next.supply[i]--;
+    next.coins -= getCost(card);
+    next.buys--;
+    next.discard[p][kindOf(card)]++;
+    next.score[p] += victoryPoints(card);
+    if (over(&next))
+      value = final(&next);
+    else if (next.buys > 0)
+      value = buy(e, &next, depth, NULL);
+    else {
+      next.toMove = 1 - p;
+      next.coins = 0;
+      value = draw(e, &next, depth - 1);
+    }
+    if (p == 0 ? value > bestValue : value < bestValue) {
+      bestValue = value;
+      pick = i;
+    }
+  }
+  if (e->aborted)
+    return 0;
+
+  entry->key = key;
+  entry->value = (float)bestValue;
+  entry->depth = depth;
+  entry->exact = !e->guessed;
+  e->guessed |= guessed;
+  if (best != NULL)
+    *best = pick;
+  return bestValue;
+}
+
+int endgameSolve(struct endgame *e, struct gameState *g, double deadline,
+		 int maxTurns, struct endgameResult *r) {
+  struct endPosition root;
+  double value;
+  int found = 0;
+  int depth;
+  int pick;
+
+  if (pack(g, &root) < 0 || isGameOver(g))
+    return -1;
+  e->deadline = deadline;
+  e->nodes = 0;
+  e->aborted = 0;
+  for (depth = 1; depth <= maxTurns && depth <= MAX_COUNT; depth++) {
+    e->guessed = 0;
+    value = buy(e, &root, depth, &pick);
+    if (e->aborted)
+      break;
+    found = 1;
+    r->move.type = pick < 0 ? MCTS_END_TURN : MCTS_BUY;
+    r->move.card = pick < 0 ? -1 : cardOf(&root, pick);
+    r->value = root.toMove == 0 ? value : 1 - value;
+    r->depth = depth;
+    //nothing was guessed, or the result is certain, so looking deeper
+    //changes nothing (a guess is never quite 0 or 1)
+    if (!e->guessed || value == 0 || value == 1)
+      break;
+  }
+  r->nodes = e->nodes;
+  return found ? 0 : -1;
+}
+
+struct endgameBot {
+  struct bot bot;
+  struct bot *inner;
+  struct endgame *solver;
+  int maxTurns;
+  long overrides;
+};
+
+//the inner bot still has actions to play
+static int inActions(struct gameState *g) {
+  struct mctsMove moves[MCTS_MAX_MOVES];
+  int n;
+  int i;
+
+  if (g->phase != 0 || g->numActions == 0)
+    return 0;
+  n = mctsLegalMoves(g, moves);
+  for (i = 0; i < n; i++) {
+    if (moves[i].type == MCTS_PLAY)
+      return 1;
+  }
+  return 0;
+}
+
+static int endgameDecide(struct bot *b, struct gameState *g, double deadline,
+			 struct mctsMove *m) {
+  struct endgameBot *eb = (struct endgameBot *)b;
+  struct endgameResult r;
+  int result;
+
+  if (isGameOver(g))
+    return -1;
+  if (endgameActive(g) && !inActions(g)
+      && endgameSolve(eb->solver, g, deadline == BOT_NO_DEADLINE
+		      ? botClock() + ENDGAME_SECONDS : deadline,
+		      eb->maxTurns, &r) == 0) {
+    *m = r.move;
+    eb->overrides++;
+    result = 0;
+  } else
+    result = botDecide(eb->inner, g, deadline, m);
+  b->stats = eb->inner->stats;
+  b->stats.decisions += eb->overrides;
+  b->stats.endgame = eb->overrides;
+  return result;
+}
+
+static void endgameMoved(struct bot *b, struct mctsMove *m,
+			 struct gameState *after) {
+  botMoved(((struct endgameBot *)b)->inner, m, after);
+}
+
+static void endgameDestroy(struct bot *b) {
+  struct endgameBot *eb = (struct endgameBot *)b;
+
+  botFree(eb->inner);
+  endgameFree(eb->solver);
+  free(eb);
+}
+
+struct bot *endgameBot(struct bot *inner, int maxTurns) {
+  struct endgameBot *eb = calloc(1, sizeof(struct endgameBot));
+
+  if (eb == NULL)
+    return NULL;
+  eb->solver = endgameCreate(ENDGAME_TABLE_BITS);
+  if (eb->solver == NULL) {
+    free(eb);
+    return NULL;
+  }
+  eb->bot.decide = endgameDecide;
+  eb->bot.moved = endgameMoved;
+  eb->bot.destroy = endgameDestroy;
+  eb->bot.seat = inner->seat;
+  eb->inner = inner;
+  eb->maxTurns = maxTurns;
+  return &eb->bot;
+}
@@ -0,0 +1,67 @@
+/* Endgame solver
+
+   Once the provinces run low, or three piles come within a couple of
+   buys of empty, the rest of a two player game is mostly a race of
+   buys: which victory card to take, whether to take the penultimate
+   province, whether emptying a pile ends the game in front.  The solver
+   searches that race exactly, with expectimax over the players' draws.
+
+   The game is cut down to what the race turns on: each player's score
+   and coppers, silvers, golds and other cards, the victory and treasure
+   piles, and the smallest of the other piles (the one a player would
+   empty to end the game on piles).  A turn is a draw, worth some coins,
+   and buys; actions are played by whoever the solver stands in for
+   before it is asked.  Each player's next hand is dealt from their real
+   deck and discard pile, reshuffle included (see drawprob.h); later
+   hands are dealt from everything they own.  The game ends as soon as
+   isGameOver would say so, and is won on score.
+
+   The search deepens one turn at a time up to a limit, and stops at a
+   deadline, answering from the deepest search it finished.  Positions
+   are packed into a few dozen bytes and hashed into a transposition
+   table that is kept from one decision to the next.  Past the depth
+   limit, a position is guessed from the lead and the provinces left.
+
+   endgameBot wraps any bot (see bot.h) and answers the buys itself in
+   the final turns.
+*/
+
+#ifndef _ENDGAME_H
+#define _ENDGAME_H
+
+#include "dominion.h"
+#include "ismcts.h"
+#include "bot.h"
+
+#define ENDGAME_PROVINCES 4     /* provinces left when the solver takes over */
+#define ENDGAME_LOW_PILE 2      /* cards left that make a pile nearly empty */
+#define ENDGAME_TABLE_BITS 18
+#define ENDGAME_SECONDS 0.1     /* the budget when a bot has no deadline */
+
+struct endgame;
+
+struct endgameResult {
+  struct mctsMove move;
+  double value;          /* chance the player to move wins, ties half */
+  int depth;             /* turns searched */
+  long nodes;
+};
+
+struct endgame *endgameCreate(int tableBits);
+void endgameFree(struct endgame *e);
+
+int endgameActive(struct gameState *g);
+/* Whether the game is close enough to over for the solver */
+
+int endgameSolve(struct endgame *e, struct gameState *g, double deadline,
+		 int maxTurns, struct endgameResult *r);
+/* The best buy (or MCTS_END_TURN) for the player to move, searching at
+   most maxTurns turns ahead and stopping at deadline (see botClock);
+   -1 if g is not a two player game in its buys, or not even one turn
+   could be searched in time */
+
+struct bot *endgameBot(struct bot *inner, int maxTurns);
+/* A bot that plays as inner, except that once endgameActive it picks
+   the buys; destroying it destroys inner */
+
+#endif
@@ -0,0 +1,572 @@
+/* Bounded-exhaustive state enumerator
+
+   Runs drawCard, or cardEffect for one card, on every state of the
+   current player up to the given pile sizes over a small set of cards,
+   and checks each result against an oracle.  States are canonical up
+   to the orders the engine cannot observe: the discard pile is only
+   ever shuffled (shuffle sorts it first), so it is enumerated as a
+   multiset, and so is the hand apart from the played card, which sits
+   at position 0.  The deck is enumerated as a sequence since draws take
+   it in order.  With -C the three choices each range over 0..n-1.
+
+   The oracles are checkInvariants (see invariants.h), "a call that
+   fails leaves the state alone", and an exact model for drawCard and
+   for the cards that only draw and add actions or buys (smithy,
+   village, great_hall, council_room).  States are numbered and sharded
+   over worker processes (see shard.h), so a state that crashes or hangs
+   the engine is isolated and reported instead of ending the run.  The
+   first state breaking each oracle is printed; with -o and a card
+   target it is also written as a state file for ddmin.
+
+   Usage: enumstate [-j workers] [-h hand] [-d deck] [-x discard]
+                    [-c card,card,...] [-C choices] [-T timeout]
+                    [-o prefix] drawCard | card
+*/
+
+#include "dominion.h"
+#include "dominion_helpers.h"
+#include "interface.h"
+#include "invariants.h"
+#include "statediff.h"
+#include "statefile.h"
+#include "shard.h"
+#include "rngs.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_ENUM_CARDS 8
+#define MAX_ENUM_PILE 12
+#define ENUM_SEED 1
+#define SHARD_STATES 20000
+#define TARGET_DRAW_CARD -1
+
+enum VIOLATION {
+  VIOLATION_NONE = 0,
+  VIOLATION_INVARIANT,   /* checkInvariants failed */
+  VIOLATION_CHANGED,     /* returned -1 but changed the state */
+  VIOLATION_MODEL,       /* differs from the oracle's model */
+  NUM_VIOLATIONS
+};
+
+static const char *violationNames[NUM_VIOLATIONS] = {
+  "none", "invariant", "changed", "model"
+};
+
+//every pile of one kind, each stored as indices into the card set
+struct pileList {
+  long count;
+  long cap;
+  int width;
+  unsigned char *lens;
+  unsigned char *cards;          /* count * width */
+};
+
+struct enumSpace {
+  int target;                    /* a card, or TARGET_DRAW_CARD */
+  int numCards;
+  int cards[MAX_ENUM_CARDS];
+  int choiceRange;               /* each choice is 0..choiceRange-1 */
+  int numChoices;
+  struct pileList hands;         /* the hand apart from a played card */
+  struct pileList decks;
+  struct pileList discards;
+  long total;
+  struct gameState base;
+};
+
+struct enumResult {
+  long states;
+  long violations[NUM_VIOLATIONS];
+  long first[NUM_VIOLATIONS];
+};
+
+//cards that only draw and add actions or buys
+struct drawModel {
+  int card;
+  int draws;
+  int actions;
+  int buys;
+  int othersDraw;
+};
+
+static const struct drawModel drawModels[] = {
+  {smithy, 3, 0, 0, 0},
+  {village, 1, 2, 0, 0},
+  {great_hall, 1, 1, 0, 0},
+  {council_room, 4, 0, 1, 1}
+};
+
+static double now(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int addPile(struct pileList *l, unsigned char *cards, int len) {
+  if (l->count == l->cap) {
+    l->cap = l->cap ? l->cap * 2 : 256;
+    l->lens = realloc(l->lens, l->cap);
+    l->cards = realloc(l->cards, l->cap * l->width);
+    if (l->lens == NULL || l->cards == NULL)
+      return -1;
+  }
+  l->lens[l->count] = len;
+  memcpy(l->cards + l->count * l->width, cards, len);
+  l->count++;
+  return 0;
+}
+
+//appends every pile of length len, in order, or sorted when !ordered
+static int genPiles(struct pileList *l, int numCards, int ordered, int len,
+		    int pos, int min, unsigned char *cur) {
+  int c;
+
+  if (pos == len)
+    return addPile(l, cur, len);
+  for (c = ordered ? 0 : min; c < numCards; c++) {
+    cur[pos] = c;
+    if (genPiles(l, numCards, ordered, len, pos + 1, c, cur) < 0)
+      return -1;
+  }
+  return 0;
+}
+
+static int makePiles(struct pileList *l, int numCards, int ordered,
+		     int maxLen) {
+  unsigned char cur[MAX_ENUM_PILE];
+  int len;
+
+  memset(l, 0, sizeof(*l));
+  l->width = maxLen > 0 ? maxLen : 1;
+  for (len = 0; len <= maxLen; len++) {
+    if (genPiles(l, numCards, ordered, len, 0, 0, cur) < 0)
+      return -1;
+  }
+  return 0;
+}
+
+static void setPile(struct enumSpace *s, struct pileList *l, long i,
+		    int *pile, int *count) {
+  unsigned char *cards = l->cards + i * l->width;
+  int j;
+
+  for (j = 0; j < l->lens[i]; j++)
+    pile[*count + j] = s->cards[cards[j]];
+  *count += l->lens[i];
+}
+
+//builds state number index; returns the choices through choices[3]
+static void buildState(struct enumSpace *s, long index,
+		       struct gameState *state, int choices[3]) {
+  long choice = index % s->numChoices;
+  long rest = index / s->numChoices;
+  long discard = rest % s->discards.count;
+  long hand;
+  long deck;
+  int i;
+
+  rest /= s->discards.count;
+  hand = rest % s->hands.count;
+  deck = rest / s->hands.count;
+  for (i = 0; i < 3; i++) {
+    choices[i] = choice % s->choiceRange;
+    choice /= s->choiceRange;
+  }
+
+  memcpy(state, &s->base, sizeof(struct gameState));
+  state->handCount[0] = 0;
+  state->deckCount[0] = 0;
+  state->discardCount[0] = 0;
+  if (s->target != TARGET_DRAW_CARD)
+    state->hand[0][state->handCount[0]++] = s->target;
+  setPile(s, &s->hands, hand, state->hand[0], &state->handCount[0]);
+  setPile(s, &s->decks, deck, state->deck[0], &state->deckCount[0]);
+  setPile(s, &s->discards, discard, state->discard[0],
+	  &state->discardCount[0]);
+}
+
+static void countPile(int *pile, int n, int counts[treasure_map + 1]) {
+  int i;
+
+  for (i = 0; i < n; i++) {
+    if (pile[i] >= curse && pile[i] <= treasure_map)
+      counts[pile[i]]++;
+  }
+}
+
+//the player's cards, with the played cards counted as theirs
+static void countPlayer(struct gameState *state, int player,
+			int counts[treasure_map + 1]) {
+  memset(counts, 0, (treasure_map + 1) * sizeof(int));
+  countPile(state->hand[player], state->handCount[player], counts);
+  countPile(state->deck[player], state->deckCount[player], counts);
+  countPile(state->discard[player], state->discardCount[player], counts);
+  if (player == state->whoseTurn)
+    countPile(state->playedCards, state->playedCardCount, counts);
+}
+
+static int sameCards(struct gameState *a, struct gameState *b, int player) {
+  int countsA[treasure_map + 1];
+  int countsB[treasure_map + 1];
+
+  countPlayer(a, player, countsA);
+  countPlayer(b, player, countsB);
+  return memcmp(countsA, countsB, sizeof(countsA)) == 0;
+}
+
+static int checkDrawCard(struct gameState *pre, struct gameState *post,
+			 int r) {
+  static struct gameState expected;
+  int n = pre->handCount[0];
+
+  if (pre->deckCount[0] > 0) {
+    memcpy(&expected, pre, sizeof(expected));
+    expected.hand[0][n] = pre->deck[0][pre->deckCount[0] - 1];
+    expected.handCount[0]++;
+    expected.deckCount[0]--;
+    return r == 0 && sameGameState(&expected, post) ? 0 : -1;
+  }
+  if (pre->discardCount[0] == 0)
+    return r == -1 ? 0 : -1;
+  //the discard pile is shuffled into the deck, then one card is drawn
+  if (r != 0 || post->discardCount[0] != 0
+      || post->deckCount[0] != pre->discardCount[0] - 1
+      || post->handCount[0] != n + 1
+      || memcmp(post->hand[0], pre->hand[0], n * sizeof(int)) != 0)
+    return -1;
+  return sameCards(pre, post, 0) ? 0 : -1;
+}
+
+static int checkDrawModel(const struct drawModel *m, struct gameState *pre,
+			  struct gameState *post, int r) {
+  int available = pre->deckCount[0] + pre->discardCount[0];
+  int drawn = m->draws < available ? m->draws : available;
+  int i;
+
+  if (r != 0 || post->handCount[0] != pre->handCount[0] + drawn - 1
+      || post->numActions != pre->numActions + m->actions
+      || post->numBuys != pre->numBuys + m->buys
+      || post->coins != pre->coins
+      || post->playedCardCount != pre->playedCardCount + 1
+      || post->playedCards[pre->playedCardCount] != m->card
+      || !sameCards(pre, post, 0))
+    return -1;
+  for (i = 1; i < pre->numPlayers; i++) {
+    available = pre->deckCount[i] + pre->discardCount[i];
+    if (post->handCount[i] != pre->handCount[i]
+	+ (m->othersDraw && available > 0)
+	|| !sameCards(pre, post, i))
+      return -1;
+  }
+  return 0;
+}
+
+static int checkModel(struct enumSpace *s, struct gameState *pre,
+		      struct gameState *post, int r) {
+  int i;
+
+  if (s->target == TARGET_DRAW_CARD)
+    return checkDrawCard(pre, post, r);
+  for (i = 0; i < sizeof(drawModels) / sizeof(drawModels[0]); i++) {
+    if (drawModels[i].card == s->target)
+      return checkDrawModel(&drawModels[i], pre, post, r);
+  }
+  return 0;
+}
+
+//runs the target on state number index; returns the violation found
+static int runState(struct enumSpace *s, long index, struct gameState *state,
+		    char *why, int size) {
+  static struct gameState pre;
+  int choices[3];
+  int bonus = 0;
+  long baseline;
+  int r;
+
+  buildState(s, index, state, choices);
+  memcpy(&pre, state, sizeof(pre));
+  baseline = cardTotal(state);
+  SelectStream(1);
+  PutSeed(ENUM_SEED);
+  if (s->target == TARGET_DRAW_CARD)
+    r = drawCard(0, state);
+  else
+    r = cardEffect(s->target, choices[0], choices[1], choices[2], state, 0,
+		   &bonus);
+
+  why[0] = '\0';
+  if (checkInvariants(state, baseline, why, size) > 0)
+    return VIOLATION_INVARIANT;
+  if (r < 0 && !sameGameState(&pre, state)) {
+    snprintf(why, size, "returned %d but changed the state", r);
+    return VIOLATION_CHANGED;
+  }
+  if (checkModel(s, &pre, state, r) < 0) {
+    snprintf(why, size, "returned %d, not what the model expects", r);
+    return VIOLATION_MODEL;
+  }
+  return VIOLATION_NONE;
+}
+
+static int enumShard(void *arg, long firstSeed, long games, void *result) {
+  static struct gameState state;
+  struct enumSpace *s = arg;
+  struct enumResult *res = result;
+  char why[INVARIANT_TEXT];
+  long i;
+  int v;
+
+  //some cards print while they run; keep the workers quiet
+  if (freopen("/dev/null", "w", stdout) == NULL)
+    return -1;
+  for (i = firstSeed; i < firstSeed + games; i++) {
+    v = runState(s, i, &state, why, sizeof(why));
+    res->states++;
+    if (v != VIOLATION_NONE && res->violations[v]++ == 0)
+      res->first[v] = i;
+  }
+  return 0;
+}
+
+static void mergeEnum(void *arg, void *total, void *result) {
+  struct enumResult *t = total;
+  struct enumResult *r = result;
+  int v;
+
+  t->states += r->states;
+  for (v = 1; v < NUM_VIOLATIONS; v++) {
+    if (r->violations[v] > 0
+	&& (t->violations[v] == 0 || r->first[v] < t->first[v]))
+      t->first[v] = r->first[v];
+    t->violations[v] += r->violations[v];
+  }
+}
+
+static void printPile(const char *label, int *pile, int n) {
+  char name[MAX_STRING_LENGTH];
+  int i;
+
+  printf("  %-8s", label);
+  for (i = 0; i < n; i++) {
+    cardNumToName(pile[i], name);
+    printf(" %s%s", name, i + 1 < n ? "," : "");
+  }
+  printf("\n");
+}
+
+static void writeCase(struct enumSpace *s, long index, const char *prefix,
+		      const char *kind) {
+  struct playCase c;
+  char path[256];
+  int choices[3];
+
+  if (prefix == NULL || s->target == TARGET_DRAW_CARD)
+    return;
+  memset(&c, 0, sizeof(c));
+  buildState(s, index, &c.state, choices);
+  c.entry = ENTRY_CARD_EFFECT;
+  c.card = s->target;
+  c.handPos = 0;
+  c.choice1 = choices[0];
+  c.choice2 = choices[1];
+  c.choice3 = choices[2];
+  c.seed = ENUM_SEED;
+  snprintf(path, sizeof(path), "%s-%s.dst", prefix, kind);
+  if (writeStateFile(path, &c) < 0)
+    printf("  Could not write %s\n", path);
+  else
+    printf("  Written to %s\n", path);
+}
+
+//replays state number index in this process and describes it
+static void reportState(struct enumSpace *s, long index, const char *prefix,
+			const char *kind) {
+  static struct gameState state;
+  char why[INVARIANT_TEXT];
+  int choices[3];
+
+  buildState(s, index, &state, choices);
+  printf("First %s state: %ld\n", kind, index);
+  printPile("hand", state.hand[0], state.handCount[0]);
+  printPile("deck", state.deck[0], state.deckCount[0]);
+  printPile("discard", state.discard[0], state.discardCount[0]);
+  if (s->target != TARGET_DRAW_CARD)
+    printf("  choices  %d %d %d\n", choices[0], choices[1], choices[2]);
+  if (strcmp(kind, "crash") != 0) {
+    runState(s, index, &state, why, sizeof(why));
+    printf("  %s\n", why);
+  }
+  writeCase(s, index, prefix, kind);
+}
+
+static int parseCards(char *list, struct enumSpace *s) {
+  char *name;
+  int card;
+
+  s->numCards = 0;
+  for (name = strtok(list, ","); name != NULL; name = strtok(NULL, ",")) {
+    card = cardNameToNum(name);
+    if (card < 0 || s->numCards == MAX_ENUM_CARDS)
+      return -1;
+    s->cards[s->numCards++] = card;
+  }
+  return s->numCards > 0 ? 0 : -1;
+}
+
+//a kingdom holding the target and the other action cards in the set
+static int setupBase(struct enumSpace *s) {
+  int defaults[] = {adventurer, council_room, feast, gardens, mine, remodel,
+		    smithy, village, baron, great_hall, minion, steward,
+		    tribute, ambassador, cutpurse, embargo, outpost, salvager,
+		    sea_hag, treasure_map};
+  int k[10];
+  int n = 0;
+  int i;
+  int j;
+
+  if (s->target >= adventurer)
+    k[n++] = s->target;
+  for (i = 0; i < s->numCards; i++) {
+    if (s->cards[i] >= adventurer && s->cards[i] != s->target && n < 10)
+      k[n++] = s->cards[i];
+  }
+  for (i = 0; n < 10; i++) {
+    for (j = 0; j < n && k[j] != defaults[i]; j++)
+      ;
+    if (j == n)
+      k[n++] = defaults[i];
+  }
+  if (initializeGame(2, k, ENUM_SEED, &s->base) < 0)
+    return -1;
+  s->base.whoseTurn = 0;
+  s->base.phase = 0;
+  s->base.numActions = 1;
+  s->base.numBuys = 1;
+  s->base.coins = 0;
+  s->base.playedCardCount = 0;
+  return 0;
+}
+
+static void usage(void) {
+  printf("Usage: enumstate [-j workers] [-h hand] [-d deck] [-x discard]\n"
+	 "                 [-c card,card,...] [-C choices] [-T timeout]\n"
+	 "                 [-o prefix] drawCard | card\n");
+}
+
+int main(int argc, char **argv) {
+  struct enumSpace s;
+  struct enumResult total;
+  struct shardJob job;
+  struct shardStats stats;
+  char defaultCards[] = "copper,silver,estate";
+  char *cardList = defaultCards;
+  const char *prefix = NULL;
+  int maxHand = 3;
+  int maxDeck = 4;
+  int maxDiscard = 3;
+  int failed = 0;
+  int opt;
+  int v;
+  double start;
+  double seconds;
+
+  memset(&s, 0, sizeof(s));
+  memset(&job, 0, sizeof(job));
+  s.choiceRange = 1;
+  job.numWorkers = sysconf(_SC_NPROCESSORS_ONLN);
+  job.shardGames = SHARD_STATES;
+  job.timeout = 10;
+
+  while ((opt = getopt(argc, argv, "j:h:d:x:c:C:T:o:")) != -1) {
+    switch (opt) {
+    case 'j': job.numWorkers = atoi(optarg); break;
+    case 'h': maxHand = atoi(optarg); break;
+    case 'd': maxDeck = atoi(optarg); break;
+    case 'x': maxDiscard = atoi(optarg); break;
+    case 'c': cardList = optarg; break;
+    case 'C': s.choiceRange = atoi(optarg); break;
+    case 'T': job.timeout = atoi(optarg); break;
+    case 'o': prefix = optarg; break;
+    default: usage(); return 2;
+    }
+  }
+  if (optind != argc - 1 || job.numWorkers < 1 || maxHand < 0
+      || maxHand > MAX_ENUM_PILE || maxDeck < 0 || maxDeck > MAX_ENUM_PILE
+      || maxDiscard < 0 || maxDiscard > MAX_ENUM_PILE || s.choiceRange < 1
+      || job.timeout < 0) {
+    usage();
+    return 2;
+  }
+  if (strcmp(argv[optind], "drawCard") == 0) {
+    s.target = TARGET_DRAW_CARD;
+  } else {
+    s.target = cardNameToNum(argv[optind]);
+    if (s.target < 0) {
+      printf("Unknown target %s\n", argv[optind]);
+      return 2;
+    }
+    //the played card takes one hand slot
+    if (maxHand < 1) {
+      usage();
+      return 2;
+    }
+    maxHand--;
+  }
+  if (parseCards(cardList, &s) < 0) {
+    printf("Bad card list (at most %d cards)\n", MAX_ENUM_CARDS);
+    return 2;
+  }
+  if (s.target == TARGET_DRAW_CARD)
+    s.choiceRange = 1;
+  s.numChoices = s.choiceRange * s.choiceRange * s.choiceRange;
+
+  if (makePiles(&s.hands, s.numCards, 0, maxHand) < 0
+      || makePiles(&s.decks, s.numCards, 1, maxDeck) < 0
+      || makePiles(&s.discards, s.numCards, 0, maxDiscard) < 0
+      || setupBase(&s) < 0) {
+    printf("Could not set up the state space\n");
+    return 2;
+  }
+  s.total = s.decks.count * s.hands.count * s.discards.count * s.numChoices;
+  printf("States: %ld (%ld hands x %ld decks x %ld discards x %d choices)\n",
+	 s.total, s.hands.count, s.decks.count, s.discards.count,
+	 s.numChoices);
+
+  memset(&total, 0, sizeof(total));
+  job.firstSeed = 0;
+  job.games = s.total;
+  job.resultSize = sizeof(struct enumResult);
+  job.play = enumShard;
+  job.merge = mergeEnum;
+  job.arg = &s;
+  fflush(stdout);
+  start = now();
+  if (runShardedBatch(&job, &total, &stats) < 0) {
+    printf("Could not start worker processes\n");
+    return 2;
+  }
+  seconds = now() - start;
+
+  printf("Checked: %ld in %.2fs (%.0f per minute) on %d workers\n",
+	 total.states, seconds, seconds > 0 ? 60 * total.states / seconds : 0.0,
+	 job.numWorkers);
+  for (v = 1; v < NUM_VIOLATIONS; v++) {
+    printf("Violations (%s): %ld\n", violationNames[v], total.violations[v]);
+    failed |= total.violations[v] > 0;
+  }
+  if (stats.crashedSeeds > 0)
+    printf("Crashed or hung: %ld\n", stats.crashedSeeds);
+  for (v = 1; v < NUM_VIOLATIONS; v++) {
+    if (total.violations[v] > 0)
+      reportState(&s, total.first[v], prefix, violationNames[v]);
+  }
+  if (stats.crashedSeeds > 0) {
+    reportState(&s, stats.firstCrashedSeed, prefix, "crash");
+    failed = 1;
+  }
+  return failed;
+}
@@ -0,0 +1,607 @@
+/* Persistent fuzz harness for playCard and cardEffect
+
+   Every case is built from a byte string: a kingdom, supply piles,
+   hands, decks and discards drawn only from cards in the game, the card
+   under test placed in the current player's hand, and choice1..3 that
+   are either the simulator's sensible defaults or small random values
+   around the valid hand and supply indices.  The call runs in process
+   and is checked for crashes, hangs, out-of-range counts and card ids,
+   cards appearing from nowhere, negative actions/coins/buys and state
+   changed by a call that failed (see playcheck.h).  The state and the
+   call's stack sit between PROT_NONE pages so that the engine's
+   overruns fault inside the call and the loop carries on; a card that
+   keeps hanging is dropped from the run after a few reproducers.
+
+   The first case of every (card, finding) pair is saved as a state file
+   (see statefile.h) that -r replays.  Built with -DLIBFUZZER the same
+   builder is the libFuzzer entry point; it aborts on a finding so
+   libFuzzer keeps the input, and -b turns such an input into a state
+   file.  FUZZ_CARDS restricts the cards under libFuzzer like -c does.
+
+   Every few thousand calls the loop reads the engine's coverage points
+   (see covpoints.h), reports the branches reached for the first time,
+   and picks the cards with branches still unreached more often; -u
+   keeps the choice uniform.  The points never reached are listed at the
+   end.
+
+   Usage: fuzz [-n iterations] [-s seed] [-c card[,card...]] [-o dir] [-u]
+          fuzz -r reproducer.dst
+          fuzz -b input [-w reproducer.dst]
+*/
+
+#include "dominion.h"
+#include "dominion_helpers.h"
+#include "interface.h"
+#include "simulate.h"
+#include "kingdom.h"
+#include "statefile.h"
+#include "rngs.h"
+#include "covpoints.h"
+#include "playcheck.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <setjmp.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+
+#define INPUT_SIZE 512
+#define HANG_CHECK_MS 50
+#define CALL_STACK_SIZE (1 << 20)
+#define HANG_QUARANTINE 3  /* stop fuzzing a card after this many hangs */
+#define BASE_CARDS (gold + 1)
+#define COVER_CHECK_CALLS 4096
+#define COVER_BIAS 3       /* extra picks per unreached point of a card */
+#define MAX_PICKS (NUM_KINGDOM_CARDS * (1 + COVER_BIAS * NUM_COVER_POINTS))
+
+struct fuzzInput {
+  const unsigned char *data;
+  size_t size;
+  size_t pos;
+};
+
+static int targets[NUM_KINGDOM_CARDS];
+static int numTargets;
+static int picks[MAX_PICKS];   /* weighted targets, unused while empty */
+static int numPicks;
+
+static sigjmp_buf guard;
+static volatile sig_atomic_t inCall;
+static volatile long calls;
+static long lastTick = -1;
+static ucontext_t harnessContext;
+static ucontext_t callTemplate;
+static ucontext_t callContext;
+static char *callStack;
+static struct playCase *callCase;
+static int callFinding;
+static int callResult;
+
+//an exhausted input reads as zeros, which must build the plainest case
+static int nextByte(struct fuzzInput *in) {
+  return in->pos < in->size ? in->data[in->pos++] : 0;
+}
+
+static int nextInt(struct fuzzInput *in, int n) {
+  int v = nextByte(in) << 8;
+
+  v |= nextByte(in);
+  return v % n;
+}
+
+static void fillPile(struct fuzzInput *in, int *cards, int count,
+		     int *inGame, int numInGame) {
+  int i;
+
+  for (i = 0; i < count; i++)
+    cards[i] = inGame[nextInt(in, numInGame)];
+}
+
+//a pile may be filled close to its limit to reach the overflow paths
+static int pileCount(struct fuzzInput *in, int usual, int max) {
+  if (nextByte(in) == 255)
+    return max - nextInt(in, 4);
+  return nextInt(in, usual + 1);
+}
+
+static void buildCase(struct fuzzInput *in, struct playCase *c) {
+  struct gameState *s = &c->state;
+  int k[KINGDOM_SIZE];
+  int inGame[BASE_CARDS + KINGDOM_SIZE];
+  int card;
+  int cur;
+  int p;
+  int i;
+
+  memset(c, 0, sizeof(struct playCase));
+  s->numPlayers = 2 + nextInt(in, MAX_PLAYERS - 1);
+  kingdomUnrank(((long)nextInt(in, 65536) << 8 | nextByte(in)) % KINGDOM_SETS, k);
+  if (numPicks > 0)
+    card = picks[nextInt(in, numPicks)];
+  else
+    card = targets[nextInt(in, numTargets)];
+  for (i = 0; i < KINGDOM_SIZE && k[i] != card; i++)
+    ;
+  if (i == KINGDOM_SIZE)
+    k[nextInt(in, KINGDOM_SIZE)] = card;
+
+  for (i = 0; i <= treasure_map; i++)
+    s->supplyCount[i] = -1;
+  for (i = 0; i < BASE_CARDS; i++) {
+    inGame[i] = i;
+    s->supplyCount[i] = nextInt(in, 31);
+  }
+  for (i = 0; i < KINGDOM_SIZE; i++) {
+    inGame[BASE_CARDS + i] = k[i];
+    s->supplyCount[k[i]] = nextInt(in, 11);
+  }
+  while (nextByte(in) >= 240)
+    s->embargoTokens[inGame[nextInt(in, BASE_CARDS + KINGDOM_SIZE)]]++;
+
+  s->whoseTurn = nextInt(in, s->numPlayers);
+  s->phase = nextByte(in) >= 248 ? 1 : 0;
+  s->numActions = nextByte(in) >= 248 ? 0 : 1 + nextInt(in, 3);
+  s->coins = nextInt(in, 9);
+  s->numBuys = 1 + nextInt(in, 2);
+  for (p = 0; p < s->numPlayers; p++) {
+    s->handCount[p] = pileCount(in, 7, MAX_HAND);
+    fillPile(in, s->hand[p], s->handCount[p], inGame, BASE_CARDS + KINGDOM_SIZE);
+    s->deckCount[p] = pileCount(in, 20, MAX_DECK);
+    fillPile(in, s->deck[p], s->deckCount[p], inGame, BASE_CARDS + KINGDOM_SIZE);
+    s->discardCount[p] = pileCount(in, 20, MAX_DECK);
+    fillPile(in, s->discard[p], s->discardCount[p], inGame,
+	     BASE_CARDS + KINGDOM_SIZE);
+  }
+  s->playedCardCount = nextInt(in, 6);
+  fillPile(in, s->playedCards, s->playedCardCount, inGame,
+	   BASE_CARDS + KINGDOM_SIZE);
+
+  cur = s->whoseTurn;
+  if (s->handCount[cur] == 0)
+    s->handCount[cur] = 1;
+  c->handPos = nextInt(in, s->handCount[cur]);
+  s->hand[cur][c->handPos] = card;
+  c->card = card;
+  c->entry = nextByte(in) >= 230 ? ENTRY_CARD_EFFECT : ENTRY_PLAY_CARD;
+  c->seed = 1 + nextInt(in, 65535);
+
+  if (nextByte(in) >= 128
+      || simChoices(card, c->handPos, s, &c->choice1, &c->choice2,
+		    &c->choice3) < 0) {
+    c->choice1 = nextInt(in, 32) - 2;
+    c->choice2 = nextInt(in, 32) - 2;
+    c->choice3 = nextInt(in, 32) - 2;
+  }
+}
+
+//runs the call with no signal handling; *result gets its return value.
+//Failed calls are checked separately by the caller (see checkFailure)
+//so that the common path does not have to copy the state.
+static int runCase(struct playCase *c, int *result) {
+  struct snapshot pre;
+  int bonus = 0;
+  int r;
+
+  if (takeSnapshot(&c->state, &pre) != FIND_NONE)
+    return FIND_NONE;  //not a case the builder makes, nothing to check
+  SelectStream(1);
+  PutSeed(c->seed);
+  if (c->entry == ENTRY_CARD_EFFECT)
+    r = cardEffect(c->card, c->choice1, c->choice2, c->choice3, &c->state,
+		   c->handPos, &bonus);
+  else
+    r = playCard(c->handPos, c->choice1, c->choice2, c->choice3, &c->state);
+  *result = r;
+  return checkCall(&pre, &c->state);
+}
+
+static void parseTargets(const char *list) {
+  char name[MAX_STRING_LENGTH];
+  const char *end;
+  int card;
+  int i;
+
+  numTargets = 0;
+  while (list != NULL && *list) {
+    end = strchr(list, ',');
+    snprintf(name, sizeof(name), "%.*s",
+	     (int)(end ? end - list : (long)strlen(list)), list);
+    card = cardNameToNum(name);
+    if (card >= adventurer && card <= treasure_map)
+      targets[numTargets++] = card;
+    else
+      fprintf(stderr, "Ignoring %s, not a kingdom card\n", name);
+    list = end ? end + 1 : NULL;
+  }
+  if (numTargets == 0) {
+    for (i = 0; i < NUM_KINGDOM_CARDS; i++)
+      targets[i] = adventurer + i;
+    numTargets = NUM_KINGDOM_CARDS;
+  }
+}
+
+#ifdef LIBFUZZER
+
+int LLVMFuzzerInitialize(int *argc, char ***argv) {
+  parseTargets(getenv("FUZZ_CARDS"));
+  return 0;
+}
+
+int LLVMFuzzerTestOneInput(const unsigned char *data, size_t size) {
+  static struct playCase c;
+  static struct playCase pre;
+  struct fuzzInput in = {data, size, 0};
+  char name[MAX_STRING_LENGTH];
+  int finding;
+  int r;
+
+  buildCase(&in, &c);
+  finding = runCase(&c, &r);
+  if (finding == FIND_NONE && r < 0) {
+    in.pos = 0;
+    buildCase(&in, &pre);
+    finding = checkFailure(&pre, &c);
+  }
+  if (finding != FIND_NONE) {
+    cardNumToName(c.card, name);
+    fprintf(stderr, "%s: %s\n", name, findingNames[finding]);
+    abort();
+  }
+  return 0;
+}
+
+#else
+
+static void onFault(int sig) {
+  if (inCall)
+    siglongjmp(guard, sig == SIGALRM ? FIND_HANG : FIND_CRASH);
+  signal(sig, SIG_DFL);
+  raise(sig);
+}
+
+static void onTick(int sig) {
+  if (inCall && calls == lastTick)
+    onFault(sig);
+  lastTick = calls;
+}
+
+static void installGuards(void) {
+  struct sigaction sa;
+  struct itimerval tick;
+
+  memset(&sa, 0, sizeof(sa));
+  sigemptyset(&sa.sa_mask);
+  //no mask to restore, so the guard can use the cheap sigsetjmp(.., 0)
+  sa.sa_flags = SA_NODEFER;
+  sa.sa_handler = onFault;
+  sigaction(SIGSEGV, &sa, NULL);
+  sigaction(SIGBUS, &sa, NULL);
+  sigaction(SIGFPE, &sa, NULL);
+  sigaction(SIGILL, &sa, NULL);
+  sigaction(SIGABRT, &sa, NULL);
+  sa.sa_handler = onTick;
+  sigaction(SIGALRM, &sa, NULL);
+
+  memset(&tick, 0, sizeof(tick));
+  tick.it_interval.tv_usec = HANG_CHECK_MS * 1000;
+  tick.it_value = tick.it_interval;
+  setitimer(ITIMER_REAL, &tick, NULL);
+}
+
+//size bytes that end right before a PROT_NONE page (with another one in
+//front), so writes past the end fault inside the call instead of
+//corrupting the harness
+static char *fenced(long size) {
+  long page = sysconf(_SC_PAGESIZE);
+  long pages = (size + page - 1) / page;
+  char *p = mmap(NULL, (pages + 2) * page, PROT_READ | PROT_WRITE,
+		 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+  if (p == MAP_FAILED)
+    return NULL;
+  mprotect(p, page, PROT_NONE);
+  mprotect(p + (pages + 1) * page, page, PROT_NONE);
+  return p + (pages + 1) * page - size;
+}
+
+static struct playCase *fencedCase(void) {
+  return (struct playCase *)fenced(sizeof(struct playCase));
+}
+
+static void callEntry(void) {
+  callFinding = runCase(callCase, &callResult);
+}
+
+//cardEffect keeps temphand on the stack and some cards run past it, so
+//the call gets a fenced stack of its own rather than the harness's
+static int runGuarded(struct playCase *c, int *result) {
+  int finding;
+
+  *result = -1;
+  if (callStack == NULL) {
+    callStack = fenced(CALL_STACK_SIZE);
+    if (callStack == NULL || getcontext(&callTemplate) < 0)
+      return FIND_CRASH;
+  }
+  finding = sigsetjmp(guard, 0);
+  if (finding == 0) {
+    callCase = c;
+    callResult = -1;
+    callContext = callTemplate;
+    callContext.uc_stack.ss_sp = callStack;
+    callContext.uc_stack.ss_size = CALL_STACK_SIZE;
+    callContext.uc_link = &harnessContext;
+    makecontext(&callContext, callEntry, 0);
+    inCall = 1;
+    swapcontext(&harnessContext, &callContext);
+    finding = callFinding;
+  }
+  *result = callResult;
+  inCall = 0;
+  calls++;
+  return finding;
+}
+
+static unsigned long nextRandom(unsigned long *x) {
+  unsigned long z = (*x += 0x9e3779b97f4a7c15UL);
+
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9UL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebUL;
+  return z ^ (z >> 31);
+}
+
+static void reproducerPath(const char *dir, int card, int finding, char *path,
+			   int size) {
+  char name[MAX_STRING_LENGTH];
+  char *p;
+
+  cardNumToName(card, name);
+  for (p = name; *p; p++) {
+    if (*p == ' ')
+      *p = '_';
+  }
+  snprintf(path, size, "%s/%s-%s.dst", dir, name, findingNames[finding]);
+}
+
+static void describe(struct playCase *c) {
+  struct gameState *s = &c->state;
+  char name[MAX_STRING_LENGTH];
+  int p;
+
+  cardNumToName(c->entry == ENTRY_CARD_EFFECT ? c->card
+		: s->hand[s->whoseTurn][c->handPos], name);
+  fprintf(stderr, "%s %s handPos %d choices %d %d %d, seed %d\n",
+	  c->entry == ENTRY_CARD_EFFECT ? "cardEffect" : "playCard", name,
+	  c->handPos, c->choice1, c->choice2, c->choice3, c->seed);
+  fprintf(stderr, "players %d turn %d phase %d actions %d coins %d buys %d"
+	  " played %d\n", s->numPlayers, s->whoseTurn, s->phase, s->numActions,
+	  s->coins, s->numBuys, s->playedCardCount);
+  for (p = 0; p < s->numPlayers; p++)
+    fprintf(stderr, "  player %d: hand %d deck %d discard %d\n", p,
+	    s->handCount[p], s->deckCount[p], s->discardCount[p]);
+}
+
+static int replay(struct playCase *c) {
+  static struct playCase pre;
+  int finding;
+  int r;
+
+  installGuards();
+  fprintf(stderr, "Before:\n");
+  describe(c);
+  pre = *c;
+  finding = runGuarded(c, &r);
+  if (finding == FIND_NONE && r < 0)
+    finding = checkFailure(&pre, c);
+  if (finding != FIND_CRASH && finding != FIND_HANG) {
+    fprintf(stderr, "After (returned %d):\n", r);
+    describe(c);
+  }
+  fprintf(stderr, "Finding: %s\n", findingNames[finding]);
+  return finding == FIND_NONE ? 0 : 1;
+}
+
+static int replayInput(const char *inputPath, const char *outPath) {
+  struct playCase *c = fencedCase();
+  static unsigned char data[1 << 16];
+  struct fuzzInput in = {data, 0, 0};
+  FILE *f = fopen(inputPath, "rb");
+
+  if (f == NULL || c == NULL) {
+    fprintf(stderr, "Could not read %s\n", inputPath);
+    return 2;
+  }
+  in.size = fread(data, 1, sizeof(data), f);
+  fclose(f);
+  buildCase(&in, c);
+  if (outPath != NULL && writeStateFile(outPath, c) < 0) {
+    fprintf(stderr, "Could not write %s\n", outPath);
+    return 2;
+  }
+  return replay(c);
+}
+
+//reports the points reached since the last look and weights the picks
+//towards the cards that still have unreached points
+static void updateCoverage(long n, unsigned long *seen, int bias) {
+  unsigned long counts[NUM_COVER_POINTS];
+  int unreached[treasure_map + 1];
+  int reached = 0;
+  int fresh = 0;
+  int card;
+  int i;
+  int w;
+
+  coverSnapshot(counts);
+  memset(unreached, 0, sizeof(unreached));
+  for (i = 0; i < NUM_COVER_POINTS; i++) {
+    reached += counts[i] > 0;
+    if (counts[i] > 0 && seen[i] == 0)
+      fresh++;
+    card = coverPointCard(i);
+    if (counts[i] == 0 && card >= 0)
+      unreached[card]++;
+  }
+  if (fresh > 0) {
+    fprintf(stderr, "#%ld reached %d of %d points, new:", n, reached,
+	    NUM_COVER_POINTS);
+    for (i = 0; i < NUM_COVER_POINTS; i++) {
+      if (counts[i] > 0 && seen[i] == 0)
+	fprintf(stderr, " %s", coverPointName(i));
+    }
+    fprintf(stderr, "\n");
+  }
+  memcpy(seen, counts, sizeof(counts));
+
+  numPicks = 0;
+  for (i = 0; bias && i < numTargets; i++) {
+    for (w = 0; w <= COVER_BIAS * unreached[targets[i]]; w++)
+      picks[numPicks++] = targets[i];
+  }
+}
+
+static void usage(void) {
+  fprintf(stderr, "Usage: fuzz [-n iterations] [-s seed] [-c card[,card...]] [-o dir] [-u]\n"
+	  "       fuzz -r reproducer.dst\n"
+	  "       fuzz -b input [-w reproducer.dst]\n");
+}
+
+int main(int argc, char **argv) {
+  struct playCase *c = fencedCase();
+  static struct playCase saved;
+  static long found[treasure_map + 1][NUM_FINDINGS];
+  static unsigned long seen[NUM_COVER_POINTS];
+  int fuzzed[treasure_map + 1];
+  unsigned char input[INPUT_SIZE];
+  struct fuzzInput in;
+  const char *dir = ".";
+  const char *replayPath = NULL;
+  const char *inputPath = NULL;
+  const char *outPath = NULL;
+  char path[1024];
+  char name[MAX_STRING_LENGTH];
+  unsigned long rng = 1;
+  unsigned long x;
+  long iterations = 1000000;
+  int bias = 1;
+  long accepted = 0;
+  long total = 0;
+  long n;
+  double seconds;
+  clock_t start;
+  int finding;
+  int opt;
+  int r;
+  int i;
+  int j;
+
+  if (c == NULL)
+    return 2;
+  parseTargets(NULL);
+  while ((opt = getopt(argc, argv, "n:s:c:o:r:b:w:u")) != -1) {
+    switch (opt) {
+    case 'n': iterations = atol(optarg); break;
+    case 's': rng = strtoul(optarg, NULL, 0); break;
+    case 'c': parseTargets(optarg); break;
+    case 'o': dir = optarg; break;
+    case 'r': replayPath = optarg; break;
+    case 'b': inputPath = optarg; break;
+    case 'w': outPath = optarg; break;
+    case 'u': bias = 0; break;
+    default: usage(); return 2;
+    }
+  }
+
+  if (replayPath != NULL) {
+    if (readStateFile(replayPath, c) < 0) {
+      fprintf(stderr, "Could not read %s\n", replayPath);
+      return 2;
+    }
+    return replay(c);
+  }
+  if (inputPath != NULL)
+    return replayInput(inputPath, outPath);
+
+  //the engine prints from inside some cards; keep it out of the report
+  if (freopen("/dev/null", "w", stdout) == NULL)
+    return 2;
+  installGuards();
+  memset(fuzzed, 0, sizeof(fuzzed));
+  for (i = 0; i < numTargets; i++)
+    fuzzed[targets[i]] = 1;
+  start = clock();
+  for (n = 0; n < iterations; n++) {
+    if (n > 0 && n % COVER_CHECK_CALLS == 0)
+      updateCoverage(n, seen, bias);
+    for (i = 0; i < INPUT_SIZE; i += 8) {
+      x = nextRandom(&rng);
+      memcpy(input + i, &x, 8);
+    }
+    in.data = input;
+    in.size = INPUT_SIZE;
+    in.pos = 0;
+    buildCase(&in, c);
+    finding = runGuarded(c, &r);
+    if (r >= 0)
+      accepted++;
+    if (finding == FIND_NONE && r < 0) {
+      in.pos = 0;
+      buildCase(&in, &saved);
+      finding = checkFailure(&saved, c);
+    }
+    if (finding == FIND_NONE)
+      continue;
+
+    if (found[c->card][finding]++ == 0) {
+      //the call changed c, so rebuild the case from its input
+      in.pos = 0;
+      buildCase(&in, &saved);
+      reproducerPath(dir, saved.card, finding, path, sizeof(path));
+      cardNumToName(saved.card, name);
+      if (writeStateFile(path, &saved) < 0)
+	fprintf(stderr, "Could not write %s\n", path);
+      fprintf(stderr, "#%ld new finding: %s %s -> %s\n", n, name,
+	      findingNames[finding], path);
+    }
+    //every hang costs a timer tick, which would swamp the run
+    if (finding == FIND_HANG && found[c->card][finding] == HANG_QUARANTINE
+	&& numTargets > 1) {
+      for (i = 0; targets[i] != c->card; i++)
+	;
+      targets[i] = targets[--numTargets];
+      updateCoverage(n, seen, bias);
+      cardNumToName(c->card, name);
+      fprintf(stderr, "#%ld no longer fuzzing %s, it keeps hanging\n", n, name);
+    }
+  }
+  seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+  updateCoverage(n, seen, bias);
+
+  fprintf(stderr, "%ld calls (%ld accepted) in %.2fs, %.0f calls/s\n",
+	  iterations, accepted, seconds, seconds > 0 ? iterations / seconds : 0.0);
+  for (i = 0; i <= treasure_map; i++) {
+    for (j = 1; j < NUM_FINDINGS; j++) {
+      if (found[i][j] == 0)
+	continue;
+      cardNumToName(i, name);
+      fprintf(stderr, "  %-14s %-10s %ld\n", name, findingNames[j], found[i][j]);
+      total += found[i][j];
+    }
+  }
+  fprintf(stderr, "Never reached:");
+  for (i = 0, j = 0; i < NUM_COVER_POINTS; i++) {
+    if (seen[i] == 0
+	&& (coverPointCard(i) < 0 || fuzzed[coverPointCard(i)])) {
+      fprintf(stderr, " %s", coverPointName(i));
+      j++;
+    }
+  }
+  fprintf(stderr, "%s\n", j ? "" : " none");
+  return total > 0 ? 1 : 0;
+}
+
+#endif
@@ -8,71 +8,57 @@ Sam Heinith CS362
 #include <math.h>
 #include <assert.h>
 #include <string.h>
+#include <ctype.h>
 #include "rngs.h"
 #include "interface.h"
 #include "dominion.h"
 
 
+//Interned display names, indexed by card; callers share them, never copy
+static const char *cardNames[NUM_TOTAL_K_CARDS] = {
+  "Curse", "Estate", "Duchy", "Province", "Copper", "Silver", "Gold",
+  "Adventurer", "Council Room", "Feast", "Gardens", "Mine", "Remodel",
+  "Smithy", "Village", "Baron", "Great Hall", "Minion", "Steward", "Tribute",
+  "Ambassador", "Cutpurse", "Embargo", "Outpost", "Salvager", "Sea Hag",
+  "Treasure Map"
+};
+
+static const char *phaseNames[] = {"Action", "Buy", "Cleanup"};
+
+//Console output goes through one buffer, written once per print call
+static struct outBuf console;
+
+const char *cardName(int card) {
+  if(card < curse || card >= NUM_TOTAL_K_CARDS) return "?";
+  return cardNames[card];
+}
+
+const char *phaseName(int phase) {
+  if(phase < ACTION_PHASE || phase > CLEANUP_PHASE) return "";
+  return phaseNames[phase];
+}
+
 void cardNumToName(int card, char *name){
-  switch(card){
-  case curse: strcpy(name,"Curse");
-    break;
-  case estate: strcpy(name,"Estate");
-    break;
-  case duchy: strcpy(name,"Duchy");
-    break;
-  case province: strcpy(name,"Province");
-    break;
-  case copper: strcpy(name,"Copper");
-    break;
-  case silver: strcpy(name,"Silver");
-    break;
-  case gold: strcpy(name,"Gold");
-    break;
-  case adventurer: strcpy(name,"Adventurer");
-    break;
-  case council_room: strcpy(name,"Council Room");
-    break;
-  case feast: strcpy(name,"Feast");
-    break;
-  case gardens: strcpy(name,"Gardens");
-    break;
-  case mine: strcpy(name,"Mine");
-    break;
-  case remodel: strcpy(name,"Remodel");
-    break;
-  case smithy: strcpy(name,"Smithy");
-    break;
-  case village: strcpy(name,"Village");
-    break;
-  case baron: strcpy(name,"Baron");
-    break;
-  case great_hall: strcpy(name,"Great Hall");
-    break;
-  case minion: strcpy(name,"Minion");
-    break;
-  case steward: strcpy(name,"Steward");
-    break;
-  case tribute: strcpy(name,"Tribute");
-    break;
-  case ambassador: strcpy(name,"Ambassador");
-    break;
-  case cutpurse: strcpy(name,"Cutpurse");
-    break;
-  case embargo: strcpy(name,"Embargo");
-    break;
-  case outpost: strcpy(name,"Outpost");
-    break;
-  case salvager: strcpy(name,"Salvager");
-    break;
-  case sea_hag: strcpy(name,"Sea Hag");
-    break;
-  case treasure_map: strcpy(name,"Treasure Map");
-    break;
+  strcpy(name, cardName(card));
+}
 
-  default: strcpy(name,"?");
-  }
 
+
+int cardNameToNum(const char *name) {
+  //Accepts both display names ("Council Room") and enum names (council_room)
+  const char *cardName;
+  int card, i;
+  for(card = curse; card < NUM_TOTAL_K_CARDS; card++) {
+    cardName = cardNames[card];
+    for(i = 0; name[i] != '\0' && cardName[i] != '\0'; i++) {
+      char a = tolower((unsigned char)name[i]);
+      char b = tolower((unsigned char)cardName[i]);
+      if(a == '_') a = ' ';
+      if(a != b) break;
+    }
+    if(name[i] == '\0' && cardName[i] == '\0') return card;
+  }
+  return FAILURE;
 }
 
 
@@ -144,108 +130,71 @@ int getCardCost(int card) {
 
 
 
-void printHand(int player, struct gameState *game) {
-  int handCount = game->handCount[player];
-  int handIndex;
-  printf("Player %d's hand:\n", player);
-  if(handCount > 0) printf("#  Card\n");
-  for(handIndex = 0; handIndex < handCount; handIndex++) {
-    int card = game->hand[player][handIndex];
-    char name[MAX_STRING_LENGTH];
-    cardNumToName(card, name);
-    printf("%-2d %-13s\n", handIndex, name);
-  }
-  printf("\n");
-}
-
+static void renderCards(struct outBuf *out, const char *what, int player,
+			int *cards, int count, const char *pad) {
+  int i;
 
-
-void printDeck(int player, struct gameState *game) {
-  int deckCount = game->deckCount[player];
-  int deckIndex;
-  printf("Player %d's deck: \n", player);
-  if(deckCount > 0) printf("#  Card\n");
-  for(deckIndex = 0; deckIndex < deckCount; deckIndex++) {
-    int card = game->deck[player][deckIndex];
-    char name[MAX_STRING_LENGTH];
-    cardNumToName(card, name);
-    printf("%-2d %-13s\n", deckIndex, name);
-  }
-  printf("\n");
+  outPrintf(out, "Player %d's %s:%s\n", player, what, pad);
+  if(count > 0) outPrintf(out, "#  Card\n");
+  for(i = 0; i < count; i++)
+    outPrintf(out, "%-2d %-13s%s\n", i, cardName(cards[i]), pad);
+  outPrintf(out, "\n");
 }
 
-void printPlayed(int player, struct gameState *game) {
-  int playedCount = game->playedCardCount;
-  int playedIndex;
-  printf("Player %d's played cards: \n", player);
-  if(playedCount > 0) printf("#  Card\n");
-  for(playedIndex = 0; playedIndex < playedCount; playedIndex++) {
-    int card = game->playedCards[playedIndex];
-    char name[MAX_STRING_LENGTH];
-    cardNumToName(card, name);
-    printf("%-2d %-13s \n", playedIndex, name);
-  }
-  printf("\n");
+void renderHand(struct outBuf *out, int player, struct gameState *game) {
+  renderCards(out, "hand", player, game->hand[player],
+	      game->handCount[player], "");
 }
 
+void renderDeck(struct outBuf *out, int player, struct gameState *game) {
+  int i;
 
-
-void printDiscard(int player, struct gameState *game) {
-  int discardCount = game->discardCount[player];
-  int discardIndex;
-  printf("Player %d's discard: \n", player);
-  if(discardCount > 0) printf("#  Card\n");
-  for(discardIndex = 0; discardIndex < discardCount; discardIndex++) {
-    int card = game->discard[player][discardIndex];
-    char name[MAX_STRING_LENGTH];
-    cardNumToName(card, name);
-    printf("%-2d %-13s \n", discardIndex, name);
-  }
-  printf("\n");
+  outPrintf(out, "Player %d's deck: \n", player);
+  if(game->deckCount[player] > 0) outPrintf(out, "#  Card\n");
+  for(i = 0; i < game->deckCount[player]; i++)
+    outPrintf(out, "%-2d %-13s\n", i, cardName(game->deck[player][i]));
+  outPrintf(out, "\n");
 }
 
+void renderPlayed(struct outBuf *out, int player, struct gameState *game) {
+  renderCards(out, "played cards", player, game->playedCards,
+	      game->playedCardCount, " ");
+}
 
+void renderDiscard(struct outBuf *out, int player, struct gameState *game) {
+  renderCards(out, "discard", player, game->discard[player],
+	      game->discardCount[player], " ");
+}
 
+void renderSupply(struct outBuf *out, struct gameState *game) {
+  int card;
 
-void printSupply(struct gameState *game) {
-  int cardNum, cardCost, cardCount;
-  char name[MAX_STRING_LENGTH];
-  printf("#   Card          Cost   Copies\n");
-  for(cardNum = 0; cardNum < NUM_TOTAL_K_CARDS; cardNum++){
-    cardCount = game->supplyCount[cardNum];
-    if(cardCount == -1) continue;
-    cardNumToName(cardNum, name);
-    cardCost = getCardCost(cardNum);
-    printf("%-2d  %-13s %-5d  %-5d", cardNum, name, cardCost, cardCount);
-    printf("\n");
+  if(out == NULL) return;
+  outPrintf(out, "#   Card          Cost   Copies\n");
+  for(card = 0; card < NUM_TOTAL_K_CARDS; card++) {
+    if(game->supplyCount[card] == -1) continue;
+    outPrintf(out, "%-2d  %-13s %-5d  %-5d\n", card, cardNames[card],
+	      getCardCost(card), game->supplyCount[card]);
   }
-  printf("\n");
+  outPrintf(out, "\n");
 }
 
-
-void printState(struct gameState *game) {
-  int numActions = game->numActions;
-  int numCoins = game->coins;
-  int numBuys = game->numBuys;
-  int currentPlayer = game->whoseTurn;
-  int phase = game->phase;
-  char phaseName[MAX_STRING_LENGTH];
-  phaseNumToName(phase,phaseName);
-  printf("Player %d:\n%s phase\n%d actions\n%d coins\n%d buys\n\n", currentPlayer, phaseName, numActions, numCoins, numBuys);
+void renderState(struct outBuf *out, struct gameState *game) {
+  outPrintf(out, "Player %d:\n%s phase\n%d actions\n%d coins\n%d buys\n\n",
+	    game->whoseTurn, phaseName(game->phase), game->numActions,
+	    game->coins, game->numBuys);
 }
 
-void printScores(struct gameState *game) {
-  int playerNum, score[MAX_PLAYERS];
-  int numPlayers = game->numPlayers;
-  for(playerNum = 0; playerNum < numPlayers; playerNum++) {
-    score[playerNum] = scoreFor(playerNum,game);
-    printf("Player %d has a score of %d\n", playerNum, score[playerNum]);
-  }
-}
+void renderScores(struct outBuf *out, struct gameState *game) {
+  int playerNum;
 
+  for(playerNum = 0; playerNum < game->numPlayers; playerNum++)
+    outPrintf(out, "Player %d has a score of %d\n", playerNum,
+	      scoreFor(playerNum, game));
+}
 
-void printHelp(void) {
-  printf("Commands are: \n\
+void renderHelp(struct outBuf *out) {
+  outPrintf(out, "Commands are: \n\
   add [Supply Card Number] 			- add any card to your hand (teh hacks)\n\
   buy [Supply Card Number] 			- buy a card at supply position\n\
   end 			      			- end your turn\n\
@@ -257,21 +206,62 @@ void printHelp(void) {
   stat 						- show your turn's status\n\
   supp 						- show the supply\n\
   whos 			      			- whos turn\n\
-  exit 			      			- exit the interface");
-  printf("\n\n");
+  exit 			      			- exit the interface\n\n");
+}
+
+static struct outBuf *consoleBuffer(void) {
+  if(console.data == NULL) outInit(&console, 4096, 1 << 24);
+  return &console;
+}
+
+static void flushConsole(void) {
+  fwrite(console.data, 1, console.len, stdout);
+  outClear(&console);
+}
 
+void printHand(int player, struct gameState *game) {
+  renderHand(consoleBuffer(), player, game);
+  flushConsole();
+}
+
+void printDeck(int player, struct gameState *game) {
+  renderDeck(consoleBuffer(), player, game);
+  flushConsole();
+}
+
+void printPlayed(int player, struct gameState *game) {
+  renderPlayed(consoleBuffer(), player, game);
+  flushConsole();
+}
+
+void printDiscard(int player, struct gameState *game) {
+  renderDiscard(consoleBuffer(), player, game);
+  flushConsole();
+}
+
+void printSupply(struct gameState *game) {
+  renderSupply(consoleBuffer(), game);
+  flushConsole();
+}
+
+void printState(struct gameState *game) {
+  renderState(consoleBuffer(), game);
+  flushConsole();
+}
+
+void printScores(struct gameState *game) {
+  renderScores(consoleBuffer(), game);
+  flushConsole();
+}
+
+void printHelp(void) {
+  renderHelp(consoleBuffer());
+  flushConsole();
 }
 
 
 void phaseNumToName(int phase, char *name) {
-  switch(phase){
-  case ACTION_PHASE: strcpy(name,"Action");
-    break;
-  case BUY_PHASE: strcpy(name,"Buy");
-    break;
-  case CLEANUP_PHASE: strcpy(name,"Cleanup");
-    break;	
-  }
+  strcpy(name, phaseName(phase));
 }
 
 
@@ -328,36 +318,33 @@ int countHandCoins(int player, struct gameState *game) {
 }
 
 
-void executeBotTurn(int player, int *turnNum, struct gameState *game) {
+void playBotTurn(int player, int *turnNum, struct gameState *game,
+		 struct outBuf *out) {
   int coins = countHandCoins(player, game);
-	
-  printf("*****************Executing Bot Player %d Turn Number %d*****************\n", player, *turnNum);
-  printSupply(game);	
+  int buy = -1;
+
+  outPrintf(out, "*****************Executing Bot Player %d Turn Number %d"
+	    "*****************\n", player, *turnNum);
+  renderSupply(out, game);
   //sleep(1); //Thinking...
-	
-  if(coins >= PROVINCE_COST && supplyCount(province,game) > 0) {
-    buyCard(province,game);
-    printf("Player %d buys card Province\n\n", player);
-  }
-  else if(supplyCount(province,game) == 0 && coins >= DUCHY_COST ) {
-    buyCard(duchy,game);
-    printf("Player %d buys card Duchy\n\n", player);
-  }
-  else if(coins >= GOLD_COST && supplyCount(gold,game) > 0) {
-    buyCard(gold,game);
-    printf("Player %d buys card Gold\n\n", player);
-  }
-  else if(coins >= SILVER_COST && supplyCount(silver,game) > 0) {
-    buyCard(silver,game);
-    printf("Player %d buys card Silver\n\n", player);
 
+  if(coins >= PROVINCE_COST && supplyCount(province,game) > 0) buy = province;
+  else if(supplyCount(province,game) == 0 && coins >= DUCHY_COST) buy = duchy;
+  else if(coins >= GOLD_COST && supplyCount(gold,game) > 0) buy = gold;
+  else if(coins >= SILVER_COST && supplyCount(silver,game) > 0) buy = silver;
+  if(buy != -1) {
+    buyCard(buy, game);
+    outPrintf(out, "Player %d buys card %s\n\n", player, cardNames[buy]);
   }
 
-	
   if(player == (game->numPlayers -1)) (*turnNum)++;
   endTurn(game);
-  if(! isGameOver(game)) {
-    int currentPlayer = whoseTurn(game);
-    printf("Player %d's turn number %d\n\n", currentPlayer, (*turnNum));
-  }
+  if(! isGameOver(game))
+    outPrintf(out, "Player %d's turn number %d\n\n", whoseTurn(game),
+	      *turnNum);
+}
+
+void executeBotTurn(int player, int *turnNum, struct gameState *game) {
+  playBotTurn(player, turnNum, game, consoleBuffer());
+  flushConsole();
 }
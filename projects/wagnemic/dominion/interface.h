@@ -12,6 +12,7 @@
 
 
 #include "dominion.h"
+#include "outbuf.h"
 
 //Last card enum (Treasure map) card number plus one for the 0th card.
 #define NUM_TOTAL_K_CARDS (treasure_map + 1)
@@ -92,8 +93,17 @@ int countHandCoins(int player, struct gameState *game);
 
 void executeBotTurn(int player, int *turnNum, struct gameState *game);
 
+//The same turn, rendered into out; a NULL out plays it quietly
+void playBotTurn(int player, int *turnNum, struct gameState *game,
+		 struct outBuf *out);
+
 void phaseNumToName(int phase, char *name); 
 void cardNumToName(int card, char *name);
+int cardNameToNum(const char *name);
+
+//Interned names, shared by every caller: no copy, no allocation
+const char *cardName(int card);
+const char *phaseName(int phase);
 
 int getCardCost(int card);
 
@@ -113,6 +123,18 @@ void printSupply(struct gameState *game);
 
 void printGameState(struct gameState *game);
 
+//The print functions render into a reusable buffer and write it out once;
+//these render into the caller's buffer instead, for output that is sent
+//once per command.  A NULL out renders nothing.
+void renderHand(struct outBuf *out, int player, struct gameState *game);
+void renderDeck(struct outBuf *out, int player, struct gameState *game);
+void renderDiscard(struct outBuf *out, int player, struct gameState *game);
+void renderPlayed(struct outBuf *out, int player, struct gameState *game);
+void renderState(struct outBuf *out, struct gameState *game);
+void renderSupply(struct outBuf *out, struct gameState *game);
+void renderScores(struct outBuf *out, struct gameState *game);
+void renderHelp(struct outBuf *out);
+
 void printScores(struct gameState *game);
 
 void selectKingdomCards(int randomSeed, int kingdomCards[NUM_K_CARDS]);
@@ -0,0 +1,259 @@
+#include "invariants.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+static int validCard(int card) {
+  return card >= curse && card <= treasure_map;
+}
+
+static int playersOf(struct gameState *state) {
+  if (state->numPlayers < 2 || state->numPlayers > MAX_PLAYERS)
+    return MAX_PLAYERS;
+  return state->numPlayers;
+}
+
+long cardTotal(struct gameState *state) {
+  long total = state->playedCardCount;
+  int p;
+  int i;
+
+  for (p = 0; p < playersOf(state); p++)
+    total += state->handCount[p] + state->deckCount[p]
+      + state->discardCount[p];
+  for (i = curse; i <= treasure_map; i++) {
+    if (state->supplyCount[i] > 0)
+      total += state->supplyCount[i];
+  }
+  return total;
+}
+
+static void note(char *why, int size, int *found, const char *format, ...) {
+  va_list args;
+  int used = strlen(why);
+
+  if ((*found)++ > 0 && used < size - 2) {
+    strcpy(why + used, "; ");
+    used += 2;
+  }
+  va_start(args, format);
+  vsnprintf(why + used, size - used, format, args);
+  va_end(args);
+}
+
+static void checkPile(const char *name, int p, int *cards, int count,
+		      int bound, char *why, int size, int *found) {
+  int i;
+
+  if (count < 0 || count > bound) {
+    note(why, size, found, "%s[%d] count %d", name, p, count);
+    return;
+  }
+  for (i = 0; i < count; i++) {
+    if (!validCard(cards[i])) {
+      note(why, size, found, "%s[%d][%d] card %d", name, p, i, cards[i]);
+      return;
+    }
+  }
+}
+
+int checkInvariants(struct gameState *state, long baseline, char *why,
+		    int size) {
+  int found = 0;
+  long total;
+  int p;
+  int i;
+
+  why[0] = '\0';
+  if (state->numPlayers < 2 || state->numPlayers > MAX_PLAYERS)
+    note(why, size, &found, "numPlayers %d", state->numPlayers);
+  else if (state->whoseTurn < 0 || state->whoseTurn >= state->numPlayers)
+    note(why, size, &found, "whoseTurn %d", state->whoseTurn);
+  for (i = curse; i <= treasure_map; i++) {
+    if (state->supplyCount[i] < -1)
+      note(why, size, &found, "supplyCount[%d] %d", i, state->supplyCount[i]);
+  }
+  for (p = 0; p < playersOf(state); p++) {
+    checkPile("hand", p, state->hand[p], state->handCount[p], MAX_HAND,
+	      why, size, &found);
+    checkPile("deck", p, state->deck[p], state->deckCount[p], MAX_DECK,
+	      why, size, &found);
+    checkPile("discard", p, state->discard[p], state->discardCount[p],
+	      MAX_DECK, why, size, &found);
+  }
+  checkPile("playedCards", 0, state->playedCards, state->playedCardCount,
+	    MAX_DECK, why, size, &found);
+  if (baseline >= 0) {
+    total = cardTotal(state);
+    if (total > baseline)
+      note(why, size, &found, "%ld cards created", total - baseline);
+  }
+  return found;
+}
+
+#ifndef CHECK_INVARIANTS
+
+void setInvariantSampling(long every) {
+}
+
+long invariantViolations(void) {
+  return 0;
+}
+
+#else
+
+enum INVARIANT_CALL {
+  CALL_INITIALIZE_GAME = 0,
+  CALL_SHUFFLE,
+  CALL_PLAY_CARD,
+  CALL_BUY_CARD,
+  CALL_END_TURN
+};
+
+struct callRecord {
+  int call;
+  int args[4];
+  int result;
+};
+
+static const char *callNames[] = {
+  "initializeGame", "shuffle", "playCard", "buyCard", "endTurn"
+};
+
+static long sampling = -1;   /* -1 until the environment has been read */
+static long violations = 0;
+
+//per thread, so that threaded sims keep their own games apart
+static __thread struct callRecord history[INVARIANT_HISTORY];
+static __thread long numCalls = 0;
+static __thread struct gameState *lastState = NULL;
+static __thread long lastTotal = -1;
+
+void setInvariantSampling(long every) {
+  __atomic_store_n(&sampling, every < 0 ? 0 : every, __ATOMIC_RELAXED);
+}
+
+long invariantViolations(void) {
+  return __atomic_load_n(&violations, __ATOMIC_RELAXED);
+}
+
+static long samplingRate(void) {
+  long every = __atomic_load_n(&sampling, __ATOMIC_RELAXED);
+  const char *env;
+
+  if (every >= 0)
+    return every;
+  env = getenv("INVARIANT_SAMPLING");
+  every = env != NULL ? atol(env) : CHECK_INVARIANTS;
+  setInvariantSampling(every);
+  return every < 0 ? 0 : every;
+}
+
+static void dumpPile(const char *name, int p, int *cards, int count,
+		     int bound) {
+  int i;
+
+  fprintf(stderr, "  %s[%d] (%d):", name, p, count);
+  for (i = 0; i < count && i < bound; i++)
+    fprintf(stderr, " %d", cards[i]);
+  fprintf(stderr, "\n");
+}
+
+static void dump(struct gameState *state, const char *why) {
+  struct callRecord *c;
+  long first = numCalls > INVARIANT_HISTORY ? numCalls - INVARIANT_HISTORY : 0;
+  long n;
+  int p;
+  int i;
+
+  fprintf(stderr, "Invariant violated: %s\nLast calls:\n", why);
+  for (n = first; n < numCalls; n++) {
+    c = &history[n % INVARIANT_HISTORY];
+    fprintf(stderr, "  #%ld %s(%d, %d, %d, %d) = %d\n", n, callNames[c->call],
+	    c->args[0], c->args[1], c->args[2], c->args[3], c->result);
+  }
+  fprintf(stderr, "State: numPlayers %d, whoseTurn %d, phase %d, "
+	  "numActions %d, coins %d, numBuys %d, outpost %d/%d\n  supply:",
+	  state->numPlayers, state->whoseTurn, state->phase, state->numActions,
+	  state->coins, state->numBuys, state->outpostPlayed,
+	  state->outpostTurn);
+  for (i = curse; i <= treasure_map; i++)
+    fprintf(stderr, " %d", state->supplyCount[i]);
+  fprintf(stderr, "\n");
+  for (p = 0; p < playersOf(state); p++) {
+    dumpPile("hand", p, state->hand[p], state->handCount[p], MAX_HAND);
+    dumpPile("deck", p, state->deck[p], state->deckCount[p], MAX_DECK);
+    dumpPile("discard", p, state->discard[p], state->discardCount[p],
+	     MAX_DECK);
+  }
+  dumpPile("playedCards", 0, state->playedCards, state->playedCardCount,
+	   MAX_DECK);
+}
+
+static void afterCall(int call, struct gameState *state, int a, int b,
+		      int c, int d, int result) {
+  struct callRecord *r = &history[numCalls % INVARIANT_HISTORY];
+  long every = samplingRate();
+  char why[INVARIANT_TEXT];
+  long baseline;
+
+  r->call = call;
+  r->args[0] = a;
+  r->args[1] = b;
+  r->args[2] = c;
+  r->args[3] = d;
+  r->result = result;
+  numCalls++;
+  if (every == 0 || numCalls % every != 0)
+    return;
+
+  //a new game or a different state has nothing to conserve against
+  baseline = call != CALL_INITIALIZE_GAME && state == lastState
+    ? lastTotal : -1;
+  if (checkInvariants(state, baseline, why, sizeof(why)) > 0
+      && __atomic_fetch_add(&violations, 1, __ATOMIC_RELAXED)
+      < INVARIANT_MAX_DUMPS)
+    dump(state, why);
+  lastState = state;
+  lastTotal = cardTotal(state);
+}
+
+int initializeGame(int numPlayers, int kingdomCards[10], int randomSeed,
+		   struct gameState *state) {
+  int r = uncheckedInitializeGame(numPlayers, kingdomCards, randomSeed, state);
+
+  afterCall(CALL_INITIALIZE_GAME, state, numPlayers, randomSeed, 0, 0, r);
+  return r;
+}
+
+int shuffle(int player, struct gameState *state) {
+  int r = uncheckedShuffle(player, state);
+
+  afterCall(CALL_SHUFFLE, state, player, 0, 0, 0, r);
+  return r;
+}
+
+int playCard(int handPos, int choice1, int choice2, int choice3,
+	     struct gameState *state) {
+  int r = uncheckedPlayCard(handPos, choice1, choice2, choice3, state);
+
+  afterCall(CALL_PLAY_CARD, state, handPos, choice1, choice2, choice3, r);
+  return r;
+}
+
+int buyCard(int supplyPos, struct gameState *state) {
+  int r = uncheckedBuyCard(supplyPos, state);
+
+  afterCall(CALL_BUY_CARD, state, supplyPos, 0, 0, 0, r);
+  return r;
+}
+
+int endTurn(struct gameState *state) {
+  int r = uncheckedEndTurn(state);
+
+  afterCall(CALL_END_TURN, state, 0, 0, 0, 0, r);
+  return r;
+}
+
+#endif
@@ -0,0 +1,55 @@
+/* Game state invariant checker
+
+   checkInvariants looks for state corruption: pile counts outside
+   their arrays, supply counts below -1, card codes outside enum CARD in
+   any live pile, a bad player count or turn, and cards appearing from
+   nowhere.  The engine has no trash pile, so conservation is checked
+   as "cards in the players' zones plus the supply never go up"; what
+   goes missing is taken to be trashed.
+
+   Building dominion.c and invariants.c with -DCHECK_INVARIANTS=N
+   (make CHECKS=-DCHECK_INVARIANTS=N) wraps initializeGame, shuffle,
+   playCard, buyCard and endTurn so that the last INVARIANT_HISTORY
+   calls of each thread are remembered and the state is checked after
+   one call in N (1 checks every call).  Calls the engine makes to
+   itself are not wrapped.  The INVARIANT_SAMPLING environment variable
+   or setInvariantSampling overrides N at run time, 0 turns checking
+   off.  A violation prints the reasons, the remembered calls and the
+   live state to stderr (the first INVARIANT_MAX_DUMPS of them) and is
+   counted.  Without CHECK_INVARIANTS the engine is not wrapped at all.
+*/
+
+#ifndef _INVARIANTS_H
+#define _INVARIANTS_H
+
+#include "dominion.h"
+
+#define INVARIANT_HISTORY 16
+#define INVARIANT_MAX_DUMPS 10
+#define INVARIANT_TEXT 256
+
+long cardTotal(struct gameState *state);
+/* Cards in every live pile plus the supply piles in the game */
+
+int checkInvariants(struct gameState *state, long baseline, char *why,
+		    int size);
+/* Returns how many invariants are violated and describes the first
+   ones in why.  baseline is cardTotal from before the call, or -1 to
+   skip the conservation check. */
+
+void setInvariantSampling(long every);
+long invariantViolations(void);
+/* Only have an effect with CHECK_INVARIANTS */
+
+#ifdef CHECK_INVARIANTS
+//the engine's own definitions, wrapped by invariants.c
+int uncheckedInitializeGame(int numPlayers, int kingdomCards[10],
+			    int randomSeed, struct gameState *state);
+int uncheckedShuffle(int player, struct gameState *state);
+int uncheckedPlayCard(int handPos, int choice1, int choice2, int choice3,
+		      struct gameState *state);
+int uncheckedBuyCard(int supplyPos, struct gameState *state);
+int uncheckedEndTurn(struct gameState *state);
+#endif
+
+#endif
@@ -0,0 +1,493 @@
+#include "ismcts.h"
+#include "simulate.h"
+#include "dominion_helpers.h"
+#include "workq.h"
+#include "rngs.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+
+#define MCTS_GRAIN 8
+#define NO_NODE -1
+
+struct mctsNode {
+  struct mctsMove move;   /* the edge into this node */
+  int mover;              /* who made it */
+  int firstChild;
+  int nextSibling;
+  int visits;
+  int avail;              /* parent visits in which move was legal */
+  int virtualLoss;
+  double reward;          /* summed over visits, for mover */
+};
+
+struct mctsTree {
+  struct mctsNode *nodes;
+  struct mctsNode *spare;   /* where advancing copies the kept subtree */
+  long count;
+  long capacity;
+  long started;             /* iterations begun, numbering the next */
+  pthread_mutex_t lock;
+  struct gameState root;
+  struct mctsConfig config;
+  int observer;
+};
+
+void mctsDefaults(struct mctsConfig *c) {
+  c->iterations = 2000;
+  c->threads = 1;
+  c->exploration = 0.7;
+  c->rolloutTurns = MAX_SIM_TURNS;
+  c->virtualLoss = 1;
+  c->seed = 1;
+}
+
+//splitmix64, so that nearby seeds give unrelated streams
+static unsigned long long mix(unsigned long long x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+static unsigned long long next(unsigned long long *rng) {
+  *rng = mix(*rng);
+  return *rng;
+}
+
+static void shuffleCards(int *cards, int count, unsigned long long *rng) {
+  int i;
+  int j;
+  int t;
+
+  for (i = count - 1; i > 0; i--) {
+    j = (int)(next(rng) % (unsigned long long)(i + 1));
+    t = cards[i];
+    cards[i] = cards[j];
+    cards[j] = t;
+  }
+}
+
+void mctsDeterminize(struct gameState *g, int observer,
+		     unsigned long long *rng, struct gameState *out) {
+  int pool[MAX_HAND + MAX_DECK];
+  int hand;
+  int p;
+
+  memcpy(out, g, sizeof(struct gameState));
+  //observer knows what is in its deck, not the order
+  shuffleCards(out->deck[observer], out->deckCount[observer], rng);
+  //and of an opponent only what is in hand and deck together
+  for (p = 0; p < g->numPlayers; p++) {
+    if (p == observer)
+      continue;
+    hand = g->handCount[p];
+    memcpy(pool, g->hand[p], hand * sizeof(int));
+    memcpy(pool + hand, g->deck[p], g->deckCount[p] * sizeof(int));
+    shuffleCards(pool, hand + g->deckCount[p], rng);
+    memcpy(out->hand[p], pool, hand * sizeof(int));
+    memcpy(out->deck[p], pool + hand, g->deckCount[p] * sizeof(int));
+  }
+}
+
+static int findCard(int player, int card, struct gameState *g) {
+  int i;
+
+  for (i = 0; i < g->handCount[player]; i++) {
+    if (g->hand[player][i] == card)
+      return i;
+  }
+  return -1;
+}
+
+//what simChoices allows, less the cards whose engine effect corrupts the
+//state (tribute reads past its reveal buffer and runs the deck count
+//negative, salvager and sea hag lose track of cards), which would crash
+//or mislead a search that plays every card it is dealt
+static int playable(int card, int pos, struct gameState *g, int *choice1,
+		    int *choice2, int *choice3) {
+  if (card < adventurer || card > treasure_map || card == tribute
+      || card == salvager || card == sea_hag)
+    return 0;
+  return simChoices(card, pos, g, choice1, choice2, choice3) == 0;
+}
+
+static int addMove(struct mctsMove *moves, int n, int type, int card) {
+  if (n < MCTS_MAX_MOVES) {
+    moves[n].type = type;
+    moves[n].card = card;
+    n++;
+  }
+  return n;
+}
+
+int mctsLegalMoves(struct gameState *g, struct mctsMove *moves) {
+  int player = whoseTurn(g);
+  int seen[treasure_map + 1];
+  int choice1, choice2, choice3;
+  int card;
+  int n = 0;
+  int i;
+
+  if (isGameOver(g))
+    return 0;
+  if (g->phase == 0 && g->numActions > 0) {
+    memset(seen, 0, sizeof(seen));
+    for (i = 0; i < g->handCount[player]; i++) {
+      card = g->hand[player][i];
+      if (card < 0 || card > treasure_map || seen[card])
+	continue;
+      seen[card] = 1;
+      if (playable(card, i, g, &choice1, &choice2, &choice3))
+	n = addMove(moves, n, MCTS_PLAY, card);
+    }
+    //with nothing to play, go straight to the buys
+    if (n > 0)
+      return addMove(moves, n, MCTS_END_ACTIONS, -1);
+  }
+  if (g->numBuys > 0) {
+    for (card = estate; card <= treasure_map; card++) {
+      if (supplyCount(card, g) > 0 && getCost(card) <= g->coins)
+	n = addMove(moves, n, MCTS_BUY, card);
+    }
+  }
+  return addMove(moves, n, MCTS_END_TURN, -1);
+}
+
+int mctsApply(struct mctsMove *m, struct gameState *g) {
+  int choice1, choice2, choice3;
+  int pos;
+
+  switch (m->type) {
+  case MCTS_PLAY:
+    pos = findCard(whoseTurn(g), m->card, g);
+    if (pos < 0 || !playable(m->card, pos, g, &choice1, &choice2, &choice3))
+      return -1;
+    if (playCard(pos, choice1, choice2, choice3, g) == 0)
+      return 0;
+    //a card that cannot be played ends the action phase, not the search
+    g->phase = 1;
+    return -1;
+  case MCTS_END_ACTIONS:
+    g->phase = 1;
+    return 0;
+  case MCTS_BUY:
+    return buyCard(m->card, g);
+  default:
+    return endTurn(g);
+  }
+}
+
+//big money for everyone, from wherever the turn stands
+static void rollout(struct gameState *g, int maxTurns) {
+  static struct strategy bigMoney = {-1, 0};
+  struct simMove buy;
+  int choice1, choice2, choice3;
+  int card;
+  int player;
+  int plays;
+  int turns = 0;
+  int i;
+
+  while (!isGameOver(g) && turns < maxTurns) {
+    player = whoseTurn(g);
+    for (plays = 0; g->phase == 0 && g->numActions > 0
+	   && plays < MAX_SIM_PLAYS; plays++) {
+      //the first action card there are choices for
+      for (i = 0; i < g->handCount[player]; i++) {
+	card = g->hand[player][i];
+	if (playable(card, i, g, &choice1, &choice2, &choice3))
+	  break;
+      }
+      if (i == g->handCount[player]
+	  || playCard(i, choice1, choice2, choice3, g) < 0)
+	break;
+    }
+    while (simBuyMove(&bigMoney, 0, g, &buy) == 0
+	   && applySimMove(&buy, g) == 0)
+      ;
+    endTurn(g);
+    turns++;
+  }
+}
+
+//1 for the leader, split between those tied for the lead
+static void rewards(struct gameState *g, double *reward) {
+  int score[MAX_PLAYERS];
+  int best = 0;
+  int leaders = 0;
+  int p;
+
+  for (p = 0; p < g->numPlayers; p++) {
+    score[p] = scoreFor(p, g);
+    if (p == 0 || score[p] > best)
+      best = score[p];
+  }
+  for (p = 0; p < g->numPlayers; p++)
+    leaders += score[p] == best;
+  for (p = 0; p < g->numPlayers; p++)
+    reward[p] = score[p] == best ? 1.0 / leaders : 0.0;
+}
+
+static int sameMove(struct mctsMove *a, struct mctsMove *b) {
+  return a->type == b->type && a->card == b->card;
+}
+
+static double bound(struct mctsTree *t, struct mctsNode *n) {
+  double visits = n->visits + n->virtualLoss;
+
+  //a virtual loss counts as a visit that scored nothing
+  return n->reward / visits
+    + t->config.exploration * sqrt(log((double)n->avail) / visits);
+}
+
+//picks the edge to follow from node, expanding one if any legal move has
+//none yet; called with the lock held, returns NO_NODE at a leaf
+static int descend(struct mctsTree *t, int node, struct gameState *g,
+		   unsigned long long *rng) {
+  struct mctsMove moves[MCTS_MAX_MOVES];
+  int child[MCTS_MAX_MOVES];
+  struct mctsNode *n;
+  int untried = 0;
+  int count = mctsLegalMoves(g, moves);
+  int pick = -1;
+  int c;
+  int i;
+
+  for (i = 0; i < count; i++) {
+    for (c = t->nodes[node].firstChild; c != NO_NODE;
+	 c = t->nodes[c].nextSibling) {
+      if (sameMove(&t->nodes[c].move, &moves[i]))
+	break;
+    }
+    child[i] = c;
+    if (c == NO_NODE)
+      untried++;
+    else
+      t->nodes[c].avail++;
+  }
+  if (count == 0)
+    return NO_NODE;
+
+  if (untried > 0 && t->count < t->capacity) {
+    untried = (int)(next(rng) % (unsigned long long)untried);
+    for (i = 0; i < count; i++) {
+      if (child[i] == NO_NODE && untried-- == 0)
+	break;
+    }
+    c = t->count++;
+    n = &t->nodes[c];
+    memset(n, 0, sizeof(struct mctsNode));
+    n->move = moves[i];
+    n->mover = whoseTurn(g);
+    n->firstChild = NO_NODE;
+    n->nextSibling = t->nodes[node].firstChild;
+    n->avail = 1;
+    t->nodes[node].firstChild = c;
+    return c;
+  }
+  for (i = 0; i < count; i++) {
+    if (child[i] != NO_NODE && (pick < 0 || bound(t, &t->nodes[child[i]])
+				> bound(t, &t->nodes[child[pick]])))
+      pick = i;
+  }
+  return pick < 0 ? NO_NODE : child[pick];
+}
+
+static void clearRoot(struct mctsTree *t) {
+  memset(&t->nodes[0], 0, sizeof(struct mctsNode));
+  t->nodes[0].firstChild = NO_NODE;
+  t->nodes[0].mover = -1;
+  t->count = 1;
+}
+
+struct mctsTree *mctsTreeCreate(struct mctsConfig *c, long capacity) {
+  struct mctsTree *t = calloc(1, sizeof(struct mctsTree));
+
+  if (t == NULL)
+    return NULL;
+  t->capacity = capacity > 1 ? capacity : 2;
+  t->nodes = malloc(t->capacity * sizeof(struct mctsNode));
+  t->spare = malloc(t->capacity * sizeof(struct mctsNode));
+  if (t->nodes == NULL || t->spare == NULL) {
+    mctsTreeFree(t);
+    return NULL;
+  }
+  t->config = *c;
+  pthread_mutex_init(&t->lock, NULL);
+  clearRoot(t);
+  return t;
+}
+
+void mctsTreeFree(struct mctsTree *t) {
+  if (t == NULL)
+    return;
+  if (t->nodes != NULL && t->spare != NULL)
+    pthread_mutex_destroy(&t->lock);
+  free(t->nodes);
+  free(t->spare);
+  free(t);
+}
+
+void mctsTreeReset(struct mctsTree *t, struct gameState *g, int observer) {
+  pthread_mutex_lock(&t->lock);
+  memcpy(&t->root, g, sizeof(struct gameState));
+  t->observer = observer;
+  clearRoot(t);
+  pthread_mutex_unlock(&t->lock);
+}
+
+long mctsTreeAdvance(struct mctsTree *t, struct mctsMove *m,
+		     struct gameState *after) {
+  struct mctsNode *kept = t->spare;
+  struct mctsNode *n;
+  long count = 1;
+  long i;
+  int c;
+
+  pthread_mutex_lock(&t->lock);
+  memcpy(&t->root, after, sizeof(struct gameState));
+  for (c = t->nodes[0].firstChild; c != NO_NODE; c = t->nodes[c].nextSibling) {
+    if (sameMove(&t->nodes[c].move, m))
+      break;
+  }
+  if (c == NO_NODE || t->nodes[c].visits == 0) {
+    clearRoot(t);
+    pthread_mutex_unlock(&t->lock);
+    return 0;
+  }
+  //copy the subtree breadth first, so each child list is copied once its
+  //parent has its new place; firstChild holds the old index until then
+  kept[0] = t->nodes[c];
+  kept[0].nextSibling = NO_NODE;
+  for (i = 0; i < count; i++) {
+    c = kept[i].firstChild;
+    kept[i].firstChild = NO_NODE;
+    for (; c != NO_NODE; c = t->nodes[c].nextSibling) {
+      n = &kept[count];
+      *n = t->nodes[c];
+      n->nextSibling = kept[i].firstChild;
+      kept[i].firstChild = count++;
+    }
+  }
+  t->spare = t->nodes;
+  t->nodes = kept;
+  t->count = count;
+  pthread_mutex_unlock(&t->lock);
+  return kept[0].visits;
+}
+
+void mctsTreeIterate(struct mctsTree *t, struct gameState *g) {
+  unsigned long long rng;
+  int path[MCTS_MAX_DEPTH + 1];
+  double reward[MAX_PLAYERS];
+  struct mctsNode *n;
+  int depth = 0;
+  int leaf = 0;
+  int node;
+  int i;
+
+  pthread_mutex_lock(&t->lock);
+  rng = mix(t->config.seed * 1000003ULL + t->started++);
+  pthread_mutex_unlock(&t->lock);
+  mctsDeterminize(&t->root, t->observer, &rng, g);
+  //the engine's own shuffles in this iteration follow from it too
+  SelectStream(1);
+  PutSeed((long)(next(&rng) % 2147483646) + 1);
+
+  path[depth++] = 0;
+  pthread_mutex_lock(&t->lock);
+  while (!leaf && depth <= MCTS_MAX_DEPTH) {
+    node = descend(t, path[depth - 1], g, &rng);
+    if (node == NO_NODE)
+      break;
+    n = &t->nodes[node];
+    leaf = n->visits == 0;
+    n->virtualLoss += t->config.virtualLoss;
+    path[depth++] = node;
+    pthread_mutex_unlock(&t->lock);
+    mctsApply(&n->move, g);
+    pthread_mutex_lock(&t->lock);
+  }
+  pthread_mutex_unlock(&t->lock);
+
+  rollout(g, t->config.rolloutTurns);
+  rewards(g, reward);
+
+  pthread_mutex_lock(&t->lock);
+  t->nodes[0].visits++;
+  for (i = 1; i < depth; i++) {
+    n = &t->nodes[path[i]];
+    n->visits++;
+    n->virtualLoss -= t->config.virtualLoss;
+    n->reward += reward[n->mover];
+  }
+  pthread_mutex_unlock(&t->lock);
+}
+
+int mctsTreeBest(struct mctsTree *t, struct mctsMove *best,
+		 struct mctsStats *stats) {
+  int pick = NO_NODE;
+  int i;
+
+  pthread_mutex_lock(&t->lock);
+  //the most visited move is the most trusted one
+  for (i = t->nodes[0].firstChild; i != NO_NODE;
+       i = t->nodes[i].nextSibling) {
+    if (pick == NO_NODE || t->nodes[i].visits > t->nodes[pick].visits)
+      pick = i;
+  }
+  if (pick != NO_NODE) {
+    *best = t->nodes[pick].move;
+    if (stats != NULL) {
+      stats->iterations = t->nodes[0].visits;
+      stats->nodes = t->count;
+      stats->visits = t->nodes[pick].visits;
+    }
+  }
+  pthread_mutex_unlock(&t->lock);
+  return pick == NO_NODE ? -1 : 0;
+}
+
+static void searchRange(void *arg, int worker, long begin, long end) {
+  struct mctsTree *t = arg;
+  struct gameState *g = malloc(sizeof(struct gameState));
+  long i;
+
+  if (g == NULL)
+    return;
+  for (i = begin; i < end; i++)
+    mctsTreeIterate(t, g);
+  free(g);
+}
+
+int mctsDecide(struct gameState *g, struct mctsConfig *c,
+	       struct mctsMove *best, struct mctsStats *stats) {
+  struct mctsTree *t;
+  struct timespec start, stop;
+  int result;
+
+  if (isGameOver(g) || c->iterations < 1)
+    return -1;
+  t = mctsTreeCreate(c, c->iterations + 1);
+  if (t == NULL)
+    return -1;
+  mctsTreeReset(t, g, whoseTurn(g));
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  if (workqRun(0, c->iterations, MCTS_GRAIN, c->threads, searchRange,
+	       t) < 0) {
+    mctsTreeFree(t);
+    return -1;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &stop);
+
+  result = mctsTreeBest(t, best, stats);
+  if (result == 0 && stats != NULL)
+    stats->seconds = (stop.tv_sec - start.tv_sec)
+      + (stop.tv_nsec - start.tv_nsec) / 1e9;
+  mctsTreeFree(t);
+  return result;
+}
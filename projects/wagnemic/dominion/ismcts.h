@@ -0,0 +1,119 @@
+/* Information-set Monte Carlo tree search
+
+   A player that searches the game without peeking at what it cannot
+   see.  Each iteration deals a determinization of the root state from
+   the point of view of the player to move: that player's deck is
+   reshuffled, and every opponent's hand and deck are pooled and dealt
+   again, so each pile keeps its size and each player keeps the card
+   counts fullDeckCount reports, but the hidden order is new.  All
+   determinizations share one tree (single observer ISMCTS), whose
+   edges are moves rather than states; a child's availability counts
+   the visits to its parent in which the move was legal, and stands in
+   for the parent's visit count in the UCB bound.
+
+   A move is one step of a turn: play an action card (with simChoices'
+   choices), stop playing actions, buy a card, or end the turn.  Tribute,
+   salvager and sea hag are never played: the engine's versions of them
+   corrupt the state.  Past the tree, playouts play big money from
+   simulate.c to the end of the game, or for rolloutTurns turns, and
+   score 1 for the player ahead (split on ties).
+
+   Iterations run on a workq thread pool sharing the tree under one
+   lock, which is held only to walk and update nodes; determinizing,
+   applying moves and playouts run outside it.  A thread on its way
+   down adds a virtual loss to every node it passes, so the others
+   spread over different branches until it backs its result up.
+   Iteration i draws its randomness from seed and i alone, so a search
+   on one thread is repeatable.
+
+   mctsDecide builds a tree for one decision and drops it.  A player
+   that keeps searching across moves (see bot.h) holds an mctsTree
+   instead: it resets it to a state, runs iterations on it from as many
+   threads as it likes for as long as it likes, reads off the best move
+   at any point, and after each move in the game advances it, keeping
+   the subtree below that move and dropping the rest.
+*/
+
+#ifndef _ISMCTS_H
+#define _ISMCTS_H
+
+#include "dominion.h"
+
+#define MCTS_MAX_MOVES 64
+#define MCTS_MAX_DEPTH 128
+
+enum MCTS_MOVE {
+  MCTS_PLAY = 0,       /* card */
+  MCTS_END_ACTIONS,
+  MCTS_BUY,            /* card */
+  MCTS_END_TURN
+};
+
+struct mctsMove {
+  int type;
+  int card;
+};
+
+struct mctsConfig {
+  long iterations;
+  int threads;         /* 0 = one per core */
+  double exploration;  /* UCB constant */
+  int rolloutTurns;
+  int virtualLoss;
+  unsigned long seed;
+};
+
+struct mctsTree;
+
+struct mctsStats {
+  long iterations;
+  long nodes;
+  double seconds;
+  int visits;          /* the chosen move's */
+};
+
+void mctsDefaults(struct mctsConfig *c);
+/* 2000 iterations, one thread, exploration 0.7, playouts to the end */
+
+int mctsLegalMoves(struct gameState *g, struct mctsMove *moves);
+/* Fills up to MCTS_MAX_MOVES moves for the player to move; returns the
+   count, 0 once the game is over */
+
+int mctsApply(struct mctsMove *m, struct gameState *g);
+/* Returns what the engine call returned */
+
+void mctsDeterminize(struct gameState *g, int observer,
+		     unsigned long long *rng, struct gameState *out);
+/* A copy of g with everything observer cannot see dealt again */
+
+int mctsDecide(struct gameState *g, struct mctsConfig *c,
+	       struct mctsMove *best, struct mctsStats *stats);
+/* Searches from g for the player to move; stats may be NULL.  Returns
+   -1 if the game is over or memory runs out */
+
+struct mctsTree *mctsTreeCreate(struct mctsConfig *c, long capacity);
+/* An empty tree of at most capacity nodes, searching with c's
+   exploration, playouts, virtual loss and seed; once it is full,
+   iterations go on updating the nodes it has.  NULL if memory runs out */
+
+void mctsTreeFree(struct mctsTree *t);
+
+void mctsTreeReset(struct mctsTree *t, struct gameState *g, int observer);
+/* Drops the tree and searches a copy of g, seen by observer */
+
+long mctsTreeAdvance(struct mctsTree *t, struct mctsMove *m,
+		     struct gameState *after);
+/* Makes the child for m the root, keeping its subtree, and after (the
+   state m led to) the state searched.  Returns the visits kept, 0 if
+   the tree had to start over.  No iteration may be running */
+
+void mctsTreeIterate(struct mctsTree *t, struct gameState *scratch);
+/* Runs one iteration, using scratch for the determinization; any
+   number of threads may run them at once */
+
+int mctsTreeBest(struct mctsTree *t, struct mctsMove *best,
+		 struct mctsStats *stats);
+/* The most visited move at the root, and stats other than seconds (may
+   be NULL); -1 if no move has been tried yet */
+
+#endif
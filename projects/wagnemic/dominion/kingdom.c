@@ -0,0 +1,104 @@
+#include "kingdom.h"
+#include <stdlib.h>
+
+static long binomial(int n, int k) {
+  static long table[NUM_KINGDOM_CARDS + 1][KINGDOM_SIZE + 1];
+  static int filled = 0;
+  int i, j;
+
+  if (!filled) {
+    for (i = 0; i <= NUM_KINGDOM_CARDS; i++) {
+      for (j = 0; j <= KINGDOM_SIZE; j++) {
+	if (j == 0)
+	  table[i][j] = 1;
+	else if (i == 0)
+	  table[i][j] = 0;
+	else
+	  table[i][j] = table[i-1][j-1] + table[i-1][j];
+      }
+    }
+    filled = 1;
+  }
+  if (n < 0 || k < 0 || n > NUM_KINGDOM_CARDS || k > KINGDOM_SIZE)
+    return 0;
+  return table[n][k];
+}
+
+unsigned int kingdomMask(int kingdomCards[KINGDOM_SIZE]) {
+  unsigned int mask = 0;
+  int i;
+
+  for (i = 0; i < KINGDOM_SIZE; i++) {
+    if (kingdomCards[i] < adventurer || kingdomCards[i] > treasure_map)
+      return 0;
+    mask |= 1u << (kingdomCards[i] - adventurer);
+  }
+  return mask;
+}
+
+int kingdomFromMask(unsigned int mask, int kingdomCards[KINGDOM_SIZE]) {
+  int i;
+  int n = 0;
+
+  for (i = 0; i < NUM_KINGDOM_CARDS; i++) {
+    if (mask & (1u << i)) {
+      if (n == KINGDOM_SIZE)
+	return -1;
+      kingdomCards[n++] = adventurer + i;
+    }
+  }
+  return n == KINGDOM_SIZE ? 0 : -1;
+}
+
+long kingdomRank(int kingdomCards[KINGDOM_SIZE]) {
+  unsigned int mask = kingdomMask(kingdomCards);
+  long rank = 0;
+  int i;
+  int n = 0;
+
+  if (__builtin_popcount(mask) != KINGDOM_SIZE)
+    return -1;
+
+  //colex rank: sum of C(c_i, i+1) over the cards in ascending order
+  for (i = 0; i < NUM_KINGDOM_CARDS; i++) {
+    if (mask & (1u << i)) {
+      rank += binomial(i, n + 1);
+      n++;
+    }
+  }
+  return rank;
+}
+
+int kingdomUnrank(long rank, int kingdomCards[KINGDOM_SIZE]) {
+  int i;
+  int c = NUM_KINGDOM_CARDS - 1;
+
+  if (rank < 0 || rank >= KINGDOM_SETS)
+    return -1;
+
+  for (i = KINGDOM_SIZE - 1; i >= 0; i--) {
+    while (binomial(c, i + 1) > rank)
+      c--;
+    kingdomCards[i] = adventurer + c;
+    rank -= binomial(c, i + 1);
+    c--;
+  }
+  return 0;
+}
+
+long kingdomSample(long stratum, long strata, long seed) {
+  long begin = stratum * KINGDOM_SETS / strata;
+  long end = (stratum + 1) * KINGDOM_SETS / strata;
+  unsigned long long x = (unsigned long long)seed * 0x9E3779B97F4A7C15ULL + stratum;
+
+  //splitmix64 finalizer
+  x ^= x >> 30;
+  x *= 0xBF58476D1CE4E5B9ULL;
+  x ^= x >> 27;
+  x *= 0x94D049BB133111EBULL;
+  x ^= x >> 31;
+
+  if (end <= begin)
+    return begin;
+  return begin + (long)(x % (unsigned long long)(end - begin));
+}
@@ -0,0 +1,33 @@
+/* Kingdom set enumeration
+
+   A kingdom is a set of 10 distinct cards out of the 20 kingdom cards
+   (adventurer .. treasure_map).  Sets are numbered 0 .. KINGDOM_SETS-1
+   in colexicographic order so that drivers can split the whole space
+   into index ranges.
+*/
+
+#ifndef _KINGDOM_H
+#define _KINGDOM_H
+
+#include "dominion.h"
+
+#define NUM_KINGDOM_CARDS (treasure_map - adventurer + 1)
+#define KINGDOM_SIZE 10
+#define KINGDOM_SETS 184756L   /* 20 choose 10 */
+
+long kingdomRank(int kingdomCards[KINGDOM_SIZE]);
+/* Index of the set, or -1 if the cards are not 10 distinct kingdom cards */
+
+int kingdomUnrank(long rank, int kingdomCards[KINGDOM_SIZE]);
+/* Fill kingdomCards (ascending) with the set at the given index */
+
+unsigned int kingdomMask(int kingdomCards[KINGDOM_SIZE]);
+/* Bit (card - adventurer) set for every card in the kingdom */
+
+int kingdomFromMask(unsigned int mask, int kingdomCards[KINGDOM_SIZE]);
+
+long kingdomSample(long stratum, long strata, long seed);
+/* Stratified sample: a deterministic pseudo-random index inside the
+   stratum-th of strata equal slices of the index space */
+
+#endif
@@ -0,0 +1,394 @@
+/* Differential lockstep harness
+
+   Plays the same seeds and the same moves on the reference engine (see
+   refengine.h) and on the working engine, comparing the return value
+   and the live part of both game states after every call.  Moves are
+   chosen from the working engine's state by the simulator strategies;
+   by default every seat gets a random action card of the game's
+   kingdom so that all the card effects get exercised.
+
+   Games run in worker processes (see shard.h), so the seeds that crash
+   both engines on their known overruns are isolated and counted rather
+   than taking the run down.  The lowest diverging seed is replayed in
+   the coordinator and its first diverging call is reported with the
+   fields that differ.  Exits 1 if any game diverged.
+
+   Usage: lockstep [-j workers] [-n games] [-s first seed] [-p players]
+                   [-a strategy] [-b strategy] [-k fixed] [-v]
+*/
+
+#include "dominion.h"
+#include "refengine.h"
+#include "simulate.h"
+#include "interface.h"
+#include "shard.h"
+#include "statediff.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SHARD_GAMES 500
+
+enum CALL {
+  CALL_INIT = 0,
+  CALL_PLAY,
+  CALL_BUY,
+  CALL_END,
+  CALL_GAME_OVER,
+  CALL_SCORE
+};
+
+struct divergence {
+  long seed;
+  long call;         /* calls made in the game before this one */
+  int turn;
+  int kind;          /* enum CALL */
+  struct simMove move;
+  int numPlayers;
+  int kingdom[10];
+  struct strategy strategies[MAX_PLAYERS];
+  int candidateResult;
+  int referenceResult;
+  struct gameState candidate;
+  struct gameState reference;
+};
+
+struct lockstep {
+  int numPlayers;
+  int fixedKingdom;
+  int kingdom[10];
+  int fixedStrategies;
+  struct strategy strategies[MAX_PLAYERS];
+};
+
+struct lockstepResult {
+  long games;
+  long calls;
+  long diverged;
+  long firstSeed;   /* lowest diverging seed, when diverged > 0 */
+};
+
+static int refApply(struct simMove *m, struct gameState *state) {
+  switch (m->type) {
+  case MOVE_PLAY:
+    return ref_playCard(m->handPos, m->choice1, m->choice2, m->choice3, state);
+  case MOVE_BUY:
+    return ref_buyCard(m->card, state);
+  default:
+    return ref_endTurn(state);
+  }
+}
+
+struct game {
+  struct lockstep *ls;
+  struct divergence *capture;   /* filled in on divergence if not NULL */
+  long seed;
+  long calls;
+  int turn;
+  int numPlayers;
+  int kingdom[10];
+  struct strategy strategies[MAX_PLAYERS];
+  struct gameState cand;
+  struct gameState ref;
+};
+
+static void diverge(struct game *g, int kind, struct simMove *m, int rc,
+		    int rr) {
+  struct divergence *d = g->capture;
+
+  if (d != NULL) {
+    d->seed = g->seed;
+    d->call = g->calls;
+    d->turn = g->turn;
+    d->kind = kind;
+    if (m != NULL)
+      d->move = *m;
+    else
+      memset(&d->move, 0, sizeof(d->move));
+    d->numPlayers = g->numPlayers;
+    memcpy(d->kingdom, g->kingdom, sizeof(d->kingdom));
+    memcpy(d->strategies, g->strategies, sizeof(d->strategies));
+    d->candidateResult = rc;
+    d->referenceResult = rr;
+    d->candidate = g->cand;
+    d->reference = g->ref;
+  }
+}
+
+//one lockstep step: returns 0 if both engines agree
+static int step(struct game *g, int kind, struct simMove *m, int rc, int rr) {
+  g->calls++;
+  if (rc == rr && sameGameState(&g->cand, &g->ref))
+    return 0;
+  diverge(g, kind, m, rc, rr);
+  return -1;
+}
+
+static void pickStrategies(struct game *g) {
+  struct lockstep *ls = g->ls;
+  unsigned long x = (unsigned long)g->seed * 0x9e3779b97f4a7c15UL;
+  int i;
+
+  for (i = 0; i < g->numPlayers; i++) {
+    if (ls->fixedStrategies) {
+      g->strategies[i] = ls->strategies[i];
+      continue;
+    }
+    //a kingdom action card (not gardens) with 1..3 copies per seat
+    do {
+      x ^= x >> 29;
+      x *= 0xbf58476d1ce4e5b9UL;
+      g->strategies[i].action = g->kingdom[(x >> 33) % 10];
+    } while (g->strategies[i].action == gardens);
+    g->strategies[i].copies = 1 + (int)((x >> 17) % 3);
+  }
+}
+
+//returns -1 if the engines diverged
+static int playGame(struct game *g) {
+  struct strategy *s;
+  struct simMove m;
+  int buys[MAX_PLAYERS] = {0};
+  int players[MAX_PLAYERS];
+  int refPlayers[MAX_PLAYERS];
+  int player;
+  int plays;
+  int rc;
+  int rr;
+  int i;
+
+  memcpy(g->kingdom, g->ls->kingdom, sizeof(g->kingdom));
+  if (!g->ls->fixedKingdom)
+    selectKingdomCards((int)g->seed, g->kingdom);
+  pickStrategies(g);
+
+  memset(&g->cand, 0, sizeof(struct gameState));
+  memset(&g->ref, 0, sizeof(struct gameState));
+  rc = initializeGame(g->numPlayers, g->kingdom, (int)g->seed, &g->cand);
+  rr = ref_initializeGame(g->numPlayers, g->kingdom, (int)g->seed, &g->ref);
+  if (step(g, CALL_INIT, NULL, rc, rr) < 0)
+    return -1;
+  if (rc < 0)
+    return 0;
+
+  for (g->turn = 0; g->turn < MAX_SIM_TURNS; g->turn++) {
+    rc = isGameOver(&g->cand);
+    rr = ref_isGameOver(&g->ref);
+    if (step(g, CALL_GAME_OVER, NULL, rc, rr) < 0)
+      return -1;
+    if (rc)
+      break;
+    player = whoseTurn(&g->cand);
+    s = &g->strategies[player];
+
+    for (plays = 0; plays < MAX_SIM_PLAYS; plays++) {
+      if (simPlayMove(s, &g->cand, &m) < 0)
+	break;
+      rc = applySimMove(&m, &g->cand);
+      rr = refApply(&m, &g->ref);
+      if (step(g, CALL_PLAY, &m, rc, rr) < 0)
+	return -1;
+      if (rc < 0)
+	break;
+    }
+    while (simBuyMove(s, buys[player], &g->cand, &m) == 0) {
+      rc = applySimMove(&m, &g->cand);
+      rr = refApply(&m, &g->ref);
+      if (step(g, CALL_BUY, &m, rc, rr) < 0)
+	return -1;
+      if (rc < 0)
+	break;
+      if (m.card == s->action)
+	buys[player]++;
+    }
+    m.type = MOVE_END;
+    rc = applySimMove(&m, &g->cand);
+    rr = refApply(&m, &g->ref);
+    if (step(g, CALL_END, &m, rc, rr) < 0)
+      return -1;
+  }
+
+  for (i = 0; i < g->numPlayers; i++) {
+    rc = scoreFor(i, &g->cand);
+    rr = ref_scoreFor(i, &g->ref);
+    if (step(g, CALL_SCORE, NULL, rc, rr) < 0)
+      return -1;
+  }
+  getWinners(players, &g->cand);
+  ref_getWinners(refPlayers, &g->ref);
+  return step(g, CALL_SCORE, NULL, 0,
+	      memcmp(players, refPlayers, sizeof(players)) == 0 ? 0 : 1);
+}
+
+static void startGame(struct game *g, struct lockstep *ls, long seed,
+		      struct divergence *capture) {
+  g->ls = ls;
+  g->capture = capture;
+  g->seed = seed;
+  g->calls = 0;
+  g->turn = 0;
+  g->numPlayers = ls->numPlayers;
+}
+
+static int playShard(void *arg, long firstSeed, long games, void *result) {
+  struct lockstepResult *r = result;
+  struct game *g = malloc(sizeof(struct game));
+  long seed;
+
+  if (g == NULL)
+    return -1;
+  for (seed = firstSeed; seed < firstSeed + games; seed++) {
+    startGame(g, arg, seed, NULL);
+    if (playGame(g) < 0 && r->diverged++ == 0)
+      r->firstSeed = seed;
+    r->games++;
+    r->calls += g->calls;
+  }
+  free(g);
+  return 0;
+}
+
+static void mergeShard(void *arg, void *total, void *result) {
+  struct lockstepResult *into = total;
+  struct lockstepResult *from = result;
+
+  if (from->diverged > 0
+      && (into->diverged == 0 || from->firstSeed < into->firstSeed))
+    into->firstSeed = from->firstSeed;
+  into->games += from->games;
+  into->calls += from->calls;
+  into->diverged += from->diverged;
+}
+
+static void report(struct divergence *d) {
+  static const char *callNames[] = {
+    "initializeGame", "playCard", "buyCard", "endTurn", "isGameOver",
+    "scoreFor/getWinners"
+  };
+  static struct stateDiffs diffs;
+  char name[MAX_STRING_LENGTH];
+  char text[MAX_STRING_LENGTH];
+  int i;
+
+  printf("First divergence: seed %ld, call %ld (turn %d): %s", d->seed,
+	 d->call, d->turn, callNames[d->kind]);
+  cardNumToName(d->move.card, name);
+  if (d->kind == CALL_PLAY)
+    printf(" %s at hand %d, choices %d %d %d", name, d->move.handPos,
+	   d->move.choice1, d->move.choice2, d->move.choice3);
+  else if (d->kind == CALL_BUY)
+    printf(" %s", name);
+  printf("\n  returned: candidate %d, reference %d\n", d->candidateResult,
+	 d->referenceResult);
+  printf("  players %d, kingdom", d->numPlayers);
+  for (i = 0; i < 10; i++) {
+    cardNumToName(d->kingdom[i], name);
+    printf("%s %s", i ? "," : "", name);
+  }
+  printf("\n  strategies");
+  for (i = 0; i < d->numPlayers; i++) {
+    formatStrategy(&d->strategies[i], text, sizeof(text));
+    printf(" %s", text);
+  }
+  printf("\n  state after the call:\n");
+  diffGameState(&d->candidate, &d->reference, &diffs);
+  printStateDiffs(stdout, &d->candidate, &d->reference, &diffs, "candidate",
+		  "reference");
+}
+
+static void usage(void) {
+  printf("Usage: lockstep [-j workers] [-n games] [-s first seed] [-p players]\n"
+	 "                [-a strategy] [-b strategy] [-k fixed] [-v]\n");
+}
+
+int main(int argc, char **argv) {
+  static struct lockstep ls;
+  static struct game g;
+  static struct divergence first;
+  struct lockstepResult total;
+  struct shardJob shards;
+  struct shardStats stats;
+  struct strategy a;
+  struct strategy other;
+  int verbose = 0;
+  int opt;
+  int i;
+  int k[10] = {adventurer, gardens, embargo, village, minion, mine, cutpurse,
+	       sea_hag, tribute, smithy};
+  struct timespec start;
+  struct timespec stop;
+  double seconds;
+
+  ls.numPlayers = 2;
+  memcpy(ls.kingdom, k, sizeof(k));
+  parseStrategy("smithy", &a);
+  parseStrategy("adventurer", &other);
+  memset(&shards, 0, sizeof(shards));
+  shards.numWorkers = sysconf(_SC_NPROCESSORS_ONLN);
+  shards.firstSeed = 1;
+  shards.games = 10000;
+  shards.shardGames = SHARD_GAMES;
+
+  while ((opt = getopt(argc, argv, "j:n:s:p:a:b:k:v")) != -1) {
+    switch (opt) {
+    case 'j': shards.numWorkers = atoi(optarg); break;
+    case 'n': shards.games = atol(optarg); break;
+    case 's': shards.firstSeed = atol(optarg); break;
+    case 'p': ls.numPlayers = atoi(optarg); break;
+    case 'a':
+    case 'b':
+      if (parseStrategy(optarg, opt == 'a' ? &a : &other) < 0) {
+	printf("Unknown strategy %s\n", optarg);
+	return 2;
+      }
+      ls.fixedStrategies = 1;
+      break;
+    case 'k': ls.fixedKingdom = strcmp(optarg, "fixed") == 0; break;
+    case 'v': verbose = 1; break;
+    default: usage(); return 2;
+    }
+  }
+  if (shards.games < 1 || shards.firstSeed < 1 || shards.numWorkers < 1
+      || ls.numPlayers < 2 || ls.numPlayers > MAX_PLAYERS) {
+    usage();
+    return 2;
+  }
+  ls.strategies[0] = a;
+  for (i = 1; i < MAX_PLAYERS; i++)
+    ls.strategies[i] = other;
+
+  memset(&total, 0, sizeof(total));
+  shards.resultSize = sizeof(struct lockstepResult);
+  shards.play = playShard;
+  shards.merge = mergeShard;
+  shards.arg = &ls;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  if (runShardedBatch(&shards, &total, &stats) < 0) {
+    printf("Could not start worker processes\n");
+    return 2;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &stop);
+  seconds = stop.tv_sec - start.tv_sec + (stop.tv_nsec - start.tv_nsec) / 1e9;
+
+  printf("Games: %ld, calls: %ld, diverged games: %ld\n", total.games,
+	 total.calls, total.diverged);
+  if (stats.crashedSeeds > 0)
+    printf("Crashed seeds: %ld (first %ld)\n", stats.crashedSeeds,
+	   stats.firstCrashedSeed);
+  if (verbose)
+    printf("%.2fs, %.0f games/hour on %d workers\n", seconds,
+	   seconds > 0 ? total.games / seconds * 3600 : 0.0, shards.numWorkers);
+  if (total.diverged == 0)
+    return 0;
+
+  //deterministic, so replaying the seed here finds the same call
+  startGame(&g, &ls, total.firstSeed, &first);
+  if (playGame(&g) == 0)
+    printf("Seed %ld diverged in a worker but not when replayed\n",
+	   total.firstSeed);
+  else
+    report(&first);
+  return 1;
+}
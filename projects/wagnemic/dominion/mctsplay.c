@@ -0,0 +1,251 @@
+/* ISMCTS against a fixed strategy
+
+   Plays two player games between the information-set MCTS player (see
+   ismcts.h) and one of simulate.c's strategies, swapping seats every
+   game, and reports the results and how the search went.  Both sides
+   are bots (see bot.h) asked for one move at a time.  The search bot
+   keeps its tree from move to move; it searches each move for -T
+   milliseconds, or else for -i more iterations, and with -P
+   it goes on searching through the other player's turns as well.  With
+   -E the endgame solver (see endgame.h) takes over its buys in the
+   final turns, looking that many turns ahead.  With -B it opens from an
+   opening book made by mkbook (see book.h) in the kingdoms it has.
+
+   Usage: mctsplay [-g games] [-i iterations] [-j threads] [-s first seed]
+                   [-b strategy] [-k random] [-t playout turns]
+                   [-T ms per move] [-P] [-E endgame turns] [-B book]
+*/
+
+#include "dominion.h"
+#include "interface.h"
+#include "simulate.h"
+#include "ismcts.h"
+#include "bot.h"
+#include "endgame.h"
+#include "book.h"
+#include "workq.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_TURN_STEPS 64   /* decisions in one turn before it is ended */
+#define SEARCH_NODES (1L << 18)
+
+struct match {
+  struct mctsConfig config;
+  struct strategy other;
+  double budget;       /* seconds per move, 0 for config.iterations */
+  int ponder;
+  int endgameTurns;    /* 0 for no endgame solver */
+  struct book *book;   /* NULL for none */
+};
+
+struct tally {
+  long wins;
+  long losses;
+  long ties;
+  long decisions;
+  long visits;
+  long reused;
+  long endgame;
+  long book;
+  double seconds;
+  double overshoot;    /* the most a decision ran past its deadline */
+};
+
+static void makeMove(struct bot **bots, struct mctsMove *m,
+		     struct gameState *g) {
+  mctsApply(m, g);
+  botMoved(bots[0], m, g);
+  botMoved(bots[1], m, g);
+}
+
+static void playTurn(struct bot **bots, struct match *x, int seat,
+		     struct gameState *g, struct tally *t) {
+  int player = whoseTurn(g);
+  double start, deadline, late;
+  struct mctsMove m;
+  int steps;
+
+  for (steps = 0; steps < MAX_TURN_STEPS; steps++) {
+    start = botClock();
+    deadline = x->budget > 0 ? start + x->budget : BOT_NO_DEADLINE;
+    if (botDecide(bots[player], g, deadline, &m) < 0)
+      return;
+    if (player == seat) {
+      late = botClock() - deadline;
+      t->seconds += botClock() - start;
+      if (x->budget > 0 && late > t->overshoot)
+	t->overshoot = late;
+    }
+    makeMove(bots, &m, g);
+    if (m.type == MCTS_END_TURN)
+      return;
+  }
+  if (whoseTurn(g) == player) {
+    m.type = MCTS_END_TURN;
+    m.card = -1;
+    makeMove(bots, &m, g);
+  }
+}
+
+static int playGame(struct match *x, int seat, int kingdom[10], int seed,
+		    struct tally *t) {
+  struct gameState *g = malloc(sizeof(struct gameState));
+  struct bot *bots[2];
+  struct bot *search;
+  long nodes = SEARCH_NODES;
+  int turns = 0;
+  int us;
+  int them;
+
+  if (g == NULL)
+    return -1;
+  memset(g, 0, sizeof(struct gameState));
+  if (initializeGame(2, kingdom, seed, g) < 0) {
+    free(g);
+    return -1;
+  }
+  if (x->config.iterations + 1 > nodes)
+    nodes = x->config.iterations + 1;
+  x->config.seed = seed;
+  bots[seat] = searchBot(&x->config, nodes, seat, x->ponder);
+  if (bots[seat] != NULL && x->endgameTurns > 0) {
+    search = bots[seat];
+    bots[seat] = endgameBot(search, x->endgameTurns);
+    if (bots[seat] == NULL)
+      botFree(search);
+  }
+  if (bots[seat] != NULL && x->book != NULL) {
+    search = bots[seat];
+    bots[seat] = bookBot(search, x->book);
+    if (bots[seat] == NULL)
+      botFree(search);
+  }
+  bots[1 - seat] = strategyBot(&x->other, 1 - seat);
+  if (bots[0] == NULL || bots[1] == NULL) {
+    botFree(bots[0]);
+    botFree(bots[1]);
+    free(g);
+    return -1;
+  }
+  while (!isGameOver(g) && turns < MAX_SIM_TURNS) {
+    playTurn(bots, x, seat, g, t);
+    turns++;
+  }
+  t->decisions += bots[seat]->stats.decisions;
+  t->visits += bots[seat]->stats.iterations;
+  t->reused += bots[seat]->stats.reused;
+  t->endgame += bots[seat]->stats.endgame;
+  t->book += bots[seat]->stats.book;
+  botFree(bots[0]);
+  botFree(bots[1]);
+
+  us = scoreFor(seat, g);
+  them = scoreFor(1 - seat, g);
+  if (us > them)
+    t->wins++;
+  else if (us < them)
+    t->losses++;
+  else
+    t->ties++;
+  free(g);
+  return 0;
+}
+
+static void usage(void) {
+  printf("Usage: mctsplay [-g games] [-i iterations] [-j threads] "
+	 "[-s first seed]\n"
+	 "                [-b strategy] [-k random] [-t playout turns]\n"
+	 "                [-T ms per move] [-P] [-E endgame turns] "
+	 "[-B book]\n");
+}
+
+int main(int argc, char **argv) {
+  int k[10] = {adventurer, gardens, embargo, village, minion, mine, cutpurse,
+	       sea_hag, tribute, smithy};
+  struct match x;
+  struct tally t;
+  char name[MAX_STRING_LENGTH];
+  int randomKingdom = 0;
+  long games = 10;
+  long firstSeed = 1;
+  long g;
+  int opt;
+
+  memset(&x, 0, sizeof(x));
+  mctsDefaults(&x.config);
+  parseStrategy("smithy", &x.other);
+  while ((opt = getopt(argc, argv, "g:i:j:s:b:k:t:T:PE:B:")) != -1) {
+    switch (opt) {
+    case 'g': games = atol(optarg); break;
+    case 'i': x.config.iterations = atol(optarg); break;
+    case 'j': x.config.threads = atoi(optarg); break;
+    case 's': firstSeed = atol(optarg); break;
+    case 'b':
+      if (parseStrategy(optarg, &x.other) < 0) {
+	printf("Unknown strategy %s\n", optarg);
+	return 1;
+      }
+      break;
+    case 'k': randomKingdom = strcmp(optarg, "random") == 0; break;
+    case 't': x.config.rolloutTurns = atoi(optarg); break;
+    case 'T': x.budget = atof(optarg) / 1000; break;
+    case 'P': x.ponder = 1; break;
+    case 'E': x.endgameTurns = atoi(optarg); break;
+    case 'B':
+      x.book = readBook(optarg);
+      if (x.book == NULL) {
+	printf("Could not read a book from %s\n", optarg);
+	return 1;
+      }
+      break;
+    default: usage(); return 1;
+    }
+  }
+  if (games < 1 || x.config.iterations < 1 || x.config.threads < 0
+      || firstSeed < 1 || x.budget < 0 || x.endgameTurns < 0) {
+    usage();
+    return 1;
+  }
+
+  if (x.config.threads == 0)
+    x.config.threads = workqDefaultThreads();
+  memset(&t, 0, sizeof(t));
+  for (g = 0; g < games; g++) {
+    if (randomKingdom)
+      selectKingdomCards((int)(firstSeed + g), k);
+    if (playGame(&x, g % 2, k, (int)(firstSeed + g), &t) < 0) {
+      printf("Could not play seed %ld\n", firstSeed + g);
+      return 1;
+    }
+  }
+
+  formatStrategy(&x.other, name, sizeof(name));
+  if (x.budget > 0)
+    printf("Games: %ld (ISMCTS, %.0f ms per move%s, against %s)\n", games,
+	   x.budget * 1000, x.ponder ? ", pondering" : "", name);
+  else
+    printf("Games: %ld (ISMCTS, %ld iterations%s, against %s)\n", games,
+	   x.config.iterations, x.ponder ? ", pondering" : "", name);
+  printf("ISMCTS wins: %ld, losses: %ld, ties: %ld\n", t.wins, t.losses,
+	 t.ties);
+  printf("Decisions: %ld, %.0f ms each, %.0f visits at the root "
+	 "(%.0f of them kept from earlier moves)", t.decisions,
+	 t.decisions > 0 ? t.seconds * 1000 / t.decisions : 0.0,
+	 t.decisions > 0 ? (double)t.visits / t.decisions : 0.0,
+	 t.decisions > 0 ? (double)t.reused / t.decisions : 0.0);
+  if (x.config.threads != 1)
+    printf(" on %d threads", x.config.threads);
+  printf("\n");
+  if (x.endgameTurns > 0)
+    printf("Endgame: %ld decisions by the solver\n", t.endgame);
+  if (x.book != NULL)
+    printf("Book: %ld decisions from the book\n", t.book);
+  if (x.budget > 0)
+    printf("Latest decision: %.2f ms past its deadline\n",
+	   t.overshoot * 1000);
+  freeBook(x.book);
+  return 0;
+}
@@ -0,0 +1,233 @@
+/* Opening book generator
+
+   For each kingdom, plays every pair of opening buys for the 5/2 and
+   4/3 splits against a strategy, with that strategy as the
+   continuation, on every core, and adds the best pair for each split to
+   a book (see book.h).  Every pair plays the same seeds, alternating
+   seats, so the pairs are compared on the same shuffles.  Tribute,
+   salvager and sea hag are never opened with: the engine's versions of
+   them corrupt the state.  An existing book is added to, as long as it
+   is for the same strategy.
+
+   The kingdom is the ten cards given, or with -k random, -n kingdoms
+   picked by selectKingdomCards from consecutive seeds.
+
+   Usage: mkbook [-j threads] [-g games per pair] [-s first seed]
+                 [-b strategy] [-k random [-n kingdoms]] -o book [card...]
+*/
+
+#include "dominion.h"
+#include "dominion_helpers.h"
+#include "interface.h"
+#include "simulate.h"
+#include "kingdom.h"
+#include "book.h"
+#include "workq.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_CANDIDATES (NUM_K_CARDS + 2)
+#define MAX_PAIRS (BOOK_SPLITS * MAX_CANDIDATES * MAX_CANDIDATES)
+
+struct opening {
+  int split;
+  int buys[2];
+};
+
+struct job {
+  int kingdom[NUM_K_CARDS];
+  struct strategy strategy;
+  struct opening pairs[MAX_PAIRS];
+  int numPairs;
+  int games;
+  long firstSeed;
+  double *scores;      /* one per pair and game */
+  int failed;
+};
+
+//what an opening hand of coins can buy: nothing, silver, or a kingdom
+//card the engine plays safely
+static int candidates(int kingdom[NUM_K_CARDS], int coins, int *cards) {
+  int n = 0;
+  int i;
+
+  cards[n++] = -1;
+  if (getCost(silver) <= coins)
+    cards[n++] = silver;
+  for (i = 0; i < NUM_K_CARDS; i++) {
+    if (getCost(kingdom[i]) <= coins && kingdom[i] != tribute
+	&& kingdom[i] != salvager && kingdom[i] != sea_hag)
+      cards[n++] = kingdom[i];
+  }
+  return n;
+}
+
+static void addPairs(struct job *j, int split) {
+  int big[MAX_CANDIDATES], small[MAX_CANDIDATES];
+  int bigCoins = split == SPLIT_5_2 ? 5 : 4;
+  int nBig = candidates(j->kingdom, bigCoins, big);
+  int nSmall = candidates(j->kingdom, 7 - bigCoins, small);
+  struct opening *o;
+  int a, b;
+
+  for (a = 0; a < nBig; a++) {
+    for (b = 0; b < nSmall; b++) {
+      o = &j->pairs[j->numPairs++];
+      o->split = split;
+      o->buys[0] = big[a];
+      o->buys[1] = small[b];
+    }
+  }
+}
+
+static void playRange(void *arg, int worker, long begin, long end) {
+  struct job *j = arg;
+  struct opening *o;
+  long game;
+  long i;
+
+  for (i = begin; i < end; i++) {
+    o = &j->pairs[i / j->games];
+    game = i % j->games;
+    if (playOpening(j->kingdom, (int)(j->firstSeed + game), &j->strategy,
+		    game % 2, o->split, o->buys, &j->scores[i]) < 0)
+      j->failed = 1;
+  }
+}
+
+static const char *buyName(int card) {
+  return card < 0 ? "nothing" : cardName(card);
+}
+
+static int bookKingdom(struct job *j, int threads, struct book *book) {
+  struct bookEntry e;
+  double best[BOOK_SPLITS];
+  double sum;
+  int split;
+  int p, g;
+
+  j->numPairs = 0;
+  addPairs(j, SPLIT_5_2);
+  addPairs(j, SPLIT_4_3);
+  j->failed = 0;
+  if (workqRun(0, (long)j->numPairs * j->games, 4, threads, playRange,
+	       j) < 0 || j->failed)
+    return -1;
+
+  memset(&e, 0, sizeof(e));
+  for (split = 0; split < BOOK_SPLITS; split++)
+    best[split] = -1;
+  for (p = 0; p < j->numPairs; p++) {
+    for (sum = 0, g = 0; g < j->games; g++)
+      sum += j->scores[(long)p * j->games + g];
+    split = j->pairs[p].split;
+    if (sum / j->games > best[split]) {
+      best[split] = sum / j->games;
+      e.buys[split][0] = j->pairs[p].buys[0];
+      e.buys[split][1] = j->pairs[p].buys[1];
+    }
+  }
+  e.kingdom = kingdomMask(j->kingdom);
+  if (bookAdd(book, &e) < 0)
+    return -1;
+
+  for (p = 0; p < NUM_K_CARDS; p++)
+    printf("%s%s", p > 0 ? " " : "", cardName(j->kingdom[p]));
+  printf(": 5/2 %s/%s %.1f%%, 4/3 %s/%s %.1f%% (%d pairs)\n",
+	 buyName(e.buys[SPLIT_5_2][0]), buyName(e.buys[SPLIT_5_2][1]),
+	 100 * best[SPLIT_5_2], buyName(e.buys[SPLIT_4_3][0]),
+	 buyName(e.buys[SPLIT_4_3][1]), 100 * best[SPLIT_4_3], j->numPairs);
+  return 0;
+}
+
+static void usage(void) {
+  printf("Usage: mkbook [-j threads] [-g games per pair] [-s first seed]\n"
+	 "              [-b strategy] [-k random [-n kingdoms]] -o book "
+	 "[card...]\n");
+}
+
+int main(int argc, char **argv) {
+  static struct job j;
+  int k[NUM_K_CARDS] = {adventurer, gardens, embargo, village, minion, mine,
+			cutpurse, sea_hag, tribute, smithy};
+  struct book *book;
+  char name[MAX_STRING_LENGTH];
+  char *bookPath = NULL;
+  int randomKingdom = 0;
+  long kingdoms = 1;
+  int threads = 0;
+  long n;
+  int opt;
+  int i;
+
+  j.games = 200;
+  j.firstSeed = 1;
+  parseStrategy("smithy", &j.strategy);
+  while ((opt = getopt(argc, argv, "j:g:s:b:k:n:o:")) != -1) {
+    switch (opt) {
+    case 'j': threads = atoi(optarg); break;
+    case 'g': j.games = atoi(optarg); break;
+    case 's': j.firstSeed = atol(optarg); break;
+    case 'b':
+      if (parseStrategy(optarg, &j.strategy) < 0) {
+	printf("Unknown strategy %s\n", optarg);
+	return 1;
+      }
+      break;
+    case 'k': randomKingdom = strcmp(optarg, "random") == 0; break;
+    case 'n': kingdoms = atol(optarg); break;
+    case 'o': bookPath = optarg; break;
+    default: usage(); return 1;
+    }
+  }
+  if (bookPath == NULL || j.games < 1 || j.firstSeed < 1 || kingdoms < 1
+      || threads < 0 || (optind < argc && argc - optind != NUM_K_CARDS)) {
+    usage();
+    return 1;
+  }
+  for (i = 0; optind < argc && i < NUM_K_CARDS; i++) {
+    k[i] = cardNameToNum(argv[optind + i]);
+    if (k[i] < adventurer || k[i] > treasure_map) {
+      printf("Not a kingdom card: %s\n", argv[optind + i]);
+      return 1;
+    }
+  }
+  if (!randomKingdom)
+    kingdoms = 1;
+
+  formatStrategy(&j.strategy, name, sizeof(name));
+  book = readBook(bookPath);
+  if (book != NULL && (book->strategy.action != j.strategy.action
+		       || book->strategy.copies != j.strategy.copies)) {
+    printf("%s is not a book for %s\n", bookPath, name);
+    return 1;
+  }
+  if (book == NULL)
+    book = createBook(&j.strategy);
+  j.scores = malloc((long)MAX_PAIRS * j.games * sizeof(double));
+  if (book == NULL || j.scores == NULL)
+    return 1;
+
+  for (n = 0; n < kingdoms; n++) {
+    if (randomKingdom)
+      selectKingdomCards((int)(j.firstSeed + n), k);
+    memcpy(j.kingdom, k, sizeof(k));
+    if (bookKingdom(&j, threads, book) < 0) {
+      printf("Could not play the openings\n");
+      return 1;
+    }
+  }
+
+  if (writeBook(bookPath, book) < 0) {
+    perror(bookPath);
+    return 1;
+  }
+  printf("Book for %s: %ld kingdoms, %ld bytes, %d games per opening\n",
+	 name, book->entries, BOOK_HEADER_SIZE + book->slots * BOOK_SLOT_SIZE,
+	 j.games);
+  freeBook(book);
+  free(j.scores);
+  return 0;
+}
@@ -0,0 +1,651 @@
+/* Mutant schema generator
+
+   Rewrites a C file (dominion.c) into one schema file in which every
+   mutation is compiled in and guarded by a mutant id chosen at run time
+   (see mutschema.h), so one build serves every mutant.  Inside function
+   bodies it mutates:
+     decimal integer constants       c -> c+1, c-1
+     relational operators            <  -> <=, >=   (and so on)
+     equality operators              == <-> !=
+     additive operators              +  <-> -
+     if and while conditions         negated, false
+   Constants in case labels, array sizes of declarations and static
+   initializers are left alone since they must stay constant.  Operands
+   are found from operator precedence over the tokens, so the rewrite
+   keeps the meaning of the unmutated program and its line numbers.
+
+   The mutant list has one line per mutant: id, site, function:line and
+   the change; mutrun reads it.
+
+   Usage: mutate input.c schema.c mutants.lst
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define MAX_MUTANTS 65536
+#define MAX_NAME 64
+
+enum TOKEN {
+  TOK_IDENT = 0,
+  TOK_NUMBER,
+  TOK_LITERAL,    /* string or character constant */
+  TOK_PUNCT
+};
+
+enum SITE {
+  SITE_CONST = 0,
+  SITE_BINARY,
+  SITE_COND
+};
+
+struct token {
+  int type;
+  int line;
+  int wsStart;    /* whitespace, comments and directives before it */
+  int start;
+  int end;
+  int match;      /* index of the matching bracket, -1 otherwise */
+  int mutable;    /* inside a function body, outside constant contexts */
+  char func[MAX_NAME];
+};
+
+struct site {
+  int kind;
+  int id;         /* first mutant id */
+  int count;
+  int start;      /* first token */
+  int end;        /* one past the last token */
+  int op;         /* operator token of SITE_BINARY */
+  int rank;       /* orders sites with the same span, outermost first */
+};
+
+struct source {
+  char *text;
+  int size;
+  struct token *tokens;
+  int numTokens;
+  struct site *sites;
+  int numSites;
+  int numMutants;
+};
+
+static const char *puncts[] = {
+  ">>=", "<<=", "...", "->", "++", "--", "<<", ">>", "<=", ">=", "==", "!=",
+  "&&", "||", "+=", "-=", "*=", "/=", "%=", "&=", "^=", "|=", NULL
+};
+
+static const char *typeWords[] = {
+  "int", "char", "long", "short", "unsigned", "signed", "double", "float",
+  "struct", "enum", "union", "void", "const", "static", NULL
+};
+
+static int isWord(const char *s, int len, const char **words) {
+  int i;
+
+  for (i = 0; words[i] != NULL; i++) {
+    if ((int)strlen(words[i]) == len && strncmp(s, words[i], len) == 0)
+      return 1;
+  }
+  return 0;
+}
+
+static int is(struct source *src, int t, const char *text) {
+  struct token *k;
+
+  if (t < 0 || t >= src->numTokens)
+    return 0;
+  k = &src->tokens[t];
+  return k->end - k->start == (int)strlen(text)
+    && strncmp(src->text + k->start, text, k->end - k->start) == 0;
+}
+
+static int skipSpace(struct source *src, int pos, int *line) {
+  char *s = src->text;
+  int atLineStart = pos == 0 || s[pos - 1] == '\n';
+
+  while (pos < src->size) {
+    if (s[pos] == '\n') {
+      (*line)++;
+      atLineStart = 1;
+      pos++;
+    } else if (isspace((unsigned char)s[pos])) {
+      pos++;
+    } else if (s[pos] == '/' && s[pos + 1] == '/') {
+      while (pos < src->size && s[pos] != '\n')
+	pos++;
+    } else if (s[pos] == '/' && s[pos + 1] == '*') {
+      for (pos += 2; pos < src->size
+	     && !(s[pos] == '*' && s[pos + 1] == '/'); pos++) {
+	if (s[pos] == '\n')
+	  (*line)++;
+      }
+      pos += 2;
+    } else if (s[pos] == '#' && atLineStart) {
+      //a directive runs to the end of the line, with continuations
+      while (pos < src->size && s[pos] != '\n') {
+	if (s[pos] == '\\' && s[pos + 1] == '\n') {
+	  (*line)++;
+	  pos++;
+	}
+	pos++;
+      }
+    } else {
+      break;
+    }
+  }
+  return pos < src->size ? pos : src->size;
+}
+
+static int tokenize(struct source *src) {
+  char *s = src->text;
+  int cap = 1024;
+  int line = 1;
+  int pos = 0;
+  int wsStart;
+  int i;
+  struct token *t;
+
+  src->tokens = malloc(cap * sizeof(struct token));
+  while (src->tokens != NULL) {
+    wsStart = pos;
+    pos = skipSpace(src, pos, &line);
+    if (src->numTokens == cap) {
+      cap *= 2;
+      src->tokens = realloc(src->tokens, cap * sizeof(struct token));
+      if (src->tokens == NULL)
+	break;
+    }
+    t = &src->tokens[src->numTokens];
+    memset(t, 0, sizeof(struct token));
+    t->wsStart = wsStart;
+    t->start = pos;
+    t->line = line;
+    t->match = -1;
+    if (pos == src->size) {
+      //end marker carries the trailing whitespace
+      t->type = TOK_PUNCT;
+      t->end = pos;
+      return 0;
+    }
+    if (isalpha((unsigned char)s[pos]) || s[pos] == '_') {
+      t->type = TOK_IDENT;
+      while (pos < src->size && (isalnum((unsigned char)s[pos]) || s[pos] == '_'))
+	pos++;
+    } else if (isdigit((unsigned char)s[pos])) {
+      t->type = TOK_NUMBER;
+      while (pos < src->size && (isalnum((unsigned char)s[pos]) || s[pos] == '.'
+				 || s[pos] == '_'))
+	pos++;
+    } else if (s[pos] == '"' || s[pos] == '\'') {
+      t->type = TOK_LITERAL;
+      for (pos++; pos < src->size && s[pos] != s[t->start]; pos++) {
+	if (s[pos] == '\\')
+	  pos++;
+      }
+      pos++;
+    } else {
+      t->type = TOK_PUNCT;
+      for (i = 0; puncts[i] != NULL; i++) {
+	if (strncmp(s + pos, puncts[i], strlen(puncts[i])) == 0)
+	  break;
+      }
+      pos += puncts[i] != NULL ? (int)strlen(puncts[i]) : 1;
+    }
+    t->end = pos;
+    src->numTokens++;
+  }
+  return -1;
+}
+
+//pairs brackets and marks where mutation is allowed
+static int scanStructure(struct source *src) {
+  int stack[1024];
+  int depth = 0;
+  int braces = 0;        /* open braces, 0 at file scope */
+  int inBody = 0;
+  int stmtStart = 1;
+  int declStmt = 0;
+  int staticStmt = 0;
+  int inCase = 0;
+  int declBrackets = 0;  /* open [ of a declaration */
+  char func[MAX_NAME] = "";
+  struct token *t;
+  int i;
+  int open;
+
+  for (i = 0; i < src->numTokens; i++) {
+    t = &src->tokens[i];
+    if (stmtStart && t->type == TOK_IDENT) {
+      declStmt = isWord(src->text + t->start, t->end - t->start, typeWords);
+      staticStmt = is(src, i, "static");
+    }
+    stmtStart = 0;
+
+    if (is(src, i, "(") || is(src, i, "[") || is(src, i, "{")) {
+      if (depth == 1024)
+	return -1;
+      if (is(src, i, "{")) {
+	if (braces == 0 && is(src, i - 1, ")"))
+	  inBody = 1;
+	braces++;
+	stmtStart = 1;
+      }
+      if (is(src, i, "[") && declStmt)
+	declBrackets++;
+      //a function name is the identifier before a ( at file scope
+      if (is(src, i, "(") && braces == 0 && depth == 0
+	  && i > 0 && src->tokens[i - 1].type == TOK_IDENT) {
+	snprintf(func, sizeof(func), "%.*s",
+		 src->tokens[i - 1].end - src->tokens[i - 1].start,
+		 src->text + src->tokens[i - 1].start);
+      }
+      stack[depth++] = i;
+    } else if (is(src, i, ")") || is(src, i, "]") || is(src, i, "}")) {
+      if (depth == 0)
+	return -1;
+      open = stack[--depth];
+      t->match = open;
+      src->tokens[open].match = i;
+      if (is(src, i, "}")) {
+	if (--braces == 0)
+	  inBody = 0;
+	stmtStart = 1;
+	declStmt = 0;
+      }
+      if (is(src, i, "]") && declBrackets > 0)
+	declBrackets--;
+    } else if (is(src, i, ";")) {
+      stmtStart = 1;
+      declStmt = 0;
+      staticStmt = 0;
+    } else if (is(src, i, "case")) {
+      inCase = 1;
+    } else if (is(src, i, ":")) {
+      inCase = 0;
+    }
+
+    t->mutable = inBody && !inCase && !staticStmt && declBrackets == 0;
+    snprintf(t->func, sizeof(t->func), "%s", func);
+  }
+  return depth == 0 ? 0 : -1;
+}
+
+static int isKeyword(struct source *src, int t) {
+  return is(src, t, "return") || is(src, t, "case") || is(src, t, "else")
+    || is(src, t, "sizeof") || is(src, t, "do");
+}
+
+//true if the token before t ends an operand, making t a binary operator
+static int afterOperand(struct source *src, int t) {
+  struct token *p;
+
+  if (t == 0)
+    return 0;
+  p = &src->tokens[t - 1];
+  if (p->type == TOK_IDENT)
+    return !isKeyword(src, t - 1);
+  if (p->type == TOK_NUMBER || p->type == TOK_LITERAL)
+    return 1;
+  if (is(src, t - 1, ")") || is(src, t - 1, "]"))
+    return 1;
+  if (is(src, t - 1, "++") || is(src, t - 1, "--"))
+    return afterOperand(src, t - 1);
+  return 0;
+}
+
+//precedence of t as a binary operator, 0 if it is not one
+static int binaryLevel(struct source *src, int t) {
+  static const struct {
+    const char *op;
+    int level;
+  } levels[] = {
+    {"*", 13}, {"/", 13}, {"%", 13}, {"+", 12}, {"-", 12}, {"<<", 11},
+    {">>", 11}, {"<", 10}, {"<=", 10}, {">", 10}, {">=", 10}, {"==", 9},
+    {"!=", 9}, {"&", 8}, {"^", 7}, {"|", 6}, {"&&", 5}, {"||", 4},
+    {NULL, 0}
+  };
+  int i;
+
+  if (src->tokens[t].type != TOK_PUNCT || !afterOperand(src, t))
+    return 0;
+  for (i = 0; levels[i].op != NULL; i++) {
+    if (is(src, t, levels[i].op))
+      return levels[i].level;
+  }
+  return 0;
+}
+
+//tokens that end an operand whatever the precedence
+static int stops(struct source *src, int t) {
+  static const char *enders[] = {
+    ";", ",", "{", "}", "?", ":", "=", "+=", "-=", "*=", "/=", "%=", "&=",
+    "^=", "|=", "<<=", ">>=", NULL
+  };
+  int i;
+
+  if (t < 0 || t >= src->numTokens - 1 || isKeyword(src, t))
+    return 1;
+  for (i = 0; enders[i] != NULL; i++) {
+    if (is(src, t, enders[i]))
+      return 1;
+  }
+  return 0;
+}
+
+//left-associative: the left operand takes in operators of the same level
+static int leftOperand(struct source *src, int op, int level) {
+  int t = op - 1;
+  int l;
+
+  while (!stops(src, t)) {
+    if (is(src, t, ")") || is(src, t, "]")) {
+      t = src->tokens[t].match - 1;
+      continue;
+    }
+    if (is(src, t, "(") || is(src, t, "["))
+      break;
+    l = binaryLevel(src, t);
+    if (l > 0 && l < level)
+      break;
+    t--;
+  }
+  return t + 1;
+}
+
+static int rightOperand(struct source *src, int op, int level) {
+  int t = op + 1;
+  int l;
+
+  while (!stops(src, t)) {
+    if (is(src, t, "(") || is(src, t, "[")) {
+      t = src->tokens[t].match + 1;
+      continue;
+    }
+    if (is(src, t, ")") || is(src, t, "]"))
+      break;
+    l = binaryLevel(src, t);
+    if (l > 0 && l <= level)
+      break;
+    t++;
+  }
+  return t;
+}
+
+static const char *binaryMutants(struct source *src, int t, int *count) {
+  static const struct {
+    const char *op;
+    const char *alternatives;
+    int count;
+  } table[] = {
+    {"<", "<=, >=", 2}, {"<=", "<, >", 2}, {">", ">=, <=", 2},
+    {">=", ">, <", 2}, {"==", "!=", 1}, {"!=", "==", 1}, {"+", "-", 1},
+    {"-", "+", 1}, {NULL, NULL, 0}
+  };
+  int i;
+
+  for (i = 0; table[i].op != NULL; i++) {
+    if (is(src, t, table[i].op)) {
+      *count = table[i].count;
+      return table[i].alternatives;
+    }
+  }
+  return NULL;
+}
+
+static int allDigits(struct source *src, int t) {
+  struct token *k = &src->tokens[t];
+  int i;
+
+  for (i = k->start; i < k->end; i++) {
+    if (!isdigit((unsigned char)src->text[i]))
+      return 0;
+  }
+  return 1;
+}
+
+static int addSite(struct source *src, int kind, int count, int start,
+		   int end, int op, int rank) {
+  struct site *s;
+
+  if (src->numMutants + count > MAX_MUTANTS)
+    return -1;
+  s = &src->sites[src->numSites++];
+  s->kind = kind;
+  s->id = src->numMutants + 1;   /* 0 is the unmutated program */
+  s->count = count;
+  s->start = start;
+  s->end = end;
+  s->op = op;
+  s->rank = rank;
+  src->numMutants += count;
+  return 0;
+}
+
+static int findSites(struct source *src) {
+  int t;
+  int level;
+  int count;
+  int rc = 0;
+
+  src->sites = malloc(src->numTokens * sizeof(struct site));
+  if (src->sites == NULL)
+    return -1;
+  for (t = 0; t < src->numTokens && rc == 0; t++) {
+    if (!src->tokens[t].mutable)
+      continue;
+    if (src->tokens[t].type == TOK_NUMBER && allDigits(src, t)) {
+      rc = addSite(src, SITE_CONST, 2, t, t + 1, -1, 0);
+    } else if ((is(src, t, "if") || is(src, t, "while"))
+	       && is(src, t + 1, "(")
+	       && src->tokens[t + 1].match > t + 2) {
+      rc = addSite(src, SITE_COND, 2, t + 2, src->tokens[t + 1].match, -1, 2);
+    } else if ((level = binaryLevel(src, t)) > 0
+	       && binaryMutants(src, t, &count) != NULL) {
+      rc = addSite(src, SITE_BINARY, count, leftOperand(src, t, level),
+		   rightOperand(src, t, level), t, 1);
+    }
+  }
+  return rc;
+}
+
+static void emitRange(struct source *src, FILE *out, int start, int end,
+		      int withSpace);
+
+//the outermost site beginning at token t and ending by end
+static struct site *outermost(struct source *src, int t, int end) {
+  struct site *best = NULL;
+  struct site *s;
+  int i;
+
+  for (i = 0; i < src->numSites; i++) {
+    s = &src->sites[i];
+    if (s->start != t || s->end > end || s->end <= s->start)
+      continue;
+    if (best == NULL || s->end > best->end
+	|| (s->end == best->end && s->rank > best->rank))
+      best = s;
+  }
+  return best;
+}
+
+static void emitToken(struct source *src, FILE *out, int t, int withSpace) {
+  struct token *k = &src->tokens[t];
+
+  if (withSpace)
+    fwrite(src->text + k->wsStart, 1, k->start - k->wsStart, out);
+  fwrite(src->text + k->start, 1, k->end - k->start, out);
+}
+
+static void emitSite(struct source *src, FILE *out, struct site *s,
+		     int withSpace) {
+  struct token *k = &src->tokens[s->start];
+  int count;
+  const char *alternatives;
+
+  if (withSpace)
+    fwrite(src->text + k->wsStart, 1, k->start - k->wsStart, out);
+  //the site is taken out of the search so that its operands can be
+  //searched for the sites they hold
+  s->end = -s->end;
+  switch (s->kind) {
+  case SITE_CONST:
+    fprintf(out, "MUT_CONST(%d, ", s->id);
+    emitToken(src, out, s->start, 0);
+    fprintf(out, ")");
+    break;
+  case SITE_COND:
+    fprintf(out, "MUT_COND(%d, ", s->id);
+    emitRange(src, out, s->start, -s->end, 0);
+    fprintf(out, ")");
+    break;
+  default:
+    alternatives = binaryMutants(src, s->op, &count);
+    fprintf(out, "MUT_OP%d(%d, ", count, s->id);
+    emitRange(src, out, s->start, s->op, 0);
+    fprintf(out, ", ");
+    emitToken(src, out, s->op, 1);
+    fprintf(out, ", ");
+    emitRange(src, out, s->op + 1, -s->end, 1);
+    fprintf(out, ", %s)", alternatives);
+    break;
+  }
+  s->end = -s->end;
+}
+
+static void emitRange(struct source *src, FILE *out, int start, int end,
+		      int withSpace) {
+  struct site *s;
+  int t = start;
+
+  while (t < end) {
+    s = outermost(src, t, end);
+    if (s != NULL) {
+      emitSite(src, out, s, withSpace || t > start);
+      t = s->end;
+    } else {
+      emitToken(src, out, t, withSpace || t > start);
+      t++;
+    }
+  }
+}
+
+static void describe(struct source *src, struct site *s, int i, char *text,
+		     int size) {
+  static const char *relational[][2] = {
+    {"<", "<=|>="}, {"<=", "<|>"}, {">", ">=|<="}, {">=", ">|<"},
+    {"==", "!="}, {"!=", "=="}, {"+", "-"}, {"-", "+"}
+  };
+  struct token *op;
+  char name[8];
+  char alternatives[8];
+  char *bar;
+  int n;
+
+  switch (s->kind) {
+  case SITE_CONST:
+    n = atoi(src->text + src->tokens[s->start].start);
+    snprintf(text, size, "%d -> %d", n, i == 0 ? n + 1 : n - 1);
+    break;
+  case SITE_COND:
+    snprintf(text, size, "%.*s condition %s",
+	     src->tokens[s->start - 2].end - src->tokens[s->start - 2].start,
+	     src->text + src->tokens[s->start - 2].start,
+	     i == 0 ? "negated" : "false");
+    break;
+  default:
+    op = &src->tokens[s->op];
+    snprintf(name, sizeof(name), "%.*s", op->end - op->start,
+	     src->text + op->start);
+    for (n = 0; strcmp(relational[n][0], name) != 0; n++)
+      ;
+    snprintf(alternatives, sizeof(alternatives), "%s", relational[n][1]);
+    bar = strchr(alternatives, '|');
+    if (bar != NULL)
+      *bar = '\0';
+    snprintf(text, size, "%s -> %s", name,
+	     i == 0 ? alternatives : bar + 1);
+    break;
+  }
+}
+
+static int writeList(struct source *src, const char *path) {
+  FILE *f = fopen(path, "w");
+  struct site *s;
+  struct token *k;
+  char text[64];
+  int i;
+  int j;
+
+  if (f == NULL)
+    return -1;
+  for (i = 0; i < src->numSites; i++) {
+    s = &src->sites[i];
+    k = &src->tokens[s->kind == SITE_BINARY ? s->op : s->start];
+    for (j = 0; j < s->count; j++) {
+      describe(src, s, j, text, sizeof(text));
+      fprintf(f, "%d %d %s:%d %s\n", s->id + j, s->id, k->func, k->line,
+	      text);
+    }
+  }
+  return fclose(f);
+}
+
+static int readSource(const char *path, struct source *src) {
+  FILE *f = fopen(path, "r");
+  long size;
+
+  if (f == NULL)
+    return -1;
+  fseek(f, 0, SEEK_END);
+  size = ftell(f);
+  rewind(f);
+  src->text = calloc(size + 2, 1);   /* lookahead of two reads zeros */
+  if (src->text == NULL || fread(src->text, 1, size, f) != (size_t)size) {
+    fclose(f);
+    return -1;
+  }
+  src->size = size;
+  fclose(f);
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  struct source src;
+  FILE *out;
+
+  if (argc != 4) {
+    printf("Usage: mutate input.c schema.c mutants.lst\n");
+    return 1;
+  }
+  memset(&src, 0, sizeof(src));
+  if (readSource(argv[1], &src) < 0) {
+    printf("Could not read %s\n", argv[1]);
+    return 1;
+  }
+  if (tokenize(&src) < 0 || scanStructure(&src) < 0) {
+    printf("Could not parse %s\n", argv[1]);
+    return 1;
+  }
+  if (findSites(&src) < 0) {
+    printf("More than %d mutants\n", MAX_MUTANTS);
+    return 1;
+  }
+
+  out = fopen(argv[2], "w");
+  if (out == NULL) {
+    printf("Could not write %s\n", argv[2]);
+    return 1;
+  }
+  fprintf(out, "/* Generated by mutate from %s, do not edit */\n"
+	  "#include \"mutschema.h\"\n#line 1 \"%s\"\n", argv[1], argv[1]);
+  emitRange(&src, out, 0, src.numTokens, 1);
+  if (fclose(out) != 0 || writeList(&src, argv[3]) < 0) {
+    printf("Could not write the schema\n");
+    return 1;
+  }
+  printf("%d mutants at %d sites\n", src.numMutants, src.numSites);
+  return 0;
+}
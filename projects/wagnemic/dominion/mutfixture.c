@@ -0,0 +1,21 @@
+/* Fixture for testMutate: each kind of mutation site, and constants
+   that mutate must leave alone */
+
+static int limits[3] = {1, 2, 3};
+
+int clampTo(int n, int max) {
+  if (n < 0)
+    return 0;
+  if (n >= max)
+    return max - 1;
+  return n;
+}
+
+int pickLimit(int which) {
+  switch (which) {
+  case 1:
+    return limits[which];
+  default:
+    return which + 1;
+  }
+}
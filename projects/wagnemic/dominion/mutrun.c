@@ -0,0 +1,309 @@
+/* Mutation analysis runner
+
+   Runs test programs linked against a mutant schema (see mutate.c and
+   mutschema.h) once per mutant, in forked children, several at a time.
+   Each test is first run unmutated with coverage on; it must pass, and
+   it is then only run against the mutants whose site it reached.  A
+   mutant is killed by a test that exits non-zero, dies on a signal or
+   runs longer than the timeout (10 times its unmutated time plus a
+   second unless -t is given).  Prints the kill matrix, K for killed,
+   . for survived and - for not covered, then the mutation score.
+
+   Usage: mutrun [-j jobs] [-t seconds] [-s] mutants.lst test [test ...]
+          -s prints only the surviving mutants
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define MAX_TESTS 32
+#define MAX_CHANGE 64
+
+enum OUTCOME {
+  NOT_COVERED = 0,
+  PENDING,
+  SURVIVED,
+  KILLED
+};
+
+struct mutant {
+  int id;
+  int site;
+  char where[MAX_CHANGE];
+  char change[MAX_CHANGE];
+};
+
+struct run {
+  pid_t pid;
+  int mutant;       /* index into the mutant list */
+  int test;
+  double started;
+};
+
+static double now(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int readMutants(const char *path, struct mutant **list, int *count) {
+  FILE *f = fopen(path, "r");
+  char line[256];
+  struct mutant *m;
+  int cap = 0;
+  int n;
+
+  if (f == NULL)
+    return -1;
+  *list = NULL;
+  *count = 0;
+  while (fgets(line, sizeof(line), f) != NULL) {
+    if (*count == cap) {
+      cap = cap ? cap * 2 : 1024;
+      *list = realloc(*list, cap * sizeof(struct mutant));
+      if (*list == NULL)
+	return -1;
+    }
+    m = &(*list)[*count];
+    if (sscanf(line, "%d %d %63s %n", &m->id, &m->site, m->where, &n) < 3)
+      continue;
+    snprintf(m->change, sizeof(m->change), "%s", line + n);
+    m->change[strcspn(m->change, "\n")] = '\0';
+    (*count)++;
+  }
+  fclose(f);
+  return 0;
+}
+
+//the signal mask children start with; the runner blocks SIGCHLD to wait
+//for it with a deadline
+static sigset_t unblocked;
+
+static pid_t spawn(const char *test, int mutant, const char *coverage) {
+  char id[16];
+  pid_t pid = fork();
+  int null;
+
+  if (pid != 0)
+    return pid;
+  sigprocmask(SIG_SETMASK, &unblocked, NULL);
+  snprintf(id, sizeof(id), "%d", mutant);
+  setenv("DOMINION_MUTANT", id, 1);
+  if (coverage != NULL)
+    setenv("DOMINION_MUTANT_COVERAGE", coverage, 1);
+  null = open("/dev/null", O_WRONLY);
+  dup2(null, 1);
+  dup2(null, 2);
+  execl(test, test, (char *)NULL);
+  _exit(127);
+}
+
+//runs a test unmutated; fills covered[site] and its time, -1 if it fails
+static int baseline(const char *test, unsigned char *covered, int maxSite,
+		    double *seconds) {
+  char path[] = "/tmp/mutrunXXXXXX";
+  double start = now();
+  int status;
+  int site;
+  int fd = mkstemp(path);
+  FILE *f;
+
+  if (fd < 0)
+    return -1;
+  close(fd);
+  if (waitpid(spawn(test, 0, path), &status, 0) < 0
+      || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    unlink(path);
+    return -1;
+  }
+  *seconds = now() - start;
+  f = fopen(path, "r");
+  while (f != NULL && fscanf(f, "%d", &site) == 1) {
+    if (site > 0 && site <= maxSite)
+      covered[site] = 1;
+  }
+  if (f != NULL)
+    fclose(f);
+  unlink(path);
+  return 0;
+}
+
+static void usage(void) {
+  printf("Usage: mutrun [-j jobs] [-t seconds] [-s] mutants.lst test "
+	 "[test ...]\n");
+}
+
+int main(int argc, char **argv) {
+  struct mutant *mutants;
+  int numMutants;
+  const char *tests[MAX_TESTS];
+  int numTests;
+  unsigned char *covered[MAX_TESTS];
+  double timeouts[MAX_TESTS];
+  unsigned char *outcome;     /* [mutant * numTests + test] */
+  struct run *running;
+  int jobs = sysconf(_SC_NPROCESSORS_ONLN);
+  double timeout = 0;
+  int survivorsOnly = 0;
+  int maxSite = 0;
+  int numRunning = 0;
+  long next = 0;
+  long pairs;
+  long runs = 0;
+  int coveredMutants = 0;
+  int killed = 0;
+  int status;
+  int opt;
+  int m;
+  int t;
+  int r;
+  int any;
+  pid_t pid;
+  double start;
+  double wait;
+  double left;
+  sigset_t childExit;
+  struct timespec ts;
+
+  while ((opt = getopt(argc, argv, "j:t:s")) != -1) {
+    switch (opt) {
+    case 'j': jobs = atoi(optarg); break;
+    case 't': timeout = atof(optarg); break;
+    case 's': survivorsOnly = 1; break;
+    default: usage(); return 2;
+    }
+  }
+  numTests = argc - optind - 1;
+  if (numTests < 1 || numTests > MAX_TESTS || jobs < 1) {
+    usage();
+    return 2;
+  }
+  if (readMutants(argv[optind], &mutants, &numMutants) < 0
+      || numMutants == 0) {
+    printf("Could not read %s\n", argv[optind]);
+    return 2;
+  }
+  for (m = 0; m < numMutants; m++) {
+    if (mutants[m].site > maxSite)
+      maxSite = mutants[m].site;
+  }
+
+  //SIGCHLD stays pending until sigtimedwait takes it, so no exit is missed
+  sigemptyset(&childExit);
+  sigaddset(&childExit, SIGCHLD);
+  sigprocmask(SIG_BLOCK, &childExit, &unblocked);
+
+  start = now();
+  for (t = 0; t < numTests; t++) {
+    tests[t] = argv[optind + 1 + t];
+    covered[t] = calloc(maxSite + 1, 1);
+    if (covered[t] == NULL
+	|| baseline(tests[t], covered[t], maxSite, &timeouts[t]) < 0) {
+      printf("%s fails without mutants\n", tests[t]);
+      return 2;
+    }
+    timeouts[t] = timeout > 0 ? timeout : 10 * timeouts[t] + 1;
+  }
+
+  pairs = (long)numMutants * numTests;
+  outcome = calloc(pairs, 1);
+  running = calloc(jobs, sizeof(struct run));
+  if (outcome == NULL || running == NULL)
+    return 2;
+  for (m = 0; m < numMutants; m++) {
+    for (t = 0; t < numTests; t++) {
+      if (covered[t][mutants[m].site])
+	outcome[(long)m * numTests + t] = PENDING;
+    }
+  }
+
+  while (next < pairs || numRunning > 0) {
+    while (numRunning < jobs && next < pairs) {
+      if (outcome[next] == PENDING) {
+	r = numRunning;
+	running[r].mutant = next / numTests;
+	running[r].test = next % numTests;
+	running[r].pid = spawn(tests[running[r].test],
+			       mutants[running[r].mutant].id, NULL);
+	if (running[r].pid < 0) {
+	  //try again once a child has finished
+	  if (numRunning > 0)
+	    break;
+	  perror("fork");
+	  return 2;
+	}
+	running[r].started = now();
+	numRunning++;
+	runs++;
+      }
+      next++;
+    }
+    if (numRunning == 0)
+      continue;
+
+    pid = waitpid(-1, &status, WNOHANG);
+    if (pid == 0) {
+      //sleep until a child exits or the first timeout runs out
+      wait = -1;
+      for (r = 0; r < numRunning; r++) {
+	left = running[r].started + timeouts[running[r].test] - now();
+	if (left <= 0)
+	  kill(running[r].pid, SIGKILL);
+	else if (wait < 0 || left < wait)
+	  wait = left;
+      }
+      if (wait > 0) {
+	ts.tv_sec = (time_t)wait;
+	ts.tv_nsec = (long)((wait - ts.tv_sec) * 1e9);
+	sigtimedwait(&childExit, NULL, &ts);
+      }
+      continue;
+    }
+    if (pid < 0)
+      break;
+    for (r = 0; r < numRunning && running[r].pid != pid; r++)
+      ;
+    if (r == numRunning)
+      continue;
+    outcome[(long)running[r].mutant * numTests + running[r].test] =
+      WIFEXITED(status) && WEXITSTATUS(status) == 0 ? SURVIVED : KILLED;
+    running[r] = running[--numRunning];
+  }
+
+  for (t = 0; t < numTests; t++)
+    printf("t%d = %s\n", t + 1, tests[t]);
+  printf("%-6s %-24s %-22s", "Mutant", "Location", "Change");
+  for (t = 0; t < numTests; t++)
+    printf(" t%-2d", t + 1);
+  printf("\n");
+  for (m = 0; m < numMutants; m++) {
+    any = 0;
+    r = 0;
+    for (t = 0; t < numTests; t++) {
+      any |= outcome[(long)m * numTests + t] != NOT_COVERED;
+      r |= outcome[(long)m * numTests + t] == KILLED;
+    }
+    coveredMutants += any;
+    killed += r;
+    if (survivorsOnly && (!any || r))
+      continue;
+    printf("%-6d %-24s %-22s", mutants[m].id, mutants[m].where,
+	   mutants[m].change);
+    for (t = 0; t < numTests; t++)
+      printf(" %-3s", outcome[(long)m * numTests + t] == KILLED ? "K"
+	     : outcome[(long)m * numTests + t] == SURVIVED ? "." : "-");
+    printf("\n");
+  }
+  printf("Mutants: %d, covered: %d, killed: %d, score %.1f%% of covered\n",
+	 numMutants, coveredMutants, killed,
+	 coveredMutants ? 100.0 * killed / coveredMutants : 0.0);
+  printf("%ld runs in %.1fs on %d jobs\n", runs, now() - start, jobs);
+  return 0;
+}
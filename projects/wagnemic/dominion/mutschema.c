@@ -0,0 +1,31 @@
+#include "mutschema.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+int mutantId = 0;
+unsigned char mutantCovered[MUTANT_MAX + 1];
+
+static const char *coveragePath;
+
+static void writeCoverage(void) {
+  FILE *f = fopen(coveragePath, "w");
+  int i;
+
+  if (f == NULL)
+    return;
+  for (i = 1; i <= MUTANT_MAX; i++) {
+    if (mutantCovered[i])
+      fprintf(f, "%d\n", i);
+  }
+  fclose(f);
+}
+
+__attribute__((constructor)) static void initMutant(void) {
+  const char *id = getenv("DOMINION_MUTANT");
+
+  if (id != NULL)
+    mutantId = atoi(id);
+  coveragePath = getenv("DOMINION_MUTANT_COVERAGE");
+  if (coveragePath != NULL)
+    atexit(writeCoverage);
+}
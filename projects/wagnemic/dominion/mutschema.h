@@ -0,0 +1,40 @@
+/* Run-time side of a mutant schema (see mutate.c)
+
+   DOMINION_MUTANT selects the mutant a schema binary runs, 0 or unset
+   runs the original program.  Every site marks itself in mutantCovered
+   when it is reached; if DOMINION_MUTANT_COVERAGE names a file, the ids
+   of the sites reached are written to it at exit.
+
+   The MUT_ macros evaluate each operand once, in a temporary of its own
+   type, so the unmutated path computes exactly what the original
+   expression did.
+*/
+
+#ifndef _MUTSCHEMA_H
+#define _MUTSCHEMA_H
+
+#define MUTANT_MAX 65536
+
+extern int mutantId;
+extern unsigned char mutantCovered[MUTANT_MAX + 1];
+
+#define MUT_CONST(id, c)						\
+  (mutantCovered[id] = 1,						\
+   mutantId == (id) ? (c) + 1 : mutantId == (id) + 1 ? (c) - 1 : (c))
+
+#define MUT_COND(id, c)							\
+  (mutantCovered[id] = 1,						\
+   mutantId == (id) + 1 ? 0 : ((c) ? 1 : 0) ^ (mutantId == (id)))
+
+#define MUT_OP1(id, a, op, b, alt)					\
+  ({ __typeof__(a) mutA_ = (a); __typeof__(b) mutB_ = (b);		\
+    mutantCovered[id] = 1;						\
+    mutantId == (id) ? mutA_ alt mutB_ : mutA_ op mutB_; })
+
+#define MUT_OP2(id, a, op, b, alt1, alt2)				\
+  ({ __typeof__(a) mutA_ = (a); __typeof__(b) mutB_ = (b);		\
+    mutantCovered[id] = 1;						\
+    mutantId == (id) ? mutA_ alt1 mutB_					\
+      : mutantId == (id) + 1 ? mutA_ alt2 mutB_ : mutA_ op mutB_; })
+
+#endif
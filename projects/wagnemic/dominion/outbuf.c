@@ -0,0 +1,84 @@
+#include "outbuf.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+int outInit(struct outBuf *out, int size, int limit) {
+  out->data = malloc(size);
+  out->len = 0;
+  out->size = out->data == NULL ? 0 : size;
+  out->limit = limit < size ? size : limit;
+  out->dropped = 0;
+  return out->data == NULL ? -1 : 0;
+}
+
+void outFree(struct outBuf *out) {
+  free(out->data);
+  out->data = NULL;
+  out->len = out->size = 0;
+}
+
+//makes room for need more bytes plus a terminating nul
+static int reserve(struct outBuf *out, int need) {
+  int size = out->size;
+  char *data;
+
+  if (out->len + need + 1 <= out->size)
+    return 0;
+  if (out->len + need + 1 > out->limit)
+    return -1;
+  while (size < out->len + need + 1)
+    size = size > 0 ? 2 * size : 256;
+  if (size > out->limit)
+    size = out->limit;
+  data = realloc(out->data, size);
+  if (data == NULL)
+    return -1;
+  out->data = data;
+  out->size = size;
+  return 0;
+}
+
+int outPrintf(struct outBuf *out, const char *format, ...) {
+  va_list args;
+  int n;
+
+  if (out == NULL)
+    return 0;
+  va_start(args, format);
+  n = vsnprintf(out->data + out->len, out->size - out->len, format, args);
+  va_end(args);
+  if (n < 0)
+    return -1;
+  if (out->len + n >= out->size) {
+    if (reserve(out, n) < 0) {
+      //vsnprintf wrote what fitted past len; only what was kept counts
+      out->data[out->len] = '\0';
+      out->dropped += n;
+      return -1;
+    }
+    va_start(args, format);
+    vsnprintf(out->data + out->len, out->size - out->len, format, args);
+    va_end(args);
+  }
+  out->len += n;
+  return n;
+}
+
+int outAppend(struct outBuf *out, const char *text, int len) {
+  if (out == NULL)
+    return 0;
+  if (reserve(out, len) < 0) {
+    out->dropped += len;
+    return -1;
+  }
+  memcpy(out->data + out->len, text, len);
+  out->len += len;
+  out->data[out->len] = '\0';
+  return len;
+}
+
+void outClear(struct outBuf *out) {
+  out->len = 0;
+}
@@ -0,0 +1,36 @@
+/* Growable output buffer
+
+   Text is appended with outPrintf and handed on (written to a socket or
+   stdout) by the owner, who then empties the buffer with outClear.  The
+   memory is kept, so once a buffer has grown to fit the largest
+   response it is reused without further allocation.  A buffer never
+   grows past its limit; text that does not fit is dropped and counted.
+   Appending to a NULL buffer does nothing, which gives callers a quiet
+   mode for free.
+*/
+
+#ifndef _OUTBUF_H
+#define _OUTBUF_H
+
+struct outBuf {
+  char *data;
+  int len;
+  int size;
+  int limit;
+  long dropped;     /* bytes that did not fit under the limit */
+};
+
+int outInit(struct outBuf *out, int size, int limit);
+/* Returns -1 if the first allocation fails */
+
+void outFree(struct outBuf *out);
+
+int outPrintf(struct outBuf *out, const char *format, ...)
+  __attribute__((format(printf, 2, 3)));
+/* Returns the number of bytes appended, -1 if the text was dropped */
+
+int outAppend(struct outBuf *out, const char *text, int len);
+
+void outClear(struct outBuf *out);
+
+#endif
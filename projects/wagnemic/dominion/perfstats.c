@@ -0,0 +1,203 @@
+#include "perfstats.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+//one per thread that has counted anything
+struct perfBlock {
+  struct perfStats stats;
+  struct perfBlock *next;
+};
+
+static const char *siteNames[PERF_SITES] = {
+  "curse", "estate", "duchy", "province", "copper", "silver", "gold",
+  "adventurer", "council_room", "feast", "gardens", "mine", "remodel",
+  "smithy", "village", "baron", "great_hall", "minion", "steward", "tribute",
+  "ambassador", "cutpurse", "embargo", "outpost", "salvager", "sea_hag",
+  "treasure_map", "other card", "initializeGame", "shuffle", "playCard",
+  "buyCard", "endTurn", "drawCard", "gainCard", "discardCard",
+  "updateCoins", "isGameOver", "scoreFor"
+};
+
+__thread unsigned long perfDrawn = 0;
+__thread unsigned long perfShuffled = 0;
+
+static __thread struct perfBlock *ours = NULL;
+static struct perfBlock *blocks = NULL;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+static unsigned long long cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+static int bucketOf(unsigned long long value) {
+  int e;
+
+  if (value < 2 * PERF_SUB_BUCKETS)
+    return value;
+  e = 63 - __builtin_clzll(value);
+  if (e > PERF_MAX_EXPONENT)
+    return PERF_BUCKETS - 1;
+  //the top bit is e, the next four pick the sub-bucket
+  return 2 * PERF_SUB_BUCKETS + (e - 5) * PERF_SUB_BUCKETS
+    + (int)(value >> (e - 4)) - PERF_SUB_BUCKETS;
+}
+
+//the largest value that lands in bucket b
+static unsigned long long bucketTop(int b) {
+  int e;
+
+  if (b < 2 * PERF_SUB_BUCKETS)
+    return b;
+  e = 5 + (b - 2 * PERF_SUB_BUCKETS) / PERF_SUB_BUCKETS;
+  return ((unsigned long long)(PERF_SUB_BUCKETS + b % PERF_SUB_BUCKETS + 1)
+	  << (e - 4)) - 1;
+}
+
+void perfHistRecord(struct perfHist *h, unsigned long long value) {
+  h->count++;
+  h->sum += value;
+  if (value > h->max)
+    h->max = value;
+  h->buckets[bucketOf(value)]++;
+}
+
+unsigned long long perfHistPercentile(struct perfHist *h, double percent) {
+  unsigned long want = (unsigned long)(h->count * percent / 100.0);
+  unsigned long seen = 0;
+  int b;
+
+  if (h->count == 0)
+    return 0;
+  if (want >= h->count)
+    want = h->count - 1;
+  for (b = 0; b < PERF_BUCKETS; b++) {
+    seen += h->buckets[b];
+    //the top bucket has no upper bound but the largest value seen
+    if (seen > want && b < PERF_BUCKETS - 1)
+      return bucketTop(b) < h->max ? bucketTop(b) : h->max;
+  }
+  return h->max;
+}
+
+void perfHistMerge(struct perfHist *into, struct perfHist *from) {
+  int b;
+
+  into->count += from->count;
+  into->sum += from->sum;
+  if (from->max > into->max)
+    into->max = from->max;
+  for (b = 0; b < PERF_BUCKETS; b++)
+    into->buckets[b] += from->buckets[b];
+}
+
+struct perfMark perfBegin(int site) {
+  struct perfMark m;
+
+  m.site = site;
+  m.drawn = perfDrawn;
+  m.shuffles = perfShuffled;
+  m.start = cycles();
+  return m;
+}
+
+void perfEnd(struct perfMark *m) {
+  unsigned long long spent = cycles() - m->start;
+  struct perfSite *s;
+
+  if (ours == NULL) {
+    ours = calloc(1, sizeof(struct perfBlock));
+    if (ours == NULL)
+      return;
+    pthread_mutex_lock(&lock);
+    ours->next = blocks;
+    blocks = ours;
+    pthread_mutex_unlock(&lock);
+  }
+  if (m->site < 0 || m->site >= PERF_SITES)
+    m->site = PERF_CARD_EFFECT_OTHER;
+  s = &ours->stats.sites[m->site];
+  s->calls++;
+  s->drawn += perfDrawn - m->drawn;
+  s->shuffles += perfShuffled - m->shuffles;
+  perfHistRecord(&s->cycles, spent);
+}
+
+void perfSnapshot(struct perfStats *out) {
+  struct perfBlock *b;
+  int i;
+
+  memset(out, 0, sizeof(struct perfStats));
+  pthread_mutex_lock(&lock);
+  for (b = blocks; b != NULL; b = b->next) {
+    for (i = 0; i < PERF_SITES; i++) {
+      out->sites[i].calls += b->stats.sites[i].calls;
+      out->sites[i].drawn += b->stats.sites[i].drawn;
+      out->sites[i].shuffles += b->stats.sites[i].shuffles;
+      perfHistMerge(&out->sites[i].cycles, &b->stats.sites[i].cycles);
+    }
+  }
+  pthread_mutex_unlock(&lock);
+}
+
+void perfReset(void) {
+  struct perfBlock *b;
+
+  pthread_mutex_lock(&lock);
+  for (b = blocks; b != NULL; b = b->next)
+    memset(&b->stats, 0, sizeof(struct perfStats));
+  pthread_mutex_unlock(&lock);
+}
+
+const char *perfSiteName(int site) {
+  if (site < 0 || site >= PERF_SITES)
+    return "unknown";
+  return siteNames[site];
+}
+
+static int byTotal(const void *a, const void *b) {
+  const struct perfSite *x = *(const struct perfSite * const *)a;
+  const struct perfSite *y = *(const struct perfSite * const *)b;
+
+  if (x->cycles.sum != y->cycles.sum)
+    return x->cycles.sum < y->cycles.sum ? 1 : -1;
+  return 0;
+}
+
+int perfPrint(FILE *f, struct perfStats *s) {
+  struct perfSite *order[PERF_SITES];
+  struct perfSite *p;
+  int n = 0;
+  int i;
+
+  for (i = 0; i < PERF_SITES; i++) {
+    if (s->sites[i].calls > 0)
+      order[n++] = &s->sites[i];
+  }
+  if (n == 0)
+    return 0;
+  qsort(order, n, sizeof(order[0]), byTotal);
+  fprintf(f, "%-15s %10s %7s %7s %9s %8s %8s %9s %10s\n", "Site", "Calls",
+	  "Draws", "Shuffle", "Mean", "p50", "p99", "Max", "Total (M)");
+  for (i = 0; i < n; i++) {
+    p = order[i];
+    fprintf(f, "%-15s %10lu %7.2f %7.3f %9.0f %8llu %8llu %9llu %10.1f\n",
+	    perfSiteName(p - s->sites), p->calls,
+	    (double)p->drawn / p->calls, (double)p->shuffles / p->calls,
+	    (double)p->cycles.sum / p->calls,
+	    perfHistPercentile(&p->cycles, 50), perfHistPercentile(&p->cycles, 99),
+	    p->cycles.max, p->cycles.sum / 1e6);
+  }
+  return n;
+}
@@ -0,0 +1,103 @@
+/* Per-card and per-primitive performance counters
+
+   Building dominion.c with -DPERF_STATS (make PERF=-DPERF_STATS) puts a
+   PERF_SCOPE at the top of cardEffect and of the engine primitives.
+   Each scope counts the call, the cards drawn and shuffles done inside
+   it (nested calls included), and the cycles it took into a
+   log-linear histogram with PERF_SUB_BUCKETS buckets per power of two,
+   so percentiles come out within about 6%.  Counters live in a block
+   per thread that is allocated on first use and never freed, so
+   perfSnapshot can merge them at any time, finished threads included.
+   Without PERF_STATS the macros are empty and nothing is counted.
+*/
+
+#ifndef _PERFSTATS_H
+#define _PERFSTATS_H
+
+#include "dominion.h"
+#include <stdio.h>
+
+#define PERF_SUB_BUCKETS 16
+#define PERF_MAX_EXPONENT 47   /* larger values go in the top bucket */
+#define PERF_BUCKETS (2 * PERF_SUB_BUCKETS \
+		      + (PERF_MAX_EXPONENT - 4) * PERF_SUB_BUCKETS)
+
+//sites 0..treasure_map are cardEffect for that card
+enum PERF_SITE {
+  PERF_CARD_EFFECT_OTHER = treasure_map + 1,  /* card out of range */
+  PERF_INITIALIZE_GAME,
+  PERF_SHUFFLE,
+  PERF_PLAY_CARD,
+  PERF_BUY_CARD,
+  PERF_END_TURN,
+  PERF_DRAW_CARD,
+  PERF_GAIN_CARD,
+  PERF_DISCARD_CARD,
+  PERF_UPDATE_COINS,
+  PERF_IS_GAME_OVER,
+  PERF_SCORE_FOR,
+  PERF_SITES
+};
+
+struct perfHist {
+  unsigned long count;
+  unsigned long long sum;
+  unsigned long long max;
+  unsigned long buckets[PERF_BUCKETS];
+};
+
+struct perfSite {
+  unsigned long calls;
+  unsigned long drawn;      /* cards drawn inside the call */
+  unsigned long shuffles;   /* shuffles done inside the call */
+  struct perfHist cycles;
+};
+
+struct perfStats {
+  struct perfSite sites[PERF_SITES];
+};
+
+struct perfMark {
+  int site;
+  unsigned long long start;
+  unsigned long drawn;
+  unsigned long shuffles;
+};
+
+extern __thread unsigned long perfDrawn;
+extern __thread unsigned long perfShuffled;
+
+struct perfMark perfBegin(int site);
+void perfEnd(struct perfMark *mark);
+
+#ifdef PERF_STATS
+//measured until the enclosing function returns, whichever way it does
+#define PERF_SCOPE(site) \
+  struct perfMark perfMark __attribute__((cleanup(perfEnd))) = \
+    perfBegin(site)
+#define PERF_DRAWN() (perfDrawn++)
+#define PERF_SHUFFLED() (perfShuffled++)
+#else
+#define PERF_SCOPE(site)
+#define PERF_DRAWN()
+#define PERF_SHUFFLED()
+#endif
+
+void perfHistRecord(struct perfHist *h, unsigned long long value);
+unsigned long long perfHistPercentile(struct perfHist *h, double percent);
+/* The upper bound of the bucket holding that percentile */
+void perfHistMerge(struct perfHist *into, struct perfHist *from);
+
+void perfSnapshot(struct perfStats *out);
+/* The counters of every thread so far, added up */
+
+void perfReset(void);
+/* Zeroes every thread's counters; call it while no thread is counting */
+
+const char *perfSiteName(int site);
+
+int perfPrint(FILE *f, struct perfStats *s);
+/* One line per site that was called, busiest first; returns the number
+   of lines */
+
+#endif
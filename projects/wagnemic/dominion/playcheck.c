@@ -0,0 +1,85 @@
+#include "playcheck.h"
+#include <string.h>
+
+const char *findingNames[NUM_FINDINGS] = {
+  "ok", "crash", "hang", "count", "card", "created", "supply", "resources",
+  "dirty"
+};
+
+static int pileOk(int *cards, int count, int max) {
+  int i;
+
+  if (count < 0 || count > max)
+    return FIND_COUNT;
+  for (i = 0; i < count; i++) {
+    if (cards[i] < curse || cards[i] > treasure_map)
+      return FIND_CARD;
+  }
+  return FIND_NONE;
+}
+
+static void addPile(struct snapshot *snap, int *cards, int count) {
+  int i;
+
+  for (i = 0; i < count; i++)
+    snap->totals[cards[i]]++;
+}
+
+int takeSnapshot(struct gameState *s, struct snapshot *snap) {
+  int finding;
+  int p;
+  int i;
+
+  memset(snap, 0, sizeof(struct snapshot));
+  for (p = 0; p < s->numPlayers; p++) {
+    if ((finding = pileOk(s->hand[p], s->handCount[p], MAX_HAND))
+	|| (finding = pileOk(s->deck[p], s->deckCount[p], MAX_DECK))
+	|| (finding = pileOk(s->discard[p], s->discardCount[p], MAX_DECK)))
+      return finding;
+  }
+  if ((finding = pileOk(s->playedCards, s->playedCardCount, MAX_DECK)))
+    return finding;
+
+  for (p = 0; p < s->numPlayers; p++) {
+    addPile(snap, s->hand[p], s->handCount[p]);
+    addPile(snap, s->deck[p], s->deckCount[p]);
+    addPile(snap, s->discard[p], s->discardCount[p]);
+  }
+  addPile(snap, s->playedCards, s->playedCardCount);
+  for (i = 0; i <= treasure_map; i++) {
+    snap->supply[i] = s->supplyCount[i];
+    if (s->supplyCount[i] > 0)
+      snap->totals[i] += s->supplyCount[i];
+  }
+  return FIND_NONE;
+}
+
+int checkCall(struct snapshot *pre, struct gameState *s) {
+  struct snapshot post;
+  int finding = takeSnapshot(s, &post);
+  int i;
+
+  if (finding != FIND_NONE)
+    return finding;
+  for (i = 0; i <= treasure_map; i++) {
+    if (post.totals[i] > pre->totals[i])
+      return FIND_CREATED;
+    if ((pre->supply[i] < 0) != (post.supply[i] < 0)
+	|| post.supply[i] < -1)
+      return FIND_SUPPLY;
+  }
+  if (s->numActions < 0 || s->coins < 0 || s->numBuys < 0)
+    return FIND_RESOURCES;
+  return FIND_NONE;
+}
+
+int checkFailure(struct playCase *pre, struct playCase *post) {
+  static unsigned char before[STATE_FILE_MAX];
+  static unsigned char after[STATE_FILE_MAX];
+  int size = encodeStateFile(pre, before, STATE_FILE_MAX);
+
+  if (size != encodeStateFile(post, after, STATE_FILE_MAX)
+      || memcmp(before, after, size) != 0)
+    return FIND_DIRTY;
+  return FIND_NONE;
+}
@@ -0,0 +1,50 @@
+/* Play call checks
+
+   The oracle fuzz and ddmin share for one playCard or cardEffect call
+   (see statefile.h).  A snapshot of the state is taken before the call;
+   afterwards checkCall looks for pile counts outside their arrays, card
+   ids outside curse..treasure_map, more copies of a card than before,
+   supply piles going negative or appearing, and negative actions, coins
+   or buys.  A call that fails must leave the state alone, which
+   checkFailure checks on the live part of the state.
+*/
+
+#ifndef _PLAYCHECK_H
+#define _PLAYCHECK_H
+
+#include "dominion.h"
+#include "statefile.h"
+
+enum FINDING {
+  FIND_NONE = 0,
+  FIND_CRASH,
+  FIND_HANG,
+  FIND_COUNT,      /* a pile count outside 0..MAX */
+  FIND_CARD,       /* a card id outside curse..treasure_map */
+  FIND_CREATED,    /* more copies of a card than before the call */
+  FIND_SUPPLY,     /* a pile in the game went negative or one appeared */
+  FIND_RESOURCES,  /* negative actions, coins or buys */
+  FIND_DIRTY,      /* the call failed but changed the state */
+  NUM_FINDINGS
+};
+
+extern const char *findingNames[NUM_FINDINGS];
+
+struct snapshot {
+  long totals[treasure_map + 1];
+  int supply[treasure_map + 1];
+};
+
+int takeSnapshot(struct gameState *s, struct snapshot *snap);
+/* Returns FIND_COUNT or FIND_CARD if the state is not even safe to
+   walk, FIND_NONE otherwise */
+
+int checkCall(struct snapshot *pre, struct gameState *s);
+/* Returns the first finding for the state after the call, pre being
+   the snapshot from before it */
+
+int checkFailure(struct playCase *pre, struct playCase *post);
+/* Returns FIND_DIRTY if a failed call changed the live state, pre being
+   the case before the call.  Not thread safe. */
+
+#endif
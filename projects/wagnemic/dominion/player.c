@@ -5,6 +5,13 @@
 	Questions/Comments:
 	heiniths@onid.orst.edu
 	1/26/2010
+
+	Usage: player [-q] seed
+	       player -s [-j threads] seed script...
+
+	-s runs whole command scripts (files, or - for stdin) with no
+	prompts, several at once, and prints only failed expects and each
+	script's final state (see sessionScript in session.h).
 */
 
 
@@ -15,9 +22,126 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <unistd.h>
+#include <pthread.h>
 #include "dominion.h"
 #include "interface.h"
 #include "rngs.h"
+#include "session.h"
+#include "workq.h"
+
+struct batch {
+	char **paths;
+	int seed;
+	struct outBuf *reports;
+	int failed;
+	long commands;
+	pthread_mutex_t lock;
+};
+
+//reads all of path, - for stdin, into a nul-terminated buffer
+static char *readScript(const char *path, long *len) {
+	FILE *f = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+	char *text = NULL;
+	char *more;
+	long size = 0;
+	size_t n;
+
+	*len = 0;
+	if(f == NULL) return NULL;
+	do {
+		if(*len + 1 >= size) {
+			size = size > 0 ? 2 * size : 65536;
+			more = realloc(text, size);
+			if(more == NULL) {
+				free(text);
+				text = NULL;
+				break;
+			}
+			text = more;
+		}
+		n = fread(text + *len, 1, size - *len - 1, f);
+		*len += n;
+	} while(n > 0);
+	if(text != NULL) text[*len] = '\0';
+	if(f != stdin) fclose(f);
+	return text;
+}
+
+static void runScripts(void *arg, int worker, long begin, long end) {
+	struct batch *b = arg;
+	struct session *session = calloc(1, sizeof(struct session));
+	struct outBuf work;
+	char *text;
+	long len;
+	long i;
+	int failed;
+
+	if(session == NULL || outInit(&work, 4096, 1 << 24) < 0) {
+		free(session);
+		return;
+	}
+	for(i = begin; i < end; i++) {
+		outInit(&b->reports[i], 256, 1 << 24);
+		text = readScript(b->paths[i], &len);
+		//a script that was never run ran no commands
+		session->commands = 0;
+		if(text == NULL) {
+			outPrintf(&b->reports[i], "%s: cannot read\n", b->paths[i]);
+			failed = 1;
+		} else {
+			sessionStart(session, b->seed, NULL);
+			failed = sessionScript(session, text, len, b->paths[i], &work,
+					       &b->reports[i]);
+		}
+		free(text);
+		pthread_mutex_lock(&b->lock);
+		b->failed += failed;
+		b->commands += session->commands;
+		pthread_mutex_unlock(&b->lock);
+	}
+	outFree(&work);
+	free(session);
+}
+
+static int batchMain(int argc, char *argv[]) {
+	struct batch b;
+	int threads = 0;
+	int opt;
+	int i;
+
+	while((opt = getopt(argc, argv, "sj:")) != -1) {
+		switch(opt) {
+		case 's': break;
+		case 'j': threads = atoi(optarg); break;
+		default: optind = argc + 1; break;
+		}
+	}
+	if(optind + 2 > argc || threads < 0 || atoi(argv[optind]) <= 0) {
+		printf("Usage: player -s [-j threads] seed script...\n");
+		return EXIT_FAILURE;
+	}
+	memset(&b, 0, sizeof(b));
+	b.seed = atoi(argv[optind]);
+	b.paths = argv + optind + 1;
+	b.reports = calloc(argc - optind - 1, sizeof(struct outBuf));
+	pthread_mutex_init(&b.lock, NULL);
+	if(b.reports == NULL
+	   || workqRun(0, argc - optind - 1, 1, threads, runScripts, &b) < 0) {
+		printf("Could not start worker threads\n");
+		return EXIT_FAILURE;
+	}
+	//reports go out in script order, however the scripts were scheduled
+	for(i = 0; i < argc - optind - 1; i++) {
+		if(b.reports[i].len > 0)
+			fwrite(b.reports[i].data, 1, b.reports[i].len, stdout);
+		outFree(&b.reports[i]);
+	}
+	printf("%d scripts, %ld commands, %d failures\n",
+	       argc - optind - 1, b.commands, b.failed);
+	free(b.reports);
+	return b.failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
 
 
 int main2(int argc, char *argv[]) {
@@ -31,187 +155,50 @@ int main2(int argc, char *argv[]) {
 }
 
 int main(int argc, char* argv[]) {
-		char *add  = "add";
-	char *buyC = "buy";
-	char *endT = "end";
-	char *exit = "exit";
-	char *help = "help";
-	char *init = "init";
-	char *numH = "num";
-	char *play = "play";
-	char *resign  = "resi";
-	char *show = "show";
-	char *stat = "stat";
-	char *supply = "supp";
-	char *whos = "whos";
-		
-	char command[MAX_STRING_LENGTH];
 	char line[MAX_STRING_LENGTH];
-	char cardName[MAX_STRING_LENGTH];
-
-	//Array to hold bot presence 
-	int isBot[MAX_PLAYERS] = { 0, 0, 0, 0};
-
-	int players[MAX_PLAYERS];
-	int playerNum;
-	int outcome;
-	int currentPlayer;
-	int gameOver = FALSE;
-	int gameStarted = FALSE;
-	int turnNum = 0;
-
-	int randomSeed = atoi(argv[1]);
-
-	//Default cards, as defined in playDom
-	int kCards[10] = {adventurer, gardens, embargo, village, minion, mine, cutpurse, sea_hag, tribute, smithy};
-
-	struct gameState g;
-	struct gameState * game = &g;
+	struct session session;
+	struct outBuf out;
+	int randomSeed;
+	int quiet = FALSE;
+
+	if(argc > 1 && strcmp(argv[1], "-s") == 0)
+		return batchMain(argc, argv);
+
+	//-q plays bot turns without printing them, for bot-only games
+	if(argc == 3 && strcmp(argv[1], "-q") == 0){
+		quiet = TRUE;
+		argv++;
+		argc--;
+	}
 
-	memset(game,0,sizeof(struct gameState));
-		
 	if(argc != 2){
-		printf("Usage: player [integer random number seed]\n");
+		printf("Usage: player [-q] [integer random number seed]\n");
 		return EXIT_SUCCESS;
 	}
 
+	randomSeed = atoi(argv[1]);
 	if(randomSeed <= 0){
-		printf("Usage: player [integer random number seed]\n");
+		printf("Usage: player [-q] [integer random number seed]\n");
 		return EXIT_SUCCESS;
 	}	
 	
-	initializeGame(2,kCards,randomSeed,game);
-
-	printf("Please enter a command or \"help\" for commands\n");
-	
+	//The commands themselves live in session.c, shared with domserver
+	outInit(&out, 4096, 1 << 24);
+	sessionStart(&session, randomSeed, &out);
+	session.quietBots = quiet;
 
 	while(TRUE) {
-		int arg0 = UNUSED;
-		int arg1 = UNUSED;
-		int arg2 = UNUSED;
-		int arg3 = UNUSED;
-
-		outcome = FAILURE;
-		strcpy(line,"");
-		strcpy(command,"");
-		strcpy(cardName,"");
-		
-		currentPlayer = whoseTurn(game);
-		
-		//If you are getting a seg fault comment this if block out
-		gameOver = isGameOver(game); 		
-		if(gameStarted == TRUE && gameOver == TRUE){
-			printScores(game);
-			getWinners(players, game);
-			printf("After %d turns, the winner(s) are:\n", turnNum);
-			for(playerNum = 0; playerNum < game->numPlayers; playerNum++){
-				if(players[playerNum] == WINNER) printf("Player %d\n", playerNum);
-			}
-		for(playerNum = 0; playerNum < game->numPlayers; playerNum++){
-				printHand(playerNum, game);
-				printPlayed(playerNum, game);
-				printDiscard(playerNum, game);
-				printDeck(playerNum, game);
-			}
-			
-			break; //Exit out of the game/while loop
-		}         
-		
-
-		if(isBot[currentPlayer] == TRUE) {
-				executeBotTurn(currentPlayer, &turnNum, game);
-				continue;
-		}
-		
+		fwrite(out.data, 1, out.len, stdout);
+		outClear(&out);
 		printf("$ ");
-		fgets(line, MAX_STRING_LENGTH, stdin);
-		sscanf(line, "%s %d %d %d %d", command, &arg0, &arg1, &arg2, &arg3);
-
-
-		if(COMPARE(command, add) == 0) {
-			outcome = addCardToHand(currentPlayer, arg0, game);
-			cardNumToName(arg0, cardName);
-			printf("Player %d adds %s to their hand\n\n", currentPlayer, cardName);
-		} else
-		if(COMPARE(command, buyC) == 0) {
-			outcome = buyCard(arg0, game);
-			cardNumToName(arg0, cardName);
-			if(outcome == SUCCESS){
-				printf("Player %d buys card %d, %s\n\n", currentPlayer, arg0, cardName);
-			} else {
-				printf("Player %d cannot buy card %d, %s\n\n", currentPlayer, arg0, cardName);
-			}
-		} else
-		if(COMPARE(command, endT) == 0) {
-			if(gameStarted == TRUE) {
-				if(currentPlayer == (game->numPlayers -1)) turnNum++;
-				endTurn(game);
-				currentPlayer = whoseTurn(game);
-				printf("Player %d's turn number %d\n\n", currentPlayer, turnNum);
-			}
-
-		} else			
-		if(COMPARE(command, exit) == 0) {
+		if(fgets(line, MAX_STRING_LENGTH, stdin) == NULL) break;
+		if(sessionCommand(&session, line, &out) == 1) {
+			fwrite(out.data, 1, out.len, stdout);
 			break;
-		} else
-		if(COMPARE(command, help) == 0) {
-			printHelp();
-		} else
-		if(COMPARE(command, init) == 0) {
-			int numHuman = arg0 - arg1;
-			for(playerNum = numHuman; playerNum < arg0; playerNum++) {
-				isBot[playerNum] = TRUE;
-			}			
-	//		selectKingdomCards(randomSeed, kCards);  //Comment this out to use the default card set defined in playDom.
-			outcome = initializeGame(arg0, kCards, randomSeed, game);
-			printf("\n");
-			if(outcome == SUCCESS){
-				gameStarted = TRUE;
-				currentPlayer = whoseTurn(game);
-				printf("Player %d's turn number %d\n\n", currentPlayer, turnNum);
-			}
-
-		} else
-		if(COMPARE(command, numH) == 0) {
-			int numCards = numHandCards(game);
-			printf("There are %d cards in your hand.\n", numCards);
-		} else
-		if(COMPARE(command, play) == 0) {
-			int card = handCard(arg0,game);
-			outcome = playCard(arg0, arg1, arg2, arg3, game);
-			cardNumToName(card, cardName);
-			if(outcome == SUCCESS){
-				printf("Player %d plays %s\n\n", currentPlayer, cardName);
-			} else {
-				printf("Player %d cannot play card %d\n\n", currentPlayer, arg0);
-			}
-
-		} else
-		if(COMPARE(command, resign) == 0) {
-			endTurn(game);
-			printScores(game);
-			break;
-		} else
-		if(COMPARE(command, show) == 0) {
-			if(gameStarted == FALSE) continue;
-			printHand(currentPlayer, game);
-			printPlayed(currentPlayer, game);
-			//printDiscard(currentPlayer, game);
-			//printDeck(currentPlayer, game);
-		} else
-		if(COMPARE(command, stat) == 0) {
-			if(gameStarted == FALSE) continue;
-			printState(game);
-		} else
-		if(COMPARE(command, supply) == 0) {
-			printSupply(game);
-		} else
-		if(COMPARE(command, whos) == 0) {
-			int playerNum =	whoseTurn(game);
-			printf("Player %d's turn\n", playerNum);
-		} 
+		}
     	}
 	
+	outFree(&out);
     	return EXIT_SUCCESS;
 
 }
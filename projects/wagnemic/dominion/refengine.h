@@ -0,0 +1,68 @@
+/* Reference engine
+
+   The course's unmodified engine (../../../dominion/dominion.c and
+   rngs.c) is linked next to the working one so that optimizations can
+   be checked against it call by call.  Those files are compiled with
+   -DREF_ENGINE_BUILD -include refengine.h, which gives every public
+   symbol a ref_ prefix; everything else sees the ref_ prototypes.
+   rngs.c is built through refrngs.c, which gives each thread its own
+   streams.
+*/
+
+#ifndef _REFENGINE_H
+#define _REFENGINE_H
+
+#ifdef REF_ENGINE_BUILD
+
+#define compare ref_compare
+#define newGame ref_newGame
+#define kingdomCards ref_kingdomCards
+#define initializeGame ref_initializeGame
+#define shuffle ref_shuffle
+#define playCard ref_playCard
+#define buyCard ref_buyCard
+#define numHandCards ref_numHandCards
+#define handCard ref_handCard
+#define supplyCount ref_supplyCount
+#define fullDeckCount ref_fullDeckCount
+#define whoseTurn ref_whoseTurn
+#define endTurn ref_endTurn
+#define isGameOver ref_isGameOver
+#define scoreFor ref_scoreFor
+#define getWinners ref_getWinners
+#define drawCard ref_drawCard
+#define getCost ref_getCost
+#define cardEffect ref_cardEffect
+#define discardCard ref_discardCard
+#define gainCard ref_gainCard
+#define updateCoins ref_updateCoins
+#define Random ref_Random
+#define PlantSeeds ref_PlantSeeds
+#define GetSeed ref_GetSeed
+#define PutSeed ref_PutSeed
+#define SelectStream ref_SelectStream
+#define TestRandom ref_TestRandom
+
+#else
+
+#include "dominion.h"
+
+int ref_initializeGame(int numPlayers, int kingdomCards[10], int randomSeed,
+		       struct gameState *state);
+int ref_shuffle(int player, struct gameState *state);
+int ref_playCard(int handPos, int choice1, int choice2, int choice3,
+		 struct gameState *state);
+int ref_buyCard(int supplyPos, struct gameState *state);
+int ref_endTurn(struct gameState *state);
+int ref_isGameOver(struct gameState *state);
+int ref_scoreFor(int player, struct gameState *state);
+int ref_getWinners(int players[MAX_PLAYERS], struct gameState *state);
+int ref_drawCard(int player, struct gameState *state);
+int ref_cardEffect(int card, int choice1, int choice2, int choice3,
+		   struct gameState *state, int handPos, int *bonus);
+void ref_PutSeed(long x);
+void ref_SelectStream(int index);
+
+#endif
+
+#endif
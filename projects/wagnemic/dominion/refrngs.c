@@ -0,0 +1,14 @@
+/* The course rngs.c keeps its streams in file statics (and has no static
+   functions).  Lockstep harness threads each replay their own games, so
+   the statics are made per thread.  The headers rngs.c includes are read
+   here first, before static is redefined, so that nothing the system
+   declares is affected; the include guards keep rngs.c from reading
+   them again.
+*/
+
+#include <stdio.h>
+#include <time.h>
+
+#define static static __thread
+#include REF_RNGS_C
+#undef static
@@ -0,0 +1,236 @@
+/* Result store query
+
+   Computes win rates per player seat over a result store written by
+   batchsim, grouped by any columns and filtered by column values.
+
+   Usage: resq [-g column[,column...]] [-w column=value]... store
+   Columns: seed kingdom players turns winner strat0-3 score0-3 and
+            single cards of the buy vectors such as buys0:smithy
+*/
+
+#include "dominion.h"
+#include "results.h"
+#include "interface.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_GROUP_COLUMNS 4
+#define MAX_FILTERS 8
+
+struct columnRef {
+  int col;
+  int element;
+  char name[MAX_STRING_LENGTH];
+};
+
+struct group {
+  int used;
+  long key[MAX_GROUP_COLUMNS];
+  long games;
+  long wins[MAX_PLAYERS];
+  long ties;
+  long turns;
+};
+
+struct groupTable {
+  struct group *slots;
+  long capacity;
+  long size;
+};
+
+static int numKeys;
+
+static unsigned long hashKey(long *key) {
+  unsigned long h = 1469598103934665603UL;
+  int i;
+
+  for (i = 0; i < numKeys; i++) {
+    h ^= (unsigned long)key[i];
+    h *= 1099511628211UL;
+    h ^= h >> 29;
+  }
+  return h;
+}
+
+static struct group *findGroup(struct groupTable *t, long *key);
+
+static int growTable(struct groupTable *t) {
+  struct group *old = t->slots;
+  long oldCapacity = t->capacity;
+  struct group *g;
+  long i;
+
+  t->capacity = oldCapacity ? oldCapacity * 2 : 1024;
+  t->slots = calloc(t->capacity, sizeof(struct group));
+  if (t->slots == NULL)
+    return -1;
+  t->size = 0;
+  for (i = 0; i < oldCapacity; i++) {
+    if (!old[i].used)
+      continue;
+    g = findGroup(t, old[i].key);
+    *g = old[i];
+  }
+  free(old);
+  return 0;
+}
+
+static struct group *findGroup(struct groupTable *t, long *key) {
+  unsigned long i;
+
+  if ((t->size + 1) * 2 > t->capacity && growTable(t) < 0)
+    return NULL;
+  i = hashKey(key) & (t->capacity - 1);
+  while (t->slots[i].used) {
+    if (memcmp(t->slots[i].key, key, numKeys * sizeof(long)) == 0)
+      return &t->slots[i];
+    i = (i + 1) & (t->capacity - 1);
+  }
+  t->slots[i].used = 1;
+  memcpy(t->slots[i].key, key, sizeof(t->slots[i].key));
+  t->size++;
+  return &t->slots[i];
+}
+
+static int compareGroups(const void *a, const void *b) {
+  const struct group *x = a;
+  const struct group *y = b;
+  int i;
+
+  for (i = 0; i < numKeys; i++) {
+    if (x->key[i] != y->key[i])
+      return x->key[i] < y->key[i] ? -1 : 1;
+  }
+  return 0;
+}
+
+static int parseColumn(const char *text, struct columnRef *ref) {
+  ref->col = findResultColumn(text, &ref->element);
+  snprintf(ref->name, sizeof(ref->name), "%s", text);
+  if (ref->col < 0) {
+    printf("Unknown column %s\n", text);
+    return -1;
+  }
+  return 0;
+}
+
+static void usage(void) {
+  printf("Usage: resq [-g column[,column...]] [-w column=value]... store\n");
+}
+
+int main(int argc, char **argv) {
+  struct columnRef keys[MAX_GROUP_COLUMNS];
+  struct columnRef filters[MAX_FILTERS];
+  long filterValues[MAX_FILTERS];
+  int numFilters = 0;
+  struct groupTable table = {NULL, 0, 0};
+  struct resultStore *store;
+  struct group *g;
+  long key[MAX_GROUP_COLUMNS] = {0};
+  long row;
+  long n;
+  int maxPlayers = 2;
+  int winner;
+  int opt;
+  int i;
+  char *token;
+  char *eq;
+
+  while ((opt = getopt(argc, argv, "g:w:")) != -1) {
+    switch (opt) {
+    case 'g':
+      for (token = strtok(optarg, ","); token != NULL; token = strtok(NULL, ",")) {
+	if (numKeys == MAX_GROUP_COLUMNS || parseColumn(token, &keys[numKeys]) < 0)
+	  return 1;
+	numKeys++;
+      }
+      break;
+    case 'w':
+      eq = strchr(optarg, '=');
+      if (eq == NULL || numFilters == MAX_FILTERS) {
+	usage();
+	return 1;
+      }
+      *eq = '\0';
+      if (parseColumn(optarg, &filters[numFilters]) < 0)
+	return 1;
+      filterValues[numFilters++] = strtol(eq + 1, NULL, 0);
+      break;
+    default:
+      usage();
+      return 1;
+    }
+  }
+  if (optind != argc - 1) {
+    usage();
+    return 1;
+  }
+
+  store = openResultStore(argv[optind]);
+  if (store == NULL) {
+    printf("Could not open result store %s\n", argv[optind]);
+    return 1;
+  }
+
+  for (row = 0; row < store->rows; row++) {
+    for (i = 0; i < numFilters; i++) {
+      if (resultValue(store, filters[i].col, filters[i].element, row)
+	  != filterValues[i])
+	break;
+    }
+    if (i < numFilters)
+      continue;
+    for (i = 0; i < numKeys; i++)
+      key[i] = resultValue(store, keys[i].col, keys[i].element, row);
+    g = findGroup(&table, key);
+    if (g == NULL) {
+      printf("Out of memory\n");
+      return 1;
+    }
+    winner = (int)resultValue(store, COL_WINNER, 0, row);
+    g->games++;
+    g->turns += resultValue(store, COL_TURNS, 0, row);
+    if (__builtin_popcount(winner) > 1)
+      g->ties++;
+    else if (winner)
+      g->wins[__builtin_ctz(winner)]++;
+    n = resultValue(store, COL_PLAYERS, 0, row);
+    if (n > maxPlayers && n <= MAX_PLAYERS)
+      maxPlayers = (int)n;
+  }
+
+  //compact the used slots to the front and print them in key order
+  n = 0;
+  for (row = 0; row < table.capacity; row++) {
+    if (table.slots[row].used)
+      table.slots[n++] = table.slots[row];
+  }
+  qsort(table.slots, n, sizeof(struct group), compareGroups);
+
+  for (i = 0; i < numKeys; i++)
+    printf("%-12s ", keys[i].name);
+  printf("%10s", "games");
+  for (i = 0; i < maxPlayers; i++)
+    printf("   win%%%d", i);
+  printf("    tie%%  turns\n");
+  for (row = 0; row < n; row++) {
+    g = &table.slots[row];
+    for (i = 0; i < numKeys; i++) {
+      if (keys[i].col == COL_KINGDOM)
+	printf("%-12lx ", g->key[i]);
+      else
+	printf("%-12ld ", g->key[i]);
+    }
+    printf("%10ld", g->games);
+    for (i = 0; i < maxPlayers; i++)
+      printf(" %7.2f", 100.0 * g->wins[i] / g->games);
+    printf(" %7.2f %6.2f\n", 100.0 * g->ties / g->games,
+	   (double)g->turns / g->games);
+  }
+
+  free(table.slots);
+  closeResultStore(store);
+  return 0;
+}
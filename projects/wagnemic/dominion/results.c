@@ -0,0 +1,270 @@
+#include "results.h"
+#include "kingdom.h"
+#include "interface.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define ROW_BUFFER 4096
+
+struct resultWriter {
+  FILE *files[NUM_RESULT_COLUMNS];
+  struct columnInfo info[NUM_RESULT_COLUMNS];
+  unsigned char *buffers[NUM_RESULT_COLUMNS];
+  int buffered;
+  int failed;
+};
+
+void resultColumnInfo(int col, struct columnInfo *info) {
+  info->count = 1;
+  info->isSigned = 0;
+  if (col >= COL_BUYS0) {
+    snprintf(info->name, MAX_COLUMN_NAME, "buys%d", col - COL_BUYS0);
+    info->width = 1;
+    info->count = treasure_map + 1;
+  } else if (col >= COL_SCORE0) {
+    snprintf(info->name, MAX_COLUMN_NAME, "score%d", col - COL_SCORE0);
+    info->width = 2;
+    info->isSigned = 1;
+  } else if (col >= COL_STRAT0) {
+    snprintf(info->name, MAX_COLUMN_NAME, "strat%d", col - COL_STRAT0);
+    info->width = 1;
+    info->isSigned = 1;
+  } else {
+    switch (col) {
+    case COL_SEED: strcpy(info->name, "seed"); info->width = 4; break;
+    case COL_KINGDOM: strcpy(info->name, "kingdom"); info->width = 4; break;
+    case COL_PLAYERS: strcpy(info->name, "players"); info->width = 1; break;
+    case COL_TURNS: strcpy(info->name, "turns"); info->width = 2; break;
+    default: strcpy(info->name, "winner"); info->width = 1; break;
+    }
+  }
+}
+
+static void columnPath(const char *dir, struct columnInfo *info, char *path,
+		       int size) {
+  snprintf(path, size, "%s/%s.col", dir, info->name);
+}
+
+static void fillHeader(struct columnInfo *info, unsigned char *header) {
+  memset(header, 0, COLUMN_HEADER_SIZE);
+  memcpy(header, COLUMN_MAGIC, 4);
+  header[4] = info->width;
+  header[5] = info->isSigned;
+  header[6] = info->count;
+}
+
+static long rowBytes(struct columnInfo *info) {
+  return (long)info->width * info->count;
+}
+
+static void putValue(unsigned char *p, struct columnInfo *info, long value) {
+  int bits = 8 * info->width;
+  long low = info->isSigned ? -(1L << (bits - 1)) : 0;
+  long high = info->isSigned ? (1L << (bits - 1)) - 1 : (1L << bits) - 1;
+  int i;
+
+  //values are clamped to the column's range instead of wrapping
+  if (value < low) value = low;
+  if (value > high) value = high;
+  for (i = 0; i < info->width; i++)
+    p[i] = (unsigned char)((unsigned long)value >> (8 * i));
+}
+
+static int flushRows(struct resultWriter *w) {
+  int col;
+
+  for (col = 0; col < NUM_RESULT_COLUMNS; col++) {
+    if (w->buffered > 0
+	&& fwrite(w->buffers[col], rowBytes(&w->info[col]), w->buffered,
+		  w->files[col]) != (size_t)w->buffered)
+      w->failed = 1;
+    if (fflush(w->files[col]) != 0)
+      w->failed = 1;
+  }
+  w->buffered = 0;
+  return w->failed ? -1 : 0;
+}
+
+struct resultWriter *openResultWriter(const char *dir) {
+  struct resultWriter *w;
+  unsigned char header[COLUMN_HEADER_SIZE];
+  unsigned char expected[COLUMN_HEADER_SIZE];
+  char path[1024];
+  struct stat st;
+  long rows[NUM_RESULT_COLUMNS];
+  long minRows = -1;
+  int col;
+
+  if (mkdir(dir, 0777) != 0 && errno != EEXIST)
+    return NULL;
+  w = calloc(1, sizeof(struct resultWriter));
+  if (w == NULL)
+    return NULL;
+
+  for (col = 0; col < NUM_RESULT_COLUMNS; col++) {
+    resultColumnInfo(col, &w->info[col]);
+    fillHeader(&w->info[col], expected);
+    columnPath(dir, &w->info[col], path, sizeof(path));
+    w->buffers[col] = malloc(ROW_BUFFER * rowBytes(&w->info[col]));
+    w->files[col] = fopen(path, "ab+");
+    if (w->buffers[col] == NULL || w->files[col] == NULL
+	|| fstat(fileno(w->files[col]), &st) != 0)
+      goto fail;
+
+    if (st.st_size == 0) {
+      if (fwrite(expected, COLUMN_HEADER_SIZE, 1, w->files[col]) != 1)
+	goto fail;
+      rows[col] = 0;
+    } else {
+      rewind(w->files[col]);
+      if (fread(header, COLUMN_HEADER_SIZE, 1, w->files[col]) != 1
+	  || memcmp(header, expected, COLUMN_HEADER_SIZE) != 0)
+	goto fail;  //not a column of this format
+      rows[col] = (st.st_size - COLUMN_HEADER_SIZE) / rowBytes(&w->info[col]);
+    }
+    if (minRows < 0 || rows[col] < minRows)
+      minRows = rows[col];
+  }
+
+  //drop partial rows left by an interrupted writer
+  for (col = 0; col < NUM_RESULT_COLUMNS; col++) {
+    fflush(w->files[col]);
+    if (ftruncate(fileno(w->files[col]), COLUMN_HEADER_SIZE
+		  + minRows * rowBytes(&w->info[col])) != 0)
+      goto fail;
+    fseek(w->files[col], 0, SEEK_END);
+  }
+  return w;
+
+ fail:
+  for (col = 0; col < NUM_RESULT_COLUMNS; col++) {
+    if (w->files[col] != NULL)
+      fclose(w->files[col]);
+    free(w->buffers[col]);
+  }
+  free(w);
+  return NULL;
+}
+
+int appendResult(struct resultWriter *w, struct simResult *r) {
+  int row = w->buffered;
+  int i;
+  int card;
+
+  putValue(w->buffers[COL_SEED] + row * 4, &w->info[COL_SEED], r->seed);
+  putValue(w->buffers[COL_KINGDOM] + row * 4, &w->info[COL_KINGDOM],
+	   kingdomMask(r->kingdom));
+  putValue(w->buffers[COL_PLAYERS] + row, &w->info[COL_PLAYERS],
+	   r->numPlayers);
+  putValue(w->buffers[COL_TURNS] + row * 2, &w->info[COL_TURNS], r->turns);
+  putValue(w->buffers[COL_WINNER] + row, &w->info[COL_WINNER], r->winners);
+  for (i = 0; i < MAX_PLAYERS; i++) {
+    putValue(w->buffers[COL_STRAT0 + i] + row, &w->info[COL_STRAT0 + i],
+	     i < r->numPlayers ? r->strategies[i].action : -1);
+    putValue(w->buffers[COL_SCORE0 + i] + row * 2, &w->info[COL_SCORE0 + i],
+	     i < r->numPlayers ? r->scores[i] : 0);
+    for (card = 0; card <= treasure_map; card++)
+      putValue(w->buffers[COL_BUYS0 + i] + row * (treasure_map + 1) + card,
+	       &w->info[COL_BUYS0 + i], i < r->numPlayers ? r->buys[i][card] : 0);
+  }
+
+  w->buffered++;
+  if (w->buffered == ROW_BUFFER)
+    return flushRows(w);
+  return w->failed ? -1 : 0;
+}
+
+int closeResultWriter(struct resultWriter *w) {
+  int result = flushRows(w);
+  int col;
+
+  for (col = 0; col < NUM_RESULT_COLUMNS; col++) {
+    if (fclose(w->files[col]) != 0)
+      result = -1;
+    free(w->buffers[col]);
+  }
+  free(w);
+  return result;
+}
+
+struct resultStore *openResultStore(const char *dir) {
+  struct resultStore *s = calloc(1, sizeof(struct resultStore));
+  unsigned char expected[COLUMN_HEADER_SIZE];
+  char path[1024];
+  struct stat st;
+  long rows;
+  int fd;
+  int col;
+
+  if (s == NULL)
+    return NULL;
+  s->rows = -1;
+  for (col = 0; col < NUM_RESULT_COLUMNS; col++) {
+    resultColumnInfo(col, &s->info[col]);
+    fillHeader(&s->info[col], expected);
+    columnPath(dir, &s->info[col], path, sizeof(path));
+    fd = open(path, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0 || st.st_size < COLUMN_HEADER_SIZE) {
+      if (fd >= 0)
+	close(fd);
+      closeResultStore(s);
+      return NULL;
+    }
+    s->mapSizes[col] = st.st_size;
+    s->maps[col] = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (s->maps[col] == MAP_FAILED
+	|| memcmp(s->maps[col], expected, COLUMN_HEADER_SIZE) != 0) {
+      if (s->maps[col] == MAP_FAILED)
+	s->maps[col] = NULL;
+      closeResultStore(s);
+      return NULL;
+    }
+    //scans are sequential, let the kernel read ahead aggressively
+    madvise(s->maps[col], st.st_size, MADV_SEQUENTIAL);
+    s->data[col] = (const unsigned char *)s->maps[col] + COLUMN_HEADER_SIZE;
+    rows = (st.st_size - COLUMN_HEADER_SIZE) / rowBytes(&s->info[col]);
+    if (s->rows < 0 || rows < s->rows)
+      s->rows = rows;
+  }
+  return s;
+}
+
+void closeResultStore(struct resultStore *s) {
+  int col;
+
+  if (s == NULL)
+    return;
+  for (col = 0; col < NUM_RESULT_COLUMNS; col++) {
+    if (s->maps[col] != NULL)
+      munmap(s->maps[col], s->mapSizes[col]);
+  }
+  free(s);
+}
+
+int findResultColumn(const char *name, int *element) {
+  struct columnInfo info;
+  const char *colon = strchr(name, ':');
+  int len = colon ? (int)(colon - name) : (int)strlen(name);
+  int col;
+
+  *element = 0;
+  for (col = 0; col < NUM_RESULT_COLUMNS; col++) {
+    resultColumnInfo(col, &info);
+    if ((int)strlen(info.name) != len || strncmp(info.name, name, len) != 0)
+      continue;
+    if (info.count == 1)
+      return colon ? -1 : col;
+    if (colon == NULL)
+      return -1;
+    *element = cardNameToNum(colon + 1);
+    return *element >= 0 && *element < info.count ? col : -1;
+  }
+  return -1;
+}
@@ -0,0 +1,83 @@
+/* Columnar result store
+
+   A store is a directory with one file per column.  Each file is a
+   16 byte header followed by one fixed-width little-endian value (or a
+   fixed-length vector of values) per game, so row r of a column lives
+   at header + r * width * count and readers can mmap the files and scan
+   them without parsing.  Files are only ever appended to; the number of
+   complete rows is the smallest row count over all columns.
+*/
+
+#ifndef _RESULTS_H
+#define _RESULTS_H
+
+#include "dominion.h"
+#include "simulate.h"
+
+#define COLUMN_MAGIC "DCL1"
+#define COLUMN_HEADER_SIZE 16
+#define MAX_COLUMN_NAME 16
+
+enum RESULT_COLUMN {
+  COL_SEED = 0,
+  COL_KINGDOM,     /* kingdomMask() of the 10 cards */
+  COL_PLAYERS,
+  COL_TURNS,
+  COL_WINNER,      /* bit i set if player i won */
+  COL_STRAT0,      /* action card of player i's strategy, -1 big money */
+  COL_SCORE0 = COL_STRAT0 + MAX_PLAYERS,
+  COL_BUYS0 = COL_SCORE0 + MAX_PLAYERS, /* vector: buys per enum CARD */
+  NUM_RESULT_COLUMNS = COL_BUYS0 + MAX_PLAYERS
+};
+
+struct columnInfo {
+  char name[MAX_COLUMN_NAME];
+  int width;      /* bytes per value: 1, 2 or 4 */
+  int isSigned;
+  int count;      /* values per row, 1 for scalar columns */
+};
+
+void resultColumnInfo(int col, struct columnInfo *info);
+
+struct resultWriter;
+
+struct resultWriter *openResultWriter(const char *dir);
+/* Create the store or open it for appending; NULL on failure */
+
+int appendResult(struct resultWriter *w, struct simResult *r);
+int closeResultWriter(struct resultWriter *w);
+/* Flushes buffered rows; both return -1 on a write error */
+
+struct resultStore {
+  long rows;
+  const unsigned char *data[NUM_RESULT_COLUMNS];  /* first row of column */
+  struct columnInfo info[NUM_RESULT_COLUMNS];
+  void *maps[NUM_RESULT_COLUMNS];
+  long mapSizes[NUM_RESULT_COLUMNS];
+};
+
+struct resultStore *openResultStore(const char *dir);
+/* mmap every column read-only; NULL on failure */
+
+void closeResultStore(struct resultStore *s);
+
+int findResultColumn(const char *name, int *element);
+/* "turns", "score1", or "buys0:smithy" for one element of a vector
+   column; returns the column or -1 */
+
+static inline long resultValue(struct resultStore *s, int col, int element,
+			       long row) {
+  int width = s->info[col].width;
+  const unsigned char *p = s->data[col]
+    + ((long)row * s->info[col].count + element) * width;
+  unsigned long v = 0;
+  int i;
+
+  for (i = width - 1; i >= 0; i--)
+    v = (v << 8) | p[i];
+  if (s->info[col].isSigned && (v >> (8 * width - 1)) != 0)
+    return (long)v - (1L << (8 * width));
+  return (long)v;
+}
+
+#endif
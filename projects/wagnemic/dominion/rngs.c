@@ -43,9 +43,11 @@
 #define A256       22925      /* jump multiplier, DON'T CHANGE THIS VALUE */
 #define DEFAULT    123456789  /* initial seed, use 0 < DEFAULT < MODULUS  */
       
-static long seed[STREAMS] = {DEFAULT};  /* current state of each stream   */
-static int  stream        = 0;          /* stream index, 0 is the default */
-static int  initialized   = 0;          /* test for stream initialization */
+/* Each thread gets its own set of streams so that simulations running   */
+/* on several threads stay deterministic per seed.                       */
+static __thread long seed[STREAMS] = {DEFAULT};  /* state of each stream */
+static __thread int  stream        = 0;          /* stream index         */
+static __thread int  initialized   = 0;          /* streams planted yet? */
 
 
    double Random(void)
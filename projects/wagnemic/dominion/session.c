@@ -0,0 +1,351 @@
+#include "session.h"
+#include "dominion_helpers.h"
+#include "binproto.h"
+#include "interface.h"
+#include "rngs.h"
+#include <stdio.h>
+#include <string.h>
+
+//a command that hands the game to bots returns after this many turns
+#define SESSION_MAX_BOT_TURNS 10000
+
+//Default cards, as defined in playDom
+static const int defaultKingdom[10] = {adventurer, gardens, embargo, village,
+				       minion, mine, cutpurse, sea_hag,
+				       tribute, smithy};
+
+//what player's loop did before each prompt
+static int settle(struct session *s, struct outBuf *out) {
+  struct gameState *g = &s->game;
+  int players[MAX_PLAYERS];
+  int botTurns = 0;
+  int i;
+
+  while (s->started) {
+    if (isGameOver(g)) {
+      renderScores(out, g);
+      getWinners(players, g);
+      outPrintf(out, "After %d turns, the winner(s) are:\n", s->turnNum);
+      for (i = 0; i < g->numPlayers; i++) {
+	if (players[i] == WINNER)
+	  outPrintf(out, "Player %d\n", i);
+      }
+      for (i = 0; i < g->numPlayers; i++) {
+	renderHand(out, i, g);
+	renderPlayed(out, i, g);
+	renderDiscard(out, i, g);
+	renderDeck(out, i, g);
+      }
+      return 1;
+    }
+    if (!s->isBot[whoseTurn(g)])
+      break;
+    if (botTurns++ == SESSION_MAX_BOT_TURNS) {
+      outPrintf(out, "Bots stopped after %d turns\n", SESSION_MAX_BOT_TURNS);
+      return 1;
+    }
+    playBotTurn(whoseTurn(g), &s->turnNum, g, s->quietBots ? NULL : out);
+  }
+  return 0;
+}
+
+int sessionStart(struct session *s, int seed, struct outBuf *out) {
+  memset(s, 0, sizeof(struct session));
+  memcpy(s->kingdom, defaultKingdom, sizeof(s->kingdom));
+  s->seed = seed;
+  if (seed <= 0 || initializeGame(2, s->kingdom, seed, &s->game) < 0)
+    return -1;
+  SelectStream(1);
+  GetSeed(&s->rng);
+  outPrintf(out, "Please enter a command or \"help\" for commands\n");
+  return 0;
+}
+
+//only the first four letters of a command count, as in player
+static const char *opNames[NUM_SESSION_OPS] = {
+  "", "add", "buy", "end", "exit", "help", "init", "num", "play", "resi",
+  "show", "stat", "supp", "whos", "feed"
+};
+
+static int isSupplyCard(int card) {
+  return card >= curse && card <= treasure_map;
+}
+
+static int isHandPos(int pos, int player, struct gameState *g) {
+  return pos >= 0 && pos < g->handCount[player];
+}
+
+static int isFlag(int choice) {
+  return choice == 0 || choice == 1;
+}
+
+//whether the choices mean something for card; cardEffect indexes the
+//supply and the hand with them unchecked, and feast waits for its
+//choice to be affordable
+static int validChoices(int card, int choice1, int choice2, int choice3,
+			struct gameState *g) {
+  int player = whoseTurn(g);
+
+  switch (card) {
+  case feast:
+    return isSupplyCard(choice1) && supplyCount(choice1, g) > 0
+      && getCost(choice1) <= 5;
+  case mine:
+  case remodel:
+    return isHandPos(choice1, player, g) && isSupplyCard(choice2);
+  case baron:
+    return isFlag(choice1);
+  case minion:
+    return isFlag(choice1) && (choice1 || isFlag(choice2));
+  case steward:
+    if (choice1 == 1 || choice1 == 2)
+      return 1;
+    return choice1 == 3 && isHandPos(choice2, player, g)
+      && isHandPos(choice3, player, g);
+  case ambassador:
+  case salvager:
+    return isHandPos(choice1, player, g);
+  case embargo:
+    return isSupplyCard(choice1);
+  default:
+    return 1;
+  }
+}
+
+static int runMove(struct session *s, struct sessionMove *m,
+		   struct outBuf *out) {
+  struct gameState *g = &s->game;
+  int *arg = m->args;
+  int current = whoseTurn(g);
+  int card;
+  int i;
+
+  m->outcome = SUCCESS;
+  switch (m->op) {
+  case SESSION_ADD:
+    m->outcome = FAILURE;
+    if (g->handCount[current] < MAX_HAND && isSupplyCard(arg[0]))
+      m->outcome = addCardToHand(current, arg[0], g);
+    outPrintf(out, "Player %d adds %s to their hand\n\n", current,
+	      cardName(arg[0]));
+    break;
+  case SESSION_BUY:
+    m->outcome = FAILURE;
+    if (isSupplyCard(arg[0]))
+      m->outcome = buyCard(arg[0], g);
+    outPrintf(out, "Player %d %s card %d, %s\n\n", current,
+	      m->outcome == SUCCESS ? "buys" : "cannot buy", arg[0],
+	      cardName(arg[0]));
+    break;
+  case SESSION_END:
+    if (!s->started) {
+      m->outcome = FAILURE;
+      break;
+    }
+    if (current == g->numPlayers - 1)
+      s->turnNum++;
+    endTurn(g);
+    outPrintf(out, "Player %d's turn number %d\n\n", whoseTurn(g),
+	      s->turnNum);
+    break;
+  case SESSION_EXIT:
+    return 1;
+  case SESSION_HELP:
+    renderHelp(out);
+    break;
+  case SESSION_INIT:
+    if (arg[0] >= 2 && arg[0] <= MAX_PLAYERS && arg[1] >= 0
+	&& arg[1] <= arg[0]) {
+      for (i = arg[0] - arg[1]; i < arg[0]; i++)
+	s->isBot[i] = TRUE;
+    }
+    m->outcome = initializeGame(arg[0], s->kingdom, s->seed, g);
+    outPrintf(out, "\n");
+    if (m->outcome == SUCCESS) {
+      s->started = TRUE;
+      outPrintf(out, "Player %d's turn number %d\n\n", whoseTurn(g),
+		s->turnNum);
+    }
+    break;
+  case SESSION_NUM:
+    outPrintf(out, "There are %d cards in your hand.\n", numHandCards(g));
+    break;
+  case SESSION_PLAY:
+    m->outcome = FAILURE;
+    if (isHandPos(arg[0], current, g)) {
+      card = handCard(arg[0], g);
+      if (validChoices(card, arg[1], arg[2], arg[3], g))
+	m->outcome = playCard(arg[0], arg[1], arg[2], arg[3], g);
+    }
+    if (m->outcome == SUCCESS)
+      outPrintf(out, "Player %d plays %s\n\n", current, cardName(card));
+    else
+      outPrintf(out, "Player %d cannot play card %d\n\n", current, arg[0]);
+    break;
+  case SESSION_RESIGN:
+    endTurn(g);
+    renderScores(out, g);
+    return 1;
+  case SESSION_SHOW:
+    if (s->started) {
+      renderHand(out, current, g);
+      renderPlayed(out, current, g);
+    }
+    break;
+  case SESSION_STAT:
+    if (s->started)
+      renderState(out, g);
+    break;
+  case SESSION_SUPPLY:
+    renderSupply(out, g);
+    break;
+  case SESSION_WHOS:
+    outPrintf(out, "Player %d's turn\n", whoseTurn(g));
+    break;
+  case SESSION_FEED:
+    //domserver does the streaming; the game itself is untouched
+    break;
+  }
+  return settle(s, out);
+}
+
+int sessionRun(struct session *s, struct sessionMove *m, struct outBuf *out) {
+  int over;
+
+  //this session's draws continue its own stream, whatever ran in between
+  SelectStream(1);
+  PutSeed(s->rng);
+  s->commands++;
+  over = runMove(s, m, out);
+  SelectStream(1);
+  GetSeed(&s->rng);
+  return over;
+}
+
+int sessionCommand(struct session *s, const char *line, struct outBuf *out) {
+  char command[MAX_STRING_LENGTH] = "";
+  struct sessionMove m;
+  int op;
+
+  m.args[0] = m.args[1] = m.args[2] = m.args[3] = UNUSED;
+  sscanf(line, "%31s %d %d %d %d", command, &m.args[0], &m.args[1],
+	 &m.args[2], &m.args[3]);
+  m.op = SESSION_NONE;
+  for (op = SESSION_ADD; op < NUM_SESSION_OPS; op++) {
+    if (COMPARE(command, opNames[op]) == 0) {
+      m.op = op;
+      break;
+    }
+  }
+  return sessionRun(s, &m, out);
+}
+
+//copies the line at text into line, returning where the next one starts
+static const char *scriptLine(const char *text, const char *end, char *line,
+			      int size) {
+  const char *stop = memchr(text, '\n', end - text);
+  int len;
+
+  if (stop == NULL)
+    stop = end;
+  len = stop - text;
+  if (len > 0 && text[len - 1] == '\r')
+    len--;
+  if (len > size - 1)
+    len = size - 1;
+  memcpy(line, text, len);
+  line[len] = '\0';
+  return stop < end ? stop + 1 : end;
+}
+
+static int isExpect(const char *line) {
+  return strncmp(line, "expect", 6) == 0
+    && (line[6] == ' ' || line[6] == '\0');
+}
+
+static void reportFinal(struct session *s, const char *name, int expects,
+			int failed, struct outBuf *report) {
+  struct gameState *g = &s->game;
+  int i;
+
+  outPrintf(report, "%s: %ld commands, %d expects, %d failed; ", name,
+	    s->commands, expects, failed);
+  if (!s->started) {
+    outPrintf(report, "not started\n");
+    return;
+  }
+  if (isGameOver(g))
+    outPrintf(report, "game over after %d turns, scores", s->turnNum);
+  else
+    outPrintf(report, "turn %d, player %d to move, scores", s->turnNum,
+	      whoseTurn(g));
+  for (i = 0; i < g->numPlayers; i++)
+    outPrintf(report, " %d", scoreFor(i, g));
+  outPrintf(report, "\n");
+}
+
+int sessionScript(struct session *s, const char *text, int len,
+		  const char *name, struct outBuf *work, struct outBuf *report) {
+  const char *end = text + len;
+  char line[SESSION_SCRIPT_LINE];
+  char peek[SESSION_SCRIPT_LINE];
+  char last[SESSION_SCRIPT_LINE] = "";
+  const char *want;
+  int lineNum = 0;
+  int expects = 0;
+  int failed = 0;
+  int over = 0;
+
+  outClear(work);
+  while (text < end) {
+    text = scriptLine(text, end, line, sizeof(line));
+    lineNum++;
+    if (line[0] == '\0' || line[0] == '#')
+      continue;
+    if (isExpect(line)) {
+      want = line[6] == ' ' ? line + 7 : "";
+      expects++;
+      if (strstr(work->len > 0 ? work->data : "", want) == NULL) {
+	failed++;
+	outPrintf(report, "%s:%d: expected \"%s\" after \"%s\"\n", name,
+		  lineNum, want, last);
+      }
+      continue;
+    }
+    if (over)
+      continue;
+    //only render what a following expect will look at
+    scriptLine(text, end, peek, sizeof(peek));
+    outClear(work);
+    over = sessionCommand(s, line, isExpect(peek) ? work : NULL);
+    strcpy(last, line);
+  }
+  reportFinal(s, name, expects, failed, report);
+  return failed;
+}
+
+void sessionView(struct session *s, int *view) {
+  struct gameState *g = &s->game;
+  int current = whoseTurn(g);
+  int i;
+
+  view[VIEW_STARTED] = s->started;
+  view[VIEW_NUM_PLAYERS] = g->numPlayers;
+  view[VIEW_WHOSE_TURN] = current;
+  view[VIEW_TURN] = s->turnNum;
+  view[VIEW_PHASE] = g->phase;
+  view[VIEW_ACTIONS] = g->numActions;
+  view[VIEW_COINS] = g->coins;
+  view[VIEW_BUYS] = g->numBuys;
+  view[VIEW_PLAYED_COUNT] = g->playedCardCount;
+  for (i = 0; i < MAX_PLAYERS; i++) {
+    view[VIEW_SCORE + i] = i < g->numPlayers ? scoreFor(i, g) : 0;
+    view[VIEW_DECK_COUNT + i] = g->deckCount[i];
+    view[VIEW_DISCARD_COUNT + i] = g->discardCount[i];
+    view[VIEW_HAND_COUNT + i] = g->handCount[i];
+  }
+  for (i = 0; i <= treasure_map; i++)
+    view[VIEW_SUPPLY + i] = g->supplyCount[i];
+  for (i = 0; i < MAX_HAND; i++)
+    view[VIEW_HAND + i] = i < g->handCount[current] ? g->hand[current][i] : -1;
+}
@@ -0,0 +1,86 @@
+/* Interactive game sessions
+
+   One session is one game driven by the text command set of player
+   (add, buy, end, exit, help, init, num, play, resign, show, stat, supp,
+   whos; only the first four letters count).  All output goes to an
+   outBuf, so the same session can sit behind stdin (player) or a
+   socket (domserver).  Each session keeps its own random number stream
+   state and swaps it in around every command, so many sessions can take
+   turns on one thread and each still plays out exactly as it would
+   alone.  Command arguments are range-checked before they reach the
+   engine, which trusts its callers: cards must be supply cards, and a
+   played card's choices must be the supply cards, hand positions or
+   flags that card takes them as.  A NULL outBuf runs commands
+   without rendering anything, for clients that read the state instead
+   (see binproto.h); quietBots does the same for bot turns alone, which
+   otherwise print the supply every turn.
+*/
+
+#ifndef _SESSION_H
+#define _SESSION_H
+
+#include "dominion.h"
+#include "outbuf.h"
+
+//what a command line asks for; domclient sends these as they are
+enum SESSION_OP {
+  SESSION_NONE = 0,    /* unknown command, only settles bot turns */
+  SESSION_ADD,         /* card */
+  SESSION_BUY,         /* card */
+  SESSION_END,
+  SESSION_EXIT,
+  SESSION_HELP,
+  SESSION_INIT,        /* players, bots */
+  SESSION_NUM,
+  SESSION_PLAY,        /* hand position, choice1..3 */
+  SESSION_RESIGN,
+  SESSION_SHOW,
+  SESSION_STAT,
+  SESSION_SUPPLY,
+  SESSION_WHOS,
+  SESSION_FEED,        /* binary clients: stream the whole state too */
+  NUM_SESSION_OPS
+};
+
+struct sessionMove {
+  int op;
+  int args[4];
+  int outcome;       /* set by sessionRun: 0, or -1 if refused */
+};
+
+struct session {
+  struct gameState game;
+  int kingdom[10];
+  int isBot[MAX_PLAYERS];
+  int seed;
+  long rng;          /* stream 1 state between commands */
+  int started;
+  int turnNum;
+  long commands;
+  int quietBots;     /* play bot turns without rendering them */
+};
+
+int sessionStart(struct session *s, int seed, struct outBuf *out);
+/* Sets up the default two player game and greets; seed must be > 0 */
+
+int sessionCommand(struct session *s, const char *line, struct outBuf *out);
+/* Runs one command line, then any bot turns that follow it, and reports
+   the scores and winners once the game is over.  Returns 1 when the
+   session has ended (exit, resign or game over), otherwise 0 */
+
+int sessionRun(struct session *s, struct sessionMove *m, struct outBuf *out);
+/* The same for a parsed command; out may be NULL to run it quietly */
+
+#define SESSION_SCRIPT_LINE 256
+
+int sessionScript(struct session *s, const char *text, int len,
+		  const char *name, struct outBuf *work, struct outBuf *report);
+/* Runs a whole script of command lines in a started session without
+   prompts or rendering.  Blank lines and lines starting with # are
+   skipped; "expect TEXT" checks that the output of the command before it
+   contains TEXT, and is the only reason that output is rendered (into
+   work).  Commands after the session ends are ignored.  Failed expects
+   and a final line with the command count and the game's turn and
+   scores go to report; returns the number of failed expects */
+
+#endif
@@ -0,0 +1,412 @@
+#include "shard.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <poll.h>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#define RING_SLOTS 256      /* power of two */
+#define SHARD_RETRIES 1     /* plain retries before a shard is split */
+
+enum SHARD_STATE {
+  SHARD_PENDING = 0,
+  SHARD_RUNNING,
+  SHARD_DONE,
+  SHARD_SPLIT,
+  SHARD_FAILED
+};
+
+struct shardReport {
+  long shard;
+  long result[SHARD_RESULT_MAX / sizeof(long)];
+};
+
+struct ringSlot {
+  long seq;
+  int owner;        /* pid of the worker filling it, 0 when none */
+  struct shardReport report;
+};
+
+//bounded multi-producer queue; slot seq says whose turn the slot is, and
+//a worker takes the slot's owner before it takes the tail, so a worker
+//killed halfway through a push always leaves its pid behind
+struct shardRing {
+  long head;
+  char pad1[56];
+  long tail;
+  char pad2[56];
+  struct ringSlot slots[RING_SLOTS];
+};
+
+struct shardMsg {
+  long shard;       /* -1 tells the worker to exit */
+  long firstSeed;
+  long games;
+};
+
+struct shard {
+  long firstSeed;
+  long games;
+  int attempts;
+  int state;
+};
+
+struct worker {
+  pid_t pid;
+  int fd;
+  long shard;       /* shard in flight, -1 when idle */
+  time_t started;
+};
+
+struct coordinator {
+  struct shardJob *job;
+  struct shardRing *ring;
+  struct shard *shards;
+  long numShards;
+  long capShards;
+  long *queue;      /* pending shard indices, FIFO */
+  long queueHead;
+  long queueTail;
+  long queueCap;
+  long remaining;   /* shards not yet done, split or failed */
+  struct worker *workers;
+  void *total;
+  struct shardStats *stats;
+};
+
+static void ringPush(struct shardRing *ring, struct shardReport *r) {
+  long pos = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+  int pid = getpid();
+  struct ringSlot *slot;
+  long seq;
+  int none;
+
+  while (1) {
+    slot = &ring->slots[pos & (RING_SLOTS - 1)];
+    seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+    if (seq == pos) {
+      none = 0;
+      if (!__atomic_compare_exchange_n(&slot->owner, &none, pid, 0,
+				       __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+	sched_yield();  //another worker is claiming it
+	pos = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+	continue;
+      }
+      if (__atomic_compare_exchange_n(&ring->tail, &pos, pos + 1, 0,
+				      __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+	break;
+      __atomic_store_n(&slot->owner, 0, __ATOMIC_RELEASE);
+    } else if (seq < pos) {
+      sched_yield();  //full, wait for the coordinator to drain
+      pos = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    } else {
+      pos = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    }
+  }
+  slot->report = *r;
+  __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+}
+
+static int ringPop(struct shardRing *ring, struct shardReport *r) {
+  long pos = ring->head;
+  struct ringSlot *slot = &ring->slots[pos & (RING_SLOTS - 1)];
+
+  if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != pos + 1)
+    return 0;
+  *r = slot->report;
+  __atomic_store_n(&slot->owner, 0, __ATOMIC_RELAXED);
+  __atomic_store_n(&slot->seq, pos + RING_SLOTS, __ATOMIC_RELEASE);
+  ring->head = pos + 1;
+  return 1;
+}
+
+//frees the slots a dead worker was part way through filling: one it had
+//taken the tail for is published empty, so the coordinator moves past it
+static void ringRelease(struct shardRing *ring, pid_t pid) {
+  long tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+  struct ringSlot *slot;
+  long seq;
+  int i;
+
+  for (i = 0; i < RING_SLOTS; i++) {
+    slot = &ring->slots[i];
+    seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&slot->owner, __ATOMIC_ACQUIRE) != pid
+	|| (seq & (RING_SLOTS - 1)) != i)
+      continue;  //not its slot, or already published
+    if (seq < tail) {
+      slot->report.shard = -1;
+      __atomic_store_n(&slot->seq, seq + 1, __ATOMIC_RELEASE);
+    } else {
+      __atomic_store_n(&slot->owner, 0, __ATOMIC_RELEASE);
+    }
+  }
+}
+
+static int readFull(int fd, void *buf, size_t size) {
+  size_t got = 0;
+  ssize_t n;
+
+  while (got < size) {
+    n = read(fd, (char *)buf + got, size - got);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return -1;
+    got += n;
+  }
+  return 0;
+}
+
+static void workerMain(int fd, struct shardRing *ring, struct shardJob *job) {
+  struct shardMsg m;
+  struct shardReport r;
+
+  while (readFull(fd, &m, sizeof(m)) == 0 && m.shard >= 0) {
+    memset(&r, 0, sizeof(r));
+    r.shard = m.shard;
+    job->play(job->arg, m.firstSeed, m.games, r.result);
+    ringPush(ring, &r);
+    if (write(fd, &m.shard, sizeof(m.shard)) != sizeof(m.shard))
+      break;
+  }
+  _exit(0);
+}
+
+static void *grow(void *p, long *cap, size_t size) {
+  *cap = *cap ? *cap * 2 : 64;
+  p = realloc(p, *cap * size);
+  if (p == NULL) {
+    perror("realloc");
+    exit(1);
+  }
+  return p;
+}
+
+static void enqueue(struct coordinator *c, long shard) {
+  if (c->queueTail == c->queueCap)
+    c->queue = grow(c->queue, &c->queueCap, sizeof(long));
+  c->shards[shard].state = SHARD_PENDING;
+  c->queue[c->queueTail++] = shard;
+}
+
+static long addShard(struct coordinator *c, long firstSeed, long games) {
+  if (c->numShards == c->capShards)
+    c->shards = grow(c->shards, &c->capShards, sizeof(struct shard));
+  c->shards[c->numShards].firstSeed = firstSeed;
+  c->shards[c->numShards].games = games;
+  c->shards[c->numShards].attempts = 0;
+  c->remaining++;
+  c->stats->shards++;
+  enqueue(c, c->numShards);
+  return c->numShards++;
+}
+
+static void drainRing(struct coordinator *c) {
+  struct shardReport r;
+
+  while (ringPop(c->ring, &r)) {
+    if (r.shard < 0 || r.shard >= c->numShards
+	|| c->shards[r.shard].state != SHARD_RUNNING)
+      continue;  //late report for a shard that was already given up on
+    c->shards[r.shard].state = SHARD_DONE;
+    c->job->merge(c->job->arg, c->total, r.result);
+    c->remaining--;
+  }
+}
+
+static void failShard(struct coordinator *c, long shard) {
+  struct shard *s = &c->shards[shard];
+  long firstSeed = s->firstSeed;
+  long half = s->games / 2;
+  long games = s->games;
+
+  c->stats->retries++;
+  if (++s->attempts <= SHARD_RETRIES) {
+    enqueue(c, shard);
+  } else if (games > 1) {
+    //split to isolate the seeds that crash
+    s->state = SHARD_SPLIT;
+    c->remaining--;
+    addShard(c, firstSeed, half);
+    addShard(c, firstSeed + half, games - half);
+  } else {
+    s->state = SHARD_FAILED;
+    c->remaining--;
+    if (c->stats->crashedSeeds == 0 || firstSeed < c->stats->firstCrashedSeed)
+      c->stats->firstCrashedSeed = firstSeed;
+    c->stats->crashedSeeds++;
+  }
+}
+
+static int spawnWorker(struct coordinator *c, int w) {
+  int sv[2];
+  pid_t pid;
+  int i;
+
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0)
+    return -1;
+  pid = fork();
+  if (pid < 0) {
+    close(sv[0]);
+    close(sv[1]);
+    return -1;
+  }
+  if (pid == 0) {
+    close(sv[0]);
+    for (i = 0; i < c->job->numWorkers; i++) {
+      if (i != w && c->workers[i].fd >= 0)
+	close(c->workers[i].fd);
+    }
+    workerMain(sv[1], c->ring, c->job);
+  }
+  close(sv[1]);
+  c->workers[w].pid = pid;
+  c->workers[w].fd = sv[0];
+  c->workers[w].shard = -1;
+  return 0;
+}
+
+static void reapWorker(struct coordinator *c, int w) {
+  struct worker *wk = &c->workers[w];
+
+  close(wk->fd);
+  waitpid(wk->pid, NULL, 0);
+  ringRelease(c->ring, wk->pid);
+  wk->fd = -1;
+  wk->pid = -1;
+  //a report pushed just before the crash still counts
+  drainRing(c);
+  if (wk->shard >= 0 && c->shards[wk->shard].state == SHARD_RUNNING)
+    failShard(c, wk->shard);
+  wk->shard = -1;
+}
+
+static void dispatch(struct coordinator *c, int w) {
+  struct worker *wk = &c->workers[w];
+  struct shardMsg m;
+  long shard;
+
+  if (wk->fd < 0 || wk->shard >= 0 || c->queueHead == c->queueTail)
+    return;
+  shard = c->queue[c->queueHead++];
+  m.shard = shard;
+  m.firstSeed = c->shards[shard].firstSeed;
+  m.games = c->shards[shard].games;
+  c->shards[shard].state = SHARD_RUNNING;
+  wk->shard = shard;
+  wk->started = time(NULL);
+  if (send(wk->fd, &m, sizeof(m), MSG_NOSIGNAL) != sizeof(m))
+    kill(wk->pid, SIGKILL);  //reaped as a crash on the next poll
+}
+
+//stops the workers, with a quit message or after a failure with SIGKILL,
+//and frees what the batch allocated
+static void finish(struct coordinator *c, struct pollfd *fds, int failed) {
+  struct shardMsg quit;
+  int w;
+
+  memset(&quit, 0, sizeof(quit));
+  quit.shard = -1;
+  for (w = 0; c->workers != NULL && w < c->job->numWorkers; w++) {
+    if (c->workers[w].fd < 0)
+      continue;
+    if (failed)
+      kill(c->workers[w].pid, SIGKILL);
+    else
+      send(c->workers[w].fd, &quit, sizeof(quit), MSG_NOSIGNAL);
+    close(c->workers[w].fd);
+    waitpid(c->workers[w].pid, NULL, 0);
+  }
+
+  if (c->ring != MAP_FAILED)
+    munmap(c->ring, sizeof(struct shardRing));
+  free(c->workers);
+  free(c->shards);
+  free(c->queue);
+  free(fds);
+}
+
+int runShardedBatch(struct shardJob *job, void *total,
+		    struct shardStats *stats) {
+  struct coordinator c;
+  struct pollfd *fds;
+  long seed;
+  long doneShard;
+  ssize_t n;
+  int w;
+
+  if (job->numWorkers < 1 || job->shardGames < 1 || job->resultSize < 0
+      || job->resultSize > SHARD_RESULT_MAX)
+    return -1;
+  memset(&c, 0, sizeof(c));
+  memset(stats, 0, sizeof(struct shardStats));
+  c.job = job;
+  c.total = total;
+  c.stats = stats;
+  c.ring = mmap(NULL, sizeof(struct shardRing), PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  c.workers = calloc(job->numWorkers, sizeof(struct worker));
+  fds = calloc(job->numWorkers, sizeof(struct pollfd));
+  for (w = 0; c.workers != NULL && w < job->numWorkers; w++)
+    c.workers[w].fd = -1;
+  if (c.ring == MAP_FAILED || c.workers == NULL || fds == NULL) {
+    finish(&c, fds, 1);
+    return -1;
+  }
+  for (w = 0; w < RING_SLOTS; w++)
+    c.ring->slots[w].seq = w;
+
+  for (seed = job->firstSeed; seed < job->firstSeed + job->games;
+       seed += job->shardGames)
+    addShard(&c, seed, seed + job->shardGames <= job->firstSeed + job->games
+	     ? job->shardGames : job->firstSeed + job->games - seed);
+
+  for (w = 0; w < job->numWorkers; w++) {
+    if (spawnWorker(&c, w) < 0) {
+      finish(&c, fds, 1);
+      return -1;
+    }
+  }
+
+  while (c.remaining > 0) {
+    for (w = 0; w < job->numWorkers; w++) {
+      if (c.workers[w].fd < 0 && c.queueHead != c.queueTail)
+	spawnWorker(&c, w);
+      dispatch(&c, w);
+      fds[w].fd = c.workers[w].fd;
+      fds[w].events = POLLIN;
+      fds[w].revents = 0;
+    }
+
+    if (poll(fds, job->numWorkers, 1000) < 0 && errno != EINTR)
+      break;
+    drainRing(&c);
+
+    for (w = 0; w < job->numWorkers; w++) {
+      if (c.workers[w].fd < 0)
+	continue;
+      if (fds[w].revents & (POLLIN | POLLHUP | POLLERR)) {
+	n = read(c.workers[w].fd, &doneShard, sizeof(doneShard));
+	if (n == sizeof(doneShard))
+	  c.workers[w].shard = -1;
+	else
+	  reapWorker(&c, w);
+      } else if (job->timeout > 0 && c.workers[w].shard >= 0
+		 && time(NULL) - c.workers[w].started > job->timeout) {
+	kill(c.workers[w].pid, SIGKILL);
+      }
+    }
+    drainRing(&c);
+  }
+
+  finish(&c, fds, 0);
+  return 0;
+}
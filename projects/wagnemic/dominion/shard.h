@@ -0,0 +1,48 @@
+/* Process-sharded batch runs
+
+   The coordinator forks worker processes, hands each one a seed range
+   (a shard) over a socketpair and collects the shard results (small
+   fixed-size structs the caller defines) through a ring buffer in
+   shared memory.  If a worker dies (the engine still has out-of-bounds
+   paths) or runs past the timeout, only its shard is lost: it is
+   retried once, then split in half until the seeds that crash are
+   isolated and reported.
+*/
+
+#ifndef _SHARD_H
+#define _SHARD_H
+
+#define SHARD_RESULT_MAX 256
+
+typedef int (*shardFn)(void *arg, long firstSeed, long games, void *result);
+/* Play games seeds from firstSeed on into result (resultSize bytes,
+   zeroed beforehand); runs inside a worker process */
+
+typedef void (*shardMergeFn)(void *arg, void *total, void *result);
+/* Fold one shard's result into the total; runs in the coordinator */
+
+struct shardJob {
+  int numWorkers;
+  long firstSeed;
+  long games;
+  long shardGames;   /* seeds per shard */
+  int timeout;       /* seconds per shard, 0 for none */
+  int resultSize;    /* at most SHARD_RESULT_MAX */
+  shardFn play;
+  shardMergeFn merge;
+  void *arg;
+};
+
+struct shardStats {
+  long shards;
+  long retries;
+  long crashedSeeds; /* seeds given up on after isolating them */
+  long firstCrashedSeed;
+};
+
+int runShardedBatch(struct shardJob *job, void *total,
+		    struct shardStats *stats);
+/* Returns 0 when every shard finished or was isolated, -1 on setup
+   failure */
+
+#endif
@@ -0,0 +1,366 @@
+/* Simulation coordinator
+
+   Splits a seed range into work units and leases them to simworker
+   processes over TCP.  A unit whose lease is not answered within the
+   timeout (or whose worker disconnects) is leased again; the first
+   result for a unit wins and later duplicates are dropped.  Results are
+   kept per unit and merged in unit order at the end, so the totals do
+   not depend on how many workers took part or in which order they
+   finished.
+
+   Usage: simcoord [-l port] [-w local workers] [-n games] [-s first seed]
+                   [-u unit games] [-t lease timeout] [-p players]
+                   [-a strategy] [-b strategy] [-k random]
+*/
+
+#include "dominion.h"
+#include "simulate.h"
+#include "simproto.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#define MAX_CONNS 256
+#define UNIT_GAMES 1000
+#define LEASE_TIMEOUT 30
+#define IN_BUFFER (4 * SIM_MAX_MESSAGE)
+
+enum UNIT_STATE {
+  UNIT_PENDING = 0,
+  UNIT_LEASED,
+  UNIT_DONE
+};
+
+struct unit {
+  long firstSeed;
+  long games;
+  int state;
+  time_t leasedAt;
+  struct simAggregate agg;
+};
+
+struct conn {
+  int fd;
+  int ready;        /* said HELLO and has the job */
+  long unit;        /* unit leased to this worker, -1 if idle */
+  unsigned char in[IN_BUFFER];
+  int inLen;
+};
+
+struct coord {
+  struct simJob job;
+  struct unit *units;
+  long numUnits;
+  long done;
+  long cursor;      /* no pending unit before this index */
+  long redispatched;
+  int timeout;
+  struct conn conns[MAX_CONNS];
+  int numConns;
+};
+
+static long nextPending(struct coord *c) {
+  while (c->cursor < c->numUnits && c->units[c->cursor].state != UNIT_PENDING)
+    c->cursor++;
+  return c->cursor < c->numUnits ? c->cursor : -1;
+}
+
+static void dropConn(struct coord *c, int i) {
+  struct conn *cn = &c->conns[i];
+
+  //give the lease back right away instead of waiting for the timeout
+  if (cn->unit >= 0 && c->units[cn->unit].state == UNIT_LEASED) {
+    c->units[cn->unit].state = UNIT_PENDING;
+    if (cn->unit < c->cursor)
+      c->cursor = cn->unit;
+    c->redispatched++;
+  }
+  close(cn->fd);
+  c->conns[i] = c->conns[--c->numConns];
+}
+
+static int lease(struct coord *c, struct conn *cn) {
+  struct simMessage m;
+  long u = nextPending(c);
+
+  if (u < 0)
+    return 0;
+  c->units[u].state = UNIT_LEASED;
+  c->units[u].leasedAt = time(NULL);
+  cn->unit = u;
+  m.type = MSG_LEASE;
+  m.count = 3;
+  m.fields[0] = u;
+  m.fields[1] = c->units[u].firstSeed;
+  m.fields[2] = c->units[u].games;
+  return sendSimMessage(cn->fd, &m);
+}
+
+static int handleMessage(struct coord *c, struct conn *cn, struct simMessage *m) {
+  struct simAggregate agg;
+  long u;
+
+  if (m->type == MSG_HELLO && !cn->ready) {
+    packSimJob(&c->job, m);
+    cn->ready = 1;
+    cn->unit = -1;
+    return sendSimMessage(cn->fd, m);
+  }
+  if (m->type != MSG_RESULT || unpackSimResult(m, &u, &agg) < 0
+      || u < 0 || u >= c->numUnits)
+    return -1;
+
+  if (c->units[u].state != UNIT_DONE) {
+    c->units[u].agg = agg;
+    c->units[u].state = UNIT_DONE;
+    c->done++;
+  }
+  if (cn->unit == u)
+    cn->unit = -1;
+  return 0;
+}
+
+static int readConn(struct coord *c, struct conn *cn) {
+  struct simMessage m;
+  ssize_t n;
+  int used;
+  int off = 0;
+
+  n = read(cn->fd, cn->in + cn->inLen, IN_BUFFER - cn->inLen);
+  if (n <= 0)
+    return n < 0 && errno == EINTR ? 0 : -1;
+  cn->inLen += n;
+  while ((used = decodeSimMessage(cn->in + off, cn->inLen - off, &m)) > 0) {
+    if (handleMessage(c, cn, &m) < 0)
+      return -1;
+    off += used;
+  }
+  if (used < 0)
+    return -1;
+  memmove(cn->in, cn->in + off, cn->inLen - off);
+  cn->inLen -= off;
+  return 0;
+}
+
+static void expireLeases(struct coord *c) {
+  time_t now = time(NULL);
+  long u;
+
+  for (u = 0; u < c->numUnits; u++) {
+    if (c->units[u].state == UNIT_LEASED
+	&& now - c->units[u].leasedAt > c->timeout) {
+      c->units[u].state = UNIT_PENDING;
+      if (u < c->cursor)
+	c->cursor = u;
+      c->redispatched++;
+    }
+  }
+}
+
+static int listenOn(int port) {
+  struct sockaddr_in addr;
+  int one = 1;
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+  if (fd < 0)
+    return -1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+  if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0
+      || listen(fd, 64) < 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static int boundPort(int fd) {
+  struct sockaddr_in addr;
+  socklen_t len = sizeof(addr);
+
+  if (getsockname(fd, (struct sockaddr *)&addr, &len) < 0)
+    return -1;
+  return ntohs(addr.sin_port);
+}
+
+static pid_t spawnLocalWorker(const char *self, int port) {
+  char path[1024];
+  char portText[16];
+  const char *slash = strrchr(self, '/');
+  pid_t pid;
+
+  //simworker is expected next to simcoord
+  if (slash != NULL)
+    snprintf(path, sizeof(path), "%.*ssimworker", (int)(slash - self + 1), self);
+  else
+    snprintf(path, sizeof(path), "simworker");
+  snprintf(portText, sizeof(portText), "%d", port);
+  pid = fork();
+  if (pid == 0) {
+    execlp(path, path, "127.0.0.1", portText, (char *)NULL);
+    perror(path);
+    _exit(1);
+  }
+  return pid;
+}
+
+static void usage(void) {
+  printf("Usage: simcoord [-l port] [-w local workers] [-n games] [-s first seed]\n"
+	 "                [-u unit games] [-t lease timeout] [-p players]\n"
+	 "                [-a strategy] [-b strategy] [-k random]\n");
+}
+
+int main(int argc, char **argv) {
+  static struct coord c;
+  struct pollfd fds[MAX_CONNS + 1];
+  struct simAggregate total;
+  struct simMessage done;
+  struct strategy a;
+  struct strategy other;
+  pid_t *local = NULL;
+  long numGames = 10000;
+  long firstSeed = 1;
+  long unitGames = UNIT_GAMES;
+  long u;
+  int port = SIM_DEFAULT_PORT;
+  int numLocal = 0;
+  int listenFd;
+  int fd;
+  int opt;
+  int i;
+  int k[10] = {adventurer, gardens, embargo, village, minion, mine, cutpurse,
+	       sea_hag, tribute, smithy};
+
+  c.job.numPlayers = 2;
+  c.timeout = LEASE_TIMEOUT;
+  memcpy(c.job.kingdom, k, sizeof(k));
+  parseStrategy("smithy", &a);
+  parseStrategy("adventurer", &other);
+
+  while ((opt = getopt(argc, argv, "l:w:n:s:u:t:p:a:b:k:")) != -1) {
+    switch (opt) {
+    case 'l': port = atoi(optarg); break;
+    case 'w': numLocal = atoi(optarg); break;
+    case 'n': numGames = atol(optarg); break;
+    case 's': firstSeed = atol(optarg); break;
+    case 'u': unitGames = atol(optarg); break;
+    case 't': c.timeout = atoi(optarg); break;
+    case 'p': c.job.numPlayers = atoi(optarg); break;
+    case 'a':
+    case 'b':
+      if (parseStrategy(optarg, opt == 'a' ? &a : &other) < 0) {
+	printf("Unknown strategy %s\n", optarg);
+	return 1;
+      }
+      break;
+    case 'k': c.job.randomKingdom = strcmp(optarg, "random") == 0; break;
+    default: usage(); return 1;
+    }
+  }
+  if (numGames < 1 || firstSeed < 1 || unitGames < 1 || c.timeout < 1
+      || c.job.numPlayers < 2 || c.job.numPlayers > MAX_PLAYERS
+      || numLocal < 0) {
+    usage();
+    return 1;
+  }
+  c.job.strategies[0] = a;
+  for (i = 1; i < c.job.numPlayers; i++)
+    c.job.strategies[i] = other;
+
+  c.numUnits = (numGames + unitGames - 1) / unitGames;
+  c.units = calloc(c.numUnits, sizeof(struct unit));
+  if (c.units == NULL)
+    return 1;
+  for (u = 0; u < c.numUnits; u++) {
+    c.units[u].firstSeed = firstSeed + u * unitGames;
+    c.units[u].games = u == c.numUnits - 1 ? numGames - u * unitGames : unitGames;
+  }
+
+  listenFd = listenOn(port);
+  if (listenFd < 0) {
+    perror("listen");
+    return 1;
+  }
+  port = boundPort(listenFd);
+  printf("Coordinator listening on port %d, %ld units\n", port, c.numUnits);
+  fflush(stdout);
+
+  if (numLocal > 0) {
+    local = calloc(numLocal, sizeof(pid_t));
+    for (i = 0; i < numLocal && local != NULL; i++)
+      local[i] = spawnLocalWorker(argv[0], port);
+  }
+
+  while (c.done < c.numUnits) {
+    fds[0].fd = listenFd;
+    fds[0].events = c.numConns < MAX_CONNS ? POLLIN : 0;
+    for (i = 0; i < c.numConns; i++) {
+      if (c.conns[i].ready && c.conns[i].unit < 0
+	  && lease(&c, &c.conns[i]) < 0) {
+	dropConn(&c, i--);
+	continue;
+      }
+      fds[i + 1].fd = c.conns[i].fd;
+      fds[i + 1].events = POLLIN;
+    }
+    if (poll(fds, c.numConns + 1, 1000) < 0 && errno != EINTR)
+      break;
+
+    //walk backwards so dropConn can move the last connection into slot i
+    for (i = c.numConns - 1; i >= 0; i--) {
+      if (fds[i + 1].revents && readConn(&c, &c.conns[i]) < 0)
+	dropConn(&c, i);
+    }
+    if (fds[0].revents & POLLIN) {
+      fd = accept(listenFd, NULL, NULL);
+      if (fd >= 0) {
+	opt = 1;
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+	memset(&c.conns[c.numConns], 0, sizeof(struct conn));
+	c.conns[c.numConns].fd = fd;
+	c.conns[c.numConns].unit = -1;
+	c.numConns++;
+      }
+    }
+    expireLeases(&c);
+  }
+
+  done.type = MSG_DONE;
+  done.count = 0;
+  for (i = 0; i < c.numConns; i++) {
+    sendSimMessage(c.conns[i].fd, &done);
+    close(c.conns[i].fd);
+  }
+  close(listenFd);
+  for (i = 0; i < numLocal && local != NULL; i++)
+    waitpid(local[i], NULL, 0);
+
+  //merge in unit order so the output is independent of the schedule
+  memset(&total, 0, sizeof(total));
+  for (u = 0; u < c.numUnits; u++)
+    mergeSimAggregate(&total, &c.units[u].agg);
+
+  printf("Units: %ld (%ld re-dispatched)\n", c.numUnits, c.redispatched);
+  printf("Games: %ld\n", total.games);
+  for (i = 0; i < c.job.numPlayers; i++)
+    printf("Player %d wins: %ld (%.1f%%), average score %.2f\n", i,
+	   total.wins[i], total.games ? 100.0 * total.wins[i] / total.games : 0.0,
+	   total.games ? (double)total.scores[i] / total.games : 0.0);
+  printf("Ties: %ld\nAverage turns: %.2f\n", total.ties,
+	 total.games ? (double)total.turns / total.games : 0.0);
+  free(c.units);
+  free(local);
+  return 0;
+}
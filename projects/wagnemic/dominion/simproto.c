@@ -0,0 +1,182 @@
+#include "simproto.h"
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#define JOB_FIELDS (2 + 10 + 2 * MAX_PLAYERS)
+#define RESULT_FIELDS (4 + 2 * MAX_PLAYERS)
+
+static void putBig(unsigned char *p, unsigned long v, int bytes) {
+  int i;
+
+  for (i = bytes - 1; i >= 0; i--) {
+    p[i] = (unsigned char)(v & 0xff);
+    v >>= 8;
+  }
+}
+
+static unsigned long getBig(const unsigned char *p, int bytes) {
+  unsigned long v = 0;
+  int i;
+
+  for (i = 0; i < bytes; i++)
+    v = (v << 8) | p[i];
+  return v;
+}
+
+int encodeSimMessage(struct simMessage *m, unsigned char *buf) {
+  int i;
+
+  putBig(buf, (unsigned long)m->type, 4);
+  putBig(buf + 4, (unsigned long)m->count, 4);
+  for (i = 0; i < m->count; i++)
+    putBig(buf + SIM_HEADER_SIZE + 8 * i, (unsigned long)m->fields[i], 8);
+  return SIM_HEADER_SIZE + 8 * m->count;
+}
+
+int decodeSimMessage(const unsigned char *buf, int size, struct simMessage *m) {
+  int i;
+
+  if (size < SIM_HEADER_SIZE)
+    return 0;
+  m->type = (int)getBig(buf, 4);
+  m->count = (int)getBig(buf + 4, 4);
+  if (m->count < 0 || m->count > SIM_MAX_FIELDS)
+    return -1;
+  if (size < SIM_HEADER_SIZE + 8 * m->count)
+    return 0;
+  for (i = 0; i < m->count; i++)
+    m->fields[i] = (long)getBig(buf + SIM_HEADER_SIZE + 8 * i, 8);
+  return SIM_HEADER_SIZE + 8 * m->count;
+}
+
+int sendSimMessage(int fd, struct simMessage *m) {
+  unsigned char buf[SIM_MAX_MESSAGE];
+  int size = encodeSimMessage(m, buf);
+  int sent = 0;
+  ssize_t n;
+
+  while (sent < size) {
+    n = send(fd, buf + sent, size - sent, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return -1;
+    sent += n;
+  }
+  return 0;
+}
+
+static int readFull(int fd, unsigned char *buf, int size) {
+  int got = 0;
+  ssize_t n;
+
+  while (got < size) {
+    n = read(fd, buf + got, size - got);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return -1;
+    got += n;
+  }
+  return 0;
+}
+
+int recvSimMessage(int fd, struct simMessage *m) {
+  unsigned char buf[SIM_MAX_MESSAGE];
+  int count;
+
+  if (readFull(fd, buf, SIM_HEADER_SIZE) < 0)
+    return -1;
+  count = (int)getBig(buf + 4, 4);
+  if (count < 0 || count > SIM_MAX_FIELDS
+      || readFull(fd, buf + SIM_HEADER_SIZE, 8 * count) < 0)
+    return -1;
+  return decodeSimMessage(buf, SIM_HEADER_SIZE + 8 * count, m) > 0 ? 0 : -1;
+}
+
+void packSimJob(struct simJob *job, struct simMessage *m) {
+  int i;
+
+  m->type = MSG_JOB;
+  m->count = JOB_FIELDS;
+  m->fields[0] = job->numPlayers;
+  m->fields[1] = job->randomKingdom;
+  for (i = 0; i < 10; i++)
+    m->fields[2 + i] = job->kingdom[i];
+  for (i = 0; i < MAX_PLAYERS; i++) {
+    m->fields[12 + 2 * i] = job->strategies[i].action;
+    m->fields[13 + 2 * i] = job->strategies[i].copies;
+  }
+}
+
+int unpackSimJob(struct simMessage *m, struct simJob *job) {
+  int i;
+
+  if (m->type != MSG_JOB || m->count != JOB_FIELDS)
+    return -1;
+  memset(job, 0, sizeof(struct simJob));
+  job->numPlayers = (int)m->fields[0];
+  job->randomKingdom = (int)m->fields[1];
+  for (i = 0; i < 10; i++)
+    job->kingdom[i] = (int)m->fields[2 + i];
+  for (i = 0; i < MAX_PLAYERS; i++) {
+    job->strategies[i].action = (int)m->fields[12 + 2 * i];
+    job->strategies[i].copies = (int)m->fields[13 + 2 * i];
+  }
+  if (job->numPlayers < 2 || job->numPlayers > MAX_PLAYERS)
+    return -1;
+  return 0;
+}
+
+void packSimResult(long unit, struct simAggregate *a, struct simMessage *m) {
+  int i;
+
+  m->type = MSG_RESULT;
+  m->count = RESULT_FIELDS;
+  m->fields[0] = unit;
+  m->fields[1] = a->games;
+  m->fields[2] = a->ties;
+  m->fields[3] = a->turns;
+  for (i = 0; i < MAX_PLAYERS; i++) {
+    m->fields[4 + i] = a->wins[i];
+    m->fields[4 + MAX_PLAYERS + i] = a->scores[i];
+  }
+}
+
+int unpackSimResult(struct simMessage *m, long *unit, struct simAggregate *a) {
+  int i;
+
+  if (m->type != MSG_RESULT || m->count != RESULT_FIELDS)
+    return -1;
+  *unit = m->fields[0];
+  a->games = m->fields[1];
+  a->ties = m->fields[2];
+  a->turns = m->fields[3];
+  for (i = 0; i < MAX_PLAYERS; i++) {
+    a->wins[i] = m->fields[4 + i];
+    a->scores[i] = m->fields[4 + MAX_PLAYERS + i];
+  }
+  return 0;
+}
+
+int runSimWorker(int fd) {
+  struct simMessage m;
+  struct simAggregate agg;
+  struct simJob job;
+
+  m.type = MSG_HELLO;
+  m.count = 0;
+  if (sendSimMessage(fd, &m) < 0 || recvSimMessage(fd, &m) < 0
+      || unpackSimJob(&m, &job) < 0)
+    return -1;
+  while (recvSimMessage(fd, &m) == 0 && m.type == MSG_LEASE && m.count == 3) {
+    memset(&agg, 0, sizeof(agg));
+    simulateSeeds(&job, m.fields[1], m.fields[2], &agg);
+    packSimResult(m.fields[0], &agg, &m);
+    if (sendSimMessage(fd, &m) < 0)
+      break;
+  }
+  return 0;
+}
@@ -0,0 +1,53 @@
+/* Coordinator/worker protocol for distributed simulation
+
+   Every message is a 4 byte type, a 4 byte field count and that many
+   signed 64 bit fields, all big-endian.  A worker says HELLO, gets the
+   JOB description and then one LEASE at a time; it answers each lease
+   with a RESULT.  The coordinator answers the last result with DONE.
+*/
+
+#ifndef _SIMPROTO_H
+#define _SIMPROTO_H
+
+#include "simulate.h"
+
+#define SIM_DEFAULT_PORT 7362
+#define SIM_MAX_FIELDS 32
+#define SIM_HEADER_SIZE 8
+#define SIM_MAX_MESSAGE (SIM_HEADER_SIZE + 8 * SIM_MAX_FIELDS)
+
+enum SIM_MESSAGE {
+  MSG_HELLO = 1,
+  MSG_JOB,       /* the simJob every lease refers to */
+  MSG_LEASE,     /* unit, first seed, games */
+  MSG_RESULT,    /* unit, then the simAggregate */
+  MSG_DONE
+};
+
+struct simMessage {
+  int type;
+  int count;
+  long fields[SIM_MAX_FIELDS];
+};
+
+int encodeSimMessage(struct simMessage *m, unsigned char *buf);
+/* Returns the encoded size */
+
+int decodeSimMessage(const unsigned char *buf, int size, struct simMessage *m);
+/* Returns the bytes used, 0 if buf holds only part of a message, -1 if
+   it is malformed */
+
+int sendSimMessage(int fd, struct simMessage *m);
+int recvSimMessage(int fd, struct simMessage *m);
+/* Blocking helpers for the worker side; -1 on error or disconnect */
+
+void packSimJob(struct simJob *job, struct simMessage *m);
+int unpackSimJob(struct simMessage *m, struct simJob *job);
+void packSimResult(long unit, struct simAggregate *a, struct simMessage *m);
+int unpackSimResult(struct simMessage *m, long *unit, struct simAggregate *a);
+
+int runSimWorker(int fd);
+/* The worker's side of a connection: says HELLO, then plays every lease
+   until something else arrives; -1 if the job could not be read */
+
+#endif
@@ -0,0 +1,302 @@
+#include "simulate.h"
+#include "dominion_helpers.h"
+#include "interface.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define DEFAULT_COPIES 2
+
+int parseStrategy(const char *text, struct strategy *s) {
+  char name[MAX_STRING_LENGTH];
+  const char *colon = strchr(text, ':');
+  int len = colon ? (int)(colon - text) : (int)strlen(text);
+  int card;
+
+  if (len <= 0 || len >= MAX_STRING_LENGTH)
+    return -1;
+  memcpy(name, text, len);
+  name[len] = '\0';
+
+  if (strcmp(name, "bigmoney") == 0) {
+    s->action = -1;
+    s->copies = 0;
+    return 0;
+  }
+
+  card = cardNameToNum(name);
+  if (card < adventurer || card > treasure_map || card == gardens)
+    return -1;
+  s->action = card;
+  s->copies = colon ? atoi(colon + 1) : DEFAULT_COPIES;
+  if (s->copies < 1)
+    return -1;
+  return 0;
+}
+
+void formatStrategy(struct strategy *s, char *text, int size) {
+  char name[MAX_STRING_LENGTH];
+  int i;
+
+  if (s->action < 0) {
+    snprintf(text, size, "bigmoney");
+    return;
+  }
+  cardNumToName(s->action, name);
+  for (i = 0; name[i] != '\0'; i++)
+    name[i] = name[i] == ' ' ? '_' : tolower((unsigned char)name[i]);
+  snprintf(text, size, "%s:%d", name, s->copies);
+}
+
+static int findInHand(int player, int card, int skip, struct gameState *state) {
+  int i;
+
+  for (i = 0; i < state->handCount[player]; i++) {
+    if (state->hand[player][i] == card && i != skip)
+      return i;
+  }
+  return -1;
+}
+
+int simChoices(int card, int handPos, struct gameState *state,
+	       int *choice1, int *choice2, int *choice3) {
+  int player = whoseTurn(state);
+  int i;
+
+  *choice1 = -1;
+  *choice2 = -1;
+  *choice3 = -1;
+
+  switch (card) {
+  case feast:
+    //feast loops until it can gain, so only play it when that is possible
+    if (supplyCount(duchy, state) > 0 && supplyCount(province, state) <= 2)
+      *choice1 = duchy;
+    else if (supplyCount(silver, state) > 0)
+      *choice1 = silver;
+    else
+      return -1;
+    return 0;
+
+  case mine:
+    if ((i = findInHand(player, silver, handPos, state)) >= 0
+	&& supplyCount(gold, state) > 0) {
+      *choice1 = i;
+      *choice2 = gold;
+      return 0;
+    }
+    if ((i = findInHand(player, copper, handPos, state)) >= 0
+	&& supplyCount(silver, state) > 0) {
+      *choice1 = i;
+      *choice2 = silver;
+      return 0;
+    }
+    return -1;
+
+  case remodel:
+    if ((i = findInHand(player, estate, handPos, state)) < 0)
+      return -1;
+    *choice1 = i;
+    *choice2 = silver;
+    return 0;
+
+  case baron:
+    *choice1 = findInHand(player, estate, handPos, state) >= 0;
+    return 0;
+
+  case minion:
+    *choice1 = 1;
+    *choice2 = 0;
+    return 0;
+
+  case steward:
+    *choice1 = 1;
+    return 0;
+
+  case ambassador:
+    if ((i = findInHand(player, estate, handPos, state)) < 0
+	&& (i = findInHand(player, curse, handPos, state)) < 0)
+      return -1;
+    *choice1 = i;
+    *choice2 = 0;
+    return 0;
+
+  case embargo:
+    *choice1 = province;
+    return 0;
+
+  case salvager:
+    i = findInHand(player, estate, handPos, state);
+    *choice1 = i > 0 ? i : 0;
+    return 0;
+
+  case treasure_map:
+    return findInHand(player, treasure_map, handPos, state) >= 0 ? 0 : -1;
+
+  case gardens:
+    return -1;
+  }
+
+  return card >= adventurer && card <= treasure_map ? 0 : -1;
+}
+
+int simPlayMove(struct strategy *s, struct gameState *state, struct simMove *m) {
+  int pos;
+
+  if (s->action < 0 || state->numActions < 1)
+    return -1;
+  pos = findInHand(whoseTurn(state), s->action, -1, state);
+  if (pos < 0 || simChoices(s->action, pos, state, &m->choice1, &m->choice2,
+			    &m->choice3) < 0)
+    return -1;
+  m->type = MOVE_PLAY;
+  m->card = s->action;
+  m->handPos = pos;
+  return 0;
+}
+
+int simBuyMove(struct strategy *s, int owned, struct gameState *state,
+	       struct simMove *m) {
+  int coins = state->coins;
+  int provincesLeft = supplyCount(province, state);
+  int card = -1;
+
+  if (state->numBuys < 1)
+    return -1;
+  if (coins >= 8 && provincesLeft > 0)
+    card = province;
+  else if (coins >= 5 && provincesLeft <= 2 && supplyCount(duchy, state) > 0)
+    card = duchy;
+  else if (s->action >= 0 && owned < s->copies
+	   && supplyCount(s->action, state) > 0
+	   && getCost(s->action) <= coins
+	   && (getCost(s->action) >= 6 || coins < 6))
+    card = s->action;
+  else if (coins >= 6 && supplyCount(gold, state) > 0)
+    card = gold;
+  else if (coins >= 3 && supplyCount(silver, state) > 0)
+    card = silver;
+  else if (coins >= 2 && provincesLeft <= 2 && supplyCount(estate, state) > 0)
+    card = estate;
+  if (card < 0)
+    return -1;
+  memset(m, 0, sizeof(struct simMove));
+  m->type = MOVE_BUY;
+  m->card = card;
+  return 0;
+}
+
+int applySimMove(struct simMove *m, struct gameState *state) {
+  switch (m->type) {
+  case MOVE_PLAY:
+    return playCard(m->handPos, m->choice1, m->choice2, m->choice3, state);
+  case MOVE_BUY:
+    return buyCard(m->card, state);
+  default:
+    return endTurn(state);
+  }
+}
+
+int simulateGame(int numPlayers, int kingdomCards[10], int seed,
+		 struct strategy strategies[], struct simResult *result) {
+  struct gameState G;
+  int players[MAX_PLAYERS];
+  struct strategy *s;
+  struct simMove m;
+  int player;
+  int plays;
+  int owned;
+  int i;
+
+  memset(result, 0, sizeof(struct simResult));
+  result->seed = seed;
+  result->numPlayers = numPlayers;
+  memcpy(result->kingdom, kingdomCards, 10 * sizeof(int));
+  for (i = 0; i < MAX_PLAYERS; i++) {
+    result->strategies[i].action = -1;
+    if (i < numPlayers)
+      result->strategies[i] = strategies[i];
+  }
+
+  //scoreFor reads past the live part of the deck, so start from a known state
+  memset(&G, 0, sizeof(struct gameState));
+  if (seed <= 0 || initializeGame(numPlayers, kingdomCards, seed, &G) < 0)
+    return -1;
+
+  while (!isGameOver(&G) && result->turns < MAX_SIM_TURNS) {
+    player = whoseTurn(&G);
+    s = &strategies[player];
+
+    for (plays = 0; plays < MAX_SIM_PLAYS; plays++) {
+      if (simPlayMove(s, &G, &m) < 0 || applySimMove(&m, &G) < 0)
+	break;
+    }
+
+    while (1) {
+      owned = s->action >= 0 ? result->buys[player][s->action] : 0;
+      if (simBuyMove(s, owned, &G, &m) < 0 || applySimMove(&m, &G) < 0)
+	break;
+      result->buys[player][m.card]++;
+    }
+
+    endTurn(&G);
+    result->turns++;
+  }
+
+  for (i = 0; i < numPlayers; i++)
+    result->scores[i] = scoreFor(i, &G);
+  getWinners(players, &G);
+  for (i = 0; i < numPlayers; i++) {
+    if (players[i] == 1)
+      result->winners |= 1 << i;
+  }
+  return 0;
+}
+
+int simulateSeed(struct simJob *job, long seed, struct simResult *result) {
+  int k[10];
+
+  memcpy(k, job->kingdom, sizeof(k));
+  if (job->randomKingdom)
+    selectKingdomCards((int)seed, k);
+  return simulateGame(job->numPlayers, k, (int)seed, job->strategies, result);
+}
+
+int simulateSeeds(struct simJob *job, long firstSeed, long games,
+		  struct simAggregate *out) {
+  struct simResult r;
+  long seed;
+
+  for (seed = firstSeed; seed < firstSeed + games; seed++) {
+    if (simulateSeed(job, seed, &r) == 0)
+      addSimResult(out, &r);
+  }
+  return 0;
+}
+
+void addSimResult(struct simAggregate *a, struct simResult *r) {
+  int i;
+
+  a->games++;
+  a->turns += r->turns;
+  if (__builtin_popcount(r->winners) > 1)
+    a->ties++;
+  for (i = 0; i < r->numPlayers; i++) {
+    if (r->winners == (1 << i))
+      a->wins[i]++;
+    a->scores[i] += r->scores[i];
+  }
+}
+
+void mergeSimAggregate(struct simAggregate *into, struct simAggregate *from) {
+  int i;
+
+  into->games += from->games;
+  into->ties += from->ties;
+  into->turns += from->turns;
+  for (i = 0; i < MAX_PLAYERS; i++) {
+    into->wins[i] += from->wins[i];
+    into->scores[i] += from->scores[i];
+  }
+}
@@ -0,0 +1,96 @@
+/* Headless game simulation for batch drivers
+
+   Strategies are the "big money plus one action card" family that
+   playdom.c plays by hand: buy Province at 8, the strategy's action card
+   while fewer than `copies` are owned, Gold at 6, Silver at 3.
+*/
+
+#ifndef _SIMULATE_H
+#define _SIMULATE_H
+
+#include "dominion.h"
+
+#define MAX_SIM_TURNS 200   /* end the game after this many endTurn calls */
+#define MAX_SIM_PLAYS 20    /* cards like tribute stay in hand, cap replays */
+
+struct strategy {
+  int action;   /* action card bought and played, -1 for pure big money */
+  int copies;   /* how many copies of it to buy */
+};
+
+struct simResult {
+  int seed;
+  int kingdom[10];
+  int numPlayers;
+  struct strategy strategies[MAX_PLAYERS];
+  int scores[MAX_PLAYERS];
+  int turns;
+  int winners;  /* bit i set if player i won (ties set several bits) */
+  int buys[MAX_PLAYERS][treasure_map+1];
+};
+
+enum SIM_MOVE {
+  MOVE_PLAY = 0,
+  MOVE_BUY,
+  MOVE_END
+};
+
+struct simMove {
+  int type;
+  int card;
+  int handPos;   /* MOVE_PLAY only */
+  int choice1;
+  int choice2;
+  int choice3;
+};
+
+struct simJob {
+  int numPlayers;
+  struct strategy strategies[MAX_PLAYERS];
+  int kingdom[10];
+  int randomKingdom;   /* pick the kingdom from each seed instead */
+};
+
+struct simAggregate {
+  long games;
+  long wins[MAX_PLAYERS];  /* games won outright by each seat */
+  long ties;
+  long turns;
+  long scores[MAX_PLAYERS];
+};
+
+int parseStrategy(const char *text, struct strategy *s);
+/* "bigmoney", "smithy" or "smithy:2"; returns -1 on an unknown card */
+
+void formatStrategy(struct strategy *s, char *text, int size);
+
+int simChoices(int card, int handPos, struct gameState *state,
+	       int *choice1, int *choice2, int *choice3);
+/* Pick safe default choices for playing card; returns -1 if the card
+   should not be played from this state */
+
+int simPlayMove(struct strategy *s, struct gameState *state, struct simMove *m);
+/* The next action card the strategy plays; -1 when it is done playing */
+
+int simBuyMove(struct strategy *s, int owned, struct gameState *state,
+	       struct simMove *m);
+/* The next card to buy with owned copies of the action card already
+   bought; -1 when it is done buying */
+
+int applySimMove(struct simMove *m, struct gameState *state);
+/* playCard, buyCard or endTurn; returns what the call returned */
+
+int simulateGame(int numPlayers, int kingdomCards[10], int seed,
+		 struct strategy strategies[], struct simResult *result);
+/* Play one game to the end with no output; seed must be positive */
+
+int simulateSeed(struct simJob *job, long seed, struct simResult *result);
+/* simulateGame with the job's settings */
+
+int simulateSeeds(struct simJob *job, long firstSeed, long games,
+		  struct simAggregate *out);
+
+void addSimResult(struct simAggregate *a, struct simResult *r);
+void mergeSimAggregate(struct simAggregate *into, struct simAggregate *from);
+
+#endif
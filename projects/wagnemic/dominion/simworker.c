@@ -0,0 +1,82 @@
+/* Simulation worker
+
+   Connects to a simcoord coordinator, plays the seed ranges it leases
+   and sends back one aggregate per lease until the coordinator says DONE.
+
+   Usage: simworker host [port]
+*/
+
+#include "dominion.h"
+#include "simulate.h"
+#include "simproto.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#define CONNECT_TRIES 50
+
+static int connectTo(const char *host, const char *port) {
+  struct addrinfo hints;
+  struct addrinfo *list;
+  struct addrinfo *ai;
+  int fd = -1;
+  int one = 1;
+
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(host, port, &hints, &list) != 0)
+    return -1;
+  for (ai = list; ai != NULL; ai = ai->ai_next) {
+    fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    if (fd < 0)
+      continue;
+    if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0)
+      break;
+    close(fd);
+    fd = -1;
+  }
+  freeaddrinfo(list);
+  if (fd >= 0)
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  return fd;
+}
+
+int main(int argc, char **argv) {
+  char port[16];
+  int tries;
+  int fd = -1;
+
+  if (argc < 2 || argc > 3) {
+    printf("Usage: simworker host [port]\n");
+    return 1;
+  }
+  if (argc == 3)
+    snprintf(port, sizeof(port), "%s", argv[2]);
+  else
+    snprintf(port, sizeof(port), "%d", SIM_DEFAULT_PORT);
+
+  //the coordinator may still be starting up
+  for (tries = 0; tries < CONNECT_TRIES && fd < 0; tries++) {
+    fd = connectTo(argv[1], port);
+    if (fd < 0)
+      usleep(100000);
+  }
+  if (fd < 0) {
+    printf("Could not connect to %s:%s\n", argv[1], port);
+    return 1;
+  }
+
+  if (runSimWorker(fd) < 0) {
+    printf("Bad job from coordinator\n");
+    return 1;
+  }
+
+  close(fd);
+  return 0;
+}
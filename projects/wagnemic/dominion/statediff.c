@@ -0,0 +1,196 @@
+#include "statediff.h"
+#include "interface.h"
+#include <string.h>
+
+static int pileBound(int field) {
+  return field == FIELD_HAND ? MAX_HAND : MAX_DECK;
+}
+
+static int samePile(int *a, int countA, int *b, int countB, int bound,
+		    int *position) {
+  int n = countA < bound ? countA : bound;
+  int i;
+
+  *position = -1;
+  if (countA != countB)
+    return 0;
+  if (n <= 0 || memcmp(a, b, n * sizeof(int)) == 0)
+    return 1;
+  for (i = 0; a[i] == b[i]; i++)
+    ;
+  *position = i;
+  return 0;
+}
+
+static int playersOf(struct gameState *s) {
+  if (s->numPlayers < 1 || s->numPlayers > MAX_PLAYERS)
+    return MAX_PLAYERS;
+  return s->numPlayers;
+}
+
+//pile field of player p, with its count
+static int *pileOf(struct gameState *s, int field, int p, int *count) {
+  switch (field) {
+  case FIELD_HAND:
+    *count = s->handCount[p];
+    return s->hand[p];
+  case FIELD_DECK:
+    *count = s->deckCount[p];
+    return s->deck[p];
+  case FIELD_DISCARD:
+    *count = s->discardCount[p];
+    return s->discard[p];
+  default:
+    *count = s->playedCardCount;
+    return s->playedCards;
+  }
+}
+
+static void addDiff(struct stateDiffs *out, int field, int index,
+		    int position, int a, int b) {
+  struct stateDiff *d;
+
+  if (out->count < STATE_DIFF_MAX) {
+    d = &out->diffs[out->count];
+    d->field = field;
+    d->index = index;
+    d->position = position;
+    d->a = a;
+    d->b = b;
+  }
+  out->count++;
+}
+
+static void diffScalar(struct stateDiffs *out, int field, int index, int a,
+		       int b) {
+  if (a != b)
+    addDiff(out, field, index, -1, a, b);
+}
+
+static void diffPile(struct stateDiffs *out, struct gameState *a,
+		     struct gameState *b, int field, int p) {
+  int countA;
+  int countB;
+  int *pa = pileOf(a, field, p, &countA);
+  int *pb = pileOf(b, field, p, &countB);
+  int position;
+
+  if (samePile(pa, countA, pb, countB, pileBound(field), &position))
+    return;
+  if (position < 0)
+    addDiff(out, field, p, -1, countA, countB);
+  else
+    addDiff(out, field, p, position, pa[position], pb[position]);
+}
+
+int sameGameState(struct gameState *a, struct gameState *b) {
+  int position;
+  int p;
+
+  if (a->numPlayers != b->numPlayers
+      || memcmp(a->supplyCount, b->supplyCount, sizeof(a->supplyCount))
+      || memcmp(a->embargoTokens, b->embargoTokens, sizeof(a->embargoTokens))
+      || a->outpostPlayed != b->outpostPlayed
+      || a->outpostTurn != b->outpostTurn
+      || a->whoseTurn != b->whoseTurn
+      || a->phase != b->phase
+      || a->numActions != b->numActions
+      || a->coins != b->coins
+      || a->numBuys != b->numBuys
+      || !samePile(a->playedCards, a->playedCardCount, b->playedCards,
+		   b->playedCardCount, MAX_DECK, &position))
+    return 0;
+  for (p = 0; p < playersOf(a); p++) {
+    if (!samePile(a->hand[p], a->handCount[p], b->hand[p], b->handCount[p],
+		  MAX_HAND, &position)
+	|| !samePile(a->deck[p], a->deckCount[p], b->deck[p], b->deckCount[p],
+		     MAX_DECK, &position)
+	|| !samePile(a->discard[p], a->discardCount[p], b->discard[p],
+		     b->discardCount[p], MAX_DECK, &position))
+      return 0;
+  }
+  return 1;
+}
+
+int diffGameState(struct gameState *a, struct gameState *b,
+		  struct stateDiffs *out) {
+  int i;
+  int p;
+
+  out->count = 0;
+  diffScalar(out, FIELD_NUM_PLAYERS, -1, a->numPlayers, b->numPlayers);
+  for (i = 0; i <= treasure_map; i++) {
+    diffScalar(out, FIELD_SUPPLY_COUNT, i, a->supplyCount[i],
+	       b->supplyCount[i]);
+    diffScalar(out, FIELD_EMBARGO_TOKENS, i, a->embargoTokens[i],
+	       b->embargoTokens[i]);
+  }
+  diffScalar(out, FIELD_OUTPOST_PLAYED, -1, a->outpostPlayed, b->outpostPlayed);
+  diffScalar(out, FIELD_OUTPOST_TURN, -1, a->outpostTurn, b->outpostTurn);
+  diffScalar(out, FIELD_WHOSE_TURN, -1, a->whoseTurn, b->whoseTurn);
+  diffScalar(out, FIELD_PHASE, -1, a->phase, b->phase);
+  diffScalar(out, FIELD_NUM_ACTIONS, -1, a->numActions, b->numActions);
+  diffScalar(out, FIELD_COINS, -1, a->coins, b->coins);
+  diffScalar(out, FIELD_NUM_BUYS, -1, a->numBuys, b->numBuys);
+  for (p = 0; p < playersOf(a); p++) {
+    diffPile(out, a, b, FIELD_HAND, p);
+    diffPile(out, a, b, FIELD_DECK, p);
+    diffPile(out, a, b, FIELD_DISCARD, p);
+  }
+  diffPile(out, a, b, FIELD_PLAYED_CARDS, -1);
+  return out->count;
+}
+
+static void printPile(FILE *f, const char *label, struct gameState *s,
+		      int field, int p) {
+  char name[MAX_STRING_LENGTH];
+  int count;
+  int *cards = pileOf(s, field, p, &count);
+  int i;
+
+  fprintf(f, "      %s (%d):", label, count);
+  for (i = 0; i < count && i < pileBound(field); i++) {
+    cardNumToName(cards[i], name);
+    fprintf(f, " %s", name);
+  }
+  fprintf(f, "\n");
+}
+
+void printStateDiffs(FILE *f, struct gameState *a, struct gameState *b,
+		     struct stateDiffs *d, const char *labelA,
+		     const char *labelB) {
+  static const char *fieldNames[] = {
+    "numPlayers", "supplyCount", "embargoTokens", "outpostPlayed",
+    "outpostTurn", "whoseTurn", "phase", "numActions", "coins", "numBuys",
+    "hand", "deck", "discard", "playedCards"
+  };
+  char name[MAX_STRING_LENGTH];
+  char field[64];
+  struct stateDiff *e;
+  int n = d->count < STATE_DIFF_MAX ? d->count : STATE_DIFF_MAX;
+  int i;
+
+  for (i = 0; i < n; i++) {
+    e = &d->diffs[i];
+    if (e->field == FIELD_SUPPLY_COUNT || e->field == FIELD_EMBARGO_TOKENS) {
+      cardNumToName(e->index, name);
+      snprintf(field, sizeof(field), "%s[%s]", fieldNames[e->field], name);
+    } else if (e->field >= FIELD_HAND && e->field <= FIELD_DISCARD) {
+      snprintf(field, sizeof(field), "%s[%d]", fieldNames[e->field], e->index);
+    } else {
+      snprintf(field, sizeof(field), "%s", fieldNames[e->field]);
+    }
+    if (e->field < FIELD_HAND) {
+      fprintf(f, "    %-22s %s %d, %s %d\n", field, labelA, e->a, labelB, e->b);
+      continue;
+    }
+    if (e->position < 0)
+      fprintf(f, "    %s count\n", field);
+    else
+      fprintf(f, "    %s from position %d\n", field, e->position);
+    printPile(f, labelA, a, e->field, e->index);
+    printPile(f, labelB, b, e->field, e->index);
+  }
+  if (d->count > n)
+    fprintf(f, "    ... %d more fields differ\n", d->count - n);
+}
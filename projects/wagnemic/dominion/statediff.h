@@ -0,0 +1,68 @@
+/* Field-level gameState comparison
+
+   Compares only the live part of two states: the scalar fields, the
+   supply and embargo counts and every pile up to its count.  Whatever
+   lies past a pile's count is never looked at, so states that only
+   differ in unused slots compare equal.  Piles are compared for the
+   first numPlayers players, or for all of them if numPlayers is not a
+   valid player count.  Counts outside a pile's bounds are compared but
+   the cards are then only looked at up to the bound.
+*/
+
+#ifndef _STATEDIFF_H
+#define _STATEDIFF_H
+
+#include "dominion.h"
+#include <stdio.h>
+
+#define STATE_DIFF_MAX 32
+
+enum STATE_FIELD {
+  FIELD_NUM_PLAYERS = 0,
+  FIELD_SUPPLY_COUNT,     /* index is the card */
+  FIELD_EMBARGO_TOKENS,   /* index is the card */
+  FIELD_OUTPOST_PLAYED,
+  FIELD_OUTPOST_TURN,
+  FIELD_WHOSE_TURN,
+  FIELD_PHASE,
+  FIELD_NUM_ACTIONS,
+  FIELD_COINS,
+  FIELD_NUM_BUYS,
+  FIELD_HAND,             /* index is the player */
+  FIELD_DECK,             /* index is the player */
+  FIELD_DISCARD,          /* index is the player */
+  FIELD_PLAYED_CARDS
+};
+
+/* For scalar fields a and b are the two values.  For piles position is
+   -1 if the counts differ (a and b are the counts), otherwise the first
+   position where the cards differ (a and b are the cards there). */
+struct stateDiff {
+  int field;
+  int index;
+  int position;
+  int a;
+  int b;
+};
+
+struct stateDiffs {
+  int count;     /* every difference found, may exceed STATE_DIFF_MAX */
+  struct stateDiff diffs[STATE_DIFF_MAX];
+};
+
+int sameGameState(struct gameState *a, struct gameState *b);
+/* Returns 1 if the live parts are equal, stopping at the first
+   difference */
+
+int diffGameState(struct gameState *a, struct gameState *b,
+		  struct stateDiffs *out);
+/* Records the first STATE_DIFF_MAX differences in out and returns how
+   many fields differ in all */
+
+void printStateDiffs(FILE *f, struct gameState *a, struct gameState *b,
+		     struct stateDiffs *d, const char *labelA,
+		     const char *labelB);
+/* One line per differing field; piles are printed in full on both
+   sides */
+
+#endif
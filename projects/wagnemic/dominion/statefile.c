@@ -0,0 +1,170 @@
+#include "statefile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct cursor {
+  unsigned char *out;
+  const unsigned char *in;
+  int pos;
+  int size;
+  int failed;
+};
+
+static void put(struct cursor *c, int value) {
+  unsigned int v = (unsigned int)value;
+
+  if (c->pos + 4 > c->size) {
+    c->failed = 1;
+    return;
+  }
+  c->out[c->pos] = v & 0xff;
+  c->out[c->pos + 1] = (v >> 8) & 0xff;
+  c->out[c->pos + 2] = (v >> 16) & 0xff;
+  c->out[c->pos + 3] = v >> 24;
+  c->pos += 4;
+}
+
+static int get(struct cursor *c) {
+  unsigned int v;
+
+  if (c->pos + 4 > c->size) {
+    c->failed = 1;
+    return 0;
+  }
+  v = c->in[c->pos] | (c->in[c->pos + 1] << 8) | (c->in[c->pos + 2] << 16)
+    | ((unsigned int)c->in[c->pos + 3] << 24);
+  c->pos += 4;
+  return (int)v;
+}
+
+static void putPile(struct cursor *c, int *cards, int count, int max) {
+  int i;
+
+  if (count < 0 || count > max) {
+    c->failed = 1;
+    return;
+  }
+  put(c, count);
+  for (i = 0; i < count; i++)
+    put(c, cards[i]);
+}
+
+static int getPile(struct cursor *c, int *cards, int max) {
+  int count = get(c);
+  int i;
+
+  if (count < 0 || count > max) {
+    c->failed = 1;
+    return 0;
+  }
+  for (i = 0; i < count && !c->failed; i++)
+    cards[i] = get(c);
+  return count;
+}
+
+int encodeStateFile(struct playCase *pc, unsigned char *buf, int size) {
+  struct gameState *s = &pc->state;
+  struct cursor c = {buf, NULL, 4, size, 0};
+  int i;
+
+  if (size < 4 || s->numPlayers < 0 || s->numPlayers > MAX_PLAYERS)
+    return -1;
+  memcpy(buf, STATE_FILE_MAGIC, 4);
+  put(&c, pc->entry);
+  put(&c, pc->card);
+  put(&c, pc->handPos);
+  put(&c, pc->choice1);
+  put(&c, pc->choice2);
+  put(&c, pc->choice3);
+  put(&c, pc->seed);
+  put(&c, s->numPlayers);
+  for (i = 0; i <= treasure_map; i++)
+    put(&c, s->supplyCount[i]);
+  for (i = 0; i <= treasure_map; i++)
+    put(&c, s->embargoTokens[i]);
+  put(&c, s->outpostPlayed);
+  put(&c, s->outpostTurn);
+  put(&c, s->whoseTurn);
+  put(&c, s->phase);
+  put(&c, s->numActions);
+  put(&c, s->coins);
+  put(&c, s->numBuys);
+  for (i = 0; i < s->numPlayers; i++) {
+    putPile(&c, s->hand[i], s->handCount[i], MAX_HAND);
+    putPile(&c, s->deck[i], s->deckCount[i], MAX_DECK);
+    putPile(&c, s->discard[i], s->discardCount[i], MAX_DECK);
+  }
+  putPile(&c, s->playedCards, s->playedCardCount, MAX_DECK);
+  return c.failed ? -1 : c.pos;
+}
+
+int decodeStateFile(const unsigned char *buf, int size, struct playCase *pc) {
+  struct gameState *s = &pc->state;
+  struct cursor c = {NULL, buf, 4, size, 0};
+  int i;
+
+  memset(pc, 0, sizeof(struct playCase));
+  if (size < 4 || memcmp(buf, STATE_FILE_MAGIC, 4) != 0)
+    return -1;
+  pc->entry = get(&c);
+  pc->card = get(&c);
+  pc->handPos = get(&c);
+  pc->choice1 = get(&c);
+  pc->choice2 = get(&c);
+  pc->choice3 = get(&c);
+  pc->seed = get(&c);
+  s->numPlayers = get(&c);
+  if (s->numPlayers < 0 || s->numPlayers > MAX_PLAYERS)
+    return -1;
+  for (i = 0; i <= treasure_map; i++)
+    s->supplyCount[i] = get(&c);
+  for (i = 0; i <= treasure_map; i++)
+    s->embargoTokens[i] = get(&c);
+  s->outpostPlayed = get(&c);
+  s->outpostTurn = get(&c);
+  s->whoseTurn = get(&c);
+  s->phase = get(&c);
+  s->numActions = get(&c);
+  s->coins = get(&c);
+  s->numBuys = get(&c);
+  for (i = 0; i < s->numPlayers; i++) {
+    s->handCount[i] = getPile(&c, s->hand[i], MAX_HAND);
+    s->deckCount[i] = getPile(&c, s->deck[i], MAX_DECK);
+    s->discardCount[i] = getPile(&c, s->discard[i], MAX_DECK);
+  }
+  s->playedCardCount = getPile(&c, s->playedCards, MAX_DECK);
+  return c.failed || c.pos != size ? -1 : 0;
+}
+
+int writeStateFile(const char *path, struct playCase *c) {
+  unsigned char *buf = malloc(STATE_FILE_MAX);
+  FILE *f;
+  int size;
+  int ok;
+
+  if (buf == NULL)
+    return -1;
+  size = encodeStateFile(c, buf, STATE_FILE_MAX);
+  f = size < 0 ? NULL : fopen(path, "wb");
+  ok = f != NULL && fwrite(buf, 1, size, f) == (size_t)size;
+  if (f != NULL && fclose(f) != 0)
+    ok = 0;
+  free(buf);
+  return ok ? 0 : -1;
+}
+
+int readStateFile(const char *path, struct playCase *c) {
+  unsigned char *buf = malloc(STATE_FILE_MAX + 1);
+  FILE *f = fopen(path, "rb");
+  int size = -1;
+
+  if (buf != NULL && f != NULL)
+    size = fread(buf, 1, STATE_FILE_MAX + 1, f);
+  if (f != NULL)
+    fclose(f);
+  if (size < 0 || size > STATE_FILE_MAX || decodeStateFile(buf, size, c) < 0)
+    size = -1;
+  free(buf);
+  return size < 0 ? -1 : 0;
+}
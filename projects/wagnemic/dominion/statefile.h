@@ -0,0 +1,46 @@
+/* Binary state files
+
+   A play case is a gameState plus the arguments of one playCard or
+   cardEffect call.  State files store only the live part of the state
+   (every pile up to its count) as little-endian 32 bit values after a
+   "DST1" magic, so a reproducer is usually well under a kilobyte.
+   Anything past a pile's count reads back as 0.
+*/
+
+#ifndef _STATEFILE_H
+#define _STATEFILE_H
+
+#include "dominion.h"
+
+#define STATE_FILE_MAGIC "DST1"
+#define STATE_FILE_MAX (4 * (17 + 2 * (treasure_map + 1) \
+			     + MAX_PLAYERS * (3 + MAX_HAND + 2 * MAX_DECK) \
+			     + MAX_DECK))
+
+enum PLAY_ENTRY {
+  ENTRY_PLAY_CARD = 0,   /* playCard(handPos, choices) */
+  ENTRY_CARD_EFFECT      /* cardEffect(card, choices, handPos) */
+};
+
+struct playCase {
+  int entry;
+  int card;       /* only used by ENTRY_CARD_EFFECT */
+  int handPos;
+  int choice1;
+  int choice2;
+  int choice3;
+  int seed;       /* PutSeed value for stream 1 before the call */
+  struct gameState state;
+};
+
+int encodeStateFile(struct playCase *c, unsigned char *buf, int size);
+/* Returns the encoded size, -1 if a count is out of range or buf is too
+   small.  Does not allocate. */
+
+int decodeStateFile(const unsigned char *buf, int size, struct playCase *c);
+/* Returns 0, or -1 if buf is not a well-formed state file */
+
+int writeStateFile(const char *path, struct playCase *c);
+int readStateFile(const char *path, struct playCase *c);
+
+#endif
@@ -0,0 +1,221 @@
+/* Kingdom sweep
+
+   Plays strategy A against strategy B on every 10-card kingdom set (or a
+   stratified sample of them) and appends one line per kingdom to the
+   output file as soon as it finishes.  Re-running with the same output
+   file resumes: kingdoms already in the file are skipped.  The file's
+   first line records the strategies, players, seed, games and samples,
+   and a run with different ones refuses to resume it.
+
+   Usage: sweep [-j threads] [-g games] [-n samples] [-s seed]
+                [-p players] [-a strategy] [-b strategy] -o file
+*/
+
+#include "dominion.h"
+#include "kingdom.h"
+#include "simulate.h"
+#include "workq.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#define SEED_SPACE 2147483646L
+
+struct sweep {
+  int numPlayers;
+  struct strategy a;
+  struct strategy b;
+  int games;
+  long samples;
+  long seed;
+  unsigned char *done;   //one flag per kingdom rank
+  FILE *out;
+  pthread_mutex_t outLock;
+  long swept;
+};
+
+static long taskRank(struct sweep *s, long task) {
+  if (s->samples > 0)
+    return kingdomSample(task, s->samples, s->seed);
+  return task;
+}
+
+static void sweepKingdom(struct sweep *s, long rank) {
+  struct strategy seats[MAX_PLAYERS];
+  struct simResult r;
+  int k[KINGDOM_SIZE];
+  int winsA = 0;
+  int winsB = 0;
+  int ties = 0;
+  long turns = 0;
+  int seatA;
+  int seed;
+  int g;
+  int i;
+
+  kingdomUnrank(rank, k);
+  for (g = 0; g < s->games; g++) {
+    //rotate strategy A through the seats to cancel first player advantage
+    seatA = g % s->numPlayers;
+    for (i = 0; i < s->numPlayers; i++)
+      seats[i] = i == seatA ? s->a : s->b;
+    seed = (int)((s->seed + rank * s->games + g) % SEED_SPACE) + 1;
+    if (simulateGame(s->numPlayers, k, seed, seats, &r) < 0)
+      continue;
+    turns += r.turns;
+    if (r.winners == (1 << seatA))
+      winsA++;
+    else if (r.winners & (1 << seatA))
+      ties++;
+    else
+      winsB++;
+  }
+
+  pthread_mutex_lock(&s->outLock);
+  fprintf(s->out, "%ld %05x %d %d %d %d %.2f\n", rank, kingdomMask(k),
+	  s->games, winsA, winsB, ties, s->games ? (double)turns / s->games : 0.0);
+  fflush(s->out);
+  s->swept++;
+  pthread_mutex_unlock(&s->outLock);
+}
+
+static void sweepRange(void *arg, int worker, long begin, long end) {
+  struct sweep *s = arg;
+  long task;
+  long rank;
+
+  for (task = begin; task < end; task++) {
+    rank = taskRank(s, task);
+    if (s->done[rank])
+      continue;
+    s->done[rank] = 1;  //stratified samples may repeat a rank
+    sweepKingdom(s, rank);
+  }
+}
+
+//marks the kingdoms in path as done, returning how many there were, or
+//-1 if path holds a sweep with another header
+static long loadCheckpoint(const char *path, const char *header,
+			   unsigned char *done) {
+  FILE *in = fopen(path, "r+");
+  char line[256];
+  long good = 0;
+  long rank;
+  long count = 0;
+  size_t len;
+
+  if (in == NULL)
+    return 0;
+  while (fgets(line, sizeof(line), in) != NULL) {
+    len = strlen(line);
+    if (len == 0 || line[len-1] != '\n')
+      break;  //torn last line from an interrupted run
+    if (good == 0 && strcmp(line, header) != 0) {
+      fclose(in);
+      return -1;
+    }
+    if (line[0] != '#' && sscanf(line, "%ld", &rank) == 1
+	&& rank >= 0 && rank < KINGDOM_SETS) {
+      if (!done[rank])
+	count++;
+      done[rank] = 1;
+    }
+    good = ftell(in);
+  }
+  fflush(in);
+  if (ftruncate(fileno(in), good) != 0)
+    perror("ftruncate");
+  fclose(in);
+  return count;
+}
+
+static void usage(void) {
+  printf("Usage: sweep [-j threads] [-g games] [-n samples] [-s seed]\n"
+	 "             [-p players] [-a strategy] [-b strategy] -o file\n");
+}
+
+int main(int argc, char **argv) {
+  struct sweep s;
+  const char *outPath = NULL;
+  char nameA[64];
+  char nameB[64];
+  char header[256];
+  int threads = 0;
+  long resumed;
+  long tasks;
+  int opt;
+
+  memset(&s, 0, sizeof(s));
+  s.numPlayers = 2;
+  s.games = 100;
+  s.seed = 1;
+  parseStrategy("smithy", &s.a);
+  parseStrategy("bigmoney", &s.b);
+
+  while ((opt = getopt(argc, argv, "j:g:n:s:p:a:b:o:")) != -1) {
+    switch (opt) {
+    case 'j': threads = atoi(optarg); break;
+    case 'g': s.games = atoi(optarg); break;
+    case 'n': s.samples = atol(optarg); break;
+    case 's': s.seed = atol(optarg); break;
+    case 'p': s.numPlayers = atoi(optarg); break;
+    case 'a':
+      if (parseStrategy(optarg, &s.a) < 0) {
+	printf("Unknown strategy %s\n", optarg);
+	return 1;
+      }
+      break;
+    case 'b':
+      if (parseStrategy(optarg, &s.b) < 0) {
+	printf("Unknown strategy %s\n", optarg);
+	return 1;
+      }
+      break;
+    case 'o': outPath = optarg; break;
+    default: usage(); return 1;
+    }
+  }
+  if (outPath == NULL || s.games < 1 || s.numPlayers < 2
+      || s.numPlayers > MAX_PLAYERS || s.samples > KINGDOM_SETS || s.seed < 0) {
+    usage();
+    return 1;
+  }
+
+  s.done = calloc(KINGDOM_SETS, 1);
+  if (s.done == NULL)
+    return 1;
+  formatStrategy(&s.a, nameA, sizeof(nameA));
+  formatStrategy(&s.b, nameB, sizeof(nameB));
+  snprintf(header, sizeof(header),
+	   "# A=%s B=%s players=%d seed=%ld games=%d samples=%ld\n",
+	   nameA, nameB, s.numPlayers, s.seed, s.games, s.samples);
+  resumed = loadCheckpoint(outPath, header, s.done);
+  if (resumed < 0) {
+    printf("%s holds a sweep with other settings, not resuming it; "
+	   "this one is\n%s", outPath, header);
+    return 1;
+  }
+  s.out = fopen(outPath, "a");
+  if (s.out == NULL) {
+    perror(outPath);
+    return 1;
+  }
+  fseek(s.out, 0, SEEK_END);
+  if (ftell(s.out) == 0)
+    fprintf(s.out, "%s# rank mask games winsA winsB ties avgTurns\n",
+	    header);
+  pthread_mutex_init(&s.outLock, NULL);
+
+  tasks = s.samples > 0 ? s.samples : KINGDOM_SETS;
+  if (workqRun(0, tasks, 1, threads, sweepRange, &s) < 0) {
+    printf("Could not start worker threads\n");
+    return 1;
+  }
+
+  fclose(s.out);
+  printf("Swept %ld kingdoms, %ld already done\n", s.swept, resumed);
+  free(s.done);
+  return 0;
+}
@@ -0,0 +1,122 @@
+#include "dominion.h"
+#include "session.h"
+#include "binproto.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+int main () {
+  static int view[VIEW_SLOTS], last[VIEW_SLOTS], copy[VIEW_SLOTS];
+  static struct gameState seen;
+  unsigned char frame[BIN_MAX_RESULT];
+  struct sessionMove m, back;
+  struct binResult r;
+  struct session s;
+  int size;
+  int i;
+
+  printf ("Testing the binary protocol.\n");
+
+  //moves are fixed size and survive the trip, negative arguments too
+  m.op = SESSION_PLAY;
+  m.args[0] = 3;
+  m.args[1] = -1;
+  m.args[2] = 70000;
+  m.args[3] = -123456;
+  assert(encodeBinMove(&m, frame) == BIN_MOVE_SIZE);
+  for (i = 0; i < BIN_MOVE_SIZE; i++)
+    assert(decodeBinMove(frame, i, &back) == 0);
+  assert(decodeBinMove(frame, BIN_MOVE_SIZE + 5, &back) == BIN_MOVE_SIZE);
+  assert(back.op == SESSION_PLAY && back.args[0] == 3 && back.args[1] == -1
+	 && back.args[2] == 70000 && back.args[3] == -123456);
+  frame[2] = BIN_RESULT;
+  assert(decodeBinMove(frame, BIN_MOVE_SIZE, &back) == -1);
+
+  //bots may set up their game once, and never add cards
+  assert(sessionStart(&s, 11, NULL) == 0);
+  m.op = SESSION_ADD;
+  assert(binMoveAllowed(&s, &m) == -1);
+  m.op = SESSION_INIT;
+  assert(binMoveAllowed(&s, &m) == 0);
+  s.started = 1;
+  assert(binMoveAllowed(&s, &m) == -1);
+  m.op = SESSION_PLAY;
+  assert(binMoveAllowed(&s, &m) == 0);
+
+  //the greeting carries every slot, later results only the changes
+  assert(sessionStart(&s, 11, NULL) == 0);
+  memset(&m, 0, sizeof(m));
+  for (i = 0; i < VIEW_SLOTS; i++) {
+    last[i] = VIEW_UNKNOWN;
+    copy[i] = 12345;
+  }
+  sessionView(&s, view);
+  size = encodeBinResult(&m, 0, view, last, frame);
+  assert(size == BIN_RESULT_HEADER + BIN_PAIR_SIZE * VIEW_SLOTS);
+  assert(decodeBinResult(frame, size - 1, &r, copy) == 0);
+  assert(decodeBinResult(frame, size, &r, copy) == size);
+  assert(r.count == VIEW_SLOTS && r.over == 0 && r.op == SESSION_NONE);
+  assert(memcmp(copy, view, sizeof(view)) == 0);
+  assert(copy[VIEW_STARTED] == 0);
+
+  m.op = SESSION_INIT;
+  m.args[0] = 2;
+  m.args[1] = 0;
+  assert(sessionRun(&s, &m, NULL) == 0 && m.outcome == 0);
+  sessionView(&s, view);
+  size = encodeBinResult(&m, 0, view, last, frame);
+  assert(size < BIN_RESULT_HEADER + BIN_PAIR_SIZE * 40);
+  assert(decodeBinResult(frame, size, &r, copy) == size);
+  assert(memcmp(copy, view, sizeof(view)) == 0);
+  assert(copy[VIEW_STARTED] == 1 && copy[VIEW_HAND_COUNT] == 5);
+
+  //a refused move still answers, with its outcome and nothing changed
+  m.op = SESSION_BUY;
+  m.args[0] = province;
+  assert(sessionRun(&s, &m, NULL) == 0 && m.outcome == -1);
+  sessionView(&s, view);
+  size = encodeBinResult(&m, 0, view, last, frame);
+  assert(size == BIN_RESULT_HEADER);
+  assert(decodeBinResult(frame, size, &r, copy) == size);
+  assert(r.outcome == -1 && r.count == 0 && r.op == SESSION_BUY);
+
+  //playing a whole game keeps the copy in step
+  while (!r.over) {
+    //buy what the copy says can be afforded, then end the turn
+    m.op = m.op == SESSION_BUY ? SESSION_END : SESSION_BUY;
+    m.args[0] = copy[VIEW_COINS] >= 8 ? province
+      : copy[VIEW_COINS] >= 6 ? gold : silver;
+    r.over = sessionRun(&s, &m, NULL);
+    sessionView(&s, view);
+    size = encodeBinResult(&m, r.over, view, last, frame);
+    assert(decodeBinResult(frame, size, &r, copy) == size);
+    assert(memcmp(copy, view, sizeof(view)) == 0);
+    assert(s.turnNum < 1000);
+  }
+
+  //the feed shows the player to move their own cards and no one else's
+  feedView(&s.game, 1, &seen);
+  assert(seen.handCount[0] == s.game.handCount[0]
+	 && seen.deckCount[1] == s.game.deckCount[1]);
+  assert(seen.supplyCount[province] == s.game.supplyCount[province]);
+  for (i = 0; i < MAX_DECK; i++) {
+    assert(seen.deck[0][i] == -1 && seen.deck[1][i] == -1);
+    assert(seen.discard[0][i] == -1);
+    assert(i >= s.game.discardCount[1]
+	   || seen.discard[1][i] == s.game.discard[1][i]);
+  }
+  for (i = 0; i < MAX_HAND; i++) {
+    assert(seen.hand[0][i] == -1);
+    assert(i >= s.game.handCount[1] || seen.hand[1][i] == s.game.hand[1][i]);
+  }
+
+  //malformed frames are refused
+  frame[2] = BIN_MOVE;
+  assert(decodeBinResult(frame, size, &r, copy) == -1);
+  frame[2] = BIN_RESULT;
+  frame[1] += BIN_PAIR_SIZE;
+  assert(decodeBinResult(frame, size + BIN_PAIR_SIZE, &r, copy) == -1);
+
+  printf("ALL TESTS OK\n");
+  return 0;
+}
@@ -0,0 +1,140 @@
+#include "dominion.h"
+#include "book.h"
+#include "kingdom.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#define BOOK_PATH "/tmp/testBook.dob"
+
+static int k[10] = {adventurer, gardens, embargo, village, minion, mine,
+		    cutpurse, sea_hag, tribute, smithy};
+
+int main () {
+  static struct gameState g;
+  struct strategy smithyMoney;
+  struct bookEntry e, found;
+  struct book *b, *loaded;
+  struct mctsMove m;
+  struct bot *bot;
+  int other[10];
+  int bigger;
+  int first;
+  int expect;
+  long rank;
+  double score, again;
+  FILE *f;
+
+  printf ("Testing opening books.\n");
+
+  //the splits of 7 coppers in two hands of 5
+  assert(splitOf(5, &bigger) == SPLIT_5_2 && bigger);
+  assert(splitOf(2, &bigger) == SPLIT_5_2 && !bigger);
+  assert(splitOf(4, &bigger) == SPLIT_4_3 && bigger);
+  assert(splitOf(3, &bigger) == SPLIT_4_3 && !bigger);
+  assert(splitOf(6, &bigger) == -1 && splitOf(1, &bigger) == -1);
+
+  //entries go in and come back, across the table growing
+  parseStrategy("smithy", &smithyMoney);
+  b = createBook(&smithyMoney);
+  assert(b != NULL);
+  for (rank = 0; rank < 1000; rank += 7) {
+    kingdomUnrank(rank, other);
+    e.kingdom = kingdomMask(other);
+    e.buys[SPLIT_5_2][0] = other[(int)(rank % 10)];
+    e.buys[SPLIT_5_2][1] = -1;
+    e.buys[SPLIT_4_3][0] = silver;
+    e.buys[SPLIT_4_3][1] = rank % 2 ? silver : -1;
+    assert(bookAdd(b, &e) == 0);
+  }
+  assert(b->entries == 143 && 2 * b->entries <= b->slots);
+  for (rank = 0; rank < 1000; rank++) {
+    kingdomUnrank(rank, other);
+    if (rank % 7 != 0) {
+      assert(bookFind(b, kingdomMask(other), &found) == -1);
+      continue;
+    }
+    assert(bookFind(b, kingdomMask(other), &found) == 0);
+    assert(found.buys[SPLIT_5_2][0] == other[(int)(rank % 10)]);
+    assert(found.buys[SPLIT_5_2][1] == -1);
+    assert(found.buys[SPLIT_4_3][1] == (rank % 2 ? silver : -1));
+  }
+
+  //the test kingdom opens smithy on 5/2 and silver/silver on 4/3
+  e.kingdom = kingdomMask(k);
+  e.buys[SPLIT_5_2][0] = smithy;
+  e.buys[SPLIT_5_2][1] = -1;
+  e.buys[SPLIT_4_3][0] = silver;
+  e.buys[SPLIT_4_3][1] = silver;
+  assert(bookAdd(b, &e) == 0);
+  assert(bookAdd(b, &e) == 0);
+  assert(b->entries == 144);
+
+  //and all of it survives the file
+  assert(writeBook(BOOK_PATH, b) == 0);
+  loaded = readBook(BOOK_PATH);
+  assert(loaded != NULL);
+  assert(loaded->entries == b->entries && loaded->slots == b->slots);
+  assert(loaded->strategy.action == smithy
+	 && loaded->strategy.copies == smithyMoney.copies);
+  assert(memcmp(loaded->table, b->table, b->slots * BOOK_SLOT_SIZE) == 0);
+  freeBook(loaded);
+  f = fopen(BOOK_PATH, "r+b");
+  assert(f != NULL);
+  fputc('X', f);
+  fclose(f);
+  assert(readBook(BOOK_PATH) == NULL);
+  remove(BOOK_PATH);
+
+  //the book answers the first two buys of a game, and nothing after
+  memset(&g, 0, sizeof(g));
+  assert(initializeGame(2, k, 9, &g) == 0);
+  first = g.coins;
+  expect = g.coins == 5 ? smithy : g.coins == 2 ? -1 : silver;
+  assert(bookMove(b, &g, &m) == 0);
+  assert(expect < 0 ? m.type == MCTS_END_TURN
+	 : m.type == MCTS_BUY && m.card == expect);
+  if (expect >= 0)
+    assert(buyCard(expect, &g) == 0);
+  assert(bookMove(b, &g, &m) == -1);
+  endTurn(&g);
+  assert(bookMove(b, &g, &m) == 0);   //player 1 is on their first turn
+  endTurn(&g);
+  assert(bookMove(b, &g, &m) == 0);
+  assert(g.coins == 7 - first);
+  endTurn(&g);
+  endTurn(&g);
+  assert(bookMove(b, &g, &m) == -1);
+
+  //not for kingdoms it has not seen
+  memset(&g, 0, sizeof(g));
+  kingdomUnrank(1, other);
+  assert(initializeGame(2, other, 9, &g) == 0);
+  assert(bookMove(b, &g, &m) == -1);
+
+  //a forced opening plays out the same way from the same seed
+  assert(playOpening(k, 4, &smithyMoney, 1, SPLIT_5_2,
+		     e.buys[SPLIT_5_2], &score) == 0);
+  assert(score == 0 || score == 0.5 || score == 1);
+  assert(playOpening(k, 4, &smithyMoney, 1, SPLIT_5_2,
+		     e.buys[SPLIT_5_2], &again) == 0);
+  assert(again == score);
+
+  //a bot with the book opens from it and plays on as its inner bot
+  memset(&g, 0, sizeof(g));
+  assert(initializeGame(2, k, 9, &g) == 0);
+  bot = bookBot(strategyBot(&smithyMoney, 0), b);
+  assert(bot != NULL);
+  assert(botDecide(bot, &g, BOT_NO_DEADLINE, &m) == 0);
+  assert(bot->stats.book == 1 && bot->stats.decisions == 1);
+  g.coins = 8;
+  g.phase = 1;
+  assert(botDecide(bot, &g, BOT_NO_DEADLINE, &m) == 0);
+  assert(m.type == MCTS_BUY && m.card == province);
+  assert(bot->stats.book == 1 && bot->stats.decisions == 2);
+  botFree(bot);
+  freeBook(b);
+
+  printf("ALL TESTS OK\n");
+  return 0;
+}
@@ -0,0 +1,102 @@
+#include "dominion.h"
+#include "bot.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+
+static int k[10] = {adventurer, gardens, embargo, village, minion, mine,
+		    cutpurse, sea_hag, tribute, smithy};
+
+//the buy phase of a game one province short of over, with 8 coins
+static void lastProvince(struct gameState *g) {
+  memset(g, 0, sizeof(struct gameState));
+  assert(initializeGame(2, k, 11, g) == 0);
+  g->supplyCount[province] = 1;
+  g->phase = 1;
+  g->coins = 8;
+}
+
+int main () {
+  static struct gameState g;
+  struct mctsConfig config;
+  struct strategy smithyMoney;
+  struct mctsMove m;
+  struct bot *b;
+  double deadline;
+  long visits;
+
+  printf ("Testing bots.\n");
+
+  //a strategy bot answers at once, and buys the province
+  lastProvince(&g);
+  parseStrategy("smithy", &smithyMoney);
+  b = strategyBot(&smithyMoney, 0);
+  assert(b != NULL);
+  assert(botDecide(b, &g, botClock(), &m) == 0);
+  assert(m.type == MCTS_BUY && m.card == province);
+  botFree(b);
+
+  //with no deadline a search bot runs its iterations and finds it too
+  mctsDefaults(&config);
+  config.iterations = 300;
+  config.threads = 2;
+  b = searchBot(&config, 1000, 0, 0);
+  assert(b != NULL);
+  assert(botDecide(b, &g, BOT_NO_DEADLINE, &m) == 0);
+  assert(m.type == MCTS_BUY && m.card == province);
+  assert(b->stats.iterations >= config.iterations);
+
+  mctsApply(&m, &g);
+  botMoved(b, &m, &g);
+  assert(botDecide(b, &g, BOT_NO_DEADLINE, &m) == -1);
+  botFree(b);
+
+  //what it searched below the move it made is there for the next one
+  lastProvince(&g);
+  g.supplyCount[province] = 8;
+  b = searchBot(&config, 1000, 0, 0);
+  assert(b != NULL);
+  assert(botDecide(b, &g, BOT_NO_DEADLINE, &m) == 0);
+  assert(b->stats.reused == 0);
+  mctsApply(&m, &g);
+  botMoved(b, &m, &g);
+  assert(botDecide(b, &g, BOT_NO_DEADLINE, &m) == 0);
+  assert(b->stats.reused > 0);
+  assert(b->stats.iterations >= b->stats.reused + 2 * config.iterations);
+  botFree(b);
+
+  //with a deadline it answers about on time, with what it has
+  lastProvince(&g);
+  b = searchBot(&config, 100000, 0, 0);
+  assert(b != NULL);
+  deadline = botClock() + 0.05;
+  assert(botDecide(b, &g, deadline, &m) == 0);
+  assert(botClock() < deadline + 0.05);
+  assert(m.type == MCTS_BUY && m.card == province);
+  visits = b->stats.iterations;
+  assert(visits > 0);
+
+  //a state it was not following starts the tree over; a deadline that
+  //has passed still gets a legal move
+  g.coins = 0;
+  assert(botDecide(b, &g, botClock() - 1, &m) == 0);
+  assert(m.type == MCTS_END_TURN || (m.type == MCTS_BUY && m.card == copper));
+  botFree(b);
+
+  //a pondering bot searches the position while nobody asks it to
+  lastProvince(&g);
+  g.coins = 2;
+  m.type = MCTS_END_ACTIONS;
+  m.card = -1;
+  b = searchBot(&config, 100000, 1, 1);
+  assert(b != NULL);
+  botMoved(b, &m, &g);
+  usleep(50000);
+  assert(botDecide(b, &g, botClock(), &m) == 0);
+  assert(b->stats.iterations > 0);
+  botFree(b);
+
+  printf("ALL TESTS OK\n");
+  return 0;
+}
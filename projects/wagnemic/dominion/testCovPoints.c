@@ -0,0 +1,78 @@
+#include "dominion.h"
+#include "dominion_helpers.h"
+#include "covpoints.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+#define THREADS 4
+#define DRAWS 1000
+
+static int k[10] = {adventurer, council_room, feast, gardens, mine,
+		    remodel, smithy, village, baron, great_hall};
+
+//draws from a deck that never runs out, on its own thread
+static void *drawMany(void *arg) {
+  struct gameState G;
+  int i;
+
+  assert(initializeGame(2, k, 1, &G) == 0);
+  for (i = 0; i < DRAWS; i++) {
+    G.deckCount[0] = 10;
+    G.handCount[0] = 0;
+    assert(drawCard(0, &G) == 0);
+  }
+  return NULL;
+}
+
+int main () {
+  struct gameState G;
+  unsigned long counts[NUM_COVER_POINTS];
+  pthread_t threads[THREADS];
+  int bonus = 0;
+  int i;
+
+  printf ("Testing coverage points.\n");
+
+  for (i = 0; i < NUM_COVER_POINTS; i++) {
+    assert(coverPointName(i) != NULL);
+    assert(coverPointCard(i) == -1
+	   || (coverPointCard(i) >= adventurer
+	       && coverPointCard(i) <= treasure_map));
+  }
+  assert(coverPointName(NUM_COVER_POINTS) == NULL);
+  assert(strcmp(coverPointName(COVER_BARON_NO_ESTATE), "baron/no estate") == 0);
+  assert(coverPointCard(COVER_BARON_NO_ESTATE) == baron);
+
+  coverReset();
+  coverSnapshot(counts);
+  for (i = 0; i < NUM_COVER_POINTS; i++)
+    assert(counts[i] == 0);
+
+  //baron without an estate to discard takes the gain path
+  assert(initializeGame(2, k, 1, &G) == 0);
+  G.hand[0][0] = baron;
+  for (i = 1; i < G.handCount[0]; i++)
+    G.hand[0][i] = copper;
+  assert(cardEffect(baron, 0, 0, 0, &G, 0, &bonus) == 0);
+  coverSnapshot(counts);
+  assert(counts[COVER_BARON_GAIN_ESTATE] == 1);
+  assert(counts[COVER_BARON_DISCARD_ESTATE] == 0);
+  assert(counts[COVER_GAIN_TO_DISCARD] == 1);
+
+  //the counters of finished threads stay in the total
+  for (i = 0; i < THREADS; i++)
+    assert(pthread_create(&threads[i], NULL, drawMany, NULL) == 0);
+  for (i = 0; i < THREADS; i++)
+    assert(pthread_join(threads[i], NULL) == 0);
+  coverSnapshot(counts);
+  assert(counts[COVER_DRAW_DECK] >= THREADS * DRAWS);
+
+  coverReset();
+  coverSnapshot(counts);
+  assert(counts[COVER_DRAW_DECK] == 0);
+
+  printf("ALL TESTS OK\n");
+  return 0;
+}
@@ -0,0 +1,68 @@
+#include "dominion.h"
+#include "statefile.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <sys/wait.h>
+
+//runs ddmin on the case; returns its exit code, the report in out
+static int shrink(struct playCase *c, char *out, int size) {
+  FILE *f;
+  int n = 0;
+
+  assert(writeStateFile("testDdmin.dst", c) == 0);
+  f = popen("./ddmin -j 2 -o testDdmin-min.c testDdmin.dst", "r");
+  assert(f != NULL);
+  while (n < size - 1 && fgets(out + n, size - n, f) != NULL)
+    n += strlen(out + n);
+  return WEXITSTATUS(pclose(f));
+}
+
+int main () {
+  static struct playCase c;
+  char report[1024];
+  char test[4096];
+  FILE *f;
+  int n;
+  int i;
+  int k[10] = {adventurer, council_room, feast, gardens, mine,
+	       remodel, smithy, village, embargo, great_hall};
+
+  printf ("Testing the failure minimizer.\n");
+
+  //embargo on a pile not in the game fails after taking its coins,
+  //which fuzz reports as dirty and invariants do not see
+  assert(initializeGame(2, k, 3, &c.state) == 0);
+  c.entry = ENTRY_PLAY_CARD;
+  c.handPos = 2;
+  c.choice1 = sea_hag;
+  c.seed = 5;
+  c.state.hand[0][2] = embargo;
+  for (i = 0; i < 4; i++)
+    c.state.discard[1][i] = copper;
+  c.state.discardCount[1] = 4;
+  assert(shrink(&c, report, sizeof(report)) == 0);
+  assert(strstr(report, "Fails with: dirty\n") != NULL);
+  assert(strstr(report, "Reduced 24 cards to 1 ") != NULL);
+
+  //the test it writes checks the same thing
+  f = fopen("testDdmin-min.c", "r");
+  assert(f != NULL);
+  n = fread(test, 1, sizeof(test) - 1, f);
+  test[n] = '\0';
+  fclose(f);
+  assert(strstr(test, "Fails with: dirty */") != NULL);
+  assert(strstr(test, "G.hand[0][0] = embargo;") != NULL);
+  assert(strstr(test, "r = playCard(0, ") != NULL);
+  assert(strstr(test, "checkFailure(&pre, &post) == FIND_NONE") != NULL);
+  remove("testDdmin-min.c");
+
+  //a case that passes is not minimized
+  c.choice1 = village;
+  assert(shrink(&c, report, sizeof(report)) == 1);
+  assert(strstr(report, "does not fail") != NULL);
+  remove("testDdmin.dst");
+
+  printf ("ALL TESTS OK\n");
+  return 0;
+}
@@ -0,0 +1,93 @@
+#include "dominion.h"
+#include "dominion_helpers.h"
+#include "delta.h"
+#include "statediff.h"
+#include "rngs.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+static struct gameState shadow, mirror;
+static unsigned char body[DELTA_MAX_SIZE];
+static long deltaBytes = 0;
+static long deltas = 0;
+
+//what a receiver of every delta so far would hold must match the game
+static void sync(struct gameState *g) {
+  int size = encodeDelta(g, &shadow, body);
+
+  assert(size >= 2 && size <= DELTA_MAX_SIZE);
+  assert(applyDelta(body, size, &mirror) >= 0);
+  assert(sameGameState(&mirror, g));
+  assert(sameGameState(&shadow, g));
+  deltaBytes += size;
+  deltas++;
+}
+
+int main () {
+  static struct gameState G;
+  int k[10] = {council_room, smithy, village, baron, great_hall, minion,
+	       steward, cutpurse, embargo, sea_hag};
+  int seed = 1;
+  int game;
+  int turn;
+  int size;
+  int i;
+  char *s = getenv("TEST_SEED");
+
+  if (s != NULL)
+    seed = atoi(s);
+  printf ("Testing state deltas with seed %d.\n", seed);
+  srand(seed);
+
+  //a keyframe overwrites whatever the receiver had
+  assert(initializeGame(3, k, seed, &G) == 0);
+  memset(&mirror, 0x5a, sizeof(mirror));
+  memset(&shadow, 0xa5, sizeof(shadow));
+  size = encodeKeyframe(&G, &shadow, body);
+  assert(applyDelta(body, size, &mirror) > 0);
+  assert(sameGameState(&mirror, &G) && sameGameState(&shadow, &G));
+
+  //nothing changed, nothing sent
+  assert(encodeDelta(&G, &shadow, body) == 2);
+
+  //a draw is a card into the hand and a shorter deck
+  assert(drawCard(0, &G) == 0);
+  size = encodeDelta(&G, &shadow, body);
+  assert(size == 2 + 2 * DELTA_PILE_HEADER + 1);
+  assert(applyDelta(body, size, &mirror) == 2);
+  assert(sameGameState(&mirror, &G));
+
+  //whole games, with a delta after every call
+  for (game = 0; game < 20; game++) {
+    assert(initializeGame(2 + game % 3, k, seed + game, &G) == 0);
+    sync(&G);
+    for (turn = 0; turn < 200 && !isGameOver(&G); turn++) {
+      for (i = 0; i < 3 && G.numActions > 0; i++) {
+	playCard(rand() % (G.handCount[G.whoseTurn] + 1), 1 + rand() % 2,
+		 rand() % 5, rand() % 5, &G);
+	sync(&G);
+      }
+      buyCard(G.coins >= 8 ? province : k[rand() % 10], &G);
+      sync(&G);
+      buyCard(rand() % 2 ? silver : copper, &G);
+      sync(&G);
+      assert(endTurn(&G) == 0);
+      sync(&G);
+    }
+  }
+  size = encodeKeyframe(&G, &shadow, body);
+  printf("Average delta %ld bytes against a %d byte keyframe\n",
+	 deltaBytes / deltas, size);
+  assert(deltaBytes / deltas < size / 4);
+
+  //malformed bodies are refused
+  assert(applyDelta(body, 1, &mirror) == -1);
+  assert(applyDelta(body, size - 1, &mirror) == -1);
+  body[2] = 99;
+  assert(applyDelta(body, size, &mirror) == -1);
+
+  printf("ALL TESTS OK\n");
+  return 0;
+}
@@ -0,0 +1,114 @@
+#include "dominion.h"
+#include "drawprob.h"
+#include "rngs.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#define TRIALS 20000
+
+static int k[10] = {adventurer, gardens, embargo, village, minion, mine,
+		    cutpurse, sea_hag, tribute, smithy};
+
+static int near(double a, double b, double slack) {
+  return fabs(a - b) <= slack;
+}
+
+int main () {
+  static struct gameState g, drawn;
+  struct drawPiles piles;
+  struct drawStats stats;
+  double dist[DRAW_MAX_COINS + 1];
+  double seen[DRAW_MAX_COINS + 1];
+  double sum;
+  int top;
+  int coins;
+  int t;
+  int i;
+
+  printf ("Testing draw probabilities.\n");
+
+  //five from five coppers and five estates: a plain hypergeometric
+  memset(&piles, 0, sizeof(piles));
+  piles.deck[DRAW_COPPER] = 5;
+  piles.deck[DRAW_OTHER] = 5;
+  top = drawCoins(&piles, 5, dist);
+  assert(top == 5);
+  assert(near(dist[5], 1.0 / 252, 1e-12));
+  assert(near(dist[3], 100.0 / 252, 1e-12));
+  for (sum = 0, i = 0; i <= top; i++)
+    sum += dist[i];
+  assert(near(sum, 1, 1e-12));
+  assert(near(drawAtLeastCoins(&piles, 5, 3), 0.5, 1e-12));
+
+  //two golds left in the deck are drawn, then three of six after the
+  //reshuffle
+  memset(&piles, 0, sizeof(piles));
+  piles.deck[DRAW_GOLD] = 2;
+  piles.discard[DRAW_COPPER] = 3;
+  piles.discard[DRAW_OTHER] = 3;
+  top = drawCoins(&piles, 5, dist);
+  assert(top == 9);
+  for (i = 0; i < 6; i++)
+    assert(dist[i] == 0);
+  assert(near(dist[6], 1.0 / 20, 1e-12));
+  assert(near(dist[7], 9.0 / 20, 1e-12));
+  assert(near(dist[9], 1.0 / 20, 1e-12));
+
+  //and past both piles, what there is
+  memset(&piles, 0, sizeof(piles));
+  piles.deck[DRAW_SILVER] = 1;
+  piles.discard[DRAW_SILVER] = 1;
+  assert(drawCoins(&piles, 5, dist) == 4 && dist[4] == 1);
+  assert(drawCoins(&piles, DRAW_MAX_CARDS + 1, dist) == -1);
+
+  //one treasure map in ten: even odds it is in the five
+  top = drawCardCount(10, 1, 0, 0, 5, dist);
+  assert(top == 1 && near(dist[1], 0.5, 1e-12));
+  top = drawCardCount(2, 1, 8, 1, 5, dist);
+  assert(top == 2 && near(dist[1], 5.0 / 8, 1e-12));
+  assert(drawCardCount(2, 3, 0, 0, 1, dist) == -1);
+
+  //the answers agree with the engine drawing for itself
+  memset(&g, 0, sizeof(g));
+  assert(initializeGame(2, k, 3, &g) == 0);
+  g.deckCount[0] = 0;
+  g.deck[0][g.deckCount[0]++] = gold;
+  g.deck[0][g.deckCount[0]++] = estate;
+  g.deck[0][g.deckCount[0]++] = silver;
+  g.discardCount[0] = 0;
+  for (i = 0; i < 9; i++)
+    g.discard[0][g.discardCount[0]++] = i % 3 == 0 ? estate
+      : i % 3 == 1 ? copper : silver;
+  drawPilesFor(0, 1, &g, &piles);
+  //the hand goes to the discard pile before player 0 draws again
+  assert(piles.deck[DRAW_GOLD] == 1 && piles.deck[DRAW_SILVER] == 1
+	 && piles.deck[DRAW_OTHER] == 1 && piles.deck[DRAW_COPPER] == 0);
+  assert(piles.discard[DRAW_COPPER] + piles.discard[DRAW_SILVER]
+	 + piles.discard[DRAW_OTHER] == 9 + g.handCount[0]);
+  top = drawCoins(&piles, 5, dist);
+  memset(seen, 0, sizeof(seen));
+  SelectStream(1);
+  PutSeed(5);
+  for (t = 0; t < TRIALS; t++) {
+    memcpy(&drawn, &g, sizeof(g));
+    endTurn(&drawn);
+    endTurn(&drawn);
+    for (coins = 0, i = 0; i < drawn.handCount[0]; i++)
+      coins += drawn.hand[0][i] == copper ? 1 : drawn.hand[0][i] == silver
+	? 2 : drawn.hand[0][i] == gold ? 3 : 0;
+    seen[coins] += 1.0 / TRIALS;
+  }
+  for (i = 0; i <= DRAW_MAX_COINS; i++)
+    assert(near(seen[i], i <= top ? dist[i] : 0, 0.015));
+
+  //asking again is answered from the table
+  assert(drawCoins(&piles, 5, seen) == top);
+  assert(memcmp(seen, dist, (top + 1) * sizeof(double)) == 0);
+  drawCacheStats(&stats);
+  assert(stats.hits >= 1 && stats.queries > stats.hits);
+
+  printf("ALL TESTS OK\n");
+  return 0;
+}
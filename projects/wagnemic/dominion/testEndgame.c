@@ -0,0 +1,98 @@
+#include "dominion.h"
+#include "endgame.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+static int k[10] = {adventurer, gardens, embargo, village, minion, mine,
+		    cutpurse, sea_hag, tribute, smithy};
+
+//player 0 in the buys with coins, down to the last provinces, and
+//player 1 given extra provinces
+static void lastTurns(struct gameState *g, int provinces, int coins,
+		      int given) {
+  memset(g, 0, sizeof(struct gameState));
+  assert(initializeGame(2, k, 5, g) == 0);
+  g->supplyCount[province] = provinces;
+  while (given-- > 0)
+    g->discard[1][g->discardCount[1]++] = province;
+  g->phase = 1;
+  g->coins = coins;
+}
+
+int main () {
+  static struct gameState g;
+  struct endgameResult r, again;
+  struct strategy bigMoney;
+  struct endgame *e;
+  struct mctsMove m;
+  struct bot *b;
+
+  printf ("Testing the endgame solver.\n");
+
+  e = endgameCreate(16);
+  assert(e != NULL);
+
+  //not yet, then yes
+  memset(&g, 0, sizeof(g));
+  assert(initializeGame(2, k, 5, &g) == 0);
+  assert(!endgameActive(&g));
+  g.supplyCount[province] = ENDGAME_PROVINCES;
+  assert(endgameActive(&g));
+
+  //the last province wins the game outright, and nothing needs guessing
+  lastTurns(&g, 1, 8, 0);
+  assert(endgameSolve(e, &g, botClock() + 5, 4, &r) == 0);
+  assert(r.move.type == MCTS_BUY && r.move.card == province);
+  assert(r.value == 1 && r.depth == 1);
+
+  //two provinces behind, taking the last one only ends the game lost
+  lastTurns(&g, 1, 8, 2);
+  assert(endgameSolve(e, &g, botClock() + 5, 3, &r) == 0);
+  assert(!(r.move.type == MCTS_BUY && r.move.card == province));
+  assert(r.value > 0 && r.value < 1);
+
+  //two piles out and one card left on a third: ending it while ahead wins
+  lastTurns(&g, 8, 4, 0);
+  g.supplyCount[village] = 0;
+  g.supplyCount[minion] = 0;
+  g.supplyCount[smithy] = 1;
+  g.discard[0][g.discardCount[0]++] = duchy;
+  assert(endgameActive(&g));
+  assert(endgameSolve(e, &g, botClock() + 5, 3, &r) == 0);
+  assert(r.move.type == MCTS_BUY && r.move.card == smithy);
+  assert(r.value == 1);
+
+  //the table remembers what it worked out
+  lastTurns(&g, 2, 6, 0);
+  assert(endgameSolve(e, &g, botClock() + 5, 3, &r) == 0);
+  assert(endgameSolve(e, &g, botClock() + 5, 3, &again) == 0);
+  assert(again.move.type == r.move.type && again.move.card == r.move.card);
+  assert(again.nodes < r.nodes);
+
+  //with no turns to search there is no answer
+  assert(endgameSolve(e, &g, botClock() + 5, 0, &r) == -1);
+  g.numPlayers = 3;
+  assert(endgameSolve(e, &g, botClock() + 5, 3, &r) == -1);
+  endgameFree(e);
+
+  //as a bot, it takes the buys over once the end is near
+  parseStrategy("bigmoney", &bigMoney);
+  b = endgameBot(strategyBot(&bigMoney, 0), 3);
+  assert(b != NULL);
+  memset(&g, 0, sizeof(g));
+  assert(initializeGame(2, k, 5, &g) == 0);
+  g.phase = 1;
+  g.coins = 8;
+  assert(botDecide(b, &g, BOT_NO_DEADLINE, &m) == 0);
+  assert(m.type == MCTS_BUY && m.card == province);
+  assert(b->stats.decisions == 1 && b->stats.endgame == 0);
+  lastTurns(&g, 1, 8, 0);
+  assert(botDecide(b, &g, BOT_NO_DEADLINE, &m) == 0);
+  assert(m.type == MCTS_BUY && m.card == province);
+  assert(b->stats.decisions == 2 && b->stats.endgame == 1);
+  botFree(b);
+
+  printf("ALL TESTS OK\n");
+  return 0;
+}
@@ -0,0 +1,57 @@
+#include "dominion.h"
+#include "statefile.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <sys/wait.h>
+
+//runs enumstate with args; returns its exit code, the report in out
+static int enumerate(const char *args, char *out, int size) {
+  char command[256];
+  FILE *f;
+  int n = 0;
+
+  snprintf(command, sizeof(command), "./enumstate -j 2 %s", args);
+  f = popen(command, "r");
+  assert(f != NULL);
+  while (n < size - 1 && fgets(out + n, size - n, f) != NULL)
+    n += strlen(out + n);
+  return WEXITSTATUS(pclose(f));
+}
+
+int main () {
+  static struct playCase c;
+  char report[4096];
+
+  printf ("Testing the state enumerator.\n");
+
+  //drawCard matches its model on every small state
+  assert(enumerate("-h 2 -d 2 -x 2 -c copper,estate drawCard", report,
+		   sizeof(report)) == 0);
+  assert(strstr(report, "States: 252 (6 hands x 7 decks x 6 discards"
+		" x 1 choices)\n") != NULL);
+  assert(strstr(report, "Violations (invariant): 0\n") != NULL);
+  assert(strstr(report, "Violations (changed): 0\n") != NULL);
+  assert(strstr(report, "Violations (model): 0\n") != NULL);
+
+  //steward trashing two cards from a hand of only itself leaves a
+  //negative hand count
+  assert(enumerate("-h 2 -d 2 -x 1 -C 3 -c copper,estate "
+		   "-o testEnumState steward", report, sizeof(report)) == 1);
+  assert(strstr(report, "States: 1701 (3 hands x 7 decks x 3 discards"
+		" x 27 choices)\n") != NULL);
+  assert(strstr(report, "Violations (invariant): 567\n") != NULL);
+  assert(strstr(report, "Violations (changed): 0\n") != NULL);
+  assert(strstr(report, "Violations (model): 0\n") != NULL);
+  assert(strstr(report, "First invariant state: 0\n") != NULL);
+
+  //the first one is written out for ddmin
+  assert(readStateFile("testEnumState-invariant.dst", &c) == 0);
+  assert(c.entry == ENTRY_CARD_EFFECT && c.card == steward);
+  assert(c.state.handCount[0] == 1 && c.state.hand[0][0] == steward);
+  assert(c.choice1 == 0 && c.choice2 == 0 && c.choice3 == 0);
+  remove("testEnumState-invariant.dst");
+
+  printf ("ALL TESTS OK\n");
+  return 0;
+}
@@ -0,0 +1,63 @@
+#include "dominion.h"
+#include "invariants.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+int main () {
+  struct gameState G;
+  struct gameState bad;
+  char why[INVARIANT_TEXT];
+  long total;
+  int k[10] = {adventurer, council_room, feast, gardens, mine,
+	       remodel, smithy, village, baron, great_hall};
+  int i;
+
+  printf ("Testing checkInvariants.\n");
+
+  assert(initializeGame(2, k, 1, &G) == 0);
+  total = cardTotal(&G);
+  assert(checkInvariants(&G, total, why, sizeof(why)) == 0);
+  assert(why[0] == '\0');
+
+  //a game played through keeps to them
+  for (i = 0; i < 40; i++) {
+    buyCard(silver, &G);
+    assert(endTurn(&G) == 0);
+    assert(checkInvariants(&G, total, why, sizeof(why)) == 0);
+    total = cardTotal(&G);
+  }
+
+  memcpy(&bad, &G, sizeof(bad));
+  bad.deckCount[1] = -1;
+  assert(checkInvariants(&bad, -1, why, sizeof(why)) == 1);
+  assert(strstr(why, "deck[1]") != NULL);
+
+  memcpy(&bad, &G, sizeof(bad));
+  bad.handCount[0] = MAX_HAND + 1;
+  bad.supplyCount[gold] = -2;
+  assert(checkInvariants(&bad, -1, why, sizeof(why)) == 2);
+
+  memcpy(&bad, &G, sizeof(bad));
+  bad.hand[0][0] = treasure_map + 1;
+  assert(checkInvariants(&bad, -1, why, sizeof(why)) == 1);
+  assert(strstr(why, "card") != NULL);
+
+  memcpy(&bad, &G, sizeof(bad));
+  bad.whoseTurn = 2;
+  assert(checkInvariants(&bad, -1, why, sizeof(why)) == 1);
+
+  //created out of nothing, as opposed to gained from the supply
+  memcpy(&bad, &G, sizeof(bad));
+  bad.discard[0][bad.discardCount[0]++] = curse;
+  assert(checkInvariants(&bad, total, why, sizeof(why)) == 1);
+  assert(strstr(why, "created") != NULL);
+  bad.supplyCount[curse]--;
+  assert(checkInvariants(&bad, total, why, sizeof(why)) == 0);
+  //trashing only loses cards
+  bad.discardCount[0] -= 2;
+  assert(checkInvariants(&bad, total, why, sizeof(why)) == 0);
+
+  printf ("ALL TESTS OK\n");
+  return 0;
+}
@@ -0,0 +1,99 @@
+#include "dominion.h"
+#include "ismcts.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+static int k[10] = {adventurer, gardens, embargo, village, minion, mine,
+		    cutpurse, sea_hag, tribute, smithy};
+
+//a few turns into a game, so there are discards and a part-drawn deck
+static void midGame(struct gameState *g) {
+  struct mctsMove m;
+  int i;
+
+  memset(g, 0, sizeof(struct gameState));
+  assert(initializeGame(2, k, 11, g) == 0);
+  m.type = MCTS_END_TURN;
+  m.card = -1;
+  for (i = 0; i < 5; i++)
+    assert(mctsApply(&m, g) == 0);
+}
+
+int main () {
+  static struct gameState g, d;
+  struct mctsConfig config;
+  struct mctsStats stats;
+  struct mctsMove moves[MCTS_MAX_MOVES];
+  struct mctsMove best, again;
+  unsigned long long rng = 7;
+  int observer;
+  int changed = 0;
+  int n;
+  int p;
+  int c;
+  int i;
+
+  printf ("Testing ISMCTS.\n");
+
+  //a determinization keeps what the observer knows and deals the rest
+  midGame(&g);
+  observer = whoseTurn(&g);
+  for (i = 0; i < 50; i++) {
+    mctsDeterminize(&g, observer, &rng, &d);
+    assert(memcmp(d.hand[observer], g.hand[observer],
+		  g.handCount[observer] * sizeof(int)) == 0);
+    for (p = 0; p < g.numPlayers; p++) {
+      assert(d.handCount[p] == g.handCount[p]);
+      assert(d.deckCount[p] == g.deckCount[p]);
+      assert(memcmp(d.discard[p], g.discard[p],
+		    g.discardCount[p] * sizeof(int)) == 0);
+      for (c = curse; c <= treasure_map; c++)
+	assert(fullDeckCount(p, c, &d) == fullDeckCount(p, c, &g));
+    }
+    assert(memcmp(d.supplyCount, g.supplyCount, sizeof(g.supplyCount)) == 0);
+    //between turns the hands are drawn from the deck, so that is what moves
+    changed += memcmp(d.deck[1 - observer], g.deck[1 - observer],
+		      g.deckCount[1 - observer] * sizeof(int)) != 0;
+  }
+  assert(changed > 0);
+
+  //the buys are what the coins allow, and the turn can always end
+  midGame(&g);
+  g.phase = 1;
+  g.coins = 3;
+  n = mctsLegalMoves(&g, moves);
+  assert(moves[n - 1].type == MCTS_END_TURN);
+  for (i = 0; i < n - 1; i++) {
+    assert(moves[i].type == MCTS_BUY);
+    assert(moves[i].card != curse && moves[i].card != gold);
+  }
+
+  //with the last province worth the game, the search buys it
+  mctsDefaults(&config);
+  config.iterations = 500;
+  midGame(&g);
+  g.supplyCount[province] = 1;
+  g.phase = 1;
+  g.coins = 8;
+  assert(mctsDecide(&g, &config, &best, &stats) == 0);
+  assert(best.type == MCTS_BUY && best.card == province);
+  assert(stats.iterations == config.iterations);
+  assert(stats.nodes > 1 && stats.nodes <= config.iterations + 1);
+
+  //one thread is repeatable; several share the tree and still agree here
+  assert(mctsDecide(&g, &config, &again, &stats) == 0);
+  assert(again.type == best.type && again.card == best.card);
+  config.threads = 4;
+  assert(mctsDecide(&g, &config, &again, &stats) == 0);
+  assert(again.type == MCTS_BUY && again.card == province);
+  assert(stats.iterations == config.iterations);
+
+  //and once the game is over there is nothing to decide
+  g.supplyCount[province] = 0;
+  assert(mctsLegalMoves(&g, moves) == 0);
+  assert(mctsDecide(&g, &config, &best, NULL) == -1);
+
+  printf("ALL TESTS OK\n");
+  return 0;
+}
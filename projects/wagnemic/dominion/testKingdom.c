@@ -0,0 +1,41 @@
+#include "dominion.h"
+#include "kingdom.h"
+#include <stdio.h>
+#include <assert.h>
+
+int main () {
+  int k[KINGDOM_SIZE];
+  int k2[KINGDOM_SIZE] = {adventurer, gardens, embargo, village, minion, mine,
+			  cutpurse, sea_hag, tribute, smithy};
+  long rank;
+  long sample;
+  int i;
+
+  printf ("Testing kingdomRank/kingdomUnrank.\n");
+
+  for (rank = 0; rank < KINGDOM_SETS; rank++) {
+    assert(kingdomUnrank(rank, k) == 0);
+    for (i = 1; i < KINGDOM_SIZE; i++)
+      assert(k[i-1] < k[i]);
+    assert(kingdomRank(k) == rank);
+  }
+  assert(kingdomUnrank(KINGDOM_SETS, k) == -1);
+
+  //order of the cards does not matter, duplicates are rejected
+  rank = kingdomRank(k2);
+  assert(rank >= 0);
+  assert(kingdomUnrank(rank, k) == 0);
+  assert(kingdomMask(k) == kingdomMask(k2));
+  k2[1] = adventurer;
+  assert(kingdomRank(k2) == -1);
+
+  printf ("Testing kingdomSample.\n");
+  for (i = 0; i < 1000; i++) {
+    sample = kingdomSample(i, 1000, 7);
+    assert(sample >= i * KINGDOM_SETS / 1000);
+    assert(sample < (i + 1) * KINGDOM_SETS / 1000);
+  }
+
+  printf ("ALL TESTS OK\n");
+  return 0;
+}
@@ -0,0 +1,114 @@
+#include "mutschema.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <sys/wait.h>
+
+#define FIXTURE_MUTANTS 18
+
+int clampTo(int n, int max);
+int pickLimit(int which);
+
+static char mutants[FIXTURE_MUTANTS][128];
+
+//the fixture's own test, as mutrun runs it; 4 mutants get past it
+static int fixtureTest(void) {
+  return clampTo(-3, 5) == 0 && clampTo(7, 5) == 4 && clampTo(2, 5) == 2
+    && pickLimit(1) == 2 && pickLimit(4) == 5 ? 0 : 1;
+}
+
+//the id of the mutant described as "function:line change"
+static int mutant(const char *what) {
+  int i;
+
+  for (i = 0; i < FIXTURE_MUTANTS; i++) {
+    if (strcmp(mutants[i], what) == 0)
+      return i + 1;
+  }
+  assert(0);
+  return 0;
+}
+
+static int runMutrun(const char *args, char *out, int size) {
+  char command[256];
+  FILE *f;
+  int n = 0;
+
+  snprintf(command, sizeof(command),
+	   "./mutrun -j 2 %s mutfixture.lst ./testMutate", args);
+  f = popen(command, "r");
+  assert(f != NULL);
+  while (n < size - 1 && fgets(out + n, size - n, f) != NULL)
+    n += strlen(out + n);
+  return WEXITSTATUS(pclose(f));
+}
+
+int main () {
+  char line[256];
+  char where[64];
+  char report[8192];
+  FILE *f;
+  int id;
+  int site;
+  int pos;
+  int n = 0;
+
+  if (getenv("DOMINION_MUTANT") != NULL)
+    return fixtureTest();
+
+  printf ("Testing mutation analysis.\n");
+
+  //one mutant per line, numbered from 1; nothing in the static
+  //initializer (line 4) or the case label (line 16)
+  f = fopen("mutfixture.lst", "r");
+  assert(f != NULL);
+  while (fgets(line, sizeof(line), f) != NULL) {
+    assert(n < FIXTURE_MUTANTS);
+    assert(sscanf(line, "%d %d %63s %n", &id, &site, where, &pos) == 3);
+    assert(id == n + 1 && site <= id);
+    assert(strchr(where, ':') != NULL);
+    assert(atoi(strchr(where, ':') + 1) != 4);
+    assert(atoi(strchr(where, ':') + 1) != 16);
+    line[strcspn(line, "\n")] = '\0';
+    snprintf(mutants[n++], sizeof(mutants[0]), "%s %s", where, line + pos);
+  }
+  fclose(f);
+  assert(n == FIXTURE_MUTANTS);
+
+  //unmutated, the schema computes what the fixture does
+  mutantId = 0;
+  memset(mutantCovered, 0, sizeof(mutantCovered));
+  assert(clampTo(2, 5) == 2);
+  assert(mutantCovered[mutant("clampTo:7 < -> <=")]);
+  assert(mutantCovered[mutant("clampTo:9 >= -> >")]);
+  assert(!mutantCovered[mutant("clampTo:10 - -> +")]);
+  assert(!mutantCovered[mutant("pickLimit:19 + -> -")]);
+  assert(fixtureTest() == 0);
+
+  //each id switches on its own change
+  mutantId = mutant("clampTo:7 if condition false");
+  assert(clampTo(-3, 5) == -3 && clampTo(2, 5) == 2);
+  mutantId = mutant("clampTo:7 < -> >=");
+  assert(clampTo(2, 5) == 0 && clampTo(-3, 5) == -3);
+  mutantId = mutant("clampTo:7 0 -> -1");
+  assert(clampTo(-1, 5) == -1 && clampTo(-2, 5) == 0);
+  mutantId = mutant("clampTo:9 >= -> <");
+  assert(clampTo(2, 5) == 4);
+  mutantId = mutant("clampTo:10 - -> +");
+  assert(clampTo(7, 5) == 6 && clampTo(2, 5) == 2);
+  mutantId = mutant("pickLimit:19 1 -> 0");
+  assert(pickLimit(4) == 4 && pickLimit(1) == 2);
+  mutantId = 0;
+
+  //mutrun kills what the fixture's test catches
+  assert(runMutrun("", report, sizeof(report)) == 0);
+  assert(strstr(report, "Mutants: 18, covered: 18, killed: 14,") != NULL);
+  assert(runMutrun("-s", report, sizeof(report)) == 0);
+  assert(strstr(report, "< -> <=") != NULL);
+  assert(strstr(report, ">= -> > ") != NULL);
+  assert(strstr(report, "if condition false") == NULL);
+
+  printf ("ALL TESTS OK\n");
+  return 0;
+}
@@ -0,0 +1,89 @@
+#include "dominion.h"
+#include "perfstats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <assert.h>
+
+//a scope on another thread, counted after that thread is gone
+static void *countOnThread(void *arg) {
+  struct perfMark m = perfBegin(PERF_SHUFFLE);
+
+  perfShuffled++;
+  perfEnd(&m);
+  return arg;
+}
+
+int main () {
+  static struct perfHist h, other;
+  static struct perfStats s;
+  struct perfMark outer;
+  struct perfMark inner;
+  unsigned long long v;
+  unsigned long long p;
+  pthread_t t;
+  int i;
+
+  printf ("Testing performance counters.\n");
+
+  //small values are exact, larger ones within one sub-bucket
+  memset(&h, 0, sizeof(h));
+  for (v = 0; v < 2 * PERF_SUB_BUCKETS; v++)
+    perfHistRecord(&h, v);
+  assert(perfHistPercentile(&h, 0) == 0);
+  assert(perfHistPercentile(&h, 50) == PERF_SUB_BUCKETS);
+  assert(perfHistPercentile(&h, 100) == 2 * PERF_SUB_BUCKETS - 1);
+
+  memset(&h, 0, sizeof(h));
+  for (v = 1; v <= 100000; v++)
+    perfHistRecord(&h, v);
+  assert(h.count == 100000 && h.max == 100000);
+  for (i = 1; i < 100; i += 7) {
+    p = perfHistPercentile(&h, i);
+    assert(p >= i * 1000ULL && p <= i * 1000ULL * 17 / 16 + 1);
+  }
+  assert(perfHistPercentile(&h, 100) == 100000);
+
+  //huge values land in the top bucket without overflowing it
+  memset(&other, 0, sizeof(other));
+  perfHistRecord(&other, ~0ULL);
+  perfHistRecord(&other, 1ULL << 60);
+  assert(other.buckets[PERF_BUCKETS - 1] == 2);
+  perfHistMerge(&h, &other);
+  assert(h.count == 100002 && h.max == ~0ULL);
+  assert(perfHistPercentile(&h, 100) == ~0ULL);
+
+  //draws and shuffles count towards every scope they happen in
+  perfReset();
+  outer = perfBegin(smithy);
+  for (i = 0; i < 3; i++) {
+    inner = perfBegin(PERF_DRAW_CARD);
+    perfDrawn++;
+    perfEnd(&inner);
+  }
+  perfEnd(&outer);
+  inner = perfBegin(-7);
+  perfEnd(&inner);
+  assert(pthread_create(&t, NULL, countOnThread, NULL) == 0);
+  assert(pthread_join(t, NULL) == 0);
+
+  perfSnapshot(&s);
+  assert(s.sites[smithy].calls == 1 && s.sites[smithy].drawn == 3);
+  assert(s.sites[PERF_DRAW_CARD].calls == 3);
+  assert(s.sites[PERF_DRAW_CARD].drawn == 3);
+  assert(s.sites[PERF_DRAW_CARD].cycles.count == 3);
+  assert(s.sites[PERF_CARD_EFFECT_OTHER].calls == 1);
+  assert(s.sites[PERF_SHUFFLE].calls == 1 && s.sites[PERF_SHUFFLE].shuffles == 1);
+  assert(strcmp(perfSiteName(mine), "mine") == 0);
+  assert(strcmp(perfSiteName(PERF_SCORE_FOR), "scoreFor") == 0);
+  assert(perfPrint(stdout, &s) == 4);
+
+  perfReset();
+  perfSnapshot(&s);
+  assert(s.sites[smithy].calls == 0 && s.sites[PERF_SHUFFLE].calls == 0);
+  assert(perfPrint(stdout, &s) == 0);
+
+  printf("ALL TESTS OK\n");
+  return 0;
+}
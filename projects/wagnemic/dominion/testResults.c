@@ -0,0 +1,80 @@
+#include "dominion.h"
+#include "results.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+
+static int k[10] = {adventurer, gardens, embargo, village, minion, mine,
+		    cutpurse, sea_hag, tribute, smithy};
+
+int main () {
+  char dir[] = "/tmp/testResultsXXXXXX";
+  char path[64];
+  struct simResult r;
+  struct resultWriter *w;
+  struct resultStore *s;
+  unsigned char raw[COLUMN_HEADER_SIZE + 2];
+  struct columnInfo info;
+  FILE *f;
+  int col;
+
+  printf ("Testing result stores.\n");
+
+  assert(mkdtemp(dir) != NULL);
+  memset(&r, 0, sizeof(r));
+  r.seed = 123456789;
+  memcpy(r.kingdom, k, sizeof(k));
+  r.numPlayers = 2;
+  r.strategies[0].action = smithy;
+  r.strategies[1].action = -1;
+  r.turns = 70000;
+  r.winners = 2;
+  r.scores[0] = -5;
+  r.scores[1] = -40000;
+  r.buys[0][smithy] = 300;
+  r.buys[1][silver] = 7;
+
+  w = openResultWriter(dir);
+  assert(w != NULL);
+  assert(appendResult(w, &r) == 0);
+  r.scores[0] = 40000;
+  assert(appendResult(w, &r) == 0);
+  assert(closeResultWriter(w) == 0);
+
+  //negative values survive, and values out of range are clamped to it
+  s = openResultStore(dir);
+  assert(s != NULL && s->rows == 2);
+  assert(resultValue(s, COL_SEED, 0, 0) == 123456789);
+  assert(resultValue(s, COL_PLAYERS, 0, 0) == 2);
+  assert(resultValue(s, COL_TURNS, 0, 0) == 65535);
+  assert(resultValue(s, COL_WINNER, 0, 1) == 2);
+  assert(resultValue(s, COL_STRAT0, 0, 0) == smithy);
+  assert(resultValue(s, COL_STRAT0 + 1, 0, 0) == -1);
+  assert(resultValue(s, COL_STRAT0 + 2, 0, 0) == -1);
+  assert(resultValue(s, COL_SCORE0, 0, 0) == -5);
+  assert(resultValue(s, COL_SCORE0, 0, 1) == 32767);
+  assert(resultValue(s, COL_SCORE0 + 1, 0, 0) == -32768);
+  assert(resultValue(s, COL_BUYS0, smithy, 0) == 255);
+  assert(resultValue(s, COL_BUYS0 + 1, silver, 1) == 7);
+  assert(resultValue(s, COL_BUYS0 + 1, gold, 1) == 0);
+  closeResultStore(s);
+
+  //and the files are little-endian whatever the host
+  snprintf(path, sizeof(path), "%s/score0.col", dir);
+  f = fopen(path, "rb");
+  assert(f != NULL && fread(raw, sizeof(raw), 1, f) == 1);
+  fclose(f);
+  assert(raw[COLUMN_HEADER_SIZE] == 0xfb && raw[COLUMN_HEADER_SIZE + 1] == 0xff);
+
+  for (col = 0; col < NUM_RESULT_COLUMNS; col++) {
+    resultColumnInfo(col, &info);
+    snprintf(path, sizeof(path), "%s/%s.col", dir, info.name);
+    assert(remove(path) == 0);
+  }
+  assert(rmdir(dir) == 0);
+
+  printf("ALL TESTS OK\n");
+  return 0;
+}
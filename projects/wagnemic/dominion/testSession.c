@@ -0,0 +1,152 @@
+#include "dominion.h"
+#include "session.h"
+#include "outbuf.h"
+#include "rngs.h"
+#include "interface.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+static const char *script[] = {
+  "init 2 1\n", "play 0 1 2 3\n", "buy 4\n", "end\n", "end\n", "stat\n",
+  "show\n", "end\n"
+};
+#define SCRIPT_LINES (int)(sizeof(script) / sizeof(script[0]))
+
+int main () {
+  static struct session a, b, alone, quiet;
+  struct outBuf outA, outB, outAlone, outQuiet;
+  struct outBuf small;
+  const char *text;
+  char line[64];
+  int i;
+
+  printf ("Testing sessions.\n");
+
+  assert(outInit(&outA, 16, 1 << 20) == 0);
+  assert(outInit(&outB, 16, 1 << 20) == 0);
+  assert(outInit(&outAlone, 16, 1 << 20) == 0);
+
+  //two sessions taking turns play exactly as one on its own
+  assert(sessionStart(&alone, 5, &outAlone) == 0);
+  for (i = 0; i < SCRIPT_LINES; i++)
+    assert(sessionCommand(&alone, script[i], &outAlone) == 0);
+  assert(sessionStart(&a, 5, &outA) == 0);
+  assert(sessionStart(&b, 9, &outB) == 0);
+  for (i = 0; i < SCRIPT_LINES; i++) {
+    assert(sessionCommand(&a, script[i], &outA) == 0);
+    assert(sessionCommand(&b, script[i], &outB) == 0);
+    //and whatever else uses the stream in between does not matter
+    SelectStream(1);
+    PutSeed(12345);
+    Random();
+  }
+  assert(outA.len == outAlone.len);
+  assert(memcmp(outA.data, outAlone.data, outA.len) == 0);
+  assert(memcmp(&a.game, &alone.game, sizeof(struct gameState)) == 0);
+  assert(a.commands == SCRIPT_LINES);
+  assert(strstr(outA.data, "Executing Bot Player 1") != NULL);
+
+  //arguments out of range are refused, not passed on
+  outClear(&outA);
+  assert(sessionCommand(&a, "buy 99999\n", &outA) == 0);
+  assert(strstr(outA.data, "cannot buy card 99999") != NULL);
+  assert(sessionCommand(&a, "play -7\n", &outA) == 0);
+  assert(sessionCommand(&a, "play 100000\n", &outA) == 0);
+  assert(strstr(outA.data, "cannot play card 100000") != NULL);
+  for (i = 0; i < MAX_HAND + 10; i++)
+    assert(sessionCommand(&a, "add 13\n", &outA) == 0);
+  assert(a.game.handCount[whoseTurn(&a.game)] == MAX_HAND);
+  assert(sessionCommand(&a, "init 9 12\n", &outA) == 0);
+  assert(sessionCommand(&a, "\n", &outA) == 0);
+
+  //choices are checked against what the card does with them
+  outClear(&outB);
+  assert(sessionStart(&b, 3, &outB) == 0);
+  assert(sessionCommand(&b, "init 2 0\n", &outB) == 0);
+  snprintf(line, sizeof(line), "add %d\n", embargo);
+  assert(sessionCommand(&b, line, &outB) == 0);
+  snprintf(line, sizeof(line), "add %d\n", feast);
+  assert(sessionCommand(&b, line, &outB) == 0);
+  snprintf(line, sizeof(line), "add %d\n", mine);
+  assert(sessionCommand(&b, line, &outB) == 0);
+  snprintf(line, sizeof(line), "add %d\n", minion);
+  assert(sessionCommand(&b, line, &outB) == 0);
+  snprintf(line, sizeof(line), "add %d\n", 100000000);
+  assert(sessionCommand(&b, line, &outB) == 0);
+  assert(b.game.handCount[0] == 9);
+  assert(sessionCommand(&b, "play 5 100000000\n", &outB) == 0);
+  assert(sessionCommand(&b, "play 5 -3\n", &outB) == 0);
+  snprintf(line, sizeof(line), "play 6 %d\n", council_room);
+  assert(sessionCommand(&b, line, &outB) == 0);
+  snprintf(line, sizeof(line), "play 7 100000 %d\n", gold);
+  assert(sessionCommand(&b, line, &outB) == 0);
+  snprintf(line, sizeof(line), "play 7 0 %d\n", -5);
+  assert(sessionCommand(&b, line, &outB) == 0);
+  assert(sessionCommand(&b, "play 8 7\n", &outB) == 0);
+  assert(sessionCommand(&b, "play 8 0 2\n", &outB) == 0);
+  assert(strstr(outB.data, "cannot play card 8") != NULL);
+  assert(b.game.handCount[0] == 9 && b.game.numActions == 1);
+  snprintf(line, sizeof(line), "play 5 %d\n", silver);
+  assert(sessionCommand(&b, line, &outB) == 0);
+  assert(b.game.embargoTokens[silver] == 1);
+
+  //an all-bot game runs to the end within one command
+  outClear(&outB);
+  assert(sessionStart(&b, 3, &outB) == 0);
+  assert(sessionCommand(&b, "init 2 2\n", &outB) == 1);
+  assert(strstr(outB.data, "the winner(s) are:") != NULL);
+
+  //quiet bots play the same game without printing their turns
+  assert(outInit(&outQuiet, 16, 1 << 20) == 0);
+  assert(sessionStart(&quiet, 3, &outQuiet) == 0);
+  quiet.quietBots = TRUE;
+  assert(sessionCommand(&quiet, "init 2 2\n", &outQuiet) == 1);
+  assert(strstr(outQuiet.data, "Executing Bot") == NULL);
+  assert(strstr(outQuiet.data, "the winner(s) are:") != NULL);
+  assert(memcmp(&quiet.game, &b.game, sizeof(struct gameState)) == 0);
+  assert(quiet.turnNum == b.turnNum);
+  assert(outQuiet.len < outB.len);
+
+  //a script runs without prompts and reports only failed expects
+  outClear(&outQuiet);
+  outClear(&outB);
+  assert(sessionStart(&quiet, 5, NULL) == 0);
+  text = "init 2 1\r\n# a comment\n\nbuy 4\nexpect buys card 4\n"
+    "stat\nexpect 99 coins\nexit\nend\nexpect";
+  assert(sessionScript(&quiet, text, strlen(text), "t", &outB,
+		       &outQuiet) == 1);
+  assert(quiet.commands == 4);
+  assert(strstr(outQuiet.data, "t:7: expected \"99 coins\" after \"stat\"")
+	 != NULL);
+  assert(strstr(outQuiet.data, "t: 4 commands, 3 expects, 1 failed; turn 0,")
+	 != NULL);
+
+  //names are interned, and the copying calls agree with them
+  assert(cardName(sea_hag) == cardName(sea_hag));
+  assert(strcmp(cardName(sea_hag), "Sea Hag") == 0);
+  assert(strcmp(cardName(-1), "?") == 0);
+  assert(strcmp(cardName(treasure_map + 1), "?") == 0);
+  assert(cardNameToNum("sea_hag") == sea_hag);
+  assert(strcmp(phaseName(BUY_PHASE), "Buy") == 0);
+
+  assert(sessionCommand(&a, "exit\n", &outA) == 1);
+  assert(sessionCommand(&alone, "resign\n", &outAlone) == 1);
+
+  //a full buffer drops what does not fit and keeps what does
+  assert(outInit(&small, 8, 32) == 0);
+  assert(outPrintf(&small, "%s", "0123456789") == 10);
+  assert(outPrintf(&small, "%s", "0123456789012345678901234") == -1);
+  assert(small.len == 10 && small.dropped == 25);
+  assert(strcmp(small.data, "0123456789") == 0);
+  assert(outAppend(&small, "abc", 3) == 3);
+  assert(strcmp(small.data, "0123456789abc") == 0);
+  outFree(&small);
+
+  outFree(&outA);
+  outFree(&outB);
+  outFree(&outAlone);
+  outFree(&outQuiet);
+  printf("ALL TESTS OK\n");
+  return 0;
+}
@@ -0,0 +1,59 @@
+#include "dominion.h"
+#include "simulate.h"
+#include "shard.h"
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <assert.h>
+
+#define CRASH_SEED 1234
+
+//every seed counts as one game won by player 0, except one that crashes
+static int playOrCrash(void *arg, long firstSeed, long games, void *result) {
+  struct simAggregate *out = result;
+  long seed;
+
+  for (seed = firstSeed; seed < firstSeed + games; seed++) {
+    if (seed == CRASH_SEED)
+      raise(SIGSEGV);
+    out->games++;
+    out->wins[0]++;
+  }
+  return 0;
+}
+
+static void merge(void *arg, void *total, void *result) {
+  mergeSimAggregate(total, result);
+}
+
+int main () {
+  struct shardJob job;
+  struct shardStats stats;
+  struct simAggregate total;
+
+  printf ("Testing runShardedBatch.\n");
+
+  memset(&job, 0, sizeof(job));
+  memset(&total, 0, sizeof(total));
+  job.numWorkers = 3;
+  job.firstSeed = 1;
+  job.games = 5000;
+  job.shardGames = 100;
+  job.resultSize = sizeof(struct simAggregate);
+  job.play = playOrCrash;
+  job.merge = merge;
+
+  assert(runShardedBatch(&job, &total, &stats) == 0);
+  printf ("games %ld shards %ld retries %ld crashed %ld (first %ld)\n",
+	  total.games, stats.shards, stats.retries, stats.crashedSeeds,
+	  stats.firstCrashedSeed);
+
+  //only the crashing seed is lost, everything else is counted once
+  assert(total.games == job.games - 1);
+  assert(total.wins[0] == job.games - 1);
+  assert(stats.crashedSeeds == 1);
+  assert(stats.firstCrashedSeed == CRASH_SEED);
+
+  printf ("ALL TESTS OK\n");
+  return 0;
+}
@@ -1,14 +1,21 @@
 #include "dominion.h"
+#include "statediff.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
-int compare(const int* a, const int* b);
+int compare(const void* a, const void* b);
 
 int main () {
   struct gameState G;
   struct gameState G2;
+  struct stateDiffs diffs;
+  int k[10] = {adventurer, council_room, feast, gardens, mine,
+	       remodel, smithy, village, baron, great_hall};
 
   // Initialize G.
+  initializeGame(2, k, 1, &G);
 
   memcpy (&G2, &G, sizeof(struct gameState));
 
@@ -22,6 +29,10 @@ int main () {
   } else
     assert (ret == -1);
 
-  assert(memcmp(&G, &G2, sizeof(struct gameState)) == 0);  
+  if (diffGameState(&G2, &G, &diffs) > 0)
+    printStateDiffs(stdout, &G2, &G, &diffs, "before", "after");
+  assert(diffs.count == 0);
 
+  printf ("ALL TESTS OK\n");
+  return 0;
 }
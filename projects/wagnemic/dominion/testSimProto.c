@@ -0,0 +1,108 @@
+#include "dominion.h"
+#include "simulate.h"
+#include "simproto.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#define UNITS 3
+#define UNIT_GAMES 40
+
+static int k[10] = {adventurer, gardens, embargo, village, minion, mine,
+		    cutpurse, sea_hag, tribute, smithy};
+
+int main () {
+  unsigned char buf[SIM_MAX_MESSAGE];
+  struct simMessage m, back;
+  struct simAggregate total, part, alone;
+  struct simJob job;
+  long unit;
+  int status;
+  int sv[2];
+  pid_t pid;
+  int size;
+  int u, i;
+
+  printf ("Testing the coordinator/worker protocol.\n");
+
+  //messages survive the trip, negative fields too
+  m.type = MSG_LEASE;
+  m.count = 3;
+  m.fields[0] = 7;
+  m.fields[1] = -1;
+  m.fields[2] = 1L << 40;
+  size = encodeSimMessage(&m, buf);
+  assert(size == SIM_HEADER_SIZE + 8 * 3);
+  assert(decodeSimMessage(buf, size - 1, &back) == 0);
+  assert(decodeSimMessage(buf, size, &back) == size);
+  assert(back.type == MSG_LEASE && back.count == 3 && back.fields[1] == -1
+	 && back.fields[2] == 1L << 40);
+
+  //a worker on a socketpair plays the leases it is given
+  memset(&job, 0, sizeof(job));
+  job.numPlayers = 2;
+  memcpy(job.kingdom, k, sizeof(k));
+  parseStrategy("smithy", &job.strategies[0]);
+  parseStrategy("bigmoney", &job.strategies[1]);
+  assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+  pid = fork();
+  assert(pid >= 0);
+  if (pid == 0) {
+    close(sv[0]);
+    _exit(runSimWorker(sv[1]) < 0 ? 1 : 0);
+  }
+  close(sv[1]);
+
+  assert(recvSimMessage(sv[0], &m) == 0 && m.type == MSG_HELLO);
+  packSimJob(&job, &m);
+  assert(sendSimMessage(sv[0], &m) == 0);
+  memset(&total, 0, sizeof(total));
+  for (u = 0; u < UNITS; u++) {
+    m.type = MSG_LEASE;
+    m.count = 3;
+    m.fields[0] = u;
+    m.fields[1] = 1 + u * UNIT_GAMES;
+    m.fields[2] = UNIT_GAMES;
+    assert(sendSimMessage(sv[0], &m) == 0);
+    assert(recvSimMessage(sv[0], &m) == 0);
+    memset(&part, 0, sizeof(part));
+    assert(unpackSimResult(&m, &unit, &part) == 0 && unit == u);
+    mergeSimAggregate(&total, &part);
+  }
+  m.type = MSG_DONE;
+  m.count = 0;
+  assert(sendSimMessage(sv[0], &m) == 0);
+  assert(waitpid(pid, &status, 0) == pid);
+  assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  close(sv[0]);
+
+  //and the leases add up to the same games played in one go
+  memset(&alone, 0, sizeof(alone));
+  assert(simulateSeeds(&job, 1, UNITS * UNIT_GAMES, &alone) == 0);
+  assert(total.games == UNITS * UNIT_GAMES && total.games == alone.games);
+  assert(total.ties == alone.ties && total.turns == alone.turns);
+  for (i = 0; i < MAX_PLAYERS; i++)
+    assert(total.wins[i] == alone.wins[i]
+	   && total.scores[i] == alone.scores[i]);
+
+  //a worker given something other than a job gives up
+  assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+  pid = fork();
+  assert(pid >= 0);
+  if (pid == 0) {
+    close(sv[0]);
+    _exit(runSimWorker(sv[1]) < 0 ? 1 : 0);
+  }
+  close(sv[1]);
+  assert(recvSimMessage(sv[0], &m) == 0 && m.type == MSG_HELLO);
+  assert(sendSimMessage(sv[0], &m) == 0);
+  assert(waitpid(pid, &status, 0) == pid);
+  assert(WIFEXITED(status) && WEXITSTATUS(status) == 1);
+  close(sv[0]);
+
+  printf("ALL TESTS OK\n");
+  return 0;
+}
@@ -0,0 +1,61 @@
+#include "dominion.h"
+#include "statefile.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+int main () {
+  static struct playCase c;
+  static struct playCase back;
+  static unsigned char buf[STATE_FILE_MAX];
+  int k[10] = {adventurer, council_room, feast, gardens, mine,
+	       remodel, smithy, village, baron, great_hall};
+  int size;
+  int p;
+
+  printf ("Testing state files.\n");
+
+  assert(initializeGame(3, k, 7, &c.state) == 0);
+  c.entry = ENTRY_CARD_EFFECT;
+  c.card = smithy;
+  c.handPos = 2;
+  c.choice1 = -1;
+  c.choice2 = 5;
+  c.choice3 = 0;
+  c.seed = 42;
+  c.state.playedCards[0] = village;
+  c.state.playedCardCount = 1;
+
+  size = encodeStateFile(&c, buf, sizeof(buf));
+  assert(size > 0 && size < 1024);
+  assert(decodeStateFile(buf, size, &back) == 0);
+  assert(back.entry == c.entry && back.card == c.card);
+  assert(back.handPos == 2 && back.choice1 == -1 && back.choice2 == 5);
+  assert(back.seed == 42);
+  assert(back.state.numPlayers == 3);
+  assert(memcmp(back.state.supplyCount, c.state.supplyCount,
+		sizeof(c.state.supplyCount)) == 0);
+  for (p = 0; p < 3; p++) {
+    assert(back.state.handCount[p] == c.state.handCount[p]);
+    assert(back.state.deckCount[p] == c.state.deckCount[p]);
+    assert(memcmp(back.state.deck[p], c.state.deck[p],
+		  c.state.deckCount[p] * sizeof(int)) == 0);
+  }
+  assert(back.state.playedCardCount == 1 && back.state.playedCards[0] == village);
+
+  //truncated, oversized and out-of-range inputs are rejected
+  assert(decodeStateFile(buf, size - 1, &back) < 0);
+  assert(decodeStateFile(buf, 3, &back) < 0);
+  c.state.deckCount[1] = MAX_DECK + 1;
+  assert(encodeStateFile(&c, buf, sizeof(buf)) < 0);
+  c.state.deckCount[1] = 5;
+  assert(encodeStateFile(&c, buf, 64) < 0);
+
+  assert(writeStateFile("testStateFile.dst", &c) == 0);
+  assert(readStateFile("testStateFile.dst", &back) == 0);
+  assert(back.state.deckCount[1] == 5 && back.seed == 42);
+  remove("testStateFile.dst");
+
+  printf ("ALL TESTS OK\n");
+  return 0;
+}
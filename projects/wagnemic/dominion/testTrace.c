@@ -0,0 +1,77 @@
+#include "dominion.h"
+#include "dominion_helpers.h"
+#include "trace.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+
+#define TRACE_PATH "testTrace.trace"
+
+//reads back the single ring of a trace file
+static int readTrace(unsigned int header[3], struct traceEvent *events) {
+  FILE *f = fopen(TRACE_PATH, "rb");
+  char magic[4];
+  int rings;
+
+  assert(f != NULL);
+  assert(fread(magic, 1, 4, f) == 4 && memcmp(magic, TRACE_MAGIC, 4) == 0);
+  assert(fread(&rings, sizeof(int), 1, f) == 1);
+  assert(fread(header, sizeof(unsigned int), 3, f) == 3);
+  assert(fread(events, sizeof(struct traceEvent), header[1], f) == header[1]);
+  fclose(f);
+  return rings;
+}
+
+int main () {
+  static struct traceEvent events[TRACE_RING_EVENTS];
+  struct gameState G;
+  unsigned int header[3];
+  int k[10] = {adventurer, council_room, feast, gardens, mine,
+	       remodel, smithy, village, baron, great_hall};
+  int i;
+
+  printf ("Testing tracing.\n");
+
+  //nothing is recorded while tracing is off
+  assert(initializeGame(2, k, 1, &G) == 0);
+  traceStart();
+  assert(traceWrite(TRACE_PATH) == 0);
+
+  G.deck[0][G.deckCount[0] - 1] = gold;
+  assert(drawCard(0, &G) == 0);
+  assert(buyCard(province, &G) == -1);
+  assert(endTurn(&G) == 0);
+  traceStop();
+  assert(drawCard(1, &G) == 0);
+  assert(traceWrite(TRACE_PATH) > 0);
+  assert(readTrace(header, events) == 1);
+  assert(header[2] == 0);
+  assert(events[0].type == TRACE_DRAW && events[0].player == 0
+	 && events[0].card == gold && events[0].arg == G.deckCount[0]);
+  assert(events[1].type == TRACE_BUY && events[1].card == province
+	 && events[1].arg == -1);
+  assert(events[2].type == TRACE_END_TURN && events[2].player == 0
+	 && events[2].arg == 1);
+  //endTurn's own draws, but not the one after traceStop
+  assert(header[1] == 8);
+  for (i = 3; i < header[1]; i++) {
+    assert(events[i].type == TRACE_DRAW && events[i].player == 1);
+    assert(events[i].time >= events[i - 1].time);
+  }
+
+  //a full ring keeps the newest events
+  traceStart();
+  for (i = 0; i < TRACE_RING_EVENTS + 10; i++)
+    traceEvent(TRACE_SHUFFLE, 0, -1, i);
+  traceStop();
+  assert(traceWrite(TRACE_PATH) == TRACE_RING_EVENTS - 1);
+  readTrace(header, events);
+  assert(header[1] == TRACE_RING_EVENTS - 1 && header[2] == 11);
+  assert(events[0].arg == 11);
+  assert(events[TRACE_RING_EVENTS - 2].arg == TRACE_RING_EVENTS + 9);
+
+  unlink(TRACE_PATH);
+  printf("ALL TESTS OK\n");
+  return 0;
+}
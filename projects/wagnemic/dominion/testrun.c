@@ -0,0 +1,322 @@
+/* Parallel test driver
+
+   Runs the given tests, or every test* program in the current directory
+   when none are given, -j at a time in forked children.  Each test gets
+   its own seed in TEST_SEED (the base seed from -s plus its place in
+   the list, so a run can be repeated), a timeout (-t seconds) and a log
+   in <test>.out.  A test passes if it exits 0.
+
+   With -g the tests write their gcov data under a private directory
+   each (GCOV_PREFIX), so concurrent runs never update the same .gcda
+   file; the directories are then merged with gcov-tool, copied over the
+   .gcda files here and gcov is run on each -g source.  Prints one line
+   per test and a summary, and exits 1 if any test failed.
+
+   Usage: testrun [-j jobs] [-t seconds] [-s seed] [-g source.c ...]
+                  [test ...]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#define MAX_TESTS 64
+#define MAX_SOURCES 16
+#define MAX_PATH 1024
+
+enum OUTCOME {
+  PENDING = 0,
+  PASSED,
+  FAILED,
+  CRASHED,
+  TIMED_OUT
+};
+
+static const char *outcomeNames[] = {
+  "pending", "ok", "FAILED", "CRASHED", "TIMEOUT"
+};
+
+struct test {
+  char name[256];
+  long seed;
+  pid_t pid;
+  double started;
+  double seconds;
+  int outcome;
+  int code;          /* exit status or signal */
+  int error;         /* errno if it could not be started */
+};
+
+static double now(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int byName(const void *a, const void *b) {
+  return strcmp(((const struct test *)a)->name,
+		((const struct test *)b)->name);
+}
+
+//every executable test* here that is not a mutant build or this driver
+static int discover(struct test *tests, int max) {
+  DIR *d = opendir(".");
+  struct dirent *e;
+  struct stat st;
+  int n = 0;
+
+  if (d == NULL)
+    return -1;
+  while ((e = readdir(d)) != NULL && n < max) {
+    if (strncmp(e->d_name, "test", 4) != 0
+	|| strcmp(e->d_name, "testrun") == 0
+	|| strpbrk(e->d_name, ".-") != NULL
+	|| stat(e->d_name, &st) < 0 || !S_ISREG(st.st_mode)
+	|| access(e->d_name, X_OK) < 0)
+      continue;
+    snprintf(tests[n++].name, sizeof(tests[0].name), "%s", e->d_name);
+  }
+  closedir(d);
+  qsort(tests, n, sizeof(struct test), byName);
+  return n;
+}
+
+//the signal mask tests start with; the driver blocks SIGCHLD to wait
+//for it with a deadline
+static sigset_t unblocked;
+
+static pid_t spawn(struct test *t, const char *gcovDir, int index) {
+  char path[MAX_PATH];
+  char value[32];
+  pid_t pid = fork();
+  int log;
+
+  if (pid != 0)
+    return pid;
+  sigprocmask(SIG_SETMASK, &unblocked, NULL);
+  snprintf(value, sizeof(value), "%ld", t->seed);
+  setenv("TEST_SEED", value, 1);
+  if (gcovDir != NULL) {
+    snprintf(path, sizeof(path), "%s/%d", gcovDir, index);
+    setenv("GCOV_PREFIX", path, 1);
+    setenv("GCOV_PREFIX_STRIP", "0", 1);
+  }
+  snprintf(path, sizeof(path), "%s.out", t->name);
+  log = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (log >= 0) {
+    dup2(log, 1);
+    dup2(log, 2);
+  }
+  snprintf(path, sizeof(path), "%s%s", strchr(t->name, '/') ? "" : "./",
+	   t->name);
+  execl(path, path, (char *)NULL);
+  _exit(127);
+}
+
+static int run(const char *command) {
+  int status = system(command);
+
+  return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : -1;
+}
+
+//folds the per-test gcov trees into one and copies it over the .gcda here
+static int mergeCoverage(const char *gcovDir, struct test *tests,
+			 int numTests) {
+  char cwd[MAX_PATH];
+  char merged[MAX_PATH];
+  char command[4 * MAX_PATH];
+  int have = 0;
+  int i;
+
+  if (getcwd(cwd, sizeof(cwd)) == NULL)
+    return -1;
+  snprintf(merged, sizeof(merged), "%s/merged", gcovDir);
+  for (i = 0; i < numTests; i++) {
+    //a test that died on a signal wrote nothing
+    snprintf(command, sizeof(command), "test -d %s/%d%s", gcovDir, i, cwd);
+    if (run(command) < 0)
+      continue;
+    if (!have)
+      snprintf(command, sizeof(command), "cp -r %s/%d%s %s", gcovDir, i, cwd,
+	       merged);
+    else
+      snprintf(command, sizeof(command),
+	       "gcov-tool merge -o %s %s %s/%d%s 2>/dev/null", merged, merged,
+	       gcovDir, i, cwd);
+    if (run(command) < 0)
+      return -1;
+    have = 1;
+  }
+  if (!have)
+    return 0;
+  snprintf(command, sizeof(command), "cp %s/*.gcda . 2>/dev/null", merged);
+  return run(command);
+}
+
+static void usage(void) {
+  printf("Usage: testrun [-j jobs] [-t seconds] [-s seed] [-g source.c ...]\n"
+	 "               [test ...]\n");
+}
+
+int main(int argc, char **argv) {
+  static struct test tests[MAX_TESTS];
+  const char *sources[MAX_SOURCES];
+  char gcovDir[] = "/tmp/testrunXXXXXX";
+  char command[MAX_PATH + 64];
+  int numSources = 0;
+  int numTests;
+  int jobs = sysconf(_SC_NPROCESSORS_ONLN);
+  double timeout = 60;
+  long seed = 1;
+  int running = 0;
+  int next = 0;
+  int failed = 0;
+  int status;
+  int opt;
+  int i;
+  pid_t pid;
+  double start;
+  double wait;
+  double left;
+  sigset_t childExit;
+  struct timespec ts;
+
+  while ((opt = getopt(argc, argv, "j:t:s:g:")) != -1) {
+    switch (opt) {
+    case 'j': jobs = atoi(optarg); break;
+    case 't': timeout = atof(optarg); break;
+    case 's': seed = atol(optarg); break;
+    case 'g':
+      if (numSources == MAX_SOURCES) {
+	usage();
+	return 2;
+      }
+      sources[numSources++] = optarg;
+      break;
+    default: usage(); return 2;
+    }
+  }
+  if (jobs < 1 || timeout <= 0 || argc - optind > MAX_TESTS) {
+    usage();
+    return 2;
+  }
+  if (optind < argc) {
+    numTests = argc - optind;
+    for (i = 0; i < numTests; i++)
+      snprintf(tests[i].name, sizeof(tests[i].name), "%s", argv[optind + i]);
+  } else {
+    numTests = discover(tests, MAX_TESTS);
+  }
+  if (numTests <= 0) {
+    printf("No tests to run\n");
+    return 2;
+  }
+  for (i = 0; i < numTests; i++)
+    tests[i].seed = seed + i;
+  if (numSources > 0 && mkdtemp(gcovDir) == NULL) {
+    printf("Could not make a directory for coverage data\n");
+    return 2;
+  }
+
+  //SIGCHLD stays pending until sigtimedwait takes it, so no exit is missed
+  sigemptyset(&childExit);
+  sigaddset(&childExit, SIGCHLD);
+  sigprocmask(SIG_BLOCK, &childExit, &unblocked);
+
+  start = now();
+  while (next < numTests || running > 0) {
+    while (running < jobs && next < numTests) {
+      tests[next].pid = spawn(&tests[next], numSources ? gcovDir : NULL,
+			      next);
+      tests[next].started = now();
+      if (tests[next].pid < 0) {
+	tests[next].error = errno;
+	tests[next].outcome = FAILED;
+      } else
+	running++;
+      next++;
+    }
+
+    //every test left may have failed to start
+    if (running == 0)
+      continue;
+    pid = waitpid(-1, &status, WNOHANG);
+    if (pid == 0) {
+      //sleep until a test exits or the first timeout runs out
+      wait = -1;
+      for (i = 0; i < next; i++) {
+	if (tests[i].outcome != PENDING || tests[i].pid <= 0)
+	  continue;
+	left = tests[i].started + timeout - now();
+	if (left <= 0) {
+	  tests[i].outcome = TIMED_OUT;
+	  kill(tests[i].pid, SIGKILL);
+	} else if (wait < 0 || left < wait) {
+	  wait = left;
+	}
+      }
+      if (wait > 0) {
+	ts.tv_sec = (time_t)wait;
+	ts.tv_nsec = (long)((wait - ts.tv_sec) * 1e9);
+	sigtimedwait(&childExit, NULL, &ts);
+      }
+      continue;
+    }
+    if (pid < 0)
+      break;
+    for (i = 0; i < next && tests[i].pid != pid; i++)
+      ;
+    if (i == next)
+      continue;
+    running--;
+    tests[i].seconds = now() - tests[i].started;
+    if (tests[i].outcome == TIMED_OUT)
+      continue;
+    if (WIFSIGNALED(status)) {
+      tests[i].outcome = CRASHED;
+      tests[i].code = WTERMSIG(status);
+    } else {
+      tests[i].code = WEXITSTATUS(status);
+      tests[i].outcome = tests[i].code == 0 ? PASSED : FAILED;
+    }
+  }
+  sigprocmask(SIG_SETMASK, &unblocked, NULL);
+
+  for (i = 0; i < numTests; i++) {
+    printf("%-24s %-8s %7.2fs  seed %-6ld", tests[i].name,
+	   outcomeNames[tests[i].outcome], tests[i].seconds, tests[i].seed);
+    if (tests[i].error != 0)
+      printf("  could not start: %s", strerror(tests[i].error));
+    else if (tests[i].outcome == FAILED)
+      printf("  exit %d, see %s.out", tests[i].code, tests[i].name);
+    else if (tests[i].outcome == CRASHED)
+      printf("  signal %d, see %s.out", tests[i].code, tests[i].name);
+    printf("\n");
+    failed += tests[i].outcome != PASSED;
+  }
+  printf("%d tests, %d passed, %d failed in %.2fs on %d jobs\n", numTests,
+	 numTests - failed, failed, now() - start, jobs);
+
+  if (numSources > 0) {
+    if (mergeCoverage(gcovDir, tests, numTests) < 0)
+      printf("Merging coverage data failed\n");
+    for (i = 0; i < numSources; i++) {
+      fflush(stdout);
+      snprintf(command, sizeof(command), "gcov %s | grep -A1 \"'%s'\"",
+	       sources[i], sources[i]);
+      run(command);
+    }
+    snprintf(command, sizeof(command), "rm -rf %s", gcovDir);
+    run(command);
+  }
+  return failed > 0 ? 1 : 0;
+}
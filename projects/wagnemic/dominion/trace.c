@@ -0,0 +1,158 @@
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+struct traceRing {
+  unsigned long head;            /* events ever written */
+  unsigned long base;            /* head when tracing last started */
+  int thread;
+  struct traceRing *next;
+  struct traceEvent events[TRACE_RING_EVENTS];
+};
+
+static const char *eventNames[NUM_TRACE_EVENTS] = {
+  "none", "init", "draw", "shuffle", "gain", "trash", "play", "buy",
+  "endTurn"
+};
+
+int traceOn = 0;
+
+static __thread struct traceRing *ring = NULL;
+static struct traceRing *rings = NULL;
+static int numRings = 0;
+static struct timespec origin;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+static struct traceRing *addRing(void) {
+  struct traceRing *r = malloc(sizeof(struct traceRing));
+
+  if (r == NULL)
+    return NULL;
+  r->head = 0;
+  r->base = 0;
+  pthread_mutex_lock(&lock);
+  r->thread = numRings++;
+  r->next = rings;
+  rings = r;
+  pthread_mutex_unlock(&lock);
+  return r;
+}
+
+void traceEvent(int type, int player, int card, int arg) {
+  struct traceEvent *e;
+  struct timespec ts;
+  unsigned long head;
+
+  if (ring == NULL) {
+    ring = addRing();
+    if (ring == NULL)
+      return;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  head = ring->head;
+  e = &ring->events[head & (TRACE_RING_EVENTS - 1)];
+  e->time = (ts.tv_sec - origin.tv_sec) * 1000000000ULL
+    + ts.tv_nsec - origin.tv_nsec;
+  e->type = type;
+  e->player = player;
+  e->card = card;
+  e->arg = arg;
+  //the event is complete before the reader can see it
+  __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+void traceStart(void) {
+  struct traceRing *r;
+
+  pthread_mutex_lock(&lock);
+  clock_gettime(CLOCK_MONOTONIC, &origin);
+  for (r = rings; r != NULL; r = r->next)
+    r->base = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+  pthread_mutex_unlock(&lock);
+  traceOn = 1;
+}
+
+void traceStop(void) {
+  traceOn = 0;
+}
+
+//copies the ring's live events into out; returns how many, *lost gets
+//the number that wrapped away before or during the copy
+static long copyRing(struct traceRing *r, struct traceEvent *out,
+		     unsigned long *lost) {
+  unsigned long first;
+  unsigned long last = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+  unsigned long after;
+  unsigned long i;
+  long n = 0;
+
+  //the oldest slot of a full ring is the next one the writer reuses
+  first = last - r->base > TRACE_RING_EVENTS - 1
+    ? last - (TRACE_RING_EVENTS - 1) : r->base;
+  for (i = first; i < last; i++)
+    out[n++] = r->events[i & (TRACE_RING_EVENTS - 1)];
+  //slots the writer has reused since the head was read are torn, and so
+  //may be the one it is writing now, after - TRACE_RING_EVENTS; the fence
+  //keeps the copies above from being read after the head below
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  after = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+  if (after >= first + TRACE_RING_EVENTS) {
+    i = after - TRACE_RING_EVENTS + 1 - first;
+    if (i > (unsigned long)n)
+      i = n;
+    memmove(out, out + i, (n - i) * sizeof(struct traceEvent));
+    n -= i;
+    first += i;
+  }
+  *lost = first - r->base;
+  return n;
+}
+
+static int writeAll(FILE *f, const void *p, size_t size) {
+  return fwrite(p, 1, size, f) == size ? 0 : -1;
+}
+
+int traceWrite(const char *path) {
+  struct traceEvent *events = malloc(sizeof(struct traceEvent)
+				     * TRACE_RING_EVENTS);
+  FILE *f = fopen(path, "wb");
+  struct traceRing *r;
+  unsigned long lost;
+  unsigned int header[3];
+  long total = 0;
+  long n;
+  int failed = 0;
+
+  if (f == NULL || events == NULL) {
+    if (f != NULL)
+      fclose(f);
+    free(events);
+    return -1;
+  }
+  pthread_mutex_lock(&lock);
+  failed |= writeAll(f, TRACE_MAGIC, 4);
+  failed |= writeAll(f, &numRings, sizeof(int));
+  for (r = rings; r != NULL; r = r->next) {
+    n = copyRing(r, events, &lost);
+    header[0] = r->thread;
+    header[1] = n;
+    header[2] = lost;
+    failed |= writeAll(f, header, sizeof(header));
+    failed |= writeAll(f, events, n * sizeof(struct traceEvent));
+    total += n;
+  }
+  pthread_mutex_unlock(&lock);
+  free(events);
+  if (fclose(f) != 0 || failed)
+    return -1;
+  return total;
+}
+
+const char *traceEventName(int type) {
+  if (type < 0 || type >= NUM_TRACE_EVENTS)
+    return "unknown";
+  return eventNames[type];
+}
@@ -0,0 +1,66 @@
+/* Engine event tracing
+
+   TRACE(type, player, card, arg) records a typed event in a ring buffer
+   of the calling thread.  While tracing is off (the default) it costs a
+   test of one global flag.  Each thread gets its ring on its first
+   event; only that thread writes it, publishing each event by advancing
+   the ring's head, so recording takes no lock, and a full ring
+   overwrites its oldest events.  traceWrite copies every ring (threads
+   that have finished included) into a binary trace file; tracedump
+   turns that into a readable log or Chrome trace JSON.  Rings are
+   copied while their threads may still be writing, and events that get
+   overwritten during the copy are left out, so a copy holds at most
+   TRACE_RING_EVENTS - 1 of them.
+
+   Trace files are "DTR1", the number of rings, then for each ring its
+   thread number, event count and number of events lost to wrapping, and
+   the events as struct traceEvent, all in host byte order.
+*/
+
+#ifndef _TRACE_H
+#define _TRACE_H
+
+#define TRACE_MAGIC "DTR1"
+#define TRACE_RING_EVENTS 65536   /* a power of two */
+
+enum TRACE_EVENT {
+  TRACE_INIT = 1,    /* player = number of players, arg = seed */
+  TRACE_DRAW,        /* card drawn, arg = cards left in the deck */
+  TRACE_SHUFFLE,     /* arg = cards shuffled */
+  TRACE_GAIN,        /* arg = 0 discard, 1 deck, 2 hand, -1 pile empty */
+  TRACE_TRASH,       /* card trashed from hand */
+  TRACE_PLAY,        /* card played, arg = playCard's result */
+  TRACE_BUY,         /* arg = 0, or -1 if the buy was refused */
+  TRACE_END_TURN,    /* player ending the turn, arg = next player */
+  NUM_TRACE_EVENTS
+};
+
+struct traceEvent {
+  unsigned long long time;   /* nanoseconds since traceStart */
+  unsigned char type;
+  signed char player;
+  short card;
+  int arg;
+};
+
+extern int traceOn;
+
+void traceEvent(int type, int player, int card, int arg);
+
+#define TRACE(type, player, card, arg) \
+  do { \
+    if (traceOn) \
+      traceEvent(type, player, card, arg); \
+  } while (0)
+
+void traceStart(void);
+/* Empties every ring and turns recording on */
+
+void traceStop(void);
+
+int traceWrite(const char *path);
+/* Returns the number of events written, -1 on failure */
+
+const char *traceEventName(int type);
+
+#endif
@@ -0,0 +1,177 @@
+/* Trace file decoder
+
+   Prints a trace written by traceWrite (see trace.h) as one line per
+   event, thread by thread, or with -c as Chrome trace JSON (load it in
+   chrome://tracing or Perfetto): every event is an instant on its
+   thread's track, and every game and turn is a slice, so slow games and
+   long turns stand out.
+
+   Usage: tracedump [-c] trace.bin
+*/
+
+#include "dominion.h"
+#include "interface.h"
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+struct ringHeader {
+  unsigned int thread;
+  unsigned int count;
+  unsigned int lost;
+};
+
+static void eventText(struct traceEvent *e, char *text, int size) {
+  char name[MAX_STRING_LENGTH];
+
+  name[0] = '\0';
+  if (e->card >= curse && e->card <= treasure_map)
+    cardNumToName(e->card, name);
+  switch (e->type) {
+  case TRACE_INIT:
+    snprintf(text, size, "game seed %d, %d players", e->arg, e->player);
+    break;
+  case TRACE_DRAW:
+    snprintf(text, size, "p%d draw %s, deck %d", e->player, name, e->arg);
+    break;
+  case TRACE_SHUFFLE:
+    snprintf(text, size, "p%d shuffle %d cards", e->player, e->arg);
+    break;
+  case TRACE_GAIN:
+    snprintf(text, size, "p%d gain %s %s", e->player, name,
+	     e->arg == 1 ? "to deck" : e->arg == 2 ? "to hand"
+	     : e->arg < 0 ? "failed, pile empty" : "to discard");
+    break;
+  case TRACE_TRASH:
+    snprintf(text, size, "p%d trash %s", e->player, name);
+    break;
+  case TRACE_PLAY:
+    snprintf(text, size, "p%d play %s%s", e->player, name,
+	     e->arg < 0 ? " failed" : "");
+    break;
+  case TRACE_BUY:
+    snprintf(text, size, "p%d buy %s%s", e->player, name,
+	     e->arg < 0 ? " refused" : "");
+    break;
+  case TRACE_END_TURN:
+    snprintf(text, size, "p%d end turn", e->player);
+    break;
+  default:
+    snprintf(text, size, "event %d", e->type);
+  }
+}
+
+static void printLog(struct ringHeader *h, struct traceEvent *events) {
+  char text[128];
+  unsigned int i;
+
+  printf("thread %u: %u events", h->thread, h->count);
+  if (h->lost > 0)
+    printf(" (%u earlier ones overwritten)", h->lost);
+  printf("\n");
+  for (i = 0; i < h->count; i++) {
+    eventText(&events[i], text, sizeof(text));
+    printf("  %12.3fus %s\n", events[i].time / 1000.0, text);
+  }
+}
+
+static void slice(int *first, const char *name, unsigned int thread,
+		  unsigned long long start, unsigned long long end,
+		  const char *args) {
+  printf("%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+	 "\"ts\":%.3f,\"dur\":%.3f,\"args\":{%s}}", *first ? "" : ",\n",
+	 name, thread, start / 1000.0, (end - start) / 1000.0, args);
+  *first = 0;
+}
+
+//instants for the events, slices for the games and turns
+static void printChrome(struct ringHeader *h, struct traceEvent *events,
+			int *first) {
+  unsigned long long gameStart = 0;
+  unsigned long long turnStart = 0;
+  char text[128];
+  char args[64];
+  char gameArgs[64];
+  int inGame = 0;
+  int game = 0;
+  unsigned int i;
+
+  for (i = 0; i < h->count; i++) {
+    struct traceEvent *e = &events[i];
+
+    if (e->type == TRACE_INIT) {
+      if (inGame)
+	slice(first, "game", h->thread, gameStart, e->time, gameArgs);
+      snprintf(gameArgs, sizeof(gameArgs), "\"seed\":%d,\"game\":%d", e->arg,
+	       game++);
+      inGame = 1;
+      gameStart = turnStart = e->time;
+    }
+    eventText(e, text, sizeof(text));
+    printf("%s{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,"
+	   "\"tid\":%u,\"ts\":%.3f}", *first ? "" : ",\n", text, h->thread,
+	   e->time / 1000.0);
+    *first = 0;
+    if (e->type == TRACE_END_TURN) {
+      snprintf(args, sizeof(args), "\"player\":%d", e->player);
+      slice(first, "turn", h->thread, turnStart, e->time, args);
+      turnStart = e->time;
+    }
+  }
+  if (inGame && h->count > 0)
+    slice(first, "game", h->thread, gameStart, events[h->count - 1].time,
+	  gameArgs);
+}
+
+int main(int argc, char **argv) {
+  struct traceEvent *events = malloc(sizeof(struct traceEvent)
+				     * TRACE_RING_EVENTS);
+  struct ringHeader h;
+  char magic[4];
+  int chrome = 0;
+  int first = 1;
+  int numRings;
+  int opt;
+  int r;
+  FILE *f;
+
+  while ((opt = getopt(argc, argv, "c")) != -1) {
+    switch (opt) {
+    case 'c': chrome = 1; break;
+    default:
+      printf("Usage: tracedump [-c] trace.bin\n");
+      return 2;
+    }
+  }
+  if (optind != argc - 1 || events == NULL) {
+    printf("Usage: tracedump [-c] trace.bin\n");
+    return 2;
+  }
+  f = fopen(argv[optind], "rb");
+  if (f == NULL || fread(magic, 1, 4, f) != 4
+      || memcmp(magic, TRACE_MAGIC, 4) != 0
+      || fread(&numRings, sizeof(int), 1, f) != 1) {
+    printf("%s is not a trace file\n", argv[optind]);
+    return 2;
+  }
+
+  if (chrome)
+    printf("{\"traceEvents\":[\n");
+  for (r = 0; r < numRings; r++) {
+    if (fread(&h, sizeof(h), 1, f) != 1 || h.count > TRACE_RING_EVENTS
+	|| fread(events, sizeof(struct traceEvent), h.count, f) != h.count) {
+      fprintf(stderr, "%s is truncated\n", argv[optind]);
+      break;
+    }
+    if (chrome)
+      printChrome(&h, events, &first);
+    else
+      printLog(&h, events);
+  }
+  if (chrome)
+    printf("\n]}\n");
+  fclose(f);
+  return r == numRings ? 0 : 1;
+}
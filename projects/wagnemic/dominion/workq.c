@@ -0,0 +1,176 @@
+#include "workq.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+struct slice {
+  pthread_mutex_t lock;
+  long next;
+  long end;
+  char pad[64];  //keep slices on separate cache lines
+};
+
+struct workq {
+  int numWorkers;
+  long grain;
+  struct slice *slices;
+};
+
+struct runArgs {
+  struct workq *q;
+  int worker;
+  workFn fn;
+  void *arg;
+};
+
+int workqDefaultThreads(void) {
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? (int)n : 1;
+}
+
+struct workq *workqCreate(long begin, long end, long grain, int numWorkers) {
+  struct workq *q;
+  long total = end > begin ? end - begin : 0;
+  int i;
+
+  if (numWorkers < 1)
+    return NULL;
+  q = malloc(sizeof(struct workq));
+  if (q == NULL)
+    return NULL;
+  q->slices = calloc(numWorkers, sizeof(struct slice));
+  if (q->slices == NULL) {
+    free(q);
+    return NULL;
+  }
+  q->numWorkers = numWorkers;
+  q->grain = grain > 0 ? grain : 1;
+  for (i = 0; i < numWorkers; i++) {
+    pthread_mutex_init(&q->slices[i].lock, NULL);
+    q->slices[i].next = begin + total * i / numWorkers;
+    q->slices[i].end = begin + total * (i + 1) / numWorkers;
+  }
+  return q;
+}
+
+void workqDestroy(struct workq *q) {
+  int i;
+
+  if (q == NULL)
+    return;
+  for (i = 0; i < q->numWorkers; i++)
+    pthread_mutex_destroy(&q->slices[i].lock);
+  free(q->slices);
+  free(q);
+}
+
+static int takeOwn(struct workq *q, int worker, long *begin, long *end) {
+  struct slice *s = &q->slices[worker];
+  int found = 0;
+
+  pthread_mutex_lock(&s->lock);
+  if (s->next < s->end) {
+    *begin = s->next;
+    *end = s->next + q->grain < s->end ? s->next + q->grain : s->end;
+    s->next = *end;
+    found = 1;
+  }
+  pthread_mutex_unlock(&s->lock);
+  return found;
+}
+
+static int steal(struct workq *q, int worker) {
+  struct slice *mine = &q->slices[worker];
+  struct slice *victim;
+  long best = 0;
+  long left;
+  long mid;
+  int v = -1;
+  int i;
+
+  //unlocked scan is only a hint, the split below rechecks under the lock
+  for (i = 0; i < q->numWorkers; i++) {
+    left = q->slices[i].end - q->slices[i].next;
+    if (i != worker && left > best) {
+      best = left;
+      v = i;
+    }
+  }
+  if (v < 0)
+    return 0;
+
+  //lower index first, so two workers stealing from each other cannot
+  //each hold the lock the other waits for
+  victim = &q->slices[v];
+  pthread_mutex_lock(v < worker ? &victim->lock : &mine->lock);
+  pthread_mutex_lock(v < worker ? &mine->lock : &victim->lock);
+  left = victim->end - victim->next;
+  if (left > 0) {
+    mid = victim->next + left / 2;
+    mine->next = mid;
+    mine->end = victim->end;
+    victim->end = mid;
+  }
+  //with nothing left we raced with the owner, so scan again
+  pthread_mutex_unlock(&mine->lock);
+  pthread_mutex_unlock(&victim->lock);
+  return 1;
+}
+
+int workqNext(struct workq *q, int worker, long *begin, long *end) {
+  while (1) {
+    if (takeOwn(q, worker, begin, end))
+      return 1;
+    if (!steal(q, worker))
+      return 0;
+  }
+}
+
+static void *runWorker(void *p) {
+  struct runArgs *a = p;
+  long begin;
+  long end;
+
+  while (workqNext(a->q, a->worker, &begin, &end))
+    a->fn(a->arg, a->worker, begin, end);
+  return NULL;
+}
+
+int workqRun(long begin, long end, long grain, int numThreads,
+	     workFn fn, void *arg) {
+  struct workq *q;
+  struct runArgs *args;
+  pthread_t *threads;
+  int i;
+  int started = 0;
+
+  if (numThreads < 1)
+    numThreads = workqDefaultThreads();
+  q = workqCreate(begin, end, grain, numThreads);
+  args = calloc(numThreads, sizeof(struct runArgs));
+  threads = calloc(numThreads, sizeof(pthread_t));
+  if (q == NULL || args == NULL || threads == NULL) {
+    workqDestroy(q);
+    free(args);
+    free(threads);
+    return -1;
+  }
+
+  for (i = 0; i < numThreads; i++) {
+    args[i].q = q;
+    args[i].worker = i;
+    args[i].fn = fn;
+    args[i].arg = arg;
+    if (pthread_create(&threads[i], NULL, runWorker, &args[i]) != 0)
+      break;
+    started++;
+  }
+  //if some threads failed to start, the running ones steal their slices
+  for (i = 0; i < started; i++)
+    pthread_join(threads[i], NULL);
+
+  workqDestroy(q);
+  free(args);
+  free(threads);
+  return started > 0 ? 0 : -1;
+}
@@ -0,0 +1,28 @@
+/* Work-stealing index range scheduler
+
+   The range [begin, end) is split evenly between the workers.  Each
+   worker takes grain-sized chunks from the front of its own slice and,
+   once that is empty, steals the back half of the largest remaining
+   slice of another worker.
+*/
+
+#ifndef _WORKQ_H
+#define _WORKQ_H
+
+typedef void (*workFn)(void *arg, int worker, long begin, long end);
+
+struct workq;
+
+struct workq *workqCreate(long begin, long end, long grain, int numWorkers);
+void workqDestroy(struct workq *q);
+
+int workqNext(struct workq *q, int worker, long *begin, long *end);
+/* Returns 1 and a chunk of work, or 0 when all work is handed out */
+
+int workqRun(long begin, long end, long grain, int numThreads,
+	     workFn fn, void *arg);
+/* Run fn over the range on numThreads threads (0 = one per core) */
+
+int workqDefaultThreads(void);
+
+#endif